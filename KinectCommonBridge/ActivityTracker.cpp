@@ -0,0 +1,247 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "ActivityTracker.h"
+
+static inline float DistanceSquared( const Vector4& a, const Vector4& b )
+{
+    float dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+ActivityTracker::ActivityTracker()
+{
+    Reset();
+}
+
+void ActivityTracker::Reset()
+{
+    ZeroMemory( m_slots, sizeof(m_slots) );
+    ZeroMemory( m_chosenIDs, sizeof(m_chosenIDs) );
+}
+
+ActivityTracker::Slot* ActivityTracker::FindSlot( DWORD dwTrackingID )
+{
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        if( 0 != dwTrackingID && m_slots[i].dwTrackingID == dwTrackingID )
+        {
+            return &m_slots[i];
+        }
+    }
+
+    return nullptr;
+}
+
+ActivityTracker::Slot* ActivityTracker::AllocateSlot( DWORD dwTrackingID )
+{
+    // a free slot, otherwise the one missed the longest, slots of the current frame are never taken
+    Slot* pSlot = nullptr;
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        Slot& slot = m_slots[i];
+        if( 0 == slot.dwTrackingID )
+        {
+            pSlot = &slot;
+            break;
+        }
+
+        if( !slot.bSeen && (nullptr == pSlot || slot.cMissedFrames > pSlot->cMissedFrames) )
+        {
+            pSlot = &slot;
+        }
+    }
+
+    if( nullptr != pSlot )
+    {
+        ZeroMemory( pSlot, sizeof(Slot) );
+        pSlot->dwTrackingID = dwTrackingID;
+    }
+
+    return pSlot;
+}
+
+float ActivityTracker::KineticEnergy( _In_ const HistoryEntry& newest, _In_ const HistoryEntry& oldest, float seconds )
+{
+    float sum = 0.0f;
+    UINT count = 0;
+
+    // joints when both frames have them, the skeleton may have changed between tracked and position only
+    if( newest.bJoints && oldest.bJoints )
+    {
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            if( newest.bJointTracked[j] && oldest.bJointTracked[j] )
+            {
+                sum += DistanceSquared( newest.joints[j], oldest.joints[j] );
+                ++count;
+            }
+        }
+    }
+
+    if( 0 == count )
+    {
+        sum = DistanceSquared( newest.position, oldest.position );
+        count = 1;
+    }
+
+    // 1/2 v^2 per unit mass
+    return 0.5f * sum / (count * seconds * seconds);
+}
+
+void ActivityTracker::AddSkeleton( _Inout_ Slot& slot, _In_ const NUI_SKELETON_DATA& skeleton, LONGLONG liTimeStamp )
+{
+    slot.head = (slot.head + 1) % ACTIVITY_HISTORY_FRAMES;
+    slot.count = min( slot.count + 1, static_cast<UINT>(ACTIVITY_HISTORY_FRAMES) );
+
+    HistoryEntry& entry = slot.history[slot.head];
+    entry.liTimeStamp = liTimeStamp;
+    entry.position = skeleton.Position;
+    entry.bJoints = (NUI_SKELETON_TRACKED == skeleton.eTrackingState);
+    if( entry.bJoints )
+    {
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            entry.joints[j] = skeleton.SkeletonPositions[j];
+            entry.bJointTracked[j] = (NUI_SKELETON_POSITION_NOT_TRACKED != skeleton.eSkeletonPositionTrackingState[j]);
+        }
+    }
+
+    if( slot.count < 2 )
+    {
+        return;
+    }
+
+    // speed across the whole ring, the frames in between smooth the jitter of the joints
+    const HistoryEntry& oldest = slot.history[(slot.head + ACTIVITY_HISTORY_FRAMES - (slot.count - 1)) % ACTIVITY_HISTORY_FRAMES];
+    float seconds = (liTimeStamp - oldest.liTimeStamp) / 1000.0f;
+    if( seconds <= 0.0f )
+    {
+        return;
+    }
+
+    slot.fActivity = ACTIVITY_DECAY * slot.fActivity + (1.0f - ACTIVITY_DECAY) * KineticEnergy( entry, oldest, seconds );
+}
+
+void ActivityTracker::Update( _In_ const NUI_SKELETON_FRAME& skeletonFrame )
+{
+    LONGLONG liTimeStamp = skeletonFrame.liTimeStamp.QuadPart;
+
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        m_slots[i].bSeen = false;
+    }
+
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[i];
+        if( NUI_SKELETON_NOT_TRACKED == skeleton.eTrackingState || 0 == skeleton.dwTrackingID )
+        {
+            continue;
+        }
+
+        Slot* pSlot = FindSlot( skeleton.dwTrackingID );
+        if( nullptr == pSlot )
+        {
+            pSlot = AllocateSlot( skeleton.dwTrackingID );
+        }
+
+        if( nullptr != pSlot )
+        {
+            pSlot->bSeen = true;
+            pSlot->cMissedFrames = 0;
+            AddSkeleton( *pSlot, skeleton, liTimeStamp );
+        }
+    }
+
+    // missing skeletons fade out and free their slot after the grace period
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        Slot& slot = m_slots[i];
+        if( 0 != slot.dwTrackingID && !slot.bSeen )
+        {
+            slot.fActivity *= ACTIVITY_DECAY;
+            if( ++slot.cMissedFrames > ACTIVITY_GRACE_FRAMES )
+            {
+                ZeroMemory( &slot, sizeof(Slot) );
+            }
+        }
+    }
+}
+
+void ActivityTracker::ChooseMostActive( _Out_writes_(cTrackIDs) DWORD* pTrackIDs, UINT cTrackIDs )
+{
+    cTrackIDs = min( cTrackIDs, static_cast<UINT>(NUI_SKELETON_COUNT) );
+    ZeroMemory( pTrackIDs, cTrackIDs * sizeof(DWORD) );
+
+    float scores[NUI_SKELETON_COUNT];
+    for( UINT i = 0; i < cTrackIDs; ++i )
+    {
+        scores[i] = -1.0f;
+    }
+
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        const Slot& slot = m_slots[i];
+        if( !slot.bSeen )
+        {
+            continue;
+        }
+
+        // the skeletons chosen last time win ties up to the switch ratio
+        float score = slot.fActivity;
+        for( UINT c = 0; c < cTrackIDs; ++c )
+        {
+            if( m_chosenIDs[c] == slot.dwTrackingID )
+            {
+                score *= ACTIVITY_SWITCH_RATIO;
+                break;
+            }
+        }
+
+        // insertion into the sorted choice
+        for( UINT c = 0; c < cTrackIDs; ++c )
+        {
+            if( score > scores[c] )
+            {
+                for( UINT k = cTrackIDs - 1; k > c; --k )
+                {
+                    scores[k] = scores[k - 1];
+                    pTrackIDs[k] = pTrackIDs[k - 1];
+                }
+                scores[c] = score;
+                pTrackIDs[c] = slot.dwTrackingID;
+                break;
+            }
+        }
+    }
+
+    ZeroMemory( m_chosenIDs, sizeof(m_chosenIDs) );
+    CopyMemory( m_chosenIDs, pTrackIDs, cTrackIDs * sizeof(DWORD) );
+}
+
+float ActivityTracker::GetActivity( DWORD dwTrackingID ) const
+{
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        if( 0 != dwTrackingID && m_slots[i].dwTrackingID == dwTrackingID )
+        {
+            return m_slots[i].fActivity;
+        }
+    }
+
+    return 0.0f;
+}
@@ -0,0 +1,85 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// frames of joint positions kept per skeleton, the speed is measured across them
+#define ACTIVITY_HISTORY_FRAMES     4
+
+// weight of the previous activity in every frame
+#define ACTIVITY_DECAY              0.9f
+
+// frames a skeleton that is no longer seen keeps its slot, in case the id comes back
+#define ACTIVITY_GRACE_FRAMES       30
+
+// a chosen skeleton is only replaced by one this much more active, so the choice does not flicker
+#define ACTIVITY_SWITCH_RATIO       1.5f
+
+// activity of every skeleton of the skeleton frames, for the most active chooser modes
+// every tracking id has a slot with a ring of its last joint positions; the activity is the
+// kinetic energy of the joints (unit mass, speed across the ring) decayed over the frames,
+// so a frame costs O(joints) per skeleton; position only skeletons are measured by their position
+class ActivityTracker
+{
+public:
+    ActivityTracker();
+
+    void Reset();
+
+    // adds the skeletons of the frame, skeletons not in it age out of their slots
+    void Update( _In_ const NUI_SKELETON_FRAME& skeletonFrame );
+
+    // the most active skeletons of the last frame, most active first, 0 for none
+    // previously chosen ids are kept unless another skeleton is clearly more active
+    void ChooseMostActive( _Out_writes_(cTrackIDs) DWORD* pTrackIDs, UINT cTrackIDs );
+
+    // activity of the tracking id, 0 when it has no slot
+    float GetActivity( DWORD dwTrackingID ) const;
+
+private:
+    struct HistoryEntry
+    {
+        LONGLONG liTimeStamp;
+        bool bJoints;
+        Vector4 position;
+        Vector4 joints[NUI_SKELETON_POSITION_COUNT];
+        bool bJointTracked[NUI_SKELETON_POSITION_COUNT];
+    };
+
+    struct Slot
+    {
+        DWORD dwTrackingID;         // 0 for a free slot
+        UINT cMissedFrames;
+        bool bSeen;                 // in the last frame
+        float fActivity;
+
+        // ring of the last frames, newest at head
+        HistoryEntry history[ACTIVITY_HISTORY_FRAMES];
+        UINT head;
+        UINT count;
+    };
+
+    Slot* FindSlot( DWORD dwTrackingID );
+    Slot* AllocateSlot( DWORD dwTrackingID );
+    void AddSkeleton( _Inout_ Slot& slot, _In_ const NUI_SKELETON_DATA& skeleton, LONGLONG liTimeStamp );
+
+    // mean kinetic energy of the points between two frames, seconds apart
+    static float KineticEnergy( _In_ const HistoryEntry& newest, _In_ const HistoryEntry& oldest, float seconds );
+
+private:
+    Slot m_slots[NUI_SKELETON_COUNT];
+    DWORD m_chosenIDs[NUI_SKELETON_COUNT];
+};
@@ -0,0 +1,251 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "BackgroundModel.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+#include <intrin.h>
+
+BackgroundModel::BackgroundModel()
+    : m_bEnabled(false)
+    , m_bFrozen(false)
+    , m_width(0)
+    , m_height(0)
+    , m_bResultValid(false)
+{
+    ZeroMemory( &m_params, sizeof(KINECT_BACKGROUND_MODEL) );
+    m_params.dwStructSize = sizeof(KINECT_BACKGROUND_MODEL);
+}
+
+void BackgroundModel::SetParameters( _In_opt_ const KINECT_BACKGROUND_MODEL* pParams )
+{
+    m_bEnabled = (nullptr != pParams);
+    if( nullptr != pParams )
+    {
+        m_params = *pParams;
+    }
+
+    if( 0 == m_params.usLearningStep )
+    {
+        m_params.usLearningStep = BACKGROUND_DEFAULT_LEARNING_STEP;
+    }
+
+    if( 0 == m_params.usForegroundThreshold )
+    {
+        m_params.usForegroundThreshold = BACKGROUND_DEFAULT_THRESHOLD;
+    }
+
+    m_bResultValid = false;
+}
+
+void BackgroundModel::Reset()
+{
+    m_background.assign( m_background.size(), 0 );
+    m_bResultValid = false;
+}
+
+void BackgroundModel::ResetLayout( UINT width, UINT height )
+{
+    m_width = width;
+    m_height = height;
+
+    m_background.assign( width * height, 0 );
+    m_mask.assign( width * height, 0 );
+    m_bandIndices.resize( (height + BACKGROUND_BAND_ROWS - 1) / BACKGROUND_BAND_ROWS );
+}
+
+void BackgroundModel::ProcessRow( _In_ const BYTE* pSrc, bool bPixels, UINT y, _Inout_ std::vector<DWORD>& indices )
+{
+    USHORT* pBackground = m_background.data() + y * m_width;
+    BYTE* pMask = m_mask.data() + y * m_width;
+    const DWORD rowStart = y * m_width;
+
+    const short step = static_cast<short>( m_params.usLearningStep );
+    const short threshold = static_cast<short>( m_params.usForegroundThreshold );
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vStep = _mm_set1_epi16( step );
+    const __m128i vThreshold = _mm_set1_epi16( threshold );
+    const __m128i learn = m_bFrozen ? zero : _mm_set1_epi16( -1 );
+
+    // depth fits into 13 bits, so the signed 16 bit compares work on it
+    UINT x = 0;
+    for( ; x + 16 <= m_width; x += 16 )
+    {
+        __m128i foreground[2];
+        for( UINT half = 0; half < 2; ++half )
+        {
+            UINT i = x + half * 8;
+
+            __m128i depth;
+            if( bPixels )
+            {
+                // depth is the high USHORT of every pixel
+                __m128i lo = _mm_srai_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) + i / 4 ), 16 );
+                __m128i hi = _mm_srai_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) + i / 4 + 1 ), 16 );
+                depth = _mm_packs_epi32( lo, hi );
+            }
+            else
+            {
+                depth = _mm_srli_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + i * sizeof(USHORT)) ), NUI_IMAGE_PLAYER_INDEX_SHIFT );
+            }
+
+            __m128i background = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pBackground + i) );
+
+            __m128i valid = _mm_xor_si128( _mm_cmpeq_epi16( depth, zero ), _mm_set1_epi16( -1 ) );
+            __m128i learned = _mm_xor_si128( _mm_cmpeq_epi16( background, zero ), _mm_set1_epi16( -1 ) );
+
+            // in front of the background by more than the threshold
+            foreground[half] = _mm_and_si128( _mm_and_si128( valid, learned ),
+                _mm_cmplt_epi16( depth, _mm_sub_epi16( background, vThreshold ) ) );
+
+            // step towards the depth, or take it when there is no background yet or it is behind it
+            __m128i stepped = _mm_max_epi16( _mm_min_epi16( depth, _mm_add_epi16( background, vStep ) ), _mm_sub_epi16( background, vStep ) );
+            __m128i take = _mm_or_si128( _mm_xor_si128( learned, _mm_set1_epi16( -1 ) ), _mm_cmpgt_epi16( depth, _mm_add_epi16( background, vThreshold ) ) );
+            __m128i updated = _mm_or_si128( _mm_and_si128( take, depth ), _mm_andnot_si128( take, stepped ) );
+
+            __m128i update = _mm_and_si128( valid, learn );
+            background = _mm_or_si128( _mm_and_si128( update, updated ), _mm_andnot_si128( update, background ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>(pBackground + i), background );
+        }
+
+        __m128i mask = _mm_packs_epi16( foreground[0], foreground[1] );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pMask + x), mask );
+
+        UINT bits = _mm_movemask_epi8( mask );
+        while( 0 != bits )
+        {
+            DWORD bit = 0;
+            _BitScanForward( &bit, bits );
+            bits &= bits - 1;
+
+            indices.push_back( rowStart + x + bit );
+        }
+    }
+
+    // rest of the row
+    for( ; x < m_width; ++x )
+    {
+        short depth = bPixels ? reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL*>(pSrc)[x].depth
+            : static_cast<short>( reinterpret_cast<const USHORT*>(pSrc)[x] >> NUI_IMAGE_PLAYER_INDEX_SHIFT );
+        short background = pBackground[x];
+
+        bool bForeground = 0 != depth && 0 != background && depth < background - threshold;
+        pMask[x] = bForeground ? 0xff : 0;
+        if( bForeground )
+        {
+            indices.push_back( rowStart + x );
+        }
+
+        if( 0 != depth && !m_bFrozen )
+        {
+            if( 0 == background || depth > background + threshold )
+            {
+                background = depth;
+            }
+            else
+            {
+                background = max( static_cast<short>(background - step), min( depth, static_cast<short>(background + step) ) );
+            }
+            pBackground[x] = background;
+        }
+    }
+}
+
+void BackgroundModel::Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels )
+{
+    if( width != m_width || height != m_height )
+    {
+        ResetLayout( width, height );
+    }
+
+    Concurrency::parallel_for( size_t(0), m_bandIndices.size(), [&]( size_t band )
+    {
+        std::vector<DWORD>& indices = m_bandIndices[band];
+        indices.clear();
+
+        UINT yEnd = min( height, static_cast<UINT>(band + 1) * BACKGROUND_BAND_ROWS );
+        for( UINT y = static_cast<UINT>(band) * BACKGROUND_BAND_ROWS; y < yEnd; ++y )
+        {
+            ProcessRow( pSrc + y * srcPitch, bPixels, y, indices );
+        }
+    } );
+
+    m_bResultValid = true;
+}
+
+HRESULT BackgroundModel::GetResult( const ImageTransform& transform, _Inout_ KINECT_FOREGROUND_INFO* pInfo,
+    ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices )
+{
+    if( !m_bEnabled || !m_bResultValid )
+    {
+        return E_NUI_FRAME_NO_DATA;
+    }
+
+    UINT width = m_width, height = m_height;
+    transform.GetOutputSize( m_width, m_height, width, height );
+
+    DWORD cForeground = 0;
+    for( size_t band = 0; band < m_bandIndices.size(); ++band )
+    {
+        cForeground += static_cast<DWORD>( m_bandIndices[band].size() );
+    }
+
+    pInfo->dwWidth = width;
+    pInfo->dwHeight = height;
+    pInfo->cForegroundPixels = cForeground;
+    pInfo->bFrozen = m_bFrozen;
+
+    if( (nullptr != pMask && cbMask < m_mask.size()) || (nullptr != pIndices && cIndices < cForeground) )
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    if( nullptr != pMask )
+    {
+        if( transform.IsIdentity() )
+        {
+            memcpy_s( pMask, cbMask, m_mask.data(), m_mask.size() );
+        }
+        else
+        {
+            transform.Reorder( m_mask.data(), m_width, m_height, false, pMask );
+        }
+    }
+
+    if( nullptr != pIndices )
+    {
+        // native order, the indices of a transformed frame are moved one by one
+        for( size_t band = 0; band < m_bandIndices.size(); ++band )
+        {
+            const std::vector<DWORD>& indices = m_bandIndices[band];
+            for( size_t i = 0; i < indices.size(); ++i )
+            {
+                DWORD index = indices[i];
+                if( !transform.IsIdentity() )
+                {
+                    LONG x = 0, y = 0;
+                    transform.TransformPoint( m_width, m_height, index % m_width, index / m_width, x, y );
+                    index = y * width + x;
+                }
+                *pIndices++ = index;
+            }
+        }
+    }
+
+    return S_OK;
+}
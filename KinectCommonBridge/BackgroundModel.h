@@ -0,0 +1,71 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+#include "ImageTransform.h"
+
+// rows handled by a single task
+#define BACKGROUND_BAND_ROWS                16
+
+// used when the caller leaves the value at 0
+#define BACKGROUND_DEFAULT_LEARNING_STEP    2
+#define BACKGROUND_DEFAULT_THRESHOLD        80
+
+// per pixel background depth of the depth stream, learned from the native frames
+// the background follows the depth by at most the learning step per frame, an approximate
+// running median, and takes any depth behind it right away since nothing can be seen through
+// the background; foreground is depth in front of the background by more than the threshold
+class BackgroundModel
+{
+public:
+    BackgroundModel();
+
+    // nullptr turns it off
+    void SetParameters( _In_opt_ const KINECT_BACKGROUND_MODEL* pParams );
+    bool IsEnabled() const { return m_bEnabled; }
+
+    // a frozen model still extracts foreground, but stops learning
+    void Freeze( bool bFreeze ) { m_bFrozen = bFreeze; }
+    void Reset();
+
+    // pSrc - native frame rows, srcPitch bytes apart
+    // bPixels = false: packed USHORT (depth << 3 | player), true: NUI_DEPTH_IMAGE_PIXEL
+    void Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels );
+
+    // result of the last frame in the orientation of the transform
+    HRESULT GetResult( const ImageTransform& transform, _Inout_ KINECT_FOREGROUND_INFO* pInfo,
+        ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices );
+
+private:
+    void ResetLayout( UINT width, UINT height );
+    void ProcessRow( _In_ const BYTE* pSrc, bool bPixels, UINT y, _Inout_ std::vector<DWORD>& indices );
+
+private:
+    KINECT_BACKGROUND_MODEL m_params;
+    bool m_bEnabled;
+    bool m_bFrozen;
+
+    UINT m_width;
+    UINT m_height;
+
+    // background depth in mm, 0 until the pixel had a depth
+    std::vector<USHORT> m_background;
+
+    // results of the last frame in native order, 0xff for foreground
+    bool m_bResultValid;
+    std::vector<BYTE> m_mask;
+    std::vector<std::vector<DWORD>> m_bandIndices;
+};
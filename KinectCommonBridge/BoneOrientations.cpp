@@ -0,0 +1,378 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "BoneOrientations.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <math.h>
+#include <limits>
+
+#define BONE_DEGREES_PER_RADIAN     57.29578f
+
+// 4 lanes of a vector and of a quaternion
+struct Vector4x4
+{
+    __m128 x, y, z;
+};
+
+struct Quaternion4x4
+{
+    __m128 x, y, z, w;
+};
+
+static inline __m128 Select( __m128 mask, __m128 a, __m128 b )
+{
+    return _mm_or_ps( _mm_and_ps(mask, a), _mm_andnot_ps(mask, b) );
+}
+
+static inline __m128 CopySign( __m128 magnitude, __m128 sign )
+{
+    const __m128 signBit = _mm_castsi128_ps( _mm_set1_epi32(0x80000000) );
+    return _mm_or_ps( _mm_andnot_ps(signBit, magnitude), _mm_and_ps(signBit, sign) );
+}
+
+static inline Vector4x4 LoadJoint( const float x[BONE_ORIENTATION_LANES], const float y[BONE_ORIENTATION_LANES], const float z[BONE_ORIENTATION_LANES], UINT lane )
+{
+    Vector4x4 v = { _mm_loadu_ps(x + lane), _mm_loadu_ps(y + lane), _mm_loadu_ps(z + lane) };
+    return v;
+}
+
+static inline Vector4x4 Subtract( const Vector4x4& a, const Vector4x4& b )
+{
+    Vector4x4 v = { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+    return v;
+}
+
+static inline __m128 Dot( const Vector4x4& a, const Vector4x4& b )
+{
+    return _mm_add_ps( _mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z) );
+}
+
+static inline Vector4x4 Cross( const Vector4x4& a, const Vector4x4& b )
+{
+    Vector4x4 v =
+    {
+        _mm_sub_ps( _mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y) ),
+        _mm_sub_ps( _mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z) ),
+        _mm_sub_ps( _mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x) )
+    };
+    return v;
+}
+
+// a vector of length 0 stays 0
+static inline Vector4x4 Normalize( const Vector4x4& a )
+{
+    __m128 scale = _mm_div_ps( _mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(Dot(a, a), _mm_set1_ps(1e-12f))) );
+    Vector4x4 v = { _mm_mul_ps(a.x, scale), _mm_mul_ps(a.y, scale), _mm_mul_ps(a.z, scale) };
+    return v;
+}
+
+static inline Quaternion4x4 Identity()
+{
+    Quaternion4x4 q = { _mm_setzero_ps(), _mm_setzero_ps(), _mm_setzero_ps(), _mm_set1_ps(1.0f) };
+    return q;
+}
+
+static inline Quaternion4x4 Select( __m128 mask, const Quaternion4x4& a, const Quaternion4x4& b )
+{
+    Quaternion4x4 q = { Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z), Select(mask, a.w, b.w) };
+    return q;
+}
+
+static inline Quaternion4x4 Normalize( const Quaternion4x4& a )
+{
+    __m128 length2 = _mm_add_ps( _mm_add_ps(_mm_mul_ps(a.x, a.x), _mm_mul_ps(a.y, a.y)), _mm_add_ps(_mm_mul_ps(a.z, a.z), _mm_mul_ps(a.w, a.w)) );
+    __m128 scale = _mm_div_ps( _mm_set1_ps(1.0f), _mm_sqrt_ps(_mm_max_ps(length2, _mm_set1_ps(1e-12f))) );
+    Quaternion4x4 q = { _mm_mul_ps(a.x, scale), _mm_mul_ps(a.y, scale), _mm_mul_ps(a.z, scale), _mm_mul_ps(a.w, scale) };
+    return q;
+}
+
+static inline Quaternion4x4 Conjugate( const Quaternion4x4& a )
+{
+    const __m128 signBit = _mm_castsi128_ps( _mm_set1_epi32(0x80000000) );
+    Quaternion4x4 q = { _mm_xor_ps(a.x, signBit), _mm_xor_ps(a.y, signBit), _mm_xor_ps(a.z, signBit), a.w };
+    return q;
+}
+
+// a * b, b is applied first
+static inline Quaternion4x4 Multiply( const Quaternion4x4& a, const Quaternion4x4& b )
+{
+    Quaternion4x4 q =
+    {
+        _mm_add_ps( _mm_add_ps(_mm_mul_ps(a.w, b.x), _mm_mul_ps(a.x, b.w)), _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)) ),
+        _mm_add_ps( _mm_sub_ps(_mm_mul_ps(a.w, b.y), _mm_mul_ps(a.x, b.z)), _mm_add_ps(_mm_mul_ps(a.y, b.w), _mm_mul_ps(a.z, b.x)) ),
+        _mm_add_ps( _mm_add_ps(_mm_mul_ps(a.w, b.z), _mm_mul_ps(a.x, b.y)), _mm_sub_ps(_mm_mul_ps(a.z, b.w), _mm_mul_ps(a.y, b.x)) ),
+        _mm_sub_ps( _mm_sub_ps(_mm_mul_ps(a.w, b.w), _mm_mul_ps(a.x, b.x)), _mm_add_ps(_mm_mul_ps(a.y, b.y), _mm_mul_ps(a.z, b.z)) )
+    };
+    return q;
+}
+
+// rotation that turns the camera axes into the orthonormal axes x, y, z, without branches
+static inline Quaternion4x4 FromAxes( const Vector4x4& x, const Vector4x4& y, const Vector4x4& z )
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 zero = _mm_setzero_ps();
+
+    // the axes are the columns of the matrix
+    Quaternion4x4 q =
+    {
+        _mm_mul_ps( half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(_mm_add_ps(one, x.x), _mm_add_ps(y.y, z.z)))) ),
+        _mm_mul_ps( half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(_mm_add_ps(one, y.y), _mm_add_ps(x.x, z.z)))) ),
+        _mm_mul_ps( half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(_mm_add_ps(one, z.z), _mm_add_ps(x.x, y.y)))) ),
+        _mm_mul_ps( half, _mm_sqrt_ps(_mm_max_ps(zero, _mm_add_ps(_mm_add_ps(one, x.x), _mm_add_ps(y.y, z.z)))) )
+    };
+    q.x = CopySign( q.x, _mm_sub_ps(y.z, z.y) );
+    q.y = CopySign( q.y, _mm_sub_ps(z.x, x.z) );
+    q.z = CopySign( q.z, _mm_sub_ps(x.y, y.x) );
+
+    return Normalize( q );
+}
+
+// shortest arc from the unit vector a to the unit vector b
+// a bone folded back onto its parent has no shortest arc and keeps the orientation
+static inline Quaternion4x4 FromArc( const Vector4x4& a, const Vector4x4& b )
+{
+    Vector4x4 axis = Cross( a, b );
+    Quaternion4x4 q = { axis.x, axis.y, axis.z, _mm_max_ps(_mm_add_ps(_mm_set1_ps(1.0f), Dot(a, b)), _mm_set1_ps(1e-6f)) };
+    return Normalize( q );
+}
+
+// the Y axis of the rotation
+static inline Vector4x4 AxisY( const Quaternion4x4& q )
+{
+    const __m128 two = _mm_set1_ps(2.0f);
+    Vector4x4 v =
+    {
+        _mm_mul_ps( two, _mm_sub_ps(_mm_mul_ps(q.x, q.y), _mm_mul_ps(q.w, q.z)) ),
+        _mm_sub_ps( _mm_set1_ps(1.0f), _mm_mul_ps(two, _mm_add_ps(_mm_mul_ps(q.x, q.x), _mm_mul_ps(q.z, q.z))) ),
+        _mm_mul_ps( two, _mm_add_ps(_mm_mul_ps(q.y, q.z), _mm_mul_ps(q.w, q.x)) )
+    };
+    return v;
+}
+
+// the rotation of bone j as quaternion and matrix, for the skeletons of the lanes that exist
+static void StoreRotation( const Quaternion4x4& q, UINT lane, UINT j, NUI_SKELETON_BONE_ROTATION NUI_SKELETON_BONE_ORIENTATION::* pRotation,
+    _Inout_ NUI_SKELETON_BONE_ORIENTATION* pOrientations )
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+
+    __m128 xx = _mm_mul_ps(q.x, q.x), yy = _mm_mul_ps(q.y, q.y), zz = _mm_mul_ps(q.z, q.z);
+    __m128 xy = _mm_mul_ps(q.x, q.y), xz = _mm_mul_ps(q.x, q.z), yz = _mm_mul_ps(q.y, q.z);
+    __m128 wx = _mm_mul_ps(q.w, q.x), wy = _mm_mul_ps(q.w, q.y), wz = _mm_mul_ps(q.w, q.z);
+
+    // rows are the X, Y and Z axes
+    float m[9][4];
+    _mm_storeu_ps( m[0], _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))) );
+    _mm_storeu_ps( m[1], _mm_mul_ps(two, _mm_add_ps(xy, wz)) );
+    _mm_storeu_ps( m[2], _mm_mul_ps(two, _mm_sub_ps(xz, wy)) );
+    _mm_storeu_ps( m[3], _mm_mul_ps(two, _mm_sub_ps(xy, wz)) );
+    _mm_storeu_ps( m[4], _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))) );
+    _mm_storeu_ps( m[5], _mm_mul_ps(two, _mm_add_ps(yz, wx)) );
+    _mm_storeu_ps( m[6], _mm_mul_ps(two, _mm_add_ps(xz, wy)) );
+    _mm_storeu_ps( m[7], _mm_mul_ps(two, _mm_sub_ps(yz, wx)) );
+    _mm_storeu_ps( m[8], _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))) );
+
+    float quaternion[4][4];
+    _mm_storeu_ps( quaternion[0], q.x );
+    _mm_storeu_ps( quaternion[1], q.y );
+    _mm_storeu_ps( quaternion[2], q.z );
+    _mm_storeu_ps( quaternion[3], q.w );
+
+    for( UINT i = 0; i < 4 && lane + i < NUI_SKELETON_COUNT; ++i )
+    {
+        NUI_SKELETON_BONE_ROTATION& rotation = pOrientations[(lane + i) * NUI_SKELETON_POSITION_COUNT + j].*pRotation;
+
+        Matrix4& matrix = rotation.rotationMatrix;
+        matrix.M11 = m[0][i]; matrix.M12 = m[1][i]; matrix.M13 = m[2][i]; matrix.M14 = 0.0f;
+        matrix.M21 = m[3][i]; matrix.M22 = m[4][i]; matrix.M23 = m[5][i]; matrix.M24 = 0.0f;
+        matrix.M31 = m[6][i]; matrix.M32 = m[7][i]; matrix.M33 = m[8][i]; matrix.M34 = 0.0f;
+        matrix.M41 = 0.0f;    matrix.M42 = 0.0f;    matrix.M43 = 0.0f;    matrix.M44 = 1.0f;
+
+        rotation.rotationQuaternion.x = quaternion[0][i];
+        rotation.rotationQuaternion.y = quaternion[1][i];
+        rotation.rotationQuaternion.z = quaternion[2][i];
+        rotation.rotationQuaternion.w = quaternion[3][i];
+    }
+}
+
+BoneOrientations::BoneOrientations()
+    : m_cAngles(0)
+{
+    ZeroMemory( m_angles, sizeof(m_angles) );
+}
+
+HRESULT BoneOrientations::SetJointAngles( ULONG cAngles, _In_opt_count_(cAngles) const KINECT_JOINT_ANGLE* pAngles )
+{
+    if( nullptr == pAngles )
+    {
+        cAngles = 0;
+    }
+
+    if( cAngles > BONE_MAX_JOINT_ANGLES )
+    {
+        return E_INVALIDARG;
+    }
+
+    for( ULONG i = 0; i < cAngles; ++i )
+    {
+        const KINECT_JOINT_ANGLE& angle = pAngles[i];
+        if( static_cast<UINT>(angle.eFirstJoint) >= NUI_SKELETON_POSITION_COUNT
+            || static_cast<UINT>(angle.eCenterJoint) >= NUI_SKELETON_POSITION_COUNT
+            || static_cast<UINT>(angle.eSecondJoint) >= NUI_SKELETON_POSITION_COUNT
+            || angle.eCenterJoint == angle.eFirstJoint
+            || angle.eCenterJoint == angle.eSecondJoint )
+        {
+            return E_INVALIDARG;
+        }
+    }
+
+    m_cAngles = cAngles;
+    if( cAngles > 0 )
+    {
+        memcpy( m_angles, pAngles, cAngles * sizeof(KINECT_JOINT_ANGLE) );
+    }
+
+    return S_OK;
+}
+
+void BoneOrientations::Gather( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _Out_ Joints& joints )
+{
+    ZeroMemory( &joints, sizeof(joints) );
+
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        if( NUI_SKELETON_TRACKED != skeleton.eTrackingState )
+        {
+            continue;
+        }
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            joints.x[j][s] = skeleton.SkeletonPositions[j].x;
+            joints.y[j][s] = skeleton.SkeletonPositions[j].y;
+            joints.z[j][s] = skeleton.SkeletonPositions[j].z;
+            joints.valid[j][s] = (NUI_SKELETON_POSITION_NOT_TRACKED != skeleton.eSkeletonPositionTrackingState[j]) ? 0xffffffff : 0;
+        }
+    }
+}
+
+void BoneOrientations::GetBoneOrientations( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _Out_ NUI_SKELETON_BONE_ORIENTATION* pOrientations ) const
+{
+    Joints joints;
+    Gather( skeletonFrame, joints );
+
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            NUI_SKELETON_BONE_ORIENTATION& orientation = pOrientations[s * NUI_SKELETON_POSITION_COUNT + j];
+            orientation.startJoint = SKELETON_PARENT_JOINTS[j];
+            orientation.endJoint = static_cast<NUI_SKELETON_POSITION_INDEX>(j);
+        }
+    }
+
+    for( UINT lane = 0; lane < NUI_SKELETON_COUNT; lane += 4 )
+    {
+        Quaternion4x4 absolute[NUI_SKELETON_POSITION_COUNT];
+
+        // the hip center, up the spine and across the hips
+        {
+            Vector4x4 hipCenter = LoadJoint( joints.x[NUI_SKELETON_POSITION_HIP_CENTER], joints.y[NUI_SKELETON_POSITION_HIP_CENTER], joints.z[NUI_SKELETON_POSITION_HIP_CENTER], lane );
+            Vector4x4 spine = LoadJoint( joints.x[NUI_SKELETON_POSITION_SPINE], joints.y[NUI_SKELETON_POSITION_SPINE], joints.z[NUI_SKELETON_POSITION_SPINE], lane );
+            Vector4x4 hipLeft = LoadJoint( joints.x[NUI_SKELETON_POSITION_HIP_LEFT], joints.y[NUI_SKELETON_POSITION_HIP_LEFT], joints.z[NUI_SKELETON_POSITION_HIP_LEFT], lane );
+            Vector4x4 hipRight = LoadJoint( joints.x[NUI_SKELETON_POSITION_HIP_RIGHT], joints.y[NUI_SKELETON_POSITION_HIP_RIGHT], joints.z[NUI_SKELETON_POSITION_HIP_RIGHT], lane );
+
+            Vector4x4 axisY = Normalize( Subtract(spine, hipCenter) );
+            Vector4x4 across = Subtract( hipRight, hipLeft );
+            __m128 along = Dot( across, axisY );
+            Vector4x4 acrossY = { _mm_mul_ps(along, axisY.x), _mm_mul_ps(along, axisY.y), _mm_mul_ps(along, axisY.z) };
+            Vector4x4 axisX = Normalize( Subtract(across, acrossY) );
+            Vector4x4 axisZ = Cross( axisX, axisY );
+
+            __m128 valid = _mm_and_ps(
+                _mm_and_ps(_mm_loadu_ps(reinterpret_cast<const float*>(joints.valid[NUI_SKELETON_POSITION_HIP_CENTER] + lane)),
+                           _mm_loadu_ps(reinterpret_cast<const float*>(joints.valid[NUI_SKELETON_POSITION_SPINE] + lane))),
+                _mm_and_ps(_mm_loadu_ps(reinterpret_cast<const float*>(joints.valid[NUI_SKELETON_POSITION_HIP_LEFT] + lane)),
+                           _mm_loadu_ps(reinterpret_cast<const float*>(joints.valid[NUI_SKELETON_POSITION_HIP_RIGHT] + lane))) );
+
+            absolute[NUI_SKELETON_POSITION_HIP_CENTER] = Select( valid, FromAxes(axisX, axisY, axisZ), Identity() );
+
+            StoreRotation( absolute[NUI_SKELETON_POSITION_HIP_CENTER], lane, NUI_SKELETON_POSITION_HIP_CENTER, &NUI_SKELETON_BONE_ORIENTATION::absoluteRotation, pOrientations );
+            StoreRotation( absolute[NUI_SKELETON_POSITION_HIP_CENTER], lane, NUI_SKELETON_POSITION_HIP_CENTER, &NUI_SKELETON_BONE_ORIENTATION::hierarchicalRotation, pOrientations );
+        }
+
+        // every other bone turned from its parent, parents come first
+        for( UINT j = NUI_SKELETON_POSITION_HIP_CENTER + 1; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            UINT parent = SKELETON_PARENT_JOINTS[j];
+
+            Vector4x4 start = LoadJoint( joints.x[parent], joints.y[parent], joints.z[parent], lane );
+            Vector4x4 end = LoadJoint( joints.x[j], joints.y[j], joints.z[j], lane );
+            Vector4x4 bone = Normalize( Subtract(end, start) );
+
+            __m128 valid = _mm_and_ps( _mm_loadu_ps(reinterpret_cast<const float*>(joints.valid[parent] + lane)),
+                                       _mm_loadu_ps(reinterpret_cast<const float*>(joints.valid[j] + lane)) );
+
+            Quaternion4x4 arc = Select( valid, FromArc(AxisY(absolute[parent]), bone), Identity() );
+            absolute[j] = Normalize( Multiply(arc, absolute[parent]) );
+            Quaternion4x4 hierarchical = Multiply( Conjugate(absolute[parent]), absolute[j] );
+
+            StoreRotation( absolute[j], lane, j, &NUI_SKELETON_BONE_ORIENTATION::absoluteRotation, pOrientations );
+            StoreRotation( hierarchical, lane, j, &NUI_SKELETON_BONE_ORIENTATION::hierarchicalRotation, pOrientations );
+        }
+    }
+}
+
+void BoneOrientations::GetJointAngles( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _Out_ float* pAngles ) const
+{
+    if( 0 == m_cAngles )
+    {
+        return;
+    }
+
+    Joints joints;
+    Gather( skeletonFrame, joints );
+
+    for( ULONG a = 0; a < m_cAngles; ++a )
+    {
+        const KINECT_JOINT_ANGLE& angle = m_angles[a];
+
+        for( UINT lane = 0; lane < NUI_SKELETON_COUNT; lane += 4 )
+        {
+            Vector4x4 center = LoadJoint( joints.x[angle.eCenterJoint], joints.y[angle.eCenterJoint], joints.z[angle.eCenterJoint], lane );
+            Vector4x4 first = Subtract( LoadJoint(joints.x[angle.eFirstJoint], joints.y[angle.eFirstJoint], joints.z[angle.eFirstJoint], lane), center );
+            Vector4x4 second = Subtract( LoadJoint(joints.x[angle.eSecondJoint], joints.y[angle.eSecondJoint], joints.z[angle.eSecondJoint], lane), center );
+
+            // atan2 of |a x b| and a . b stays accurate near 0 and 180 degrees, unlike acos
+            Vector4x4 normal = Cross( first, second );
+            float sine[4], cosine[4];
+            _mm_storeu_ps( sine, _mm_sqrt_ps(Dot(normal, normal)) );
+            _mm_storeu_ps( cosine, Dot(first, second) );
+
+            for( UINT i = 0; i < 4 && lane + i < NUI_SKELETON_COUNT; ++i )
+            {
+                UINT s = lane + i;
+                bool bValid = 0 != (joints.valid[angle.eCenterJoint][s] & joints.valid[angle.eFirstJoint][s] & joints.valid[angle.eSecondJoint][s]);
+
+                pAngles[s * m_cAngles + a] = bValid ? atan2f(sine[i], cosine[i]) * BONE_DEGREES_PER_RADIAN : std::numeric_limits<float>::quiet_NaN();
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+#include "SkeletonBones.h"
+
+// skeletons of a frame rounded up to the 4 lanes of SSE
+#define BONE_ORIENTATION_LANES      8
+
+// joint angles that can be set
+#define BONE_MAX_JOINT_ANGLES       64
+
+// orientations of the bones and angles at the joints of the skeletons of a frame
+// the skeletons are the lanes, every bone is computed for 4 skeletons at a time in a pass
+// in joint order, so the parent of a bone is always done before it
+//
+// the Y axis of a bone runs from its parent joint to its joint; the hip center takes its X
+// axis from the hip left to the hip right, every other bone is the orientation of its parent
+// turned by the shortest arc from the parent bone to it, which keeps the twist of the parent
+// the rotation matrices have the X, Y and Z axes of the bone in camera space as rows
+class BoneOrientations
+{
+public:
+    BoneOrientations();
+
+    // pAngles - nullptr or cAngles 0 removes every angle
+    HRESULT SetJointAngles( ULONG cAngles, _In_opt_count_(cAngles) const KINECT_JOINT_ANGLE* pAngles );
+    ULONG GetJointAngleCount() const { return m_cAngles; }
+
+    // NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT orientations, skeleton by skeleton
+    void GetBoneOrientations( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _Out_ NUI_SKELETON_BONE_ORIENTATION* pOrientations ) const;
+
+    // NUI_SKELETON_COUNT * GetJointAngleCount() angles in degrees, skeleton by skeleton
+    void GetJointAngles( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _Out_ float* pAngles ) const;
+
+private:
+    // joints of the skeletons as structure of arrays, lane s is skeleton s
+    struct Joints
+    {
+        float x[NUI_SKELETON_POSITION_COUNT][BONE_ORIENTATION_LANES];
+        float y[NUI_SKELETON_POSITION_COUNT][BONE_ORIENTATION_LANES];
+        float z[NUI_SKELETON_POSITION_COUNT][BONE_ORIENTATION_LANES];
+        UINT32 valid[NUI_SKELETON_POSITION_COUNT][BONE_ORIENTATION_LANES];
+    };
+
+    static void Gather( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _Out_ Joints& joints );
+
+private:
+    ULONG m_cAngles;
+    KINECT_JOINT_ANGLE m_angles[BONE_MAX_JOINT_ANGLES];
+};
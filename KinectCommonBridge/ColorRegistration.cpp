@@ -0,0 +1,52 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "ColorRegistration.h"
+
+template <typename PIXEL>
+static void RegisterBand(
+    size_t begin, size_t end, _In_ const PIXEL* pSrc, _In_ const NUI_DEPTH_IMAGE_POINT* pDepthPoints,
+    ULONG width, ULONG height, _Inout_ PIXEL* pDst )
+{
+    for( size_t index = begin; index < end; ++index )
+    {
+        const NUI_DEPTH_IMAGE_POINT& depthPoint = pDepthPoints[index];
+
+        // negative coordinates wrap around, so one unsigned compare per axis is enough
+        if( static_cast<ULONG>(depthPoint.x) < width && static_cast<ULONG>(depthPoint.y) < height )
+        {
+            pDst[depthPoint.y * width + depthPoint.x] = pSrc[index];
+        }
+    }
+}
+
+void ColorRegistration::RegisterBand( size_t begin, size_t end, ULONG bpp, _In_ const BYTE* pSrc, _In_ const NUI_DEPTH_IMAGE_POINT* pDepthPoints,
+    ULONG width, ULONG height, _Inout_ BYTE* pDst )
+{
+    switch( bpp )
+    {
+    case 4:
+        ::RegisterBand( begin, end, reinterpret_cast<const UINT32*>(pSrc), pDepthPoints,
+            width, height, reinterpret_cast<UINT32*>(pDst) );
+        break;
+    case 2:
+        ::RegisterBand( begin, end, reinterpret_cast<const USHORT*>(pSrc), pDepthPoints,
+            width, height, reinterpret_cast<USHORT*>(pDst) );
+        break;
+    default:
+        ::RegisterBand( begin, end, pSrc, pDepthPoints, width, height, pDst );
+    }
+}
@@ -0,0 +1,32 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// registers the color frame to the depth frame, the color pixel of every depth image point
+// is copied to the position of that point in the depth aligned image
+// a pixel is a single UINT32, USHORT or BYTE store, and a point is mapped with one unsigned
+// compare per axis
+class ColorRegistration
+{
+public:
+    // registers the color pixels [begin, end) into the depth aligned image
+    // pSrc - tightly packed color frame, bpp bytes per pixel (4 BGRX, 2 infrared, 1 Bayer)
+    // pDepthPoints - one point per color pixel, points outside width x height are not mapped
+    // pDst - width x height pixels of bpp bytes
+    static void RegisterBand( size_t begin, size_t end, ULONG bpp, _In_ const BYTE* pSrc, _In_ const NUI_DEPTH_IMAGE_POINT* pDepthPoints,
+        ULONG width, ULONG height, _Inout_ BYTE* pDst );
+};
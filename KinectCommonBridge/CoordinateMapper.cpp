@@ -17,6 +17,8 @@ See the Apache 2 License for the specific language governing permissions and lim
 #include "CoordinateMapper.h"
 #include "AutoLock.h"
 
+#include <algorithm>
+
 CoordinateMapper::CoordinateMapper()
     : m_pNuiSensor(nullptr)
     , m_pNuiCoordinateMapper(nullptr)
@@ -34,6 +36,7 @@ void CoordinateMapper::RemoveDevice()
 
     m_pNuiCoordinateMapper.Release();
     m_pNuiSensor.Release();
+    m_colorFits.clear();
 }
 
 void CoordinateMapper::AttachDevice( _In_ INuiSensor* pNuiSensor )
@@ -53,6 +56,111 @@ void CoordinateMapper::AttachDevice( _In_ INuiSensor* pNuiSensor )
 
     pNuiSensor->AddRef();
     m_pNuiSensor.Attach( pNuiSensor );
+
+    // another sensor, another calibration
+    m_pNuiCoordinateMapper.Release();
+    m_colorFits.clear();
+}
+
+void CoordinateMapper::SetColorTransform( const KINECT_IMAGE_TRANSFORM& transform )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_colorTransform.SetParameters( transform );
+}
+
+void CoordinateMapper::SetDepthTransform( const KINECT_IMAGE_TRANSFORM& transform )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_depthTransform.SetParameters( transform );
+}
+
+// only arrays that cover the whole frame can be reordered, anything else is passed through
+static bool IsFrameSized( NUI_IMAGE_RESOLUTION eResolution, DWORD count, _Out_ DWORD& width, _Out_ DWORD& height )
+{
+    width = height = 0;
+    NuiImageResolutionToSize( eResolution, width, height );
+
+    return 0 != count && width * height == count;
+}
+
+NUI_DEPTH_IMAGE_PIXEL* CoordinateMapper::GetNativeDepthPixels( NUI_IMAGE_RESOLUTION eDepthResolution, DWORD cDepthPixels, _In_count_(cDepthPixels) NUI_DEPTH_IMAGE_PIXEL* pDepthPixels )
+{
+    DWORD width, height;
+    if( m_depthTransform.IsIdentity() || nullptr == pDepthPixels || !IsFrameSized( eDepthResolution, cDepthPixels, width, height ) )
+    {
+        return pDepthPixels;
+    }
+
+    // the caller has the transformed image
+    UINT transformedWidth, transformedHeight;
+    m_depthTransform.GetOutputSize( width, height, transformedWidth, transformedHeight );
+
+    m_nativeDepthPixels.resize( cDepthPixels );
+    m_depthTransform.Reorder( pDepthPixels, transformedWidth, transformedHeight, true, m_nativeDepthPixels.data() );
+
+    return m_nativeDepthPixels.data();
+}
+
+template <typename T>
+T* CoordinateMapper::GetNativeResult( const ImageTransform& transform, NUI_IMAGE_RESOLUTION eResolution, DWORD cPoints, _In_ T* pPoints )
+{
+    DWORD width, height;
+    if( transform.IsIdentity() || nullptr == pPoints || !IsFrameSized( eResolution, cPoints, width, height ) )
+    {
+        return pPoints;
+    }
+
+    m_nativeResult.resize( cPoints * sizeof(T) );
+
+    return reinterpret_cast<T*>( m_nativeResult.data() );
+}
+
+template <typename T>
+void CoordinateMapper::ReorderResult( const ImageTransform& transform, NUI_IMAGE_RESOLUTION eResolution, _In_ const T* pNative, _Out_ T* pPoints )
+{
+    if( pNative == pPoints )
+    {
+        return;
+    }
+
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eResolution, width, height );
+
+    transform.Reorder( pNative, width, height, false, pPoints );
+}
+
+void CoordinateMapper::TransformDepthPoints( NUI_IMAGE_RESOLUTION eDepthResolution, DWORD cDepthPoints, _Inout_cap_(cDepthPoints) NUI_DEPTH_IMAGE_POINT* pDepthPoints )
+{
+    if( m_depthTransform.IsIdentity() || nullptr == pDepthPoints )
+    {
+        return;
+    }
+
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eDepthResolution, width, height );
+
+    for( DWORD i = 0; i < cDepthPoints; ++i )
+    {
+        m_depthTransform.TransformPoint( width, height, pDepthPoints[i].x, pDepthPoints[i].y, pDepthPoints[i].x, pDepthPoints[i].y );
+    }
+}
+
+void CoordinateMapper::TransformColorPoints( NUI_IMAGE_RESOLUTION eColorResolution, DWORD cColorPoints, _Inout_cap_(cColorPoints) NUI_COLOR_IMAGE_POINT* pColorPoints )
+{
+    if( m_colorTransform.IsIdentity() || nullptr == pColorPoints )
+    {
+        return;
+    }
+
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eColorResolution, width, height );
+
+    for( DWORD i = 0; i < cColorPoints; ++i )
+    {
+        m_colorTransform.TransformPoint( width, height, pColorPoints[i].x, pColorPoints[i].y, pColorPoints[i].x, pColorPoints[i].y );
+    }
 }
 
 HRESULT CoordinateMapper::IsSensorValid()
@@ -88,11 +196,22 @@ HRESULT CoordinateMapper::MapColorFrameToDepthFrame(
         return hr;
     }
 
-    return m_pNuiCoordinateMapper->MapColorFrameToDepthFrame(
+    NUI_DEPTH_IMAGE_PIXEL* pNativePixels = GetNativeDepthPixels( eDepthResolution, cDepthPixels, pDepthPixels );
+    NUI_DEPTH_IMAGE_POINT* pNativePoints = GetNativeResult( m_colorTransform, eColorResolution, cDepthPoints, pDepthPoints );
+
+    hr = m_pNuiCoordinateMapper->MapColorFrameToDepthFrame(
         eColorType, eColorResolution, 
         eDepthResolution,
-        cDepthPixels, pDepthPixels,
-        cDepthPoints, pDepthPoints );
+        cDepthPixels, pNativePixels,
+        cDepthPoints, pNativePoints );
+
+    if( SUCCEEDED(hr) )
+    {
+        ReorderResult( m_colorTransform, eColorResolution, pNativePoints, pDepthPoints );
+        TransformDepthPoints( eDepthResolution, cDepthPoints, pDepthPoints );
+    }
+
+    return hr;
 }
 
 HRESULT CoordinateMapper::MapColorFrameToSkeletonFrame(
@@ -109,10 +228,20 @@ HRESULT CoordinateMapper::MapColorFrameToSkeletonFrame(
         return hr;
     }
 
-    return m_pNuiCoordinateMapper->MapColorFrameToSkeletonFrame(
+    NUI_DEPTH_IMAGE_PIXEL* pNativePixels = GetNativeDepthPixels( eDepthResolution, cDepthPixels, pDepthPixels );
+    Vector4* pNativePoints = GetNativeResult( m_colorTransform, eColorResolution, cSkeletonPoints, pSkeletonPoints );
+
+    hr = m_pNuiCoordinateMapper->MapColorFrameToSkeletonFrame(
         eColorType, eColorResolution, eDepthResolution,
-        cDepthPixels, pDepthPixels, 
-        cSkeletonPoints, pSkeletonPoints );
+        cDepthPixels, pNativePixels, 
+        cSkeletonPoints, pNativePoints );
+
+    if( SUCCEEDED(hr) )
+    {
+        ReorderResult( m_colorTransform, eColorResolution, pNativePoints, pSkeletonPoints );
+    }
+
+    return hr;
 }
 
 HRESULT CoordinateMapper::MapDepthFrameToColorFrame(
@@ -129,11 +258,22 @@ HRESULT CoordinateMapper::MapDepthFrameToColorFrame(
         return hr;
     }
 
-    return m_pNuiCoordinateMapper->MapDepthFrameToColorFrame( 
+    NUI_DEPTH_IMAGE_PIXEL* pNativePixels = GetNativeDepthPixels( eDepthResolution, cDepthPixels, pDepthPixels );
+    NUI_COLOR_IMAGE_POINT* pNativePoints = GetNativeResult( m_depthTransform, eDepthResolution, cColorPoints, pColorPoints );
+
+    hr = m_pNuiCoordinateMapper->MapDepthFrameToColorFrame( 
         eDepthResolution, 
-        cDepthPixels, pDepthPixels, 
+        cDepthPixels, pNativePixels, 
         eColorType, eColorResolution, 
-        cColorPoints, pColorPoints );
+        cColorPoints, pNativePoints );
+
+    if( SUCCEEDED(hr) )
+    {
+        ReorderResult( m_depthTransform, eDepthResolution, pNativePoints, pColorPoints );
+        TransformColorPoints( eColorResolution, cColorPoints, pColorPoints );
+    }
+
+    return hr;
 }
 
 HRESULT CoordinateMapper::MapDepthFrameToSkeletonFrame(
@@ -149,10 +289,20 @@ HRESULT CoordinateMapper::MapDepthFrameToSkeletonFrame(
         return hr;
     }
 
-    return m_pNuiCoordinateMapper->MapDepthFrameToSkeletonFrame(
+    NUI_DEPTH_IMAGE_PIXEL* pNativePixels = GetNativeDepthPixels( eDepthResolution, cDepthPixels, pDepthPixels );
+    Vector4* pNativePoints = GetNativeResult( m_depthTransform, eDepthResolution, cSkeletonPoints, pSkeletonPoints );
+
+    hr = m_pNuiCoordinateMapper->MapDepthFrameToSkeletonFrame(
         eDepthResolution, 
-        cDepthPixels, pDepthPixels, 
-        cSkeletonPoints, pSkeletonPoints);
+        cDepthPixels, pNativePixels, 
+        cSkeletonPoints, pNativePoints);
+
+    if( SUCCEEDED(hr) )
+    {
+        ReorderResult( m_depthTransform, eDepthResolution, pNativePoints, pSkeletonPoints );
+    }
+
+    return hr;
 }
 
 HRESULT CoordinateMapper::MapDepthPointToColorPoint(
@@ -168,10 +318,31 @@ HRESULT CoordinateMapper::MapDepthPointToColorPoint(
         return hr;
     }
 
-    return m_pNuiCoordinateMapper->MapDepthPointToColorPoint(
-        eDepthResolution, pDepthPoint, 
+    if( nullptr == pDepthPoint )
+    {
+        return E_POINTER;
+    }
+
+    // the caller point is in the transformed depth image
+    NUI_DEPTH_IMAGE_POINT depthPoint = *pDepthPoint;
+    if( !m_depthTransform.IsIdentity() )
+    {
+        DWORD width = 0, height = 0;
+        NuiImageResolutionToSize( eDepthResolution, width, height );
+        m_depthTransform.InverseTransformPoint( width, height, pDepthPoint->x, pDepthPoint->y, depthPoint.x, depthPoint.y );
+    }
+
+    hr = m_pNuiCoordinateMapper->MapDepthPointToColorPoint(
+        eDepthResolution, &depthPoint, 
         eColorType, eColorResolution, 
         pColorPoint );
+
+    if( SUCCEEDED(hr) )
+    {
+        TransformColorPoints( eColorResolution, 1, pColorPoint );
+    }
+
+    return hr;
 }
 
 
@@ -187,8 +358,21 @@ HRESULT CoordinateMapper::MapDepthPointToSkeletonPoint(
         return hr;
     }
 
+    if( nullptr == pDepthPoint )
+    {
+        return E_POINTER;
+    }
+
+    NUI_DEPTH_IMAGE_POINT depthPoint = *pDepthPoint;
+    if( !m_depthTransform.IsIdentity() )
+    {
+        DWORD width = 0, height = 0;
+        NuiImageResolutionToSize( eDepthResolution, width, height );
+        m_depthTransform.InverseTransformPoint( width, height, pDepthPoint->x, pDepthPoint->y, depthPoint.x, depthPoint.y );
+    }
+
     return m_pNuiCoordinateMapper->MapDepthPointToSkeletonPoint(
-        eDepthResolution, pDepthPoint,
+        eDepthResolution, &depthPoint,
         pSkeletonPoint );
 }
 
@@ -205,10 +389,17 @@ HRESULT CoordinateMapper::MapSkeletonPointToColorPoint(
         return hr;
     }
 
-    return m_pNuiCoordinateMapper->MapSkeletonPointToColorPoint(
+    hr = m_pNuiCoordinateMapper->MapSkeletonPointToColorPoint(
         pSkeletonPoint, 
         eColorType, eColorResolution,
         pColorPoint );
+
+    if( SUCCEEDED(hr) )
+    {
+        TransformColorPoints( eColorResolution, 1, pColorPoint );
+    }
+
+    return hr;
 }
 
 HRESULT CoordinateMapper::MapSkeletonPointToDepthPoint(
@@ -224,10 +415,135 @@ HRESULT CoordinateMapper::MapSkeletonPointToDepthPoint(
         return hr;
     }
 
-    return m_pNuiCoordinateMapper->MapSkeletonPointToDepthPoint(
+    hr = m_pNuiCoordinateMapper->MapSkeletonPointToDepthPoint(
         pSkeletonPoint,
         eDepthResolution,
         pDepthPoint );
+
+    if( SUCCEEDED(hr) )
+    {
+        TransformDepthPoints( eDepthResolution, 1, pDepthPoint );
+    }
+
+    return hr;
+}
+
+const SkeletonProjector::ColorProjection* CoordinateMapper::GetColorProjection( NUI_IMAGE_TYPE eColorType, NUI_IMAGE_RESOLUTION eColorResolution )
+{
+    ColorMode mode( eColorType, eColorResolution );
+    std::map<ColorMode, ColorFit>::iterator it = m_colorFits.find( mode );
+    if( m_colorFits.end() == it )
+    {
+        // the sensor maps a grid of points once, the fit stands in for it from then on
+        std::vector<Vector4> points;
+        SkeletonProjector::GetCalibrationPoints( points );
+
+        std::vector<NUI_COLOR_IMAGE_POINT> colorPoints( points.size() );
+
+        ColorFit fit = { false };
+        bool bMapped = true;
+        for( size_t i = 0; i < points.size() && bMapped; ++i )
+        {
+            bMapped = SUCCEEDED( m_pNuiCoordinateMapper->MapSkeletonPointToColorPoint( &points[i], eColorType, eColorResolution, &colorPoints[i] ) );
+        }
+
+        if( bMapped )
+        {
+            fit.bFitted = SkeletonProjector::FitColorProjection( eColorResolution, static_cast<UINT>(points.size()), points.data(), colorPoints.data(), fit.projection );
+        }
+
+        it = m_colorFits.insert( std::make_pair( mode, fit ) ).first;
+    }
+
+    return it->second.bFitted ? &it->second.projection : nullptr;
+}
+
+HRESULT CoordinateMapper::MapSkeletonFrameToImages(
+    _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+    _Inout_ KINECT_SKELETON_PROJECTION* pProjection )
+{
+    AutoLock lock( m_nuiLock );
+
+    if( nullptr == pSkeletonFrame || nullptr == pProjection || pProjection->dwStructSize != sizeof(KINECT_SKELETON_PROJECTION) )
+    {
+        return E_INVALIDARG;
+    }
+
+    NUI_DEPTH_IMAGE_POINT* pDepthPoints = pProjection->pDepthPoints;
+    NUI_COLOR_IMAGE_POINT* pColorPoints = pProjection->pColorPoints;
+
+    // the depth camera is a pinhole of its own, only color needs the sensor
+    const SkeletonProjector::ColorProjection* pColorProjection = nullptr;
+    if( nullptr != pColorPoints )
+    {
+        HRESULT hr = IsSensorValid();
+        if( FAILED(hr) )
+        {
+            return hr;
+        }
+
+        pColorProjection = GetColorProjection( pProjection->eColorType, pProjection->eColorResolution );
+    }
+
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = pSkeletonFrame->SkeletonData[s];
+        bool bTracked = (NUI_SKELETON_TRACKED == skeleton.eTrackingState);
+
+        if( nullptr != pDepthPoints )
+        {
+            NUI_DEPTH_IMAGE_POINT* pSkeletonPoints = pDepthPoints + s * NUI_SKELETON_POSITION_COUNT;
+            if( bTracked )
+            {
+                SkeletonProjector::ProjectToDepth( pProjection->eDepthResolution, NUI_SKELETON_POSITION_COUNT, skeleton.SkeletonPositions, pSkeletonPoints );
+                TransformDepthPoints( pProjection->eDepthResolution, NUI_SKELETON_POSITION_COUNT, pSkeletonPoints );
+            }
+
+            for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+            {
+                if( !bTracked || NUI_SKELETON_POSITION_NOT_TRACKED == skeleton.eSkeletonPositionTrackingState[j] )
+                {
+                    ZeroMemory( &pSkeletonPoints[j], sizeof(NUI_DEPTH_IMAGE_POINT) );
+                }
+            }
+        }
+
+        if( nullptr != pColorPoints )
+        {
+            NUI_COLOR_IMAGE_POINT* pSkeletonPoints = pColorPoints + s * NUI_SKELETON_POSITION_COUNT;
+
+            // joints the sensor could not map are 0 like the ones not tracked
+            bool bMapped[NUI_SKELETON_POSITION_COUNT];
+            std::fill( bMapped, bMapped + NUI_SKELETON_POSITION_COUNT, true );
+
+            if( bTracked )
+            {
+                if( nullptr != pColorProjection )
+                {
+                    SkeletonProjector::ProjectToColor( *pColorProjection, NUI_SKELETON_POSITION_COUNT, skeleton.SkeletonPositions, pSkeletonPoints );
+                }
+                else
+                {
+                    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+                    {
+                        Vector4 point = skeleton.SkeletonPositions[j];
+                        bMapped[j] = SUCCEEDED( m_pNuiCoordinateMapper->MapSkeletonPointToColorPoint( &point, pProjection->eColorType, pProjection->eColorResolution, &pSkeletonPoints[j] ) );
+                    }
+                }
+                TransformColorPoints( pProjection->eColorResolution, NUI_SKELETON_POSITION_COUNT, pSkeletonPoints );
+            }
+
+            for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+            {
+                if( !bTracked || NUI_SKELETON_POSITION_NOT_TRACKED == skeleton.eSkeletonPositionTrackingState[j] || !bMapped[j] )
+                {
+                    ZeroMemory( &pSkeletonPoints[j], sizeof(NUI_COLOR_IMAGE_POINT) );
+                }
+            }
+        }
+    }
+
+    return S_OK;
 }
 
 NUI_COLOR_IMAGE_POINT* CoordinateMapper::CreateColorPoints(NUI_IMAGE_RESOLUTION eResolution, _Inout_ DWORD& cPointCount)
@@ -16,6 +16,8 @@ See the Apache 2 License for the specific language governing permissions and lim
 
 #include "KinectCommonBridgeLib.h"
 #include "CriticalSection.h"
+#include "ImageTransform.h"
+#include "SkeletonProjector.h"
 #include <memory>
 
 class CoordinateMapper
@@ -27,6 +29,11 @@ public:
     void AttachDevice( _In_ INuiSensor* pNuiSensor );
     void RemoveDevice();
 
+    // orientation of the images the caller works with
+    // pixels and points going in are mapped back to the sensor layout, results are mapped forward
+    void SetColorTransform( const KINECT_IMAGE_TRANSFORM& transform );
+    void SetDepthTransform( const KINECT_IMAGE_TRANSFORM& transform );
+
     HRESULT MapColorFrameToDepthFrame(
          NUI_IMAGE_TYPE eColorType, NUI_IMAGE_RESOLUTION eColorResolution,
          NUI_IMAGE_RESOLUTION eDepthResolution,
@@ -72,6 +79,11 @@ public:
          NUI_IMAGE_RESOLUTION eDepthResolution,
          _Inout_ NUI_DEPTH_IMAGE_POINT *pDepthPoint);
 
+    // every joint of the tracked skeletons, natively
+    HRESULT MapSkeletonFrameToImages(
+        _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+        _Inout_ KINECT_SKELETON_PROJECTION* pProjection );
+
     NUI_COLOR_IMAGE_POINT* CreateColorPoints( NUI_IMAGE_RESOLUTION eDepthResolution, _Inout_ DWORD& cColorPoints );
     NUI_DEPTH_IMAGE_PIXEL* CreateDepthPixels( NUI_IMAGE_RESOLUTION eDepthResolution, _Inout_ DWORD& cDepthPixels);
     NUI_DEPTH_IMAGE_POINT* CreateDepthPoints( NUI_IMAGE_RESOLUTION eColorResolution, _Inout_ DWORD& cDepthPoints );
@@ -84,9 +96,38 @@ private:
     HRESULT AllocateDepthPoints(NUI_IMAGE_RESOLUTION eColorResolution);
     HRESULT AllocateSkeletonPoints(NUI_IMAGE_RESOLUTION eResolution);
 
+    // depth pixels of the caller in sensor order, either pDepthPixels itself or m_nativeDepthPixels
+    NUI_DEPTH_IMAGE_PIXEL* GetNativeDepthPixels( NUI_IMAGE_RESOLUTION eDepthResolution, DWORD cDepthPixels, _In_count_(cDepthPixels) NUI_DEPTH_IMAGE_PIXEL* pDepthPixels );
+
+    // frame sized results are written to m_nativeResult and reordered for the caller afterwards
+    template <typename T>
+    T* GetNativeResult( const ImageTransform& transform, NUI_IMAGE_RESOLUTION eResolution, DWORD cPoints, _In_ T* pPoints );
+    template <typename T>
+    void ReorderResult( const ImageTransform& transform, NUI_IMAGE_RESOLUTION eResolution, _In_ const T* pNative, _Out_ T* pPoints );
+
+    void TransformDepthPoints( NUI_IMAGE_RESOLUTION eDepthResolution, DWORD cDepthPoints, _Inout_cap_(cDepthPoints) NUI_DEPTH_IMAGE_POINT* pDepthPoints );
+    void TransformColorPoints( NUI_IMAGE_RESOLUTION eColorResolution, DWORD cColorPoints, _Inout_cap_(cColorPoints) NUI_COLOR_IMAGE_POINT* pColorPoints );
+
+    // projection fitted to the sensor mapping of the color resolution, nullptr when it has to be mapped point by point
+    const SkeletonProjector::ColorProjection* GetColorProjection( NUI_IMAGE_TYPE eColorType, NUI_IMAGE_RESOLUTION eColorResolution );
+
 private:
     CriticalSection						m_nuiLock;
     ComSmartPtr<INuiSensor>             m_pNuiSensor;
 
     ComSmartPtr<INuiCoordinateMapper>   m_pNuiCoordinateMapper;
+
+    ImageTransform                      m_colorTransform;
+    ImageTransform                      m_depthTransform;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL>  m_nativeDepthPixels;
+    std::vector<BYTE>                   m_nativeResult;
+
+    // fitted once per color type and resolution of the sensor, the raw Bayer and YUV modes map differently
+    struct ColorFit
+    {
+        bool bFitted;
+        SkeletonProjector::ColorProjection projection;
+    };
+    typedef std::pair<NUI_IMAGE_TYPE, NUI_IMAGE_RESOLUTION> ColorMode;
+    std::map<ColorMode, ColorFit> m_colorFits;
 };
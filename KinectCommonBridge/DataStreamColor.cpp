@@ -16,9 +16,13 @@ See the Apache 2 License for the specific language governing permissions and lim
 
 #include "DataStreamColor.h"
 #include "AutoLock.h"
+#include "ColorRegistration.h"
 
 #include <ppl.h>
 
+// number of color rows registered by a single task when aligning to depth
+static const size_t COLOR_TO_DEPTH_BAND_ROWS = 32;
+
 DataStreamColor::DataStreamColor()
     : DataStream()
     , m_imageType( NUI_IMAGE_TYPE_COLOR )
@@ -140,8 +144,6 @@ void DataStreamColor::SetImageType( NUI_IMAGE_TYPE type )
 }
 void DataStreamColor::SetImageResolution( NUI_IMAGE_RESOLUTION resolution )
 {
-    NuiImageResolutionToSize( m_imageResolution, m_dwWidth, m_dwHeight );
-
     switch (resolution)
     {
     case NUI_IMAGE_RESOLUTION_640x480:
@@ -153,6 +155,9 @@ void DataStreamColor::SetImageResolution( NUI_IMAGE_RESOLUTION resolution )
         break;
     }
 
+    // size has to follow the accepted resolution
+    NuiImageResolutionToSize( m_imageResolution, m_dwWidth, m_dwHeight );
+
 #ifdef KCB_ENABLE_FT
     SetCameraConfig();
 #endif
@@ -177,22 +182,72 @@ void DataStreamColor::GetFrameFormat( _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame
 
     // don't need a sensor to determine the size based on the ImageResolution
     NuiImageResolutionToSize( m_imageResolution, pFrame->dwWidth, pFrame->dwHeight );
+    if( m_transform.SwapsAxes() )
+    {
+        std::swap( pFrame->dwWidth, pFrame->dwHeight );
+    }
 
     // based on the image type set byptes per pixel
+    pFrame->cbBytesPerPixel = GetBytesPerPixel();
+
+    // set the size of the buffer
+    pFrame->cbBufferSize = pFrame->dwWidth * pFrame->dwHeight * pFrame->cbBytesPerPixel;
+}
+
+ULONG DataStreamColor::GetBytesPerPixel() const
+{
     switch( m_imageType )
     {
     case NUI_IMAGE_TYPE_COLOR_RAW_BAYER:
-        pFrame->cbBytesPerPixel = 1;
-        break;
+        return 1;
     case NUI_IMAGE_TYPE_COLOR_INFRARED:
-        pFrame->cbBytesPerPixel = 2;
-        break;
+        return IsToneMapping() ? m_irToneMapper.GetBytesPerPixel() : 2;
     default: // RGB
-        pFrame->cbBytesPerPixel = 4;
+        return 4;
     }
+}
 
-    // set the size of the buffer
-    pFrame->cbBufferSize = pFrame->dwWidth * pFrame->dwHeight * pFrame->cbBytesPerPixel;
+bool DataStreamColor::IsToneMapping() const
+{
+    return NUI_IMAGE_TYPE_COLOR_INFRARED == m_imageType && m_irToneMapper.IsEnabled();
+}
+
+HRESULT DataStreamColor::SetToneMapping( _In_opt_ const KINECT_IR_TONE_MAPPING* pToneMapping )
+{
+    AutoLock lock( m_nuiLock );
+
+    KINECT_IR_TONE_MAPPING params = m_irToneMapper.GetParameters();
+    if( nullptr != pToneMapping )
+    {
+        params = *pToneMapping;
+    }
+    else
+    {
+        params.eMode = IRToneMappingModeNone;
+    }
+
+    return m_irToneMapper.SetParameters( params );
+}
+
+void DataStreamColor::SetTransform( _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_transform.SetParameters( (nullptr != pTransform) ? *pTransform : ImageTransform().GetParameters() );
+}
+
+void DataStreamColor::SetMotionDetection( _In_opt_ const KINECT_MOTION_DETECTION* pMotionDetection )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_motion.SetParameters( pMotionDetection );
+}
+
+HRESULT DataStreamColor::GetMotion( _Inout_ KINECT_MOTION_INFO* pMotionInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap )
+{
+    AutoLock lock( m_nuiLock );
+
+    return m_motion.GetResult( m_transform, pMotionInfo, cbBitmap, pBitmap );
 }
 
 HRESULT DataStreamColor::GetFrameData( ULONG cBufferSize, _Out_cap_(cBufferSize) BYTE* pImageBuffer, _Out_opt_ LONGLONG* liTimeStamp )
@@ -244,78 +299,126 @@ void DataStreamColor::CopyData( _In_ void* pImageFrame )
         return;
     }
 
-    if (nullptr != m_pDepthPoints)
-    {
-        CopyColorToDepth(pFrame);
-    }
-    else
-    {
-        // copy data from the frame
-        INuiFrameTexture* pTexture = pFrame->pFrameTexture;
-
-        // Lock the frame data so the Kinect knows not to modify it while we are reading it
-        NUI_LOCKED_RECT lockedRect;
-        pTexture->LockRect( 0, &lockedRect, NULL, 0 );
-
-        // Make sure we've received valid data
-        if (lockedRect.Pitch != 0)
-        {
-            memcpy_s( m_pImageBuffer, m_cBufferSize, lockedRect.pBits, lockedRect.size );
-        }
-
-        // Unlock frame data
-        pTexture->UnlockRect(0);
-    }
-}
-
-void DataStreamColor::CopyColorToDepth(_In_ NUI_IMAGE_FRAME *pImageFrame)
-{
     // copy data from the frame
-    INuiFrameTexture* pTexture = pImageFrame->pFrameTexture;
+    INuiFrameTexture* pTexture = pFrame->pFrameTexture;
 
     // Lock the frame data so the Kinect knows not to modify it while we are reading it
     NUI_LOCKED_RECT lockedRect;
-    pTexture->LockRect(0, &lockedRect, NULL, 0);
+    pTexture->LockRect( 0, &lockedRect, NULL, 0 );
 
     // Make sure we've received valid data
     if (lockedRect.Pitch != 0)
     {
-        size_t bpp = 4;  // 4bpp - BGR32
-        if (NUI_IMAGE_TYPE_COLOR_INFRARED == m_imageType)
-        {
-            bpp = 2;
-        }
-        else if (NUI_IMAGE_TYPE_COLOR_RAW_BAYER == m_imageType)
+        // every stage writes straight into the caller buffer when it is the last one,
+        // otherwise into a scratch frame the next stage reads from
+        const BYTE* pSrc = lockedRect.pBits;
+        ULONG cbSrc = lockedRect.size;
+        UINT pitch = lockedRect.Pitch;
+        ULONG width = m_dwWidth;
+        ULONG height = m_dwHeight;
+        ULONG bpp = GetBytesPerPixel();
+
+        bool bAligned = (nullptr != m_pDepthPoints);
+        bool bTransform = !m_transform.IsIdentity();
+
+        if( m_motion.IsEnabled() )
         {
-            bpp = 1;
+            if( !IsToneMapping() && !bAligned && !bTransform )
+            {
+                // plain copy, the motion pass copies the rows it reads
+                m_motion.Process( pSrc, pitch, width, height, bpp, m_cBufferSize, m_pImageBuffer );
+                pSrc = nullptr;
+            }
+            else
+            {
+                // motion is always measured on the native frame
+                m_motion.Process( pSrc, pitch, width, height, IsToneMapping() ? sizeof(USHORT) : bpp, 0, nullptr );
+            }
         }
 
-        // total width for a row of pixels
-        size_t dwByteWidthTotal = m_dwWidth * bpp;
-
-        Concurrency::parallel_for(size_t(0), size_t(m_cDepthPoints), [&](size_t index)
-            //for( size_t index = 0; index < m_cbDepthPoints; ++index )
+        if( nullptr != pSrc && IsToneMapping() )
         {
-            NUI_DEPTH_IMAGE_POINT depthPoint = m_pDepthPoints[index];
+            if( !bAligned && !bTransform )
+            {
+                m_irToneMapper.Process( pSrc, pitch, width, height, m_cBufferSize, m_pImageBuffer );
+                pSrc = nullptr;
+            }
+            else
+            {
+                m_toneMapped.resize( width * height * bpp );
+                m_irToneMapper.Process( pSrc, pitch, width, height, static_cast<ULONG>(m_toneMapped.size()), m_toneMapped.data() );
 
-            size_t imageBufferOffset = depthPoint.y * dwByteWidthTotal + (depthPoint.x * bpp);
-            size_t colorBufferOffset = index * bpp;
+                pSrc = m_toneMapped.data();
+                cbSrc = static_cast<ULONG>(m_toneMapped.size());
+                pitch = width * bpp;
+            }
+        }
 
-            if (imageBufferOffset + bpp <= (size_t) m_cBufferSize && colorBufferOffset + bpp <= (size_t) lockedRect.size)
+        if( nullptr != pSrc && bTransform )
+        {
+            if( !bAligned )
             {
-                // for the pixels that are mapped, map the depth point with the correct color value
-                for (size_t i = 0; i < bpp; ++i)
+                m_transform.Copy( pSrc, pitch, width, height, bpp, false, m_cBufferSize, m_pImageBuffer );
+                pSrc = nullptr;
+            }
+            else
+            {
+                // the depth points are indexed by the transformed color pixels
+                m_transformed.resize( width * height * bpp );
+                m_transform.Copy( pSrc, pitch, width, height, bpp, false, static_cast<ULONG>(m_transformed.size()), m_transformed.data() );
+
+                pSrc = m_transformed.data();
+                cbSrc = static_cast<ULONG>(m_transformed.size());
+                if( m_transform.SwapsAxes() )
                 {
-                    m_pImageBuffer[imageBufferOffset + i] = lockedRect.pBits[colorBufferOffset + i];
+                    std::swap( width, height );
                 }
             }
-        });
+        }
+
+        if( nullptr != pSrc )
+        {
+            if( bAligned )
+            {
+                CopyColorToDepth( pSrc, cbSrc, width, height, bpp );
+            }
+            else
+            {
+                memcpy_s( m_pImageBuffer, m_cBufferSize, pSrc, cbSrc );
+            }
+        }
     }
 
     // Unlock frame data
     pTexture->UnlockRect(0);
 }
 
+// pSrc - tightly packed width x height color frame, bpp bytes per pixel
+void DataStreamColor::CopyColorToDepth( _In_ const BYTE* pSrc, ULONG cbSrc, ULONG width, ULONG height, ULONG bpp )
+{
+    if (0 != width)
+    {
+        // only register the points that have a source pixel
+        size_t cPoints = min( static_cast<size_t>(m_cDepthPoints), static_cast<size_t>(cbSrc / bpp) );
+
+        // clip the destination rows to the buffer the caller gave us
+        height = min( height, m_cBufferSize / (width * bpp) );
+
+        // each task owns a band of color rows, the depth points of neighbouring rows
+        // land on neighbouring rows of the destination so tasks rarely share cache lines
+        const size_t bandSize = width * COLOR_TO_DEPTH_BAND_ROWS;
+        const size_t cBands = (cPoints + bandSize - 1) / bandSize;
+
+        Concurrency::parallel_for(size_t(0), cBands, [&](size_t band)
+        {
+            size_t begin = band * bandSize;
+            size_t end = min( begin + bandSize, cPoints );
+
+            ColorRegistration::RegisterBand( begin, end, bpp, pSrc, m_pDepthPoints, width, height, m_pImageBuffer );
+        });
+    }
+}
+
 #ifdef KCB_ENABLE_FT
 
 void DataStreamColor::SetCameraConfig()
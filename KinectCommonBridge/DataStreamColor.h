@@ -15,6 +15,9 @@ See the Apache 2 License for the specific language governing permissions and lim
 #pragma once
 
 #include "DataStreamDepth.h"
+#include "InfraredToneMapper.h"
+#include "ImageTransform.h"
+#include "MotionDetector.h"
 
 class DataStreamColor
     : public DataStream
@@ -46,6 +49,17 @@ public:
         ULONG cDepthPoints, _Inout_cap_(cDepthPoints) const NUI_DEPTH_IMAGE_POINT* pDepthPoints, 
         ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pImageBuffer, _Out_opt_ LONGLONG* liTimeStamp );
 
+    // infrared only, nullptr turns it off
+    HRESULT SetToneMapping( _In_opt_ const KINECT_IR_TONE_MAPPING* pToneMapping );
+
+    // mirror/rotation applied to the copied frames, nullptr turns it off
+    void SetTransform( _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform );
+    const KINECT_IMAGE_TRANSFORM& GetTransform() const { return m_transform.GetParameters(); }
+
+    // block motion against the previous frame, nullptr turns it off
+    void SetMotionDetection( _In_opt_ const KINECT_MOTION_DETECTION* pMotionDetection );
+    HRESULT GetMotion( _Inout_ KINECT_MOTION_INFO* pMotionInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap );
+
 protected:
     virtual void CopyData(_In_ void* pImageFrame);
 
@@ -55,7 +69,9 @@ protected:
 
 private:
     HRESULT OpenStream();
-    virtual void CopyColorToDepth(_In_ NUI_IMAGE_FRAME *pImageFrame);
+    ULONG GetBytesPerPixel() const;
+    bool IsToneMapping() const;
+    void CopyColorToDepth( _In_ const BYTE* pSrc, ULONG cbSrc, ULONG width, ULONG height, ULONG bpp );
 
 private:
     NUI_IMAGE_TYPE m_imageType;
@@ -69,5 +85,16 @@ private:
 
     DWORD m_cDepthPoints;
     const NUI_DEPTH_IMAGE_POINT* m_pDepthPoints;
+
+    // infrared post processing, the aligned path tone maps into m_toneMapped first
+    InfraredToneMapper m_irToneMapper;
+    std::vector<BYTE> m_toneMapped;
+
+    // orientation, the aligned path transforms into m_transformed first
+    ImageTransform m_transform;
+    std::vector<BYTE> m_transformed;
+
+    // runs on the native frame, the plain copy path copies in the same pass
+    MotionDetector m_motion;
 };
 
@@ -18,6 +18,78 @@ See the Apache 2 License for the specific language governing permissions and lim
 #include "AutoLock.h"
 
 #include <ppl.h>
+#include <emmintrin.h>
+#include <limits>
+
+// rows converted to meters by a single task
+static const UINT DEPTH_METERS_BAND_ROWS = 16;
+
+// one row of depth pixels to meters and KINECT_DEPTH_CLASS, minDepth..maxDepth is the valid range in mm
+static void ConvertRowToMeters( _In_ const NUI_DEPTH_IMAGE_PIXEL* pSrc, UINT width, int minDepth, int maxDepth,
+    _Out_ float* pMeters, _Out_opt_ BYTE* pClasses )
+{
+    const __m128 scale = _mm_set1_ps( 0.001f );
+    const __m128 nan = _mm_castsi128_ps( _mm_set1_epi32( 0x7fc00000 ) );
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vMin = _mm_set1_epi32( minDepth );
+    const __m128i vMax = _mm_set1_epi32( maxDepth );
+    const __m128i unknownClass = _mm_set1_epi32( DepthClassUnknown );
+    const __m128i tooNearClass = _mm_set1_epi32( DepthClassTooNear );
+    const __m128i tooFarClass = _mm_set1_epi32( DepthClassTooFar );
+
+    UINT x = 0;
+    for( ; x + 16 <= width; x += 16 )
+    {
+        __m128i classes[4];
+        for( UINT i = 0; i < 4; ++i )
+        {
+            // depth is the high USHORT of every pixel
+            __m128i depth = _mm_srli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + x + i * 4) ), 16 );
+
+            __m128i unknown = _mm_cmpeq_epi32( depth, zero );
+            __m128i tooNear = _mm_andnot_si128( unknown, _mm_cmplt_epi32( depth, vMin ) );
+            __m128i tooFar = _mm_cmpgt_epi32( depth, vMax );
+            __m128 invalid = _mm_castsi128_ps( _mm_or_si128( unknown, _mm_or_si128( tooNear, tooFar ) ) );
+
+            __m128 meters = _mm_mul_ps( _mm_cvtepi32_ps( depth ), scale );
+            _mm_storeu_ps( pMeters + x + i * 4, _mm_or_ps( _mm_andnot_ps( invalid, meters ), _mm_and_ps( invalid, nan ) ) );
+
+            classes[i] = _mm_or_si128( _mm_and_si128( unknown, unknownClass ),
+                _mm_or_si128( _mm_and_si128( tooNear, tooNearClass ), _mm_and_si128( tooFar, tooFarClass ) ) );
+        }
+
+        if( nullptr != pClasses )
+        {
+            __m128i packed = _mm_packus_epi16( _mm_packs_epi32( classes[0], classes[1] ), _mm_packs_epi32( classes[2], classes[3] ) );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>(pClasses + x), packed );
+        }
+    }
+
+    for( ; x < width; ++x )
+    {
+        int depth = pSrc[x].depth;
+
+        BYTE depthClass = DepthClassValid;
+        if( 0 == depth )
+        {
+            depthClass = DepthClassUnknown;
+        }
+        else if( depth < minDepth )
+        {
+            depthClass = DepthClassTooNear;
+        }
+        else if( depth > maxDepth )
+        {
+            depthClass = DepthClassTooFar;
+        }
+
+        pMeters[x] = (DepthClassValid == depthClass) ? depth * 0.001f : std::numeric_limits<float>::quiet_NaN();
+        if( nullptr != pClasses )
+        {
+            pClasses[x] = depthClass;
+        }
+    }
+}
 
 DataStreamDepth::DataStreamDepth()
     : DataStream()
@@ -28,6 +100,9 @@ DataStreamDepth::DataStreamDepth()
     , m_pDepthBuffer(nullptr)
     , m_cDepthPixels(0)
     , m_pDepthPixels(nullptr)
+    , m_pDepthMeters(nullptr)
+    , m_pDepthClasses(nullptr)
+    , m_pDepthColors(nullptr)
 {
 }
 DataStreamDepth::~DataStreamDepth()
@@ -149,6 +224,10 @@ void DataStreamDepth::GetFrameFormat( _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame
     }
 
     NuiImageResolutionToSize( m_imageResolution, pFrame->dwWidth, pFrame->dwHeight );
+    if( m_transform.SwapsAxes() )
+    {
+        std::swap( pFrame->dwWidth, pFrame->dwHeight );
+    }
     pFrame->cbBytesPerPixel = sizeof(short);
     pFrame->cbBufferSize = pFrame->dwWidth * pFrame->dwHeight * pFrame->cbBytesPerPixel;
 
@@ -174,6 +253,84 @@ HRESULT DataStreamDepth::GetFrameData( ULONG cBufferSize, _Inout_cap_(cBufferSiz
     return ProcessImageFrame( liTimeStamp );
 }
 
+void DataStreamDepth::SetTransform( _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_transform.SetParameters( (nullptr != pTransform) ? *pTransform : ImageTransform().GetParameters() );
+}
+
+void DataStreamDepth::SetColorization( _In_opt_ const KINECT_DEPTH_COLORIZATION* pColorization )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_colorizer.SetParameters( pColorization );
+}
+
+void DataStreamDepth::SetFilter( _In_opt_ const KINECT_DEPTH_FILTER* pFilter )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_filter.SetParameters( pFilter );
+}
+
+void DataStreamDepth::SetPlayerSegmentation( bool bEnable )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_segmentation.SetEnabled( bEnable );
+}
+
+HRESULT DataStreamDepth::GetPlayerSegmentation( _Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks )
+{
+    AutoLock lock( m_nuiLock );
+
+    return m_segmentation.GetResult( pSegmentation, cbMasks, pMasks );
+}
+
+void DataStreamDepth::SetIntegralImages( bool bEnable )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_integral.SetEnabled( bEnable );
+}
+
+HRESULT DataStreamDepth::GetRegionStats( ULONG cRegions, _In_count_(cRegions) const RECT* pRegions, _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats )
+{
+    AutoLock lock( m_nuiLock );
+
+    return m_integral.GetRegionStats( m_transform, cRegions, pRegions, pStats );
+}
+
+void DataStreamDepth::SetBackgroundModel( _In_opt_ const KINECT_BACKGROUND_MODEL* pBackgroundModel )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_background.SetParameters( pBackgroundModel );
+}
+
+void DataStreamDepth::FreezeBackground( bool bFreeze )
+{
+    AutoLock lock( m_nuiLock );
+
+    m_background.Freeze( bFreeze );
+}
+
+void DataStreamDepth::ResetBackground()
+{
+    AutoLock lock( m_nuiLock );
+
+    m_background.Reset();
+}
+
+HRESULT DataStreamDepth::GetForeground( _Inout_ KINECT_FOREGROUND_INFO* pForegroundInfo,
+    ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices )
+{
+    AutoLock lock( m_nuiLock );
+
+    return m_background.GetResult( m_transform, pForegroundInfo, cbMask, pMask, cIndices, pIndices );
+}
+
 void DataStreamDepth::CopyData( _In_ void* pImageFrame )
 {
     NUI_IMAGE_FRAME* pFrame = reinterpret_cast<NUI_IMAGE_FRAME*>(pImageFrame);
@@ -182,7 +339,15 @@ void DataStreamDepth::CopyData( _In_ void* pImageFrame )
         return;
     }
 
-    if( nullptr != m_pDepthPixels )
+    if( nullptr != m_pDepthMeters )
+    {
+        CopyMetersData( pFrame );
+    }
+    else if( nullptr != m_pDepthColors )
+    {
+        CopyColorizedData( pFrame );
+    }
+    else if( nullptr != m_pDepthPixels )
     {
         CopyPixelData( pFrame );
     }
@@ -192,6 +357,23 @@ void DataStreamDepth::CopyData( _In_ void* pImageFrame )
     }
 }
 
+void DataStreamDepth::ProcessNativeFrame( _In_ const BYTE* pBits, UINT pitch, UINT width, UINT height, bool bPixels )
+{
+    if( m_background.IsEnabled() )
+    {
+        m_background.Process( pBits, pitch, width, height, bPixels );
+    }
+
+    if( m_integral.IsEnabled() )
+    {
+        // range of the stream in mm
+        USHORT minDepth = (m_bNearMode ? NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MINIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+        USHORT maxDepth = (m_bNearMode ? NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MAXIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+
+        m_integral.Process( pBits, pitch, width, height, bPixels, minDepth, maxDepth );
+    }
+}
+
 void DataStreamDepth::CopyRawData( _In_ NUI_IMAGE_FRAME *pImageFrame )
 {
     // copy data from the frame
@@ -204,7 +386,68 @@ void DataStreamDepth::CopyRawData( _In_ NUI_IMAGE_FRAME *pImageFrame )
     // Make sure we've received valid data
     if( lockedRect.Pitch != 0 )
     {
-        memcpy_s( m_pDepthBuffer, m_cDepthBuffer, lockedRect.pBits, lockedRect.size );
+        DWORD width = 0, height = 0;
+        NuiImageResolutionToSize( m_imageResolution, width, height );
+
+        const BYTE* pBits = lockedRect.pBits;
+        UINT pitch = lockedRect.Pitch;
+        ULONG cbFrame = width * height * sizeof(USHORT);
+
+        if( m_filter.IsEnabled() )
+        {
+            // filter straight into the caller buffer when nothing follows
+            if( m_transform.IsIdentity() && m_cDepthBuffer >= cbFrame )
+            {
+                m_filter.Process( pBits, pitch, width, height, false, m_pDepthBuffer );
+                pBits = nullptr;
+            }
+            else
+            {
+                m_filtered.resize( cbFrame );
+                m_filter.Process( pBits, pitch, width, height, false, m_filtered.data() );
+
+                pBits = m_filtered.data();
+                pitch = width * sizeof(USHORT);
+            }
+        }
+
+        if( nullptr != pBits )
+        {
+            ProcessNativeFrame( pBits, pitch, width, height, false );
+        }
+        else
+        {
+            ProcessNativeFrame( m_pDepthBuffer, width * sizeof(USHORT), width, height, false );
+        }
+
+        bool bSegmented = false;
+        if( nullptr == pBits )
+        {
+            // already in the caller buffer
+        }
+        else if( m_transform.IsIdentity() && m_segmentation.IsEnabled() )
+        {
+            // copy and segment in one pass
+            m_segmentation.Process( pBits, pitch, width, height, false, 0, nullptr, m_cDepthBuffer, m_pDepthBuffer );
+            bSegmented = true;
+        }
+        else if( m_transform.IsIdentity() )
+        {
+            memcpy_s( m_pDepthBuffer, m_cDepthBuffer, pBits, (pBits == lockedRect.pBits) ? lockedRect.size : cbFrame );
+        }
+        else
+        {
+            m_transform.Copy( pBits, pitch, width, height, sizeof(USHORT), false, m_cDepthBuffer, m_pDepthBuffer );
+        }
+
+        // otherwise segment the caller buffer, the frame is still in the cache
+        if( m_segmentation.IsEnabled() && !bSegmented && m_cDepthBuffer >= cbFrame )
+        {
+            UINT outWidth = 0, outHeight = 0;
+            m_transform.GetOutputSize( width, height, outWidth, outHeight );
+
+            m_segmentation.Process( m_pDepthBuffer, outWidth * sizeof(USHORT), outWidth, outHeight, false, 0, nullptr, 0, nullptr );
+        }
     }
 
     // Unlock frame data
@@ -232,20 +475,67 @@ void DataStreamDepth::CopyPixelData( _In_ NUI_IMAGE_FRAME *pImageFrame )
     if( lockedRect.Pitch != 0 )
     {
         const NUI_DEPTH_IMAGE_PIXEL* pBufferRun = reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL *>(lockedRect.pBits);
-        
-        const size_t sizeOfShort = sizeof(short);
-        Concurrency::parallel_for(size_t(0), size_t(m_cDepthPixels), [&](size_t index)
-        {
-            m_pDepthPixels[index] = pBufferRun[index];
 
-            // if we also want the raw depth buffer we can copy that as well
-            if( nullptr != m_pDepthBuffer )
+        DWORD width = 0, height = 0;
+        NuiImageResolutionToSize( m_imageResolution, width, height );
+
+        const BYTE* pBits = lockedRect.pBits;
+        UINT pitch = lockedRect.Pitch;
+
+        // filter and reorder the pixels first, the loop below then copies them in place
+        if( m_filter.IsEnabled() )
+        {
+            if( m_transform.IsIdentity() && m_cDepthPixels >= width * height )
             {
-                short packed = m_pDepthPixels[index].depth << NUI_IMAGE_PLAYER_INDEX_SHIFT | m_pDepthPixels[index].playerIndex;
-                m_pDepthBuffer[index * sizeOfShort] = packed & 0xff;
-                m_pDepthBuffer[index * sizeOfShort + 1] = packed >> 8 & 0xff;
+                m_filter.Process( pBits, pitch, width, height, true, reinterpret_cast<BYTE*>(m_pDepthPixels) );
+                pBufferRun = m_pDepthPixels;
             }
-        } );
+            else
+            {
+                m_filtered.resize( width * height * sizeof(NUI_DEPTH_IMAGE_PIXEL) );
+                m_filter.Process( pBits, pitch, width, height, true, m_filtered.data() );
+
+                pBits = m_filtered.data();
+                pitch = width * sizeof(NUI_DEPTH_IMAGE_PIXEL);
+                pBufferRun = reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL*>(pBits);
+            }
+        }
+
+        UINT nativePitch = (reinterpret_cast<const BYTE*>(pBufferRun) == lockedRect.pBits) ? lockedRect.Pitch : width * sizeof(NUI_DEPTH_IMAGE_PIXEL);
+        ProcessNativeFrame( reinterpret_cast<const BYTE*>(pBufferRun), nativePitch, width, height, true );
+
+        if( !m_transform.IsIdentity() )
+        {
+            m_transform.Copy( pBits, pitch, width, height, sizeof(NUI_DEPTH_IMAGE_PIXEL), false,
+                m_cDepthPixels * sizeof(NUI_DEPTH_IMAGE_PIXEL), reinterpret_cast<BYTE*>(m_pDepthPixels) );
+            pBufferRun = m_pDepthPixels;
+        }
+        
+        UINT outWidth = 0, outHeight = 0;
+        m_transform.GetOutputSize( width, height, outWidth, outHeight );
+
+        // the segmentation does the copy itself, so the frame is only read once
+        if( m_segmentation.IsEnabled() && m_cDepthPixels >= outWidth * outHeight )
+        {
+            m_segmentation.Process( reinterpret_cast<const BYTE*>(pBufferRun), outWidth * sizeof(NUI_DEPTH_IMAGE_PIXEL), outWidth, outHeight, true,
+                m_cDepthPixels, m_pDepthPixels, m_cDepthBuffer, m_pDepthBuffer );
+        }
+        else
+        {
+            const size_t sizeOfShort = sizeof(short);
+            Concurrency::parallel_for(size_t(0), size_t(m_cDepthPixels), [&](size_t index)
+            {
+                m_pDepthPixels[index] = pBufferRun[index];
+
+                // if we also want the raw depth buffer we can copy that as well
+                if( nullptr != m_pDepthBuffer )
+                {
+                    short packed = m_pDepthPixels[index].depth << NUI_IMAGE_PLAYER_INDEX_SHIFT | m_pDepthPixels[index].playerIndex;
+                    m_pDepthBuffer[index * sizeOfShort] = packed & 0xff;
+                    m_pDepthBuffer[index * sizeOfShort + 1] = packed >> 8 & 0xff;
+                }
+            } );
+        }
     }
 
     // We're done with the texture so unlock it
@@ -276,6 +566,182 @@ HRESULT DataStreamDepth::GetDepthImagePixels( ULONG cbDepthPixels, _Inout_cap_(c
     return ProcessImageFrame( liTimeStamp );
 }
 
+void DataStreamDepth::CopyMetersData( _In_ NUI_IMAGE_FRAME *pImageFrame )
+{
+    BOOL nearMode;
+    ComSmartPtr<INuiFrameTexture> pTexture;
+
+    // the pixel texture has the depth of every pixel, also outside the range
+    HRESULT hr = m_pNuiSensor->NuiImageFrameGetDepthImagePixelFrameTexture( m_hStreamHandle, pImageFrame, &nearMode, &pTexture );
+    if (FAILED(hr))
+    {
+        return;
+    }
+
+    NUI_LOCKED_RECT lockedRect;
+    pTexture->LockRect(0, &lockedRect, NULL, 0);
+
+    if( lockedRect.Pitch != 0 )
+    {
+        DWORD width = 0, height = 0;
+        NuiImageResolutionToSize( m_imageResolution, width, height );
+
+        const BYTE* pBits = lockedRect.pBits;
+        UINT pitch = lockedRect.Pitch;
+
+        if( m_filter.IsEnabled() )
+        {
+            m_filtered.resize( width * height * sizeof(NUI_DEPTH_IMAGE_PIXEL) );
+            m_filter.Process( pBits, pitch, width, height, true, m_filtered.data() );
+
+            pBits = m_filtered.data();
+            pitch = width * sizeof(NUI_DEPTH_IMAGE_PIXEL);
+        }
+
+        ProcessNativeFrame( pBits, pitch, width, height, true );
+
+        // range of the frame in mm
+        int minDepth = (nearMode ? NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MINIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+        int maxDepth = (nearMode ? NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MAXIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+
+        // convert the native frame, straight into the caller buffers when nothing follows
+        float* pMeters = m_pDepthMeters;
+        BYTE* pClasses = m_pDepthClasses;
+        if( !m_transform.IsIdentity() )
+        {
+            m_meters.resize( width * height );
+            pMeters = m_meters.data();
+
+            if( nullptr != m_pDepthClasses )
+            {
+                m_classes.resize( width * height );
+                pClasses = m_classes.data();
+            }
+        }
+
+        UINT cBands = (height + DEPTH_METERS_BAND_ROWS - 1) / DEPTH_METERS_BAND_ROWS;
+        Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+        {
+            UINT yEnd = min( static_cast<UINT>(height), (band + 1) * DEPTH_METERS_BAND_ROWS );
+            for( UINT y = band * DEPTH_METERS_BAND_ROWS; y < yEnd; ++y )
+            {
+                ConvertRowToMeters( reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL*>(pBits + y * pitch), width, minDepth, maxDepth,
+                    pMeters + y * width, (nullptr != pClasses) ? pClasses + y * width : nullptr );
+            }
+        } );
+
+        if( !m_transform.IsIdentity() )
+        {
+            m_transform.Reorder( m_meters.data(), width, height, false, m_pDepthMeters );
+            if( nullptr != m_pDepthClasses )
+            {
+                m_transform.Reorder( m_classes.data(), width, height, false, m_pDepthClasses );
+            }
+        }
+    }
+
+    pTexture->UnlockRect(0);
+
+    pTexture.Release();
+}
+
+HRESULT DataStreamDepth::GetDepthMeters( ULONG cDepthPixels, _Out_cap_(cDepthPixels) float* pDepthMeters,
+    ULONG cbClasses, _Out_opt_cap_(cbClasses) BYTE* pClasses, _Out_opt_ LONGLONG* liTimeStamp )
+{
+    AutoLock lock( m_nuiLock );
+
+    if( nullptr == pDepthMeters )
+    {
+        return E_INVALIDARG;
+    }
+
+    // the conversion writes whole frames
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( m_imageResolution, width, height );
+    if( cDepthPixels < width * height || (nullptr != pClasses && cbClasses < width * height) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER );
+    }
+
+    m_pDepthMeters = pDepthMeters;
+    m_pDepthClasses = pClasses;
+
+    HRESULT hr = ProcessImageFrame( liTimeStamp );
+
+    m_pDepthMeters = nullptr;
+    m_pDepthClasses = nullptr;
+
+    return hr;
+}
+
+void DataStreamDepth::CopyColorizedData( _In_ NUI_IMAGE_FRAME *pImageFrame )
+{
+    // the packed frame has the player index in the bits the table is indexed by
+    INuiFrameTexture* pTexture = pImageFrame->pFrameTexture;
+
+    NUI_LOCKED_RECT lockedRect;
+    pTexture->LockRect( 0, &lockedRect, NULL, 0 );
+
+    if( lockedRect.Pitch != 0 )
+    {
+        DWORD width = 0, height = 0;
+        NuiImageResolutionToSize( m_imageResolution, width, height );
+
+        const BYTE* pBits = lockedRect.pBits;
+        UINT pitch = lockedRect.Pitch;
+
+        if( m_filter.IsEnabled() )
+        {
+            m_filtered.resize( width * height * sizeof(USHORT) );
+            m_filter.Process( pBits, pitch, width, height, false, m_filtered.data() );
+
+            pBits = m_filtered.data();
+            pitch = width * sizeof(USHORT);
+        }
+
+        ProcessNativeFrame( pBits, pitch, width, height, false );
+
+        // colorize the native frame, straight into the caller buffer when nothing follows
+        if( m_transform.IsIdentity() )
+        {
+            m_colorizer.Process( pBits, pitch, width, height, m_bNearMode, m_pDepthColors );
+        }
+        else
+        {
+            m_colors.resize( width * height );
+            m_colorizer.Process( pBits, pitch, width, height, m_bNearMode, m_colors.data() );
+            m_transform.Reorder( m_colors.data(), width, height, false, m_pDepthColors );
+        }
+    }
+
+    pTexture->UnlockRect(0);
+}
+
+HRESULT DataStreamDepth::GetDepthColorized( ULONG cbBuffer, _Out_cap_(cbBuffer) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp )
+{
+    AutoLock lock( m_nuiLock );
+
+    if( nullptr == pColorBuffer )
+    {
+        return E_INVALIDARG;
+    }
+
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( m_imageResolution, width, height );
+    if( cbBuffer < width * height * sizeof(UINT32) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER );
+    }
+
+    m_pDepthColors = reinterpret_cast<UINT32*>(pColorBuffer);
+
+    HRESULT hr = ProcessImageFrame( liTimeStamp );
+
+    m_pDepthColors = nullptr;
+
+    return hr;
+}
+
 #ifdef KCB_ENABLE_FT
 void DataStreamDepth::SetCameraConfig()
 {
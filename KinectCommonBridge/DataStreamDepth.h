@@ -15,6 +15,12 @@ See the Apache 2 License for the specific language governing permissions and lim
 #pragma once
 
 #include "DataStream.h"
+#include "ImageTransform.h"
+#include "DepthFilter.h"
+#include "PlayerSegmentation.h"
+#include "BackgroundModel.h"
+#include "DepthIntegral.h"
+#include "DepthColorizer.h"
 
 class DataStreamDepth
     : public DataStream
@@ -36,6 +42,36 @@ public:
     HRESULT GetFrameData( ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pDepthBuffer, _Out_opt_ LONGLONG* liTimeStamp );
     HRESULT GetDepthImagePixels( ULONG cDepthPixels, _Inout_cap_(cDepthPixels) NUI_DEPTH_IMAGE_PIXEL* pDepthPixelBuffer, _Out_opt_ LONGLONG* liTimeStamp );
 
+    // depth in meters, NaN outside the range of the near mode, pClasses gets a KINECT_DEPTH_CLASS per pixel
+    HRESULT GetDepthMeters( ULONG cDepthPixels, _Out_cap_(cDepthPixels) float* pDepthMeters,
+        ULONG cbClasses, _Out_opt_cap_(cbClasses) BYTE* pClasses, _Out_opt_ LONGLONG* liTimeStamp );
+
+    // false color BGRA image of the depth frame, 4 bytes per pixel
+    HRESULT GetDepthColorized( ULONG cbBuffer, _Out_cap_(cbBuffer) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp );
+    void SetColorization( _In_opt_ const KINECT_DEPTH_COLORIZATION* pColorization );
+
+    // mirror/rotation applied to the copied frames, nullptr turns it off
+    void SetTransform( _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform );
+    const KINECT_IMAGE_TRANSFORM& GetTransform() const { return m_transform.GetParameters(); }
+
+    // filter chain applied before the transform, nullptr turns it off
+    void SetFilter( _In_opt_ const KINECT_DEPTH_FILTER* pFilter );
+
+    // player masks and statistics of the copied frames
+    void SetPlayerSegmentation( bool bEnable );
+    HRESULT GetPlayerSegmentation( _Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks );
+
+    // summed area tables of the filtered native frames, pRegions are in the orientation of the copied frames
+    void SetIntegralImages( bool bEnable );
+    HRESULT GetRegionStats( ULONG cRegions, _In_count_(cRegions) const RECT* pRegions, _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats );
+
+    // background model learned from the filtered native frames
+    void SetBackgroundModel( _In_opt_ const KINECT_BACKGROUND_MODEL* pBackgroundModel );
+    void FreezeBackground( bool bFreeze );
+    void ResetBackground();
+    HRESULT GetForeground( _Inout_ KINECT_FOREGROUND_INFO* pForegroundInfo,
+        ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices );
+
 	NUI_IMAGE_TYPE GetImageType() { return m_imageType; }
 	NUI_IMAGE_RESOLUTION GetImageResolution() { return m_imageResolution; }
 
@@ -50,6 +86,11 @@ private:
     HRESULT OpenStream();
     void CopyRawData( _In_ NUI_IMAGE_FRAME *pImageFrame );
     void CopyPixelData( _In_ NUI_IMAGE_FRAME *pImageFrame );
+    void CopyMetersData( _In_ NUI_IMAGE_FRAME *pImageFrame );
+    void CopyColorizedData( _In_ NUI_IMAGE_FRAME *pImageFrame );
+
+    // models that learn from the filtered native frame
+    void ProcessNativeFrame( _In_ const BYTE* pBits, UINT pitch, UINT width, UINT height, bool bPixels );
 
 private:
     NUI_IMAGE_TYPE m_imageType;
@@ -61,5 +102,28 @@ private:
 
     ULONG m_cDepthPixels;
     NUI_DEPTH_IMAGE_PIXEL* m_pDepthPixels;
+
+    // only set during GetDepthMeters
+    float* m_pDepthMeters;
+    BYTE* m_pDepthClasses;
+
+    // native frame in meters when the transform follows
+    std::vector<float> m_meters;
+    std::vector<BYTE> m_classes;
+
+    // only set during GetDepthColorized, m_colors holds the native image when the transform follows
+    UINT32* m_pDepthColors;
+    std::vector<UINT32> m_colors;
+    DepthColorizer m_colorizer;
+
+    ImageTransform m_transform;
+
+    // the filter works on the native frame, m_filtered holds it when the transform follows
+    DepthFilter m_filter;
+    std::vector<BYTE> m_filtered;
+
+    PlayerSegmentation m_segmentation;
+    BackgroundModel m_background;
+    DepthIntegral m_integral;
 };
 
@@ -22,9 +22,6 @@ DataStreamSkeleton::DataStreamSkeleton()
     , m_bSmoothParams(false)
     , m_seated(false)
     , m_chooserMode(SkeletonSelectionModeDefault)
-    , m_activityLevel(0.0f)
-    , m_dwActiveID1(0)
-    , m_dwActiveID2(0)
 {
     m_stickyIDs[FirstTrackID] = 0;
     m_stickyIDs[SecondTrackID] = 0;
@@ -70,6 +67,7 @@ void DataStreamSkeleton::Initialize( bool bSeated, KINECT_SKELETON_SELECTION_MOD
     if( m_chooserMode != mode )
     {
         m_chooserMode = mode;
+        m_players.Reset();
         bChanged = true;
     }
 
@@ -80,7 +78,12 @@ void DataStreamSkeleton::Initialize( bool bSeated, KINECT_SKELETON_SELECTION_MOD
         {
             m_bSmoothParams = true;
             m_smoothParams = *pSmoothParams;
-            bChanged = true;
+
+            // smoothing is native, the stream keeps running
+            KINECT_SKELETON_FILTER filter = { sizeof(KINECT_SKELETON_FILTER) };
+            filter.eType = SkeletonFilterDoubleExponential;
+            filter.smoothParams = m_smoothParams;
+            m_filter.SetParameters( &filter );
         }
     }
     else
@@ -88,7 +91,7 @@ void DataStreamSkeleton::Initialize( bool bSeated, KINECT_SKELETON_SELECTION_MOD
         if ( m_bSmoothParams )
         {
             m_bSmoothParams = false;
-            bChanged = false;
+            m_filter.SetParameters( nullptr );
         }
     }
     
@@ -118,10 +121,74 @@ void DataStreamSkeleton::SetChooserMode( KINECT_SKELETON_SELECTION_MODE mode )
     if (m_chooserMode != mode)
     {
         m_chooserMode = mode;
+        m_players.Reset();
         StartStream();  // Restart stream with new parameter value
     }
 }
 
+HRESULT DataStreamSkeleton::SetPlayerSelection( _In_opt_ const KINECT_PLAYER_SELECTION* pSelection )
+{
+    AutoLock lock(m_nuiLock);
+
+    return m_players.SetParameters( pSelection );
+}
+
+HRESULT DataStreamSkeleton::SetFilter( _In_opt_ const KINECT_SKELETON_FILTER* pFilter )
+{
+    AutoLock lock(m_nuiLock);
+
+    HRESULT hr = m_filter.SetParameters( pFilter );
+    if( SUCCEEDED(hr) )
+    {
+        // the smooth parameters of the next Initialize apply again
+        m_bSmoothParams = false;
+    }
+
+    return hr;
+}
+
+void DataStreamSkeleton::SetHistory( _In_opt_ const KINECT_SKELETON_HISTORY* pHistory )
+{
+    AutoLock lock(m_nuiLock);
+
+    m_history.SetParameters( pHistory );
+}
+
+HRESULT DataStreamSkeleton::GetTrajectory( _Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory )
+{
+    AutoLock lock(m_nuiLock);
+
+    return m_history.GetTrajectory( pTrajectory );
+}
+
+HRESULT DataStreamSkeleton::AddGestureTemplate( _In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID )
+{
+    AutoLock lock(m_nuiLock);
+
+    return m_gestures.AddTemplate( pTemplate, pdwGestureID );
+}
+
+HRESULT DataStreamSkeleton::RemoveGestureTemplate( DWORD dwGestureID )
+{
+    AutoLock lock(m_nuiLock);
+
+    return m_gestures.RemoveTemplate( dwGestureID );
+}
+
+void DataStreamSkeleton::GetGestureEvents( ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents )
+{
+    AutoLock lock(m_nuiLock);
+
+    m_gestures.GetEvents( cMaxEvents, pEvents, pcEvents );
+}
+
+HRESULT DataStreamSkeleton::PredictFrame( LONGLONG liTimeStamp, _In_ const KINECT_SKELETON_PREDICTION& prediction, _Out_ NUI_SKELETON_FRAME& skeletonFrame )
+{
+    AutoLock lock(m_nuiLock);
+
+    return m_predictor.Predict( liTimeStamp, prediction, skeletonFrame );
+}
+
 HRESULT DataStreamSkeleton::StartStream()
 {
     AutoLock lock(m_nuiLock);
@@ -213,14 +280,10 @@ HRESULT DataStreamSkeleton::GetFrameData( _Inout_ NUI_SKELETON_FRAME& pSkeletonF
         return hr;
     }
 
-    if( m_bSmoothParams )
-    {
-        hr = m_pNuiSensor->NuiTransformSmooth( &pSkeletonFrame, &m_smoothParams );
-        if( FAILED(hr) )
-        {
-            return hr;
-        }
-    }
+    m_filter.Process( pSkeletonFrame );
+    m_history.Append( pSkeletonFrame );
+    m_gestures.Process( pSkeletonFrame );
+    m_predictor.Update( pSkeletonFrame );
 
     UpdateTrackedSkeletons( pSkeletonFrame );
     
@@ -236,171 +299,17 @@ void DataStreamSkeleton::UpdateTrackedSkeletons( _In_ NUI_SKELETON_FRAME& pSkele
 {
     DWORD trackIDs[TrackIDIndexCount] = {0};
 
-    if( SkeletonSelectionModeClosest1 == m_chooserMode || SkeletonSelectionModeClosest2 == m_chooserMode )
-    {
-        ChooseClosestSkeletons(trackIDs, pSkeletonFrame);
-    }
-    else if( SkeletonSelectionModeSticky1 == m_chooserMode || SkeletonSelectionModeSticky2 == m_chooserMode )
-    {
-        ChooseStickySkeletons(trackIDs, pSkeletonFrame);
-    }
-    else if( SkeletonSelectionModeActive1 == m_chooserMode || SkeletonSelectionModeActive2 == m_chooserMode )
-    {
-        ChooseMostActiveSkeletons(trackIDs);
-    }
+    // Track only one player ID in the modes for one, the second ID is not used
+    UINT cTrackIDs = (SkeletonSelectionModeClosest1 == m_chooserMode || SkeletonSelectionModeSticky1 == m_chooserMode
+        || SkeletonSelectionModeActive1 == m_chooserMode || SkeletonSelectionModeZone1 == m_chooserMode) ? 1 : TrackIDIndexCount;
 
-    if (SkeletonSelectionModeClosest1 == m_chooserMode || SkeletonSelectionModeSticky1 == m_chooserMode || SkeletonSelectionModeActive1 == m_chooserMode)
+    if( SkeletonSelectionModeDefault != m_chooserMode )
     {
-        // Track only one player ID. The second ID is not used
-        trackIDs[SecondTrackID] = 0;
+        m_players.Choose(m_chooserMode, pSkeletonFrame, trackIDs, cTrackIDs);
     }
 
-    m_pNuiSensor->NuiSkeletonSetTrackedSkeletons( trackIDs );
-}
-/// <summary>
-/// Find closest skeleton to set tracked
-/// </summary>
-/// <param name="trackIDs">Array of skeleton tracking IDs</param>
-void DataStreamSkeleton::ChooseClosestSkeletons( DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& pSkeletonFrame )
-{
-    ZeroMemory(trackIDs, TrackIDIndexCount * sizeof(DWORD));
-
-    // Initial depth array with max posible value
-    USHORT nearestDepth[TrackIDIndexCount] = {NUI_IMAGE_DEPTH_MAXIMUM, NUI_IMAGE_DEPTH_MAXIMUM};
-
-    for (int i = 0; i < NUI_SKELETON_COUNT; i++)
-    {
-        if (NUI_SKELETON_NOT_TRACKED != pSkeletonFrame.SkeletonData[i].eTrackingState)
-        {
-            LONG   x, y;
-            USHORT depth;
-
-            // Transform skeleton coordinates to depth image
-            NuiTransformSkeletonToDepthImage(pSkeletonFrame.SkeletonData[i].Position, &x, &y, &depth);
-
-            // Compare depth to peviously found item
-            if (depth < nearestDepth[FirstTrackID])
-            {
-                // Move depth and track ID in first place to second place and assign with the new closer one
-                nearestDepth[SecondTrackID] = nearestDepth[FirstTrackID];
-                nearestDepth[FirstTrackID]  = depth;
-
-                trackIDs[SecondTrackID] = trackIDs[FirstTrackID];
-                trackIDs[FirstTrackID]  = pSkeletonFrame.SkeletonData[i].dwTrackingID;
-            }
-            else if (depth < nearestDepth[SecondTrackID])
-            {
-                // Replace old depth and track ID in second place with the newly found closer one
-                nearestDepth[SecondTrackID] = depth;
-                trackIDs[SecondTrackID]     = pSkeletonFrame.SkeletonData[i].dwTrackingID;
-            }
-        }
-    }
-}
-
-/// <summary>
-/// Find sticky skeletons to set tracked
-/// </summary>
-/// <param name="trackIDs">Array of skeleton tracking IDs</param>
-void DataStreamSkeleton::ChooseStickySkeletons(DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& pSkeletonFrame)
-{
-    ZeroMemory(trackIDs, TrackIDIndexCount * sizeof(DWORD));
-
-    FindStickyIDs(trackIDs, pSkeletonFrame);
-    AssignNewStickyIDs(trackIDs, pSkeletonFrame);
-
-    // Update stored sticky IDs
     m_stickyIDs[FirstTrackID]  = trackIDs[FirstTrackID];
     m_stickyIDs[SecondTrackID] = trackIDs[SecondTrackID];
-}
 
-/// <summary>
-/// Verify if stored tracked IDs are found in new skeleton frame
-/// </summary>
-/// <param name="trackIDs">Array of skeleton tracking IDs</param>
-void DataStreamSkeleton::FindStickyIDs(DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& pSkeletonFrame)
-{
-    for(int i = 0; i < TrackIDIndexCount; i++)
-    {
-        for(int j = 0; j < NUI_SKELETON_COUNT; j++)
-        {
-            if(NUI_SKELETON_NOT_TRACKED != pSkeletonFrame.SkeletonData[j].eTrackingState)
-            {
-                DWORD trackID = pSkeletonFrame.SkeletonData[j].dwTrackingID;
-                if(trackID == m_stickyIDs[i])
-                {
-                    trackIDs[i] = trackID;
-                    break;
-                }
-            }
-        }
-    }
-}
-
-/// <summary>
-/// Assign a new ID if old sticky is not found in new skeleton frame
-/// </summary>
-/// <param name="trackIDs">Array of skeleton tracking IDs</param>
-void DataStreamSkeleton::AssignNewStickyIDs(DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& pSkeletonFrame)
-{
-    for (int i = 0; i < NUI_SKELETON_COUNT; i++)
-    {
-        if (trackIDs[FirstTrackID] && trackIDs[SecondTrackID])
-        {
-            break;
-        }
-
-        if (NUI_SKELETON_NOT_TRACKED != pSkeletonFrame.SkeletonData[i].eTrackingState)
-        {
-            DWORD trackID = pSkeletonFrame.SkeletonData[i].dwTrackingID;
-
-            if (!trackIDs[FirstTrackID] && trackID != trackIDs[SecondTrackID])
-            {
-                trackIDs[FirstTrackID] = trackID;
-            }
-            else if (!trackIDs[SecondTrackID] && trackID != trackIDs[FirstTrackID])
-            {
-                trackIDs[SecondTrackID] = trackID;
-            }
-        }
-    }
-}
-
-/// <summary>
-/// Find most active skeletons to set tracked
-/// </summary>
-/// <param name="trackIDs">Array of skeleton tracking IDs</param>
-void DataStreamSkeleton::ChooseMostActiveSkeletons(DWORD trackIDs[TrackIDIndexCount])
-{
-    ZeroMemory(trackIDs, TrackIDIndexCount * sizeof(DWORD));
-
-    // Find out highest activity level IDs
-    FindMostActiveIDs(trackIDs);
-}
-
-/// <summary>
-/// Find most active IDs
-/// </summary>
-/// <param name="trackIDs">Array of skeleton tracking IDs</param>
-void DataStreamSkeleton::FindMostActiveIDs(DWORD trackIDs[TrackIDIndexCount])
-{
-    // Initialize activity levels with negtive valus so they can replaced by any found activity levels
-    FLOAT activityLevels[TrackIDIndexCount] = {-1.0f, -1.0f};
-
-    // Compare to previously found activity levels
-    if (m_activityLevel > activityLevels[FirstTrackID])
-    {
-        // Move first track ID and activity level to second place. Assign newly found higher activity level and ID to first place
-        activityLevels[SecondTrackID] = activityLevels[FirstTrackID];
-        activityLevels[FirstTrackID]  = m_activityLevel;
-
-        trackIDs[SecondTrackID]       = trackIDs[FirstTrackID];
-        trackIDs[FirstTrackID]        = m_dwActiveID1;
-    }
-    else if (m_activityLevel > activityLevels[SecondTrackID])
-    {
-        // Replace the previous one
-        activityLevels[SecondTrackID] = m_activityLevel;
-        trackIDs[SecondTrackID]       = m_dwActiveID2;
-    }
+    m_pNuiSensor->NuiSkeletonSetTrackedSkeletons( trackIDs );
 }
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "DataStreamDepth.h"
+#include "PlayerSelector.h"
+#include "SkeletonFilter.h"
+#include "SkeletonHistory.h"
+#include "GestureRecognizer.h"
+#include "SkeletonPredictor.h"
 
 // Tracked player ID index
 enum TrackIDIndex
@@ -27,6 +32,16 @@ public:
 
     void SetSeatedMode( bool seated );
     void SetChooserMode( KINECT_SKELETON_SELECTION_MODE mode );
+    HRESULT SetPlayerSelection( _In_opt_ const KINECT_PLAYER_SELECTION* pSelection );
+    HRESULT SetFilter( _In_opt_ const KINECT_SKELETON_FILTER* pFilter );
+    void SetHistory( _In_opt_ const KINECT_SKELETON_HISTORY* pHistory );
+    HRESULT GetTrajectory( _Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory );
+
+    HRESULT AddGestureTemplate( _In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID );
+    HRESULT RemoveGestureTemplate( DWORD dwGestureID );
+    void GetGestureEvents( ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents );
+
+    HRESULT PredictFrame( LONGLONG liTimeStamp, _In_ const KINECT_SKELETON_PREDICTION& prediction, _Out_ NUI_SKELETON_FRAME& skeletonFrame );
 
     HRESULT GetFrameData( _Inout_ NUI_SKELETON_FRAME& skeletonFrame );
 	DWORD* GetTrackedIDs() { return m_stickyIDs; }
@@ -43,42 +58,6 @@ private:
     /// </summary>
     void UpdateTrackedSkeletons( _In_ NUI_SKELETON_FRAME& skeletonFrame );
 
-    /// <summary>
-    /// Find sticky skeletons to set tracked
-    /// </summary>
-    /// <param name="trackIDs">Array of skeleton tracking IDs</param>
-    void ChooseStickySkeletons( _In_ DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& skeletonFrame );
-
-    /// <summary>
-    /// Find closest skeleton to set tracked
-    /// </summary>
-    /// <param name="trackIDs">Array of skeleton tracking IDs</param>
-    void ChooseClosestSkeletons( _In_ DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& skeletonFrame );
-
-    /// <summary>
-    /// Find most active skeletons to set tracked
-    /// </summary>
-    /// <param name="trackIDs">Array of skeleton tracking IDs</param>
-    void ChooseMostActiveSkeletons( _In_ DWORD trackIDs[TrackIDIndexCount] );
-
-    /// <summary>
-    /// Verify if stored tracked IDs are found in new skeleton frame
-    /// </summary>
-    /// <param name="trackIDs">Array of skeleton tracking IDs</param>
-    void FindStickyIDs( _In_ DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& skeletonFrame );
-
-    /// <summary>
-    /// Assign a new ID if old sticky is not found in new skeleton frame
-    /// </summary>
-    /// <param name="trackIDs">Array of skeleton tracking IDs</param>
-    void AssignNewStickyIDs( _In_ DWORD trackIDs[TrackIDIndexCount], _In_ NUI_SKELETON_FRAME& skeletonFrame );
-
-    /// <summary>
-    /// Find most active IDs
-    /// </summary>
-    /// <param name="trackIDs">Array of skeleton tracking IDs</param>
-    void FindMostActiveIDs( _In_ DWORD trackIDs[TrackIDIndexCount] );
-
 private:
     bool    m_bSmoothParams;
     bool    m_seated;
@@ -88,7 +67,9 @@ private:
 
     NUI_TRANSFORM_SMOOTH_PARAMETERS m_smoothParams;
 
-    FLOAT   m_activityLevel;
-    DWORD    m_dwActiveID1;
-    DWORD    m_dwActiveID2;
+    PlayerSelector m_players;
+    SkeletonFilter m_filter;
+    SkeletonHistory m_history;
+    GestureRecognizer m_gestures;
+    SkeletonPredictor m_predictor;
 };
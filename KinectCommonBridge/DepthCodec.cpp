@@ -0,0 +1,573 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "DepthCodec.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+#include <intrin.h>
+#include <limits.h>
+
+// 'KCBD'
+static const UINT32 DEPTH_CODEC_MAGIC = 0x4442434b;
+
+// rows in a band, bands are the unit of parallel work
+static const UINT32 DEPTH_CODEC_BAND_ROWS = 32;
+
+// largest image of a NUI stream, 1280x960, the sizes of a header are checked against it
+static const ULONGLONG DEPTH_CODEC_MAX_PIXELS = 1280 * 960;
+
+// worst case bytes of a pixel: 6 nibbles of depth (run counts and a 14 bit zigzag delta)
+// and a player run of its own, plus the depth stream size and the last partial word of a band
+static const size_t DEPTH_CODEC_PIXEL_BOUND = 3 + 2;
+static const size_t DEPTH_CODEC_BAND_OVERHEAD = 2 * sizeof(UINT32);
+
+struct DepthCodecHeader
+{
+    UINT32 magic;
+    UINT32 width;
+    UINT32 height;
+    UINT32 bandRows;
+    UINT32 cBands;
+};
+
+//
+// RVL nibble stream, 3 bits of value per nibble lowest bits first, the high bit means more follow
+// nibbles fill 32 bit words from the top
+//
+class NibbleWriter
+{
+public:
+    NibbleWriter( _Out_ BYTE* pOut ) : m_pOut(pOut), m_bits(0), m_cNibbles(0) {}
+
+    void Write( UINT32 value )
+    {
+        // most values are small deltas of one or two nibbles, without a data dependent branch
+        if( value < 64 )
+        {
+            UINT cNibbles = 1 + (value >> 3 != 0);
+            Put( (cNibbles > 1) ? ((8 | (value & 7)) << 4 | (value >> 3)) : value, cNibbles );
+        }
+        else
+        {
+            do
+            {
+                UINT32 nibble = value & 7;
+                value >>= 3;
+                Put( (0 != value) ? (nibble | 8) : nibble, 1 );
+            } while( 0 != value );
+        }
+    }
+
+    // nibbles that are already coded, up to 8
+    void WriteCodes( UINT32 codes, UINT cNibbles )
+    {
+        Put( codes, cNibbles );
+    }
+
+    BYTE* Flush()
+    {
+        if( 0 != m_cNibbles )
+        {
+            Put( 0, 8 - m_cNibbles );
+        }
+        return m_pOut;
+    }
+
+private:
+    // a full word is written as soon as 8 nibbles are pending, up to 8 nibbles at a time
+    void Put( UINT32 nibbles, UINT cNibbles )
+    {
+        m_bits = (m_bits << (4 * cNibbles)) | nibbles;
+        m_cNibbles += cNibbles;
+        if( m_cNibbles >= 8 )
+        {
+            m_cNibbles -= 8;
+            UINT32 word = static_cast<UINT32>( m_bits >> (4 * m_cNibbles) );
+            memcpy( m_pOut, &word, sizeof(UINT32) );
+            m_pOut += sizeof(UINT32);
+        }
+    }
+
+    BYTE* m_pOut;
+    ULONGLONG m_bits;
+    UINT m_cNibbles;
+};
+
+class NibbleReader
+{
+public:
+    NibbleReader( _In_ const BYTE* pIn, _In_ const BYTE* pEnd ) : m_pIn(pIn), m_pEnd(pEnd), m_word(0), m_cNibbles(0) {}
+
+    bool Read( _Out_ UINT32& value )
+    {
+        value = 0;
+        for( UINT shift = 0; shift < 32; shift += 3 )
+        {
+            if( 0 == m_cNibbles )
+            {
+                if( static_cast<size_t>(m_pEnd - m_pIn) < sizeof(UINT32) )
+                {
+                    return false;
+                }
+                memcpy( &m_word, m_pIn, sizeof(UINT32) );
+                m_pIn += sizeof(UINT32);
+                m_cNibbles = 8;
+            }
+
+            UINT32 nibble = m_word >> 28;
+            m_word <<= 4;
+            --m_cNibbles;
+
+            value |= (nibble & 7) << shift;
+            if( 0 == (nibble & 8) )
+            {
+                return true;
+            }
+        }
+
+        // longer than any count of a band
+        return false;
+    }
+
+private:
+    const BYTE* m_pIn;
+    const BYTE* m_pEnd;
+    UINT32 m_word;
+    UINT m_cNibbles;
+};
+
+// pixels from i on with (value & mask) == match, 8 at a time while they all do
+static inline size_t ScanRun( _In_ const USHORT* pSrc, size_t i, size_t cPixels, USHORT mask, USHORT match, bool bEqual )
+{
+    const __m128i vMask = _mm_set1_epi16( static_cast<short>(mask) );
+    const __m128i vMatch = _mm_set1_epi16( static_cast<short>(match) );
+    const UINT all = bEqual ? 0xffff : 0;
+
+    size_t begin = i;
+    for( ; i + 8 <= cPixels; i += 8 )
+    {
+        __m128i values = _mm_and_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + i) ), vMask );
+        UINT equal = _mm_movemask_epi8( _mm_cmpeq_epi16( values, vMatch ) );
+        if( all != equal )
+        {
+            DWORD bit = 0;
+            _BitScanForward( &bit, equal ^ all );
+            return i + bit / 2 - begin;
+        }
+    }
+
+    for( ; i < cPixels && ((pSrc[i] & mask) == match) == bEqual; ++i )
+    {
+    }
+
+    return i - begin;
+}
+
+// zigzag deltas of the depth of 8 non zero pixels at a time, the nibble codes of deltas below 64
+// are built and joined side by side into two words, a larger step goes through NibbleWriter::Write
+static void EncodeValues( _In_ const USHORT* pSrc, size_t cPixels, _Inout_ int& previous, NibbleWriter& writer )
+{
+    const __m128i vOne = _mm_set1_epi16( 1 );
+    const __m128i vSeven = _mm_set1_epi16( 7 );
+    const __m128i vLarge = _mm_set1_epi16( 63 );
+    const __m128i vMore = _mm_set1_epi16( 0x80 );
+    const __m128i vPairScale = _mm_set1_epi32( 0x00010010 );
+    const __m128i vPairScaleTwo = _mm_set1_epi32( 0xf0 );
+    const __m128i vTwo32 = _mm_set1_epi32( 2 );
+    const __m128i vThree32 = _mm_set1_epi32( 3 );
+    const __m128i vScaleTwo = _mm_set1_epi32( 0x100 );
+    const __m128i vScaleThree = _mm_set1_epi32( 0x1000 - 0x100 );
+    const __m128i vScaleFour = _mm_set1_epi32( 0x10000 - 0x1000 );
+
+    size_t i = 0;
+    for( ; i + 8 <= cPixels; i += 8 )
+    {
+        // depth has 13 bits, the deltas and their zigzag fit in 16
+        __m128i depth = _mm_srli_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + i) ), NUI_IMAGE_PLAYER_INDEX_SHIFT );
+        __m128i delta = _mm_sub_epi16( depth, _mm_or_si128( _mm_slli_si128( depth, 2 ), _mm_cvtsi32_si128( previous ) ) );
+        __m128i zigzag = _mm_xor_si128( _mm_slli_epi16( delta, 1 ), _mm_srai_epi16( delta, 15 ) );
+        previous = _mm_extract_epi16( depth, 7 );
+
+        USHORT values[8];
+        if( 0 != _mm_movemask_epi8( _mm_cmpgt_epi16( zigzag, vLarge ) ) )
+        {
+            _mm_storeu_si128( reinterpret_cast<__m128i*>(values), zigzag );
+            for( int k = 0; k < 8; ++k )
+            {
+                writer.Write( values[k] );
+            }
+            continue;
+        }
+
+        // one nibble below 8, two nibbles (8 | low 3 bits, high 3 bits) below 64
+        __m128i twoNibbles = _mm_cmpgt_epi16( zigzag, vSeven );
+        __m128i pair = _mm_or_si128( _mm_or_si128( _mm_slli_epi16( _mm_and_si128( zigzag, vSeven ), 4 ), vMore ), _mm_srli_epi16( zigzag, 3 ) );
+        __m128i codes = _mm_or_si128( _mm_and_si128( twoNibbles, pair ), _mm_andnot_si128( twoNibbles, zigzag ) );
+        __m128i lengths = _mm_sub_epi16( vOne, twoNibbles );
+
+        // pairs into 32 bits, first * 16^length of the second + second, the scales are 16 or 256 and 1
+        __m128i scales = _mm_add_epi16( vPairScale, _mm_and_si128( _mm_srli_epi32( twoNibbles, 16 ), vPairScaleTwo ) );
+        codes = _mm_madd_epi16( codes, scales );
+        lengths = _mm_madd_epi16( lengths, vOne );
+
+        // and pairs of those into 64 bits, the second has 2 to 4 nibbles
+        __m128i secondLengths = _mm_srli_epi64( lengths, 32 );
+        scales = _mm_add_epi32( vScaleTwo,
+            _mm_add_epi32( _mm_and_si128( _mm_cmpgt_epi32( secondLengths, vTwo32 ), vScaleThree ),
+                _mm_and_si128( _mm_cmpgt_epi32( secondLengths, vThree32 ), vScaleFour ) ) );
+        codes = _mm_add_epi64( _mm_mul_epu32( codes, scales ), _mm_srli_epi64( codes, 32 ) );
+        lengths = _mm_add_epi32( lengths, secondLengths );
+
+        writer.WriteCodes( _mm_cvtsi128_si32( codes ), _mm_cvtsi128_si32( lengths ) );
+        writer.WriteCodes( _mm_cvtsi128_si32( _mm_srli_si128( codes, 8 ) ), _mm_cvtsi128_si32( _mm_srli_si128( lengths, 8 ) ) );
+    }
+
+    for( ; i < cPixels; ++i )
+    {
+        int depth = pSrc[i] >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+        int delta = depth - previous;
+        previous = depth;
+
+        // zigzag, small deltas of either sign become small values
+        writer.Write( (static_cast<UINT32>(delta) << 1) ^ static_cast<UINT32>(delta >> 31) );
+    }
+}
+
+static BYTE* EncodeBand( _In_ const USHORT* pSrc, size_t cPixels, _Out_ BYTE* pOut )
+{
+    const USHORT depthMask = static_cast<USHORT>( ~NUI_IMAGE_PLAYER_INDEX_MASK );
+
+    // depth, RVL runs of zero and non zero depth
+    BYTE* pDepthSize = pOut;
+    NibbleWriter writer( pOut + sizeof(UINT32) );
+
+    int previous = 0;
+    for( size_t i = 0; i < cPixels; )
+    {
+        size_t cZeros = ScanRun( pSrc, i, cPixels, depthMask, 0, true );
+        i += cZeros;
+        size_t cValues = ScanRun( pSrc, i, cPixels, depthMask, 0, false );
+
+        writer.Write( static_cast<UINT32>(cZeros) );
+        writer.Write( static_cast<UINT32>(cValues) );
+
+        EncodeValues( pSrc + i, cValues, previous, writer );
+        i += cValues;
+    }
+
+    BYTE* pPlayers = writer.Flush();
+    UINT32 cbDepth = static_cast<UINT32>( pPlayers - pDepthSize - sizeof(UINT32) );
+    memcpy( pDepthSize, &cbDepth, sizeof(UINT32) );
+
+    // player index, runs of a value with the run length - 1 in 7 bit groups
+    for( size_t i = 0; i < cPixels; )
+    {
+        USHORT player = pSrc[i] & NUI_IMAGE_PLAYER_INDEX_MASK;
+        size_t run = ScanRun( pSrc, i, cPixels, NUI_IMAGE_PLAYER_INDEX_MASK, player, true );
+        i += run;
+
+        *pPlayers++ = static_cast<BYTE>( player );
+        for( --run; run >= 0x80; run >>= 7 )
+        {
+            *pPlayers++ = static_cast<BYTE>( 0x80 | (run & 0x7f) );
+        }
+        *pPlayers++ = static_cast<BYTE>( run );
+    }
+
+    return pPlayers;
+}
+
+static bool DecodeBand( _In_ const BYTE* pIn, _In_ const BYTE* pEnd, size_t cPixels, _Out_ USHORT* pDst )
+{
+    UINT32 cbDepth = 0;
+    if( static_cast<size_t>(pEnd - pIn) < sizeof(UINT32) )
+    {
+        return false;
+    }
+    memcpy( &cbDepth, pIn, sizeof(UINT32) );
+    pIn += sizeof(UINT32);
+
+    if( 0 != cbDepth % sizeof(UINT32) || cbDepth > static_cast<size_t>(pEnd - pIn) )
+    {
+        return false;
+    }
+
+    // depth, written with player index 0
+    NibbleReader reader( pIn, pIn + cbDepth );
+    int previous = 0;
+    for( size_t i = 0; i < cPixels; )
+    {
+        UINT32 cZeros = 0, cValues = 0;
+        if( !reader.Read( cZeros ) || !reader.Read( cValues ) || cZeros > cPixels - i || cValues > cPixels - i - cZeros )
+        {
+            return false;
+        }
+
+        ZeroMemory( pDst + i, cZeros * sizeof(USHORT) );
+        i += cZeros;
+
+        for( size_t end = i + cValues; i < end; ++i )
+        {
+            UINT32 zigzag = 0;
+            if( !reader.Read( zigzag ) )
+            {
+                return false;
+            }
+
+            previous += static_cast<int>( (zigzag >> 1) ^ (0 - (zigzag & 1)) );
+            if( previous <= 0 || previous > (USHRT_MAX >> NUI_IMAGE_PLAYER_INDEX_SHIFT) )
+            {
+                return false;
+            }
+
+            pDst[i] = static_cast<USHORT>( previous << NUI_IMAGE_PLAYER_INDEX_SHIFT );
+        }
+    }
+
+    // player runs, 0 is already in place
+    pIn += cbDepth;
+    for( size_t i = 0; i < cPixels; )
+    {
+        if( pIn >= pEnd )
+        {
+            return false;
+        }
+
+        BYTE player = *pIn++;
+        size_t run = 0;
+        for( UINT shift = 0; ; shift += 7 )
+        {
+            if( pIn >= pEnd || shift > 28 )
+            {
+                return false;
+            }
+            BYTE group = *pIn++;
+            run |= static_cast<size_t>(group & 0x7f) << shift;
+            if( 0 == (group & 0x80) )
+            {
+                break;
+            }
+        }
+
+        if( player > NUI_IMAGE_PLAYER_INDEX_MASK || run >= cPixels - i )
+        {
+            return false;
+        }
+
+        size_t end = i + run + 1;
+        if( 0 != player )
+        {
+            const __m128i vPlayer = _mm_set1_epi16( player );
+            for( ; i + 8 <= end; i += 8 )
+            {
+                __m128i* p = reinterpret_cast<__m128i*>(pDst + i);
+                _mm_storeu_si128( p, _mm_or_si128( _mm_loadu_si128( p ), vPlayer ) );
+            }
+            for( ; i < end; ++i )
+            {
+                pDst[i] |= player;
+            }
+        }
+        i = end;
+    }
+
+    return pIn == pEnd;
+}
+
+bool DepthCodec::IsFormatSupported( const KINECT_IMAGE_FRAME_FORMAT& format )
+{
+    // in 64 bits, the fields can come from an encoded header
+    return 0 != format.dwWidth && 0 != format.dwHeight && sizeof(USHORT) == format.cbBytesPerPixel
+        && static_cast<ULONGLONG>(format.dwWidth) * format.dwHeight <= DEPTH_CODEC_MAX_PIXELS;
+}
+
+ULONG DepthCodec::GetEncodedBound( const KINECT_IMAGE_FRAME_FORMAT& format )
+{
+    if( !IsFormatSupported( format ) )
+    {
+        return 0;
+    }
+
+    const UINT32 cBands = (format.dwHeight + DEPTH_CODEC_BAND_ROWS - 1) / DEPTH_CODEC_BAND_ROWS;
+    const size_t bandBound = format.dwWidth * DEPTH_CODEC_BAND_ROWS * DEPTH_CODEC_PIXEL_BOUND + DEPTH_CODEC_BAND_OVERHEAD;
+
+    return static_cast<ULONG>( sizeof(DepthCodecHeader) + cBands * (sizeof(UINT32) + bandBound) );
+}
+
+HRESULT DepthCodec::Encode( const KINECT_IMAGE_FRAME_FORMAT& format, _In_ const BYTE* pDepth,
+    ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG& cbWritten )
+{
+    cbWritten = 0;
+
+    if( nullptr == pDepth || nullptr == pEncoded || !IsFormatSupported( format ) )
+    {
+        return E_INVALIDARG;
+    }
+
+    if( cbEncoded < GetEncodedBound( format ) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER );
+    }
+
+    DepthCodecHeader header;
+    header.magic = DEPTH_CODEC_MAGIC;
+    header.width = format.dwWidth;
+    header.height = format.dwHeight;
+    header.bandRows = DEPTH_CODEC_BAND_ROWS;
+    header.cBands = (format.dwHeight + DEPTH_CODEC_BAND_ROWS - 1) / DEPTH_CODEC_BAND_ROWS;
+
+    BYTE* pData = pEncoded + sizeof(DepthCodecHeader) + header.cBands * sizeof(UINT32);
+    const size_t bandBound = header.width * DEPTH_CODEC_BAND_ROWS * DEPTH_CODEC_PIXEL_BOUND + DEPTH_CODEC_BAND_OVERHEAD;
+
+    // every band gets its worst case slot, they are packed together afterwards
+    std::vector<UINT32> bandSizes( header.cBands );
+
+    Concurrency::parallel_for( 0u, header.cBands, [&]( UINT32 band )
+    {
+        UINT32 rows = min( DEPTH_CODEC_BAND_ROWS, header.height - band * DEPTH_CODEC_BAND_ROWS );
+        size_t cPixels = static_cast<size_t>(rows) * header.width;
+
+        const USHORT* pSrc = reinterpret_cast<const USHORT*>(pDepth) + static_cast<size_t>(band) * DEPTH_CODEC_BAND_ROWS * header.width;
+        BYTE* pOut = pData + band * bandBound;
+
+        bandSizes[band] = static_cast<UINT32>( EncodeBand( pSrc, cPixels, pOut ) - pOut );
+    });
+
+    // the packed position of a band is never behind its slot, so a forward memmove is safe
+    std::vector<UINT32> bandEnds( header.cBands );
+    size_t offset = 0;
+    for( UINT32 band = 0; band < header.cBands; ++band )
+    {
+        memmove( pData + offset, pData + band * bandBound, bandSizes[band] );
+        offset += bandSizes[band];
+        bandEnds[band] = static_cast<UINT32>( offset );
+    }
+
+    memcpy( pEncoded, &header, sizeof(DepthCodecHeader) );
+    memcpy( pEncoded + sizeof(DepthCodecHeader), bandEnds.data(), header.cBands * sizeof(UINT32) );
+
+    cbWritten = static_cast<ULONG>( (pData - pEncoded) + offset );
+
+    return S_OK;
+}
+
+HRESULT DepthCodec::GetFormat( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Out_ KINECT_IMAGE_FRAME_FORMAT& format )
+{
+    ZeroMemory( &format, sizeof(KINECT_IMAGE_FRAME_FORMAT) );
+    format.dwStructSize = sizeof(KINECT_IMAGE_FRAME_FORMAT);
+
+    if( nullptr == pEncoded || cbEncoded < sizeof(DepthCodecHeader) )
+    {
+        return E_INVALIDARG;
+    }
+
+    DepthCodecHeader header;
+    memcpy( &header, pEncoded, sizeof(DepthCodecHeader) );
+
+    if( DEPTH_CODEC_MAGIC != header.magic || 0 == header.bandRows
+        || header.cBands != (header.height + header.bandRows - 1) / header.bandRows
+        || cbEncoded < sizeof(DepthCodecHeader) + static_cast<ULONGLONG>(header.cBands) * sizeof(UINT32) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
+    format.dwWidth = header.width;
+    format.dwHeight = header.height;
+    format.cbBytesPerPixel = sizeof(USHORT);
+    if( !IsFormatSupported( format ) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
+    // can't overflow once the format is supported
+    format.cbBufferSize = header.width * header.height * sizeof(USHORT);
+
+    return S_OK;
+}
+
+HRESULT DepthCodec::Decode( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+    ULONG cbDepth, _Out_cap_(cbDepth) BYTE* pDepth )
+{
+    KINECT_IMAGE_FRAME_FORMAT format;
+    HRESULT hr = GetFormat( cbEncoded, pEncoded, format );
+    if( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    if( nullptr == pDepth )
+    {
+        return E_INVALIDARG;
+    }
+
+    if( cbDepth < format.cbBufferSize )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER );
+    }
+
+    DepthCodecHeader header;
+    memcpy( &header, pEncoded, sizeof(DepthCodecHeader) );
+
+    std::vector<UINT32> bandEnds( header.cBands );
+    memcpy( bandEnds.data(), pEncoded + sizeof(DepthCodecHeader), header.cBands * sizeof(UINT32) );
+
+    const BYTE* pData = pEncoded + sizeof(DepthCodecHeader) + header.cBands * sizeof(UINT32);
+    const size_t cbData = cbEncoded - (pData - pEncoded);
+
+    // the band table has to be in order and inside the data
+    UINT32 previousEnd = 0;
+    for( UINT32 band = 0; band < header.cBands; ++band )
+    {
+        if( bandEnds[band] < previousEnd || bandEnds[band] > cbData )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+        previousEnd = bandEnds[band];
+    }
+
+    std::vector<BYTE> bandValid( header.cBands, FALSE );
+
+    Concurrency::parallel_for( 0u, header.cBands, [&]( UINT32 band )
+    {
+        UINT32 rows = min( header.bandRows, header.height - band * header.bandRows );
+        size_t cPixels = static_cast<size_t>(rows) * header.width;
+
+        const BYTE* pIn = pData + ((0 == band) ? 0 : bandEnds[band - 1]);
+        const BYTE* pEnd = pData + bandEnds[band];
+
+        // the band has to end inside the image, DecodeBand checks its runs against cPixels
+        ULONGLONG dstOffset = static_cast<ULONGLONG>(band) * header.bandRows * header.width;
+        if( (dstOffset + cPixels) * sizeof(USHORT) > format.cbBufferSize )
+        {
+            bandValid[band] = FALSE;
+            return;
+        }
+        USHORT* pDst = reinterpret_cast<USHORT*>(pDepth) + static_cast<size_t>(dstOffset);
+
+        bandValid[band] = DecodeBand( pIn, pEnd, cPixels, pDst ) ? TRUE : FALSE;
+    });
+
+    for( UINT32 band = 0; band < header.cBands; ++band )
+    {
+        if( !bandValid[band] )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,42 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// lossless codec for packed depth frames (depth << 3 | player, 2 bytes per pixel)
+// depth and player index are coded as separate streams of every band of rows:
+// depth uses RVL, runs of zero and non zero pixels with the deltas of the non zero pixels
+// as variable length nibbles, the player index is mostly 0 and is run length coded
+//
+// layout: DepthCodecHeader, UINT32 end offset of every band, band data
+// band: UINT32 size of the depth stream, depth stream, player runs
+class DepthCodec
+{
+public:
+    static bool IsFormatSupported( const KINECT_IMAGE_FRAME_FORMAT& format );
+
+    // worst case size of the encoded frame, Encode needs a buffer at least this big
+    static ULONG GetEncodedBound( const KINECT_IMAGE_FRAME_FORMAT& format );
+
+    static HRESULT Encode( const KINECT_IMAGE_FRAME_FORMAT& format, _In_ const BYTE* pDepth,
+        ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG& cbWritten );
+
+    // reads the frame size from the header
+    static HRESULT GetFormat( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Out_ KINECT_IMAGE_FRAME_FORMAT& format );
+
+    static HRESULT Decode( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+        ULONG cbDepth, _Out_cap_(cbDepth) BYTE* pDepth );
+};
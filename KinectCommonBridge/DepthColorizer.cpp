@@ -0,0 +1,175 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "DepthColorizer.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+#include <limits.h>
+
+#define DEPTH_COLORIZER_TABLE_SIZE  (USHRT_MAX + 1)
+
+// BGRA of the player indices 1 - 6
+static const UINT32 PLAYER_COLORS[NUI_SKELETON_COUNT] =
+{
+    0xff0000ff, 0xff00ff00, 0xffff0000, 0xff00ffff, 0xffff00ff, 0xffffff00
+};
+
+static inline UINT32 MakeColor( float r, float g, float b )
+{
+    return 0xff000000 | (static_cast<UINT32>(r * 255.0f + 0.5f) << 16) | (static_cast<UINT32>(g * 255.0f + 0.5f) << 8) | static_cast<UINT32>(b * 255.0f + 0.5f);
+}
+
+// halfway between the depth color and the player color
+static inline UINT32 Blend( UINT32 color, UINT32 tint )
+{
+    return 0xff000000 | (((color & 0x00fefefe) >> 1) + ((tint & 0x00fefefe) >> 1));
+}
+
+DepthColorizer::DepthColorizer()
+    : m_tableMin(0)
+    , m_tableMax(0)
+{
+    SetParameters( nullptr );
+}
+
+void DepthColorizer::SetParameters( _In_opt_ const KINECT_DEPTH_COLORIZATION* pParams )
+{
+    if( nullptr != pParams )
+    {
+        m_params = *pParams;
+    }
+    else
+    {
+        ZeroMemory( &m_params, sizeof(KINECT_DEPTH_COLORIZATION) );
+        m_params.dwStructSize = sizeof(KINECT_DEPTH_COLORIZATION);
+        m_params.eColorMap = DepthColorMapRainbow;
+        m_params.bPlayerTint = true;
+        m_params.dwNoDepthColor = 0xff000000;
+    }
+
+    // rebuilt by the next frame
+    m_table.clear();
+}
+
+UINT32 DepthColorizer::MapDepth( USHORT depth, USHORT minDepth, USHORT maxDepth ) const
+{
+    if( depth < minDepth || depth > maxDepth || 0 == depth )
+    {
+        return m_params.dwNoDepthColor;
+    }
+
+    // 0 near, 1 far
+    float t = (maxDepth > minDepth) ? static_cast<float>(depth - minDepth) / (maxDepth - minDepth) : 0.0f;
+
+    if( DepthColorMapGrayscale == m_params.eColorMap )
+    {
+        // near is bright, far stays visible against black
+        float intensity = 1.0f - t * 0.875f;
+        return MakeColor( intensity, intensity, intensity );
+    }
+
+    // hue from red near to blue far
+    float h = t * 4.0f;
+    UINT sector = min( static_cast<UINT>(h), 3u );
+    float f = h - sector;
+    switch( sector )
+    {
+    case 0:
+        return MakeColor( 1.0f, f, 0.0f );
+    case 1:
+        return MakeColor( 1.0f - f, 1.0f, 0.0f );
+    case 2:
+        return MakeColor( 0.0f, 1.0f, f );
+    default:
+        return MakeColor( 0.0f, 1.0f - f, 1.0f );
+    }
+}
+
+void DepthColorizer::BuildTable( USHORT minDepth, USHORT maxDepth )
+{
+    m_table.resize( DEPTH_COLORIZER_TABLE_SIZE );
+    m_tableMin = minDepth;
+    m_tableMax = maxDepth;
+
+    const UINT cPlayers = 1 << NUI_IMAGE_PLAYER_INDEX_SHIFT;
+    for( UINT depth = 0; depth < (DEPTH_COLORIZER_TABLE_SIZE >> NUI_IMAGE_PLAYER_INDEX_SHIFT); ++depth )
+    {
+        UINT32 color = MapDepth( static_cast<USHORT>(depth), minDepth, maxDepth );
+        UINT32* pEntries = m_table.data() + (depth << NUI_IMAGE_PLAYER_INDEX_SHIFT);
+
+        pEntries[0] = color;
+        for( UINT player = 1; player < cPlayers; ++player )
+        {
+            pEntries[player] = (m_params.bPlayerTint && player <= NUI_SKELETON_COUNT) ? Blend( color, PLAYER_COLORS[player - 1] ) : color;
+        }
+    }
+}
+
+void DepthColorizer::ColorizeRow( _In_ const USHORT* pSrc, UINT width, _Out_ UINT32* pDst ) const
+{
+    const UINT32* pTable = m_table.data();
+
+    // SSE2 has no gather, so the packed pixels are extracted from a single load
+    // and the looked up colors leave as 16 byte stores
+    UINT x = 0;
+    for( ; x + 8 <= width; x += 8 )
+    {
+        __m128i packed = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + x) );
+
+        __m128i lo = _mm_setr_epi32( pTable[_mm_extract_epi16( packed, 0 )], pTable[_mm_extract_epi16( packed, 1 )],
+            pTable[_mm_extract_epi16( packed, 2 )], pTable[_mm_extract_epi16( packed, 3 )] );
+        __m128i hi = _mm_setr_epi32( pTable[_mm_extract_epi16( packed, 4 )], pTable[_mm_extract_epi16( packed, 5 )],
+            pTable[_mm_extract_epi16( packed, 6 )], pTable[_mm_extract_epi16( packed, 7 )] );
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pDst + x), lo );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pDst + x + 4), hi );
+    }
+
+    for( ; x < width; ++x )
+    {
+        pDst[x] = pTable[pSrc[x]];
+    }
+}
+
+void DepthColorizer::Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bNearMode, _Out_ UINT32* pDst )
+{
+    USHORT minDepth = m_params.usMinDepth;
+    USHORT maxDepth = m_params.usMaxDepth;
+    if( 0 == minDepth )
+    {
+        minDepth = (bNearMode ? NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MINIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+    }
+    if( 0 == maxDepth )
+    {
+        maxDepth = (bNearMode ? NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE : NUI_IMAGE_DEPTH_MAXIMUM) >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+    }
+
+    if( m_table.empty() || minDepth != m_tableMin || maxDepth != m_tableMax )
+    {
+        BuildTable( minDepth, maxDepth );
+    }
+
+    UINT cBands = (height + DEPTH_COLORIZER_BAND_ROWS - 1) / DEPTH_COLORIZER_BAND_ROWS;
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        UINT yEnd = min( height, (band + 1) * DEPTH_COLORIZER_BAND_ROWS );
+        for( UINT y = band * DEPTH_COLORIZER_BAND_ROWS; y < yEnd; ++y )
+        {
+            ColorizeRow( reinterpret_cast<const USHORT*>(pSrc + y * srcPitch), width, pDst + y * width );
+        }
+    } );
+}
@@ -0,0 +1,50 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// rows colorized by a single task
+#define DEPTH_COLORIZER_BAND_ROWS   16
+
+// false color BGRA image of packed depth frames (depth << 3 | player)
+// a packed pixel is 16 bits, so a table with the color of every depth and player index
+// pair turns the frame into a single lookup per pixel; the table is rebuilt when the
+// parameters or the range change
+class DepthColorizer
+{
+public:
+    DepthColorizer();
+
+    // nullptr restores the defaults
+    void SetParameters( _In_opt_ const KINECT_DEPTH_COLORIZATION* pParams );
+
+    // pSrc - native frame rows, srcPitch bytes apart, pDst - width * height BGRA pixels
+    // bNearMode - range used when the parameters leave it at 0
+    void Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bNearMode, _Out_ UINT32* pDst );
+
+private:
+    void BuildTable( USHORT minDepth, USHORT maxDepth );
+    UINT32 MapDepth( USHORT depth, USHORT minDepth, USHORT maxDepth ) const;
+    void ColorizeRow( _In_ const USHORT* pSrc, UINT width, _Out_ UINT32* pDst ) const;
+
+private:
+    KINECT_DEPTH_COLORIZATION m_params;
+
+    // color of every packed pixel, built for m_tableMin..m_tableMax
+    std::vector<UINT32> m_table;
+    USHORT m_tableMin;
+    USHORT m_tableMax;
+};
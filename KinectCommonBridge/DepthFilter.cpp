@@ -0,0 +1,329 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "DepthFilter.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+#include <math.h>
+
+// 8 unsigned 32bit values below 65536 to USHORTs, _mm_packs_epi32 saturates to the signed range
+// so the values are moved into it and the sign bit is flipped back afterwards
+static inline __m128i PackUShort( __m128i lo, __m128i hi )
+{
+    const __m128i bias = _mm_set1_epi32( 0x8000 );
+    return _mm_xor_si128( _mm_packs_epi32( _mm_sub_epi32( lo, bias ), _mm_sub_epi32( hi, bias ) ), _mm_set1_epi16( static_cast<short>(0x8000) ) );
+}
+
+// 4 depths in millimeters to the next smoothed state
+static inline __m128 SmoothDepth( __m128 depth, __m128& state, __m128 alpha, __m128 threshold )
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+
+    __m128 delta = _mm_sub_ps( depth, state );
+    __m128 smoothed = _mm_add_ps( state, _mm_mul_ps( delta, alpha ) );
+
+    // restart pixels that moved or had no depth so far
+    __m128 restart = _mm_or_ps( _mm_cmpgt_ps( _mm_and_ps( delta, absMask ), threshold ), _mm_cmpeq_ps( state, zero ) );
+    smoothed = _mm_or_ps( _mm_and_ps( restart, depth ), _mm_andnot_ps( restart, smoothed ) );
+
+    // holes keep the state for when the pixel comes back, but stay holes
+    __m128 valid = _mm_cmpneq_ps( depth, zero );
+    state = _mm_or_ps( _mm_and_ps( valid, smoothed ), _mm_andnot_ps( valid, state ) );
+
+    return _mm_and_ps( valid, smoothed );
+}
+
+// min goes to a, max to b
+#define DEPTH_SORT_2( a, b )    { __m128i t = _mm_min_epi16( a, b ); b = _mm_max_epi16( a, b ); a = t; }
+#define DEPTH_SORT_2_SCALAR( a, b )     { if( a > b ) { UINT t = a; a = b; b = t; } }
+
+// median of 9 with the 19 exchange network from Paeth, Graphics Gems
+#define DEPTH_MEDIAN_9( SORT, p ) \
+    SORT( p[1], p[2] ); SORT( p[4], p[5] ); SORT( p[7], p[8] ); \
+    SORT( p[0], p[1] ); SORT( p[3], p[4] ); SORT( p[6], p[7] ); \
+    SORT( p[1], p[2] ); SORT( p[4], p[5] ); SORT( p[7], p[8] ); \
+    SORT( p[0], p[3] ); SORT( p[5], p[8] ); SORT( p[4], p[7] ); \
+    SORT( p[3], p[6] ); SORT( p[1], p[4] ); SORT( p[2], p[5] ); \
+    SORT( p[4], p[7] ); SORT( p[4], p[2] ); SORT( p[6], p[4] ); \
+    SORT( p[4], p[2] );
+
+DepthFilter::DepthFilter()
+    : m_bEnabled(false)
+    , m_width(0)
+    , m_height(0)
+{
+    ZeroMemory( &m_params, sizeof(KINECT_DEPTH_FILTER) );
+    m_params.dwStructSize = sizeof(KINECT_DEPTH_FILTER);
+}
+
+void DepthFilter::SetParameters( _In_opt_ const KINECT_DEPTH_FILTER* pParams )
+{
+    m_bEnabled = (nullptr != pParams) && (pParams->bTemporal || pParams->bMedian || 0 != pParams->cMaxHoleWidth);
+    if( nullptr != pParams )
+    {
+        m_params = *pParams;
+    }
+
+    if( !(m_params.fTemporalAlpha > 0.0f && m_params.fTemporalAlpha <= 1.0f) )
+    {
+        m_params.fTemporalAlpha = DEPTH_FILTER_DEFAULT_ALPHA;
+    }
+
+    if( 0 == m_params.usMotionThreshold )
+    {
+        m_params.usMotionThreshold = DEPTH_FILTER_DEFAULT_THRESHOLD;
+    }
+
+    // smoothing starts over with the next frame
+    m_state.assign( m_state.size(), 0.0f );
+}
+
+void DepthFilter::ResetLayout( UINT width, UINT height )
+{
+    m_width = width;
+    m_height = height;
+
+    m_state.assign( width * height, 0.0f );
+    m_temporal.assign( width * height, 0 );
+    m_spatial.assign( width * height, 0 );
+}
+
+void DepthFilter::FilterTemporal( _In_ const BYTE* pSrc, bool bPixels, UINT y )
+{
+    USHORT* pOut = m_temporal.data() + y * m_width;
+    float* pState = m_state.data() + y * m_width;
+
+    const __m128 alpha = _mm_set1_ps( m_params.fTemporalAlpha );
+    const __m128 threshold = _mm_set1_ps( static_cast<float>(m_params.usMotionThreshold) );
+
+    UINT x = 0;
+    for( ; x + 8 <= m_width; x += 8 )
+    {
+        __m128i lo, hi;
+        if( bPixels )
+        {
+            // depth is the high USHORT of every pixel
+            lo = _mm_srli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) + x / 4 ), 16 );
+            hi = _mm_srli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) + x / 4 + 1 ), 16 );
+        }
+        else
+        {
+            __m128i depth = _mm_srli_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + x * sizeof(USHORT)) ), NUI_IMAGE_PLAYER_INDEX_SHIFT );
+            lo = _mm_unpacklo_epi16( depth, _mm_setzero_si128() );
+            hi = _mm_unpackhi_epi16( depth, _mm_setzero_si128() );
+        }
+
+        if( m_params.bTemporal )
+        {
+            __m128 stateLo = _mm_loadu_ps( pState + x );
+            __m128 stateHi = _mm_loadu_ps( pState + x + 4 );
+
+            lo = _mm_cvtps_epi32( SmoothDepth( _mm_cvtepi32_ps( lo ), stateLo, alpha, threshold ) );
+            hi = _mm_cvtps_epi32( SmoothDepth( _mm_cvtepi32_ps( hi ), stateHi, alpha, threshold ) );
+
+            _mm_storeu_ps( pState + x, stateLo );
+            _mm_storeu_ps( pState + x + 4, stateHi );
+        }
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut + x), PackUShort( lo, hi ) );
+    }
+
+    for( ; x < m_width; ++x )
+    {
+        float depth = bPixels ? reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL*>(pSrc)[x].depth
+            : static_cast<float>( reinterpret_cast<const USHORT*>(pSrc)[x] >> NUI_IMAGE_PLAYER_INDEX_SHIFT );
+
+        if( m_params.bTemporal && 0.0f != depth )
+        {
+            float delta = depth - pState[x];
+            bool bRestart = 0.0f == pState[x] || fabs( delta ) > m_params.usMotionThreshold;
+
+            pState[x] = bRestart ? depth : pState[x] + delta * m_params.fTemporalAlpha;
+            depth = pState[x];
+        }
+
+        // rounded to nearest, ties to even, like _mm_cvtps_epi32 above
+        pOut[x] = static_cast<USHORT>( _mm_cvtss_si32( _mm_set_ss( depth ) ) );
+    }
+}
+
+void DepthFilter::FilterSpatial( UINT y )
+{
+    const USHORT* pIn = m_temporal.data() + y * m_width;
+    USHORT* pOut = m_spatial.data() + y * m_width;
+
+    // the border has no full neighbourhood and is passed through
+    if( !m_params.bMedian || 0 == y || y + 1 >= m_height || m_width < 3 )
+    {
+        memcpy( pOut, pIn, m_width * sizeof(USHORT) );
+        return;
+    }
+
+    const USHORT* pAbove = pIn - m_width;
+    const USHORT* pBelow = pIn + m_width;
+
+    pOut[0] = pIn[0];
+
+    // SSE2 only compares signed 16bit values, flipping the sign bit keeps the unsigned order
+    const __m128i signBias = _mm_set1_epi16( static_cast<short>(0x8000) );
+
+    UINT x = 1;
+    for( ; x + 8 < m_width; x += 8 )
+    {
+        __m128i p[9];
+        const USHORT* rows[3] = { pAbove, pIn, pBelow };
+        for( int r = 0; r < 3; ++r )
+        {
+            for( int c = 0; c < 3; ++c )
+            {
+                p[r * 3 + c] = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>(rows[r] + x + c - 1) ), signBias );
+            }
+        }
+
+        DEPTH_MEDIAN_9( DEPTH_SORT_2, p );
+
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut + x), _mm_xor_si128( p[4], signBias ) );
+    }
+
+    for( ; x + 1 < m_width; ++x )
+    {
+        UINT p[9] = {
+            pAbove[x - 1], pAbove[x], pAbove[x + 1],
+            pIn[x - 1], pIn[x], pIn[x + 1],
+            pBelow[x - 1], pBelow[x], pBelow[x + 1] };
+
+        DEPTH_MEDIAN_9( DEPTH_SORT_2_SCALAR, p );
+
+        pOut[x] = static_cast<USHORT>( p[4] );
+    }
+
+    pOut[m_width - 1] = pIn[m_width - 1];
+}
+
+void DepthFilter::FillHoles( UINT y )
+{
+    if( 0 == m_params.cMaxHoleWidth )
+    {
+        return;
+    }
+
+    USHORT* pRow = m_spatial.data() + y * m_width;
+
+    // holes touching the border have only one side and are left alone
+    UINT x = 0;
+    while( x < m_width && 0 == pRow[x] )
+    {
+        ++x;
+    }
+
+    while( x < m_width )
+    {
+        if( 0 != pRow[x] )
+        {
+            ++x;
+            continue;
+        }
+
+        UINT begin = x;
+        while( x < m_width && 0 == pRow[x] )
+        {
+            ++x;
+        }
+
+        if( x < m_width && x - begin <= m_params.cMaxHoleWidth )
+        {
+            USHORT fill = max( pRow[begin - 1], pRow[x] );
+            for( UINT i = begin; i < x; ++i )
+            {
+                pRow[i] = fill;
+            }
+        }
+    }
+}
+
+void DepthFilter::Pack( _In_ const BYTE* pSrc, bool bPixels, UINT y, _Out_ BYTE* pDst ) const
+{
+    const USHORT* pDepth = m_spatial.data() + y * m_width;
+
+    if( bPixels )
+    {
+        const NUI_DEPTH_IMAGE_PIXEL* pIn = reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL*>(pSrc);
+        NUI_DEPTH_IMAGE_PIXEL* pOut = reinterpret_cast<NUI_DEPTH_IMAGE_PIXEL*>(pDst) + y * m_width;
+
+        for( UINT x = 0; x < m_width; ++x )
+        {
+            pOut[x].playerIndex = pIn[x].playerIndex;
+            pOut[x].depth = pDepth[x];
+        }
+        return;
+    }
+
+    const USHORT* pIn = reinterpret_cast<const USHORT*>(pSrc);
+    USHORT* pOut = reinterpret_cast<USHORT*>(pDst) + y * m_width;
+
+    const __m128i playerMask = _mm_set1_epi16( NUI_IMAGE_PLAYER_INDEX_MASK );
+
+    UINT x = 0;
+    for( ; x + 8 <= m_width; x += 8 )
+    {
+        __m128i player = _mm_and_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pIn + x) ), playerMask );
+        __m128i depth = _mm_slli_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pDepth + x) ), NUI_IMAGE_PLAYER_INDEX_SHIFT );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(pOut + x), _mm_or_si128( depth, player ) );
+    }
+
+    for( ; x < m_width; ++x )
+    {
+        pOut[x] = static_cast<USHORT>( pDepth[x] << NUI_IMAGE_PLAYER_INDEX_SHIFT | (pIn[x] & NUI_IMAGE_PLAYER_INDEX_MASK) );
+    }
+}
+
+void DepthFilter::Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels, _Out_ BYTE* pDst )
+{
+    if( nullptr == pSrc || nullptr == pDst || 0 == width || 0 == height )
+    {
+        return;
+    }
+
+    if( width != m_width || height != m_height )
+    {
+        ResetLayout( width, height );
+    }
+
+    const UINT cBands = (height + DEPTH_FILTER_BAND_ROWS - 1) / DEPTH_FILTER_BAND_ROWS;
+
+    // the median reads the rows above and below, so the temporal stage finishes the frame first
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        UINT y1 = min( height, (band + 1) * DEPTH_FILTER_BAND_ROWS );
+        for( UINT y = band * DEPTH_FILTER_BAND_ROWS; y < y1; ++y )
+        {
+            FilterTemporal( pSrc + y * srcPitch, bPixels, y );
+        }
+    });
+
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        UINT y1 = min( height, (band + 1) * DEPTH_FILTER_BAND_ROWS );
+        for( UINT y = band * DEPTH_FILTER_BAND_ROWS; y < y1; ++y )
+        {
+            FilterSpatial( y );
+            FillHoles( y );
+            Pack( pSrc + y * srcPitch, bPixels, y, pDst );
+        }
+    });
+}
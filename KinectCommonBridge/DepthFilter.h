@@ -0,0 +1,66 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// rows handled by a single task
+#define DEPTH_FILTER_BAND_ROWS          16
+
+// used when the caller leaves the value at 0
+#define DEPTH_FILTER_DEFAULT_ALPHA      0.25f
+#define DEPTH_FILTER_DEFAULT_THRESHOLD  50
+
+// temporal/spatial filter chain for the depth stream, applied to the native frame
+// 1. exponential smoothing per pixel, restarted when the depth jumps by more than the motion threshold
+// 2. 3x3 median, keeps depth edges where a box or gaussian filter would blur them
+// 3. horizontal hole filling with the farther of the two bounding depths, so foreground doesn't grow
+// the player index of every pixel is passed through untouched
+class DepthFilter
+{
+public:
+    DepthFilter();
+
+    // nullptr turns it off
+    void SetParameters( _In_opt_ const KINECT_DEPTH_FILTER* pParams );
+    bool IsEnabled() const { return m_bEnabled; }
+
+    // pSrc - native frame rows, srcPitch bytes apart
+    // bPixels = false: packed USHORT (depth << 3 | player), true: NUI_DEPTH_IMAGE_PIXEL
+    // pDst - tightly packed frame of the same format
+    void Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels, _Out_ BYTE* pDst );
+
+private:
+    void ResetLayout( UINT width, UINT height );
+
+    void FilterTemporal( _In_ const BYTE* pSrc, bool bPixels, UINT y );
+    void FilterSpatial( UINT y );
+    void FillHoles( UINT y );
+    void Pack( _In_ const BYTE* pSrc, bool bPixels, UINT y, _Out_ BYTE* pDst ) const;
+
+private:
+    KINECT_DEPTH_FILTER m_params;
+    bool m_bEnabled;
+
+    UINT m_width;
+    UINT m_height;
+
+    // smoothed depth per pixel in millimeters, 0 until the pixel had a valid depth
+    std::vector<float> m_state;
+
+    // depth planes in millimeters after the temporal and the spatial stage
+    std::vector<USHORT> m_temporal;
+    std::vector<USHORT> m_spatial;
+};
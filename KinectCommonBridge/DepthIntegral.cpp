@@ -0,0 +1,265 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "DepthIntegral.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+
+// running sum of the 4 lanes
+static inline __m128i PrefixSum4( __m128i v )
+{
+    v = _mm_add_epi32( v, _mm_slli_si128( v, 4 ) );
+    return _mm_add_epi32( v, _mm_slli_si128( v, 8 ) );
+}
+
+DepthIntegral::DepthIntegral()
+    : m_bEnabled(false)
+    , m_width(0)
+    , m_height(0)
+    , m_stride(0)
+    , m_bResultValid(false)
+{
+}
+
+void DepthIntegral::SetEnabled( bool bEnabled )
+{
+    m_bEnabled = bEnabled;
+    m_bResultValid = false;
+}
+
+void DepthIntegral::ResetLayout( UINT width, UINT height )
+{
+    m_width = width;
+    m_height = height;
+    m_stride = width + 1;
+
+    // the first row and column stay 0
+    m_sum.assign( m_stride * (height + 1), 0 );
+    m_count.assign( m_stride * (height + 1), 0 );
+    m_sumSq.assign( m_stride * (height + 1), 0 );
+}
+
+void DepthIntegral::PrefixRow( _In_ const BYTE* pSrc, bool bPixels, UINT y, USHORT minDepth, USHORT maxDepth )
+{
+    UINT offset = (y + 1) * m_stride + 1;
+    UINT* pSum = m_sum.data() + offset;
+    UINT* pCount = m_count.data() + offset;
+    ULONGLONG* pSumSq = m_sumSq.data() + offset;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i vMin = _mm_set1_epi16( static_cast<short>(minDepth - 1) );
+    const __m128i vMax = _mm_set1_epi16( static_cast<short>(maxDepth + 1) );
+
+    __m128i sumCarry = zero;
+    __m128i countCarry = zero;
+    __m128i sumSqCarry = zero;
+
+    UINT x = 0;
+    for( ; x + 8 <= m_width; x += 8 )
+    {
+        // 8 depths as 16 bit lanes, larger pixel depths saturate and fail the range
+        __m128i depth;
+        if( bPixels )
+        {
+            __m128i lo = _mm_srli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) + x / 4 ), 16 );
+            __m128i hi = _mm_srli_epi32( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc) + x / 4 + 1 ), 16 );
+            depth = _mm_packs_epi32( lo, hi );
+        }
+        else
+        {
+            depth = _mm_srli_epi16( _mm_loadu_si128( reinterpret_cast<const __m128i*>(pSrc + x * sizeof(USHORT)) ), NUI_IMAGE_PLAYER_INDEX_SHIFT );
+        }
+
+        __m128i valid = _mm_and_si128( _mm_cmpgt_epi16( depth, vMin ), _mm_cmplt_epi16( depth, vMax ) );
+        depth = _mm_and_si128( depth, valid );
+        __m128i count = _mm_srli_epi16( valid, 15 );
+
+        // squares of the 16 bit depths as 32 bit lanes
+        __m128i squareLo = _mm_mullo_epi16( depth, depth );
+        __m128i squareHi = _mm_mulhi_epu16( depth, depth );
+
+        __m128i depths[2] = { _mm_unpacklo_epi16( depth, zero ), _mm_unpackhi_epi16( depth, zero ) };
+        __m128i counts[2] = { _mm_unpacklo_epi16( count, zero ), _mm_unpackhi_epi16( count, zero ) };
+        __m128i squares[2] = { _mm_unpacklo_epi16( squareLo, squareHi ), _mm_unpackhi_epi16( squareLo, squareHi ) };
+
+        for( UINT half = 0; half < 2; ++half )
+        {
+            UINT i = x + half * 4;
+
+            __m128i sum = _mm_add_epi32( PrefixSum4( depths[half] ), sumCarry );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>(pSum + i), sum );
+            sumCarry = _mm_shuffle_epi32( sum, _MM_SHUFFLE(3, 3, 3, 3) );
+
+            __m128i counted = _mm_add_epi32( PrefixSum4( counts[half] ), countCarry );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>(pCount + i), counted );
+            countCarry = _mm_shuffle_epi32( counted, _MM_SHUFFLE(3, 3, 3, 3) );
+
+            // 4 squares still fit 32 bits, the running sum is 64 bit
+            __m128i sumSq = PrefixSum4( squares[half] );
+            __m128i sumSqLo = _mm_add_epi64( _mm_unpacklo_epi32( sumSq, zero ), sumSqCarry );
+            __m128i sumSqHi = _mm_add_epi64( _mm_unpackhi_epi32( sumSq, zero ), sumSqCarry );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>(pSumSq + i), sumSqLo );
+            _mm_storeu_si128( reinterpret_cast<__m128i*>(pSumSq + i + 2), sumSqHi );
+            sumSqCarry = _mm_unpackhi_epi64( sumSqHi, sumSqHi );
+        }
+    }
+
+    // rest of the row
+    UINT sum = (0 == x) ? 0 : pSum[x - 1];
+    UINT count = (0 == x) ? 0 : pCount[x - 1];
+    ULONGLONG sumSq = (0 == x) ? 0 : pSumSq[x - 1];
+    for( ; x < m_width; ++x )
+    {
+        USHORT depth = bPixels ? reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL*>(pSrc)[x].depth
+            : reinterpret_cast<const USHORT*>(pSrc)[x] >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+
+        if( depth >= minDepth && depth <= maxDepth )
+        {
+            sum += depth;
+            count += 1;
+            sumSq += static_cast<ULONGLONG>(depth) * depth;
+        }
+
+        pSum[x] = sum;
+        pCount[x] = count;
+        pSumSq[x] = sumSq;
+    }
+}
+
+void DepthIntegral::AccumulateStrip( UINT left, UINT right )
+{
+    for( UINT y = 2; y <= m_height; ++y )
+    {
+        UINT row = y * m_stride;
+        UINT above = row - m_stride;
+
+        UINT x = left;
+        for( ; x + 4 <= right; x += 4 )
+        {
+            __m128i* pSum = reinterpret_cast<__m128i*>(m_sum.data() + row + x);
+            __m128i* pCount = reinterpret_cast<__m128i*>(m_count.data() + row + x);
+            __m128i* pSumSq = reinterpret_cast<__m128i*>(m_sumSq.data() + row + x);
+
+            _mm_storeu_si128( pSum, _mm_add_epi32( _mm_loadu_si128( pSum ),
+                _mm_loadu_si128( reinterpret_cast<const __m128i*>(m_sum.data() + above + x) ) ) );
+            _mm_storeu_si128( pCount, _mm_add_epi32( _mm_loadu_si128( pCount ),
+                _mm_loadu_si128( reinterpret_cast<const __m128i*>(m_count.data() + above + x) ) ) );
+            _mm_storeu_si128( pSumSq, _mm_add_epi64( _mm_loadu_si128( pSumSq ),
+                _mm_loadu_si128( reinterpret_cast<const __m128i*>(m_sumSq.data() + above + x) ) ) );
+            _mm_storeu_si128( pSumSq + 1, _mm_add_epi64( _mm_loadu_si128( pSumSq + 1 ),
+                _mm_loadu_si128( reinterpret_cast<const __m128i*>(m_sumSq.data() + above + x) + 1 ) ) );
+        }
+
+        for( ; x < right; ++x )
+        {
+            m_sum[row + x] += m_sum[above + x];
+            m_count[row + x] += m_count[above + x];
+            m_sumSq[row + x] += m_sumSq[above + x];
+        }
+    }
+}
+
+void DepthIntegral::Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels, USHORT minDepth, USHORT maxDepth )
+{
+    if( width != m_width || height != m_height )
+    {
+        ResetLayout( width, height );
+    }
+
+    // rows are independent, then columns are
+    UINT cBands = (height + DEPTH_INTEGRAL_BAND_ROWS - 1) / DEPTH_INTEGRAL_BAND_ROWS;
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        UINT yEnd = min( height, (band + 1) * DEPTH_INTEGRAL_BAND_ROWS );
+        for( UINT y = band * DEPTH_INTEGRAL_BAND_ROWS; y < yEnd; ++y )
+        {
+            PrefixRow( pSrc + y * srcPitch, bPixels, y, minDepth, maxDepth );
+        }
+    } );
+
+    UINT cStrips = (m_stride + DEPTH_INTEGRAL_STRIP_COLUMNS - 1) / DEPTH_INTEGRAL_STRIP_COLUMNS;
+    Concurrency::parallel_for( 0u, cStrips, [&]( UINT strip )
+    {
+        AccumulateStrip( strip * DEPTH_INTEGRAL_STRIP_COLUMNS, min( m_stride, (strip + 1) * DEPTH_INTEGRAL_STRIP_COLUMNS ) );
+    } );
+
+    m_bResultValid = true;
+}
+
+HRESULT DepthIntegral::GetRegionStats( const ImageTransform& transform, ULONG cRegions, _In_count_(cRegions) const RECT* pRegions,
+    _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats ) const
+{
+    if( !m_bEnabled || !m_bResultValid )
+    {
+        return E_NUI_FRAME_NO_DATA;
+    }
+
+    UINT outWidth = 0, outHeight = 0;
+    transform.GetOutputSize( m_width, m_height, outWidth, outHeight );
+
+    for( ULONG i = 0; i < cRegions; ++i )
+    {
+        KINECT_DEPTH_REGION_STATS& stats = pStats[i];
+        ZeroMemory( &stats, sizeof(KINECT_DEPTH_REGION_STATS) );
+
+        // clip to the frame, empty regions keep zero statistics
+        LONG left = max( pRegions[i].left, 0L );
+        LONG top = max( pRegions[i].top, 0L );
+        LONG right = min( pRegions[i].right, static_cast<LONG>(outWidth) );
+        LONG bottom = min( pRegions[i].bottom, static_cast<LONG>(outHeight) );
+        if( left >= right || top >= bottom )
+        {
+            continue;
+        }
+
+        // mirror and rotation keep a rectangle a rectangle, so the corners are enough
+        LONG x0 = left, y0 = top, x1 = right - 1, y1 = bottom - 1;
+        if( !transform.IsIdentity() )
+        {
+            transform.InverseTransformPoint( m_width, m_height, left, top, x0, y0 );
+            transform.InverseTransformPoint( m_width, m_height, right - 1, bottom - 1, x1, y1 );
+        }
+
+        UINT nativeLeft = min( x0, x1 ), nativeRight = max( x0, x1 ) + 1;
+        UINT nativeTop = min( y0, y1 ), nativeBottom = max( y0, y1 ) + 1;
+
+        UINT topLeft = nativeTop * m_stride + nativeLeft;
+        UINT topRight = nativeTop * m_stride + nativeRight;
+        UINT bottomLeft = nativeBottom * m_stride + nativeLeft;
+        UINT bottomRight = nativeBottom * m_stride + nativeRight;
+
+        // unsigned wrap around cancels out
+        UINT sum = m_sum[bottomRight] - m_sum[topRight] - m_sum[bottomLeft] + m_sum[topLeft];
+        UINT count = m_count[bottomRight] - m_count[topRight] - m_count[bottomLeft] + m_count[topLeft];
+        ULONGLONG sumSq = m_sumSq[bottomRight] - m_sumSq[topRight] - m_sumSq[bottomLeft] + m_sumSq[topLeft];
+
+        stats.cPixels = (nativeRight - nativeLeft) * (nativeBottom - nativeTop);
+        stats.cValidPixels = count;
+        stats.fValidRatio = static_cast<float>(count) / stats.cPixels;
+
+        if( 0 != count )
+        {
+            double mean = static_cast<double>(sum) / count;
+            double variance = static_cast<double>(sumSq) / count - mean * mean;
+
+            stats.fMeanDepth = static_cast<float>(mean);
+            stats.fVariance = static_cast<float>( max( variance, 0.0 ) );
+        }
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,65 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+#include "ImageTransform.h"
+
+// rows prefixed by a single task
+#define DEPTH_INTEGRAL_BAND_ROWS        16
+
+// columns accumulated by a single task
+#define DEPTH_INTEGRAL_STRIP_COLUMNS    64
+
+// summed area tables of the native depth frame: sum, sum of squares and count of the
+// pixels with a valid depth, so the statistics of any rectangle take four reads per table
+// the tables are (width + 1) x (height + 1) with a zero first row and column; they are built
+// with the prefix of every row in row bands, followed by the accumulation of the rows in column strips
+class DepthIntegral
+{
+public:
+    DepthIntegral();
+
+    void SetEnabled( bool bEnabled );
+    bool IsEnabled() const { return m_bEnabled; }
+
+    // pSrc - native frame rows, srcPitch bytes apart
+    // bPixels = false: packed USHORT (depth << 3 | player), true: NUI_DEPTH_IMAGE_PIXEL
+    // minDepth..maxDepth - valid range in mm
+    void Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels, USHORT minDepth, USHORT maxDepth );
+
+    // statistics of the last frame, the regions are in the orientation of the transform
+    HRESULT GetRegionStats( const ImageTransform& transform, ULONG cRegions, _In_count_(cRegions) const RECT* pRegions,
+        _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats ) const;
+
+private:
+    void ResetLayout( UINT width, UINT height );
+    void PrefixRow( _In_ const BYTE* pSrc, bool bPixels, UINT y, USHORT minDepth, USHORT maxDepth );
+    void AccumulateStrip( UINT left, UINT right );
+
+private:
+    bool m_bEnabled;
+
+    UINT m_width;
+    UINT m_height;
+    UINT m_stride;
+
+    // (m_width + 1) x (m_height + 1), the sum fits 32 bits up to 640x480 pixels of 13 bit depth
+    std::vector<UINT> m_sum;
+    std::vector<UINT> m_count;
+    std::vector<ULONGLONG> m_sumSq;
+
+    bool m_bResultValid;
+};
@@ -25,6 +25,7 @@ FaceTracker::FaceTracker(KinectSensor* pSensor, bool bNearMode)
     , m_pSensor(pSensor)
     , m_pFaceTracker(nullptr)
     , m_bNearMode(bNearMode)
+    , m_dwHintTrackingID(0)
 {
     Reset();
 }
@@ -120,7 +121,9 @@ HRESULT FaceTracker::Initialize(_In_ DataStreamColor* pColorStream, _In_ DataStr
         {
             m_HeadPoint[i] = m_NeckPoint[i] = FT_VECTOR3D(0, 0, 0);
             m_SkeletonTracked[i] = false;
+            m_TrackingIDs[i] = 0;
         }
+        m_dwHintTrackingID = 0;
     }
 
     return hr;
@@ -352,48 +355,46 @@ HRESULT FaceTracker::VisualizeFaceModel(IFTImage* pColorImg, IFTModel* pModel, F
 
 HRESULT FaceTracker::GetClosestHint(FT_VECTOR3D* pHint3D)
 {
-    int selectedSkeleton = -1;
-    float smallestDistance = 0;
-
     if (!pHint3D)
     {
         return(E_POINTER);
     }
 
-    if (pHint3D[1].x == 0 && pHint3D[1].y == 0 && pHint3D[1].z == 0)
+    // Follow the player chosen by the skeleton stream, when its chooser mode chooses none
+    // stay on the skeleton the face was on, otherwise take the one closest to the camera
+    DWORD chosenID = m_pSensor->GetChosenSkeletonID();
+    int chosenSkeleton = -1;
+    int hintSkeleton = -1;
+    int closestSkeleton = -1;
+    for (int i = 0 ; i < NUI_SKELETON_COUNT ; i++ )
     {
-        // Get the skeleton closest to the camera
-        for (int i = 0 ; i < NUI_SKELETON_COUNT ; i++ )
+        if (!m_SkeletonTracked[i])
         {
-            if (m_SkeletonTracked[i] && (smallestDistance == 0 || m_HeadPoint[i].z < smallestDistance))
-            {
-                smallestDistance = m_HeadPoint[i].z;
-                selectedSkeleton = i;
-            }
+            continue;
         }
-    }
-    else
-    {   // Get the skeleton closest to the previous position
-        for (int i = 0 ; i < NUI_SKELETON_COUNT ; i++ )
+
+        if (0 != chosenID && m_TrackingIDs[i] == chosenID)
         {
-            if (m_SkeletonTracked[i])
-            {
-                float d = abs(m_HeadPoint[i].x - pHint3D[1].x) +
-                    abs(m_HeadPoint[i].y - pHint3D[1].y) +
-                    abs(m_HeadPoint[i].z - pHint3D[1].z);
-                if (smallestDistance == 0 || d < smallestDistance)
-                {
-                    smallestDistance = d;
-                    selectedSkeleton = i;
-                }
-            }
+            chosenSkeleton = i;
+        }
+        if (0 != m_dwHintTrackingID && m_TrackingIDs[i] == m_dwHintTrackingID)
+        {
+            hintSkeleton = i;
+        }
+        if (closestSkeleton == -1 || m_HeadPoint[i].z < m_HeadPoint[closestSkeleton].z)
+        {
+            closestSkeleton = i;
         }
     }
+
+    int selectedSkeleton = (chosenSkeleton != -1) ? chosenSkeleton : ((hintSkeleton != -1) ? hintSkeleton : closestSkeleton);
     if (selectedSkeleton == -1)
     {
+        m_dwHintTrackingID = 0;
         return E_FAIL;
     }
 
+    m_dwHintTrackingID = m_TrackingIDs[selectedSkeleton];
     pHint3D[0] = m_NeckPoint[selectedSkeleton];
     pHint3D[1] = m_HeadPoint[selectedSkeleton];
 
@@ -420,6 +421,7 @@ HRESULT FaceTracker::GetSkeletonFrame()
             NUI_SKELETON_POSITION_TRACKED == pSkeleton.SkeletonData[i].eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_SHOULDER_CENTER])
         {
             m_SkeletonTracked[i] = true;
+            m_TrackingIDs[i] = pSkeleton.SkeletonData[i].dwTrackingID;
             m_HeadPoint[i].x = pSkeleton.SkeletonData[i].SkeletonPositions[NUI_SKELETON_POSITION_HEAD].x;
             m_HeadPoint[i].y = pSkeleton.SkeletonData[i].SkeletonPositions[NUI_SKELETON_POSITION_HEAD].y;
             m_HeadPoint[i].z = pSkeleton.SkeletonData[i].SkeletonPositions[NUI_SKELETON_POSITION_HEAD].z;
@@ -432,6 +434,7 @@ HRESULT FaceTracker::GetSkeletonFrame()
         {
             m_HeadPoint[i] = m_NeckPoint[i] = FT_VECTOR3D(0, 0, 0);
             m_SkeletonTracked[i] = false;
+            m_TrackingIDs[i] = 0;
         }
     }	
 
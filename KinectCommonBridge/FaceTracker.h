@@ -49,6 +49,8 @@ private:
     FT_VECTOR3D m_NeckPoint[NUI_SKELETON_COUNT];
     FT_VECTOR3D m_HeadPoint[NUI_SKELETON_COUNT];
     bool m_SkeletonTracked[NUI_SKELETON_COUNT];
+    DWORD m_TrackingIDs[NUI_SKELETON_COUNT];
+    DWORD m_dwHintTrackingID;
 
     ComSmartPtr<IFTFaceTracker>     m_pFaceTracker;
     ComSmartPtr<IFTResult>          m_pFTResult;
@@ -0,0 +1,446 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "GestureRecognizer.h"
+
+#include <ppl.h>
+#include <algorithm>
+#include <xmmintrin.h>
+#include <math.h>
+#include <float.h>
+
+// squared distance of two frames of features, cDims a multiple of 4
+static inline float Distance( _In_ const float* pA, _In_ const float* pB, UINT cDims )
+{
+    __m128 sum = _mm_setzero_ps();
+    for( UINT d = 0; d < cDims; d += 4 )
+    {
+        __m128 diff = _mm_sub_ps( _mm_loadu_ps( pA + d ), _mm_loadu_ps( pB + d ) );
+        sum = _mm_add_ps( sum, _mm_mul_ps( diff, diff ) );
+    }
+
+    sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+    sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+    return _mm_cvtss_f32( sum );
+}
+
+GestureRecognizer::GestureRecognizer()
+    : m_dwNextGestureID(1)
+{
+    for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+    {
+        m_players[p].frames.resize( GESTURE_MAX_FRAMES * NUI_SKELETON_POSITION_COUNT * 3 );
+    }
+
+    Reset();
+}
+
+void GestureRecognizer::Reset()
+{
+    for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+    {
+        m_players[p].dwTrackingID = 0;
+        m_players[p].liLastTimeStamp = 0;
+        m_players[p].head = 0;
+        m_players[p].count = 0;
+    }
+
+    for( size_t t = 0; t < m_templates.size(); ++t )
+    {
+        ZeroMemory( m_templates[t]->players, sizeof(m_templates[t]->players) );
+    }
+
+    m_events.clear();
+}
+
+bool GestureRecognizer::Normalize( _In_count_(NUI_SKELETON_POSITION_COUNT) const Vector4* pPositions, _Out_cap_(NUI_SKELETON_POSITION_COUNT * 3) float* pNormalized )
+{
+    const Vector4& hip = pPositions[NUI_SKELETON_POSITION_HIP_CENTER];
+    const Vector4& shoulder = pPositions[NUI_SKELETON_POSITION_SHOULDER_CENTER];
+    const Vector4& left = pPositions[NUI_SKELETON_POSITION_SHOULDER_LEFT];
+    const Vector4& right = pPositions[NUI_SKELETON_POSITION_SHOULDER_RIGHT];
+
+    float torso = sqrtf( (shoulder.x - hip.x) * (shoulder.x - hip.x) + (shoulder.y - hip.y) * (shoulder.y - hip.y) + (shoulder.z - hip.z) * (shoulder.z - hip.z) );
+    if( torso < 0.01f )
+    {
+        return false;
+    }
+
+    // heading of the shoulders around the vertical axis
+    float dx = right.x - left.x;
+    float dz = right.z - left.z;
+    float width = sqrtf( dx * dx + dz * dz );
+    float cosine = 1.0f, sine = 0.0f;
+    if( width > 0.01f )
+    {
+        cosine = dx / width;
+        sine = dz / width;
+    }
+
+    float scale = 1.0f / torso;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        float x = pPositions[j].x - hip.x;
+        float y = pPositions[j].y - hip.y;
+        float z = pPositions[j].z - hip.z;
+
+        pNormalized[j * 3] = (cosine * x + sine * z) * scale;
+        pNormalized[j * 3 + 1] = y * scale;
+        pNormalized[j * 3 + 2] = (cosine * z - sine * x) * scale;
+    }
+
+    return true;
+}
+
+HRESULT GestureRecognizer::AddTemplate( _In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID )
+{
+    DWORD dwJointMask = pTemplate->dwJointMask & ((1 << NUI_SKELETON_POSITION_COUNT) - 1);
+    if( 0 == dwJointMask || nullptr == pTemplate->pPositions || 2 > pTemplate->cFrames || GESTURE_MAX_FRAMES < pTemplate->cFrames )
+    {
+        return E_INVALIDARG;
+    }
+
+    std::unique_ptr<Template> gesture( new (std::nothrow) Template() );
+    if( nullptr == gesture )
+    {
+        return E_OUTOFMEMORY;
+    }
+
+    gesture->cFrames = pTemplate->cFrames;
+    gesture->fThreshold = (0.0f < pTemplate->fThreshold) ? pTemplate->fThreshold : GESTURE_DEFAULT_THRESHOLD;
+
+    float band = (0.0f < pTemplate->fBand) ? min( pTemplate->fBand, 1.0f ) : GESTURE_DEFAULT_BAND;
+    gesture->cBand = max( 1u, static_cast<UINT>( band * gesture->cFrames + 0.5f ) );
+
+    gesture->cJoints = 0;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        if( 0 != (dwJointMask & (1 << j)) )
+        {
+            gesture->joints[gesture->cJoints++] = j;
+        }
+    }
+    gesture->cDims = (gesture->cJoints * 3 + 3) & ~3u;
+
+    // the joints of the template frames, normalized like the players
+    UINT cDims = gesture->cDims;
+    gesture->frames.assign( gesture->cFrames * cDims, 0.0f );
+    for( UINT f = 0; f < gesture->cFrames; ++f )
+    {
+        float normalized[NUI_SKELETON_POSITION_COUNT * 3];
+        if( !Normalize( pTemplate->pPositions + f * NUI_SKELETON_POSITION_COUNT, normalized ) )
+        {
+            return E_INVALIDARG;
+        }
+
+        for( UINT i = 0; i < gesture->cJoints; ++i )
+        {
+            memcpy( &gesture->frames[f * cDims + i * 3], &normalized[gesture->joints[i] * 3], 3 * sizeof(float) );
+        }
+    }
+
+    // envelope of the frames a warping path can reach within the band
+    gesture->upper.resize( gesture->frames.size() );
+    gesture->lower.resize( gesture->frames.size() );
+    for( UINT f = 0; f < gesture->cFrames; ++f )
+    {
+        UINT first = (f > gesture->cBand) ? f - gesture->cBand : 0;
+        UINT last = min( gesture->cFrames - 1, f + gesture->cBand );
+        for( UINT d = 0; d < cDims; ++d )
+        {
+            float upper = -FLT_MAX, lower = FLT_MAX;
+            for( UINT k = first; k <= last; ++k )
+            {
+                upper = max( upper, gesture->frames[k * cDims + d] );
+                lower = min( lower, gesture->frames[k * cDims + d] );
+            }
+            gesture->upper[f * cDims + d] = upper;
+            gesture->lower[f * cDims + d] = lower;
+        }
+    }
+
+    gesture->query.resize( gesture->frames.size() );
+    gesture->rows[0].resize( gesture->cFrames + 1 );
+    gesture->rows[1].resize( gesture->cFrames + 1 );
+    ZeroMemory( gesture->players, sizeof(gesture->players) );
+
+    gesture->dwGestureID = m_dwNextGestureID++;
+    *pdwGestureID = gesture->dwGestureID;
+
+    m_templates.push_back( std::move( gesture ) );
+
+    return S_OK;
+}
+
+HRESULT GestureRecognizer::RemoveTemplate( DWORD dwGestureID )
+{
+    if( 0 == dwGestureID )
+    {
+        m_templates.clear();
+        return S_OK;
+    }
+
+    for( size_t t = 0; t < m_templates.size(); ++t )
+    {
+        if( m_templates[t]->dwGestureID == dwGestureID )
+        {
+            m_templates.erase( m_templates.begin() + t );
+            return S_OK;
+        }
+    }
+
+    return E_INVALIDARG;
+}
+
+void GestureRecognizer::BuildQuery( _In_ const Player& player, _Inout_ Template& gesture ) const
+{
+    UINT cDims = gesture.cDims;
+    for( UINT f = 0; f < gesture.cFrames; ++f )
+    {
+        UINT frame = (player.head + GESTURE_MAX_FRAMES - gesture.cFrames + f) % GESTURE_MAX_FRAMES;
+        const float* pFrame = &player.frames[frame * NUI_SKELETON_POSITION_COUNT * 3];
+
+        for( UINT i = 0; i < gesture.cJoints; ++i )
+        {
+            memcpy( &gesture.query[f * cDims + i * 3], pFrame + gesture.joints[i] * 3, 3 * sizeof(float) );
+        }
+    }
+}
+
+float GestureRecognizer::LowerBound( _In_ const Template& gesture, float limit )
+{
+    const __m128 zero = _mm_setzero_ps();
+
+    float bound = 0.0f;
+    for( UINT f = 0; f < gesture.cFrames; ++f )
+    {
+        const float* pQuery = &gesture.query[f * gesture.cDims];
+        const float* pUpper = &gesture.upper[f * gesture.cDims];
+        const float* pLower = &gesture.lower[f * gesture.cDims];
+
+        __m128 sum = zero;
+        for( UINT d = 0; d < gesture.cDims; d += 4 )
+        {
+            __m128 query = _mm_loadu_ps( pQuery + d );
+
+            // at most one of them is above 0
+            __m128 above = _mm_max_ps( _mm_sub_ps( query, _mm_loadu_ps( pUpper + d ) ), zero );
+            __m128 below = _mm_max_ps( _mm_sub_ps( _mm_loadu_ps( pLower + d ), query ), zero );
+            __m128 outside = _mm_add_ps( above, below );
+            sum = _mm_add_ps( sum, _mm_mul_ps( outside, outside ) );
+        }
+
+        sum = _mm_add_ps( sum, _mm_movehl_ps( sum, sum ) );
+        sum = _mm_add_ss( sum, _mm_shuffle_ps( sum, sum, 1 ) );
+        bound += _mm_cvtss_f32( sum );
+
+        if( bound > limit )
+        {
+            break;
+        }
+    }
+
+    return bound;
+}
+
+float GestureRecognizer::Warp( _Inout_ Template& gesture, float limit )
+{
+    UINT n = gesture.cFrames;
+    UINT band = gesture.cBand;
+
+    float* pPrevious = gesture.rows[0].data();
+    float* pCurrent = gesture.rows[1].data();
+    std::fill( gesture.rows[0].begin(), gesture.rows[0].end(), FLT_MAX );
+    std::fill( gesture.rows[1].begin(), gesture.rows[1].end(), FLT_MAX );
+    pPrevious[0] = 0.0f;
+
+    for( UINT i = 1; i <= n; ++i )
+    {
+        UINT first = (i > band) ? i - band : 1;
+        UINT last = min( n, i + band );
+
+        // left of the band
+        pCurrent[first - 1] = FLT_MAX;
+
+        const float* pQuery = &gesture.query[(i - 1) * gesture.cDims];
+        float rowMin = FLT_MAX;
+        for( UINT j = first; j <= last; ++j )
+        {
+            float best = min( pPrevious[j - 1], min( pPrevious[j], pCurrent[j - 1] ) );
+            float cost = best + Distance( pQuery, &gesture.frames[(j - 1) * gesture.cDims], gesture.cDims );
+            pCurrent[j] = cost;
+            rowMin = min( rowMin, cost );
+        }
+
+        // every path through the row is already too long
+        if( rowMin > limit )
+        {
+            return FLT_MAX;
+        }
+
+        std::swap( pPrevious, pCurrent );
+    }
+
+    return pPrevious[n];
+}
+
+void GestureRecognizer::AddEvent( DWORD dwGestureID, DWORD dwTrackingID, LONGLONG liTimeStamp, float fDistance, float fThreshold )
+{
+    if( m_events.size() >= GESTURE_MAX_EVENTS )
+    {
+        m_events.erase( m_events.begin() );
+    }
+
+    KINECT_GESTURE_EVENT gestureEvent;
+    gestureEvent.dwGestureID = dwGestureID;
+    gestureEvent.dwTrackingID = dwTrackingID;
+    gestureEvent.liTimeStamp = liTimeStamp;
+    gestureEvent.fDistance = fDistance;
+    gestureEvent.fConfidence = max( 0.0f, 1.0f - fDistance / fThreshold );
+    m_events.push_back( gestureEvent );
+}
+
+void GestureRecognizer::Process( _In_ const NUI_SKELETON_FRAME& skeletonFrame )
+{
+    if( m_templates.empty() )
+    {
+        return;
+    }
+
+    LONGLONG liTimeStamp = skeletonFrame.liTimeStamp.QuadPart;
+
+    // add the frame to the players
+    bool bMatch[NUI_SKELETON_COUNT] = { false };
+    bool bAny = false;
+    for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[p];
+        Player& player = m_players[p];
+
+        bool bTracked = NUI_SKELETON_TRACKED == skeleton.eTrackingState;
+        if( !bTracked || player.dwTrackingID != skeleton.dwTrackingID )
+        {
+            player.dwTrackingID = bTracked ? skeleton.dwTrackingID : 0;
+            player.head = 0;
+            player.count = 0;
+            player.liLastTimeStamp = 0;
+
+            for( size_t t = 0; t < m_templates.size(); ++t )
+            {
+                ZeroMemory( &m_templates[t]->players[p], sizeof(PlayerState) );
+            }
+        }
+
+        if( !bTracked || (0 != player.count && liTimeStamp <= player.liLastTimeStamp) )
+        {
+            continue;
+        }
+
+        if( !Normalize( skeleton.SkeletonPositions, &player.frames[player.head * NUI_SKELETON_POSITION_COUNT * 3] ) )
+        {
+            continue;
+        }
+
+        player.head = (player.head + 1) % GESTURE_MAX_FRAMES;
+        player.count = min( player.count + 1, static_cast<UINT>(GESTURE_MAX_FRAMES) );
+        player.liLastTimeStamp = liTimeStamp;
+
+        bMatch[p] = true;
+        bAny = true;
+    }
+
+    if( !bAny )
+    {
+        return;
+    }
+
+    // every template on its own task, it only writes its own scratch and distances
+    Concurrency::parallel_for( size_t(0), m_templates.size(), [&]( size_t t )
+    {
+        Template& gesture = *m_templates[t];
+        for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+        {
+            gesture.fDistance[p] = FLT_MAX;
+            if( !bMatch[p] || m_players[p].count < gesture.cFrames )
+            {
+                continue;
+            }
+
+            // squared distances summed over the frames and joints
+            float limit = gesture.fThreshold * gesture.fThreshold * gesture.cFrames * gesture.cJoints;
+
+            BuildQuery( m_players[p], gesture );
+            if( LowerBound( gesture, limit ) > limit )
+            {
+                continue;
+            }
+
+            float distance = Warp( gesture, limit );
+            if( distance <= limit )
+            {
+                // root mean square distance of the joints, in torso lengths
+                gesture.fDistance[p] = sqrtf( distance / (gesture.cFrames * gesture.cJoints) );
+            }
+        }
+    } );
+
+    // fire at the lowest distance, once it rises again
+    for( size_t t = 0; t < m_templates.size(); ++t )
+    {
+        Template& gesture = *m_templates[t];
+        for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+        {
+            if( !bMatch[p] )
+            {
+                continue;
+            }
+
+            PlayerState& state = gesture.players[p];
+            if( 0 < state.cRestFrames )
+            {
+                --state.cRestFrames;
+                continue;
+            }
+
+            float distance = gesture.fDistance[p];
+            if( FLT_MAX != distance && (0.0f == state.fPending || distance < state.fPending) )
+            {
+                // 0 means none pending
+                state.fPending = max( distance, FLT_MIN );
+                state.liPending = liTimeStamp;
+            }
+            else if( 0.0f != state.fPending )
+            {
+                AddEvent( gesture.dwGestureID, m_players[p].dwTrackingID, state.liPending, state.fPending, gesture.fThreshold );
+
+                state.fPending = 0.0f;
+                state.cRestFrames = gesture.cFrames / 2;
+            }
+        }
+    }
+}
+
+void GestureRecognizer::GetEvents( ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents )
+{
+    ULONG cEvents = min( cMaxEvents, static_cast<ULONG>(m_events.size()) );
+    for( ULONG i = 0; i < cEvents; ++i )
+    {
+        pEvents[i] = m_events[i];
+    }
+
+    m_events.erase( m_events.begin(), m_events.begin() + cEvents );
+    *pcEvents = cEvents;
+}
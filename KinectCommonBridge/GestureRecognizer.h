@@ -0,0 +1,123 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// longest template, and the frames of every player kept to match it
+#define GESTURE_MAX_FRAMES              120
+
+// events waiting to be read, the oldest are dropped
+#define GESTURE_MAX_EVENTS              64
+
+// used when the caller leaves the value at 0
+#define GESTURE_DEFAULT_THRESHOLD       0.3f    // torso lengths
+#define GESTURE_DEFAULT_BAND            0.2f    // of the template length
+
+// template gestures recognized in the skeleton frames by dynamic time warping
+// skeletons are normalized to the body: hip center at the origin, shoulders along x and
+// the torso (hip center to shoulder center) as unit of length, so templates match players of
+// every size, place and heading; every frame the last frames of every player are matched against
+// every template of the same length, within a Sakoe-Chiba band; the LB_Keogh bound of the
+// template envelope skips most templates, and a warping path over the threshold is abandoned
+// early; templates run in parallel, the distances of the joints 4 floats at a time
+// a gesture fires at the frame its distance is lowest, then rests for half its length
+class GestureRecognizer
+{
+public:
+    GestureRecognizer();
+
+    HRESULT AddTemplate( _In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID );
+
+    // 0 removes every template
+    HRESULT RemoveTemplate( DWORD dwGestureID );
+
+    bool IsEnabled() const { return !m_templates.empty(); }
+
+    void Reset();
+
+    // matches the tracked skeletons of the frame, a frame that is not newer than the last one is skipped
+    void Process( _In_ const NUI_SKELETON_FRAME& skeletonFrame );
+
+    // takes the events out of the queue, oldest first
+    void GetEvents( ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents );
+
+private:
+    // joints * 3 floats of a frame, padded to a multiple of 4
+    typedef std::vector<float> Features;
+
+    struct PlayerState
+    {
+        float fPending;             // lowest distance under the threshold not fired yet, 0 for none
+        LONGLONG liPending;
+        UINT cRestFrames;
+    };
+
+    struct Template
+    {
+        DWORD dwGestureID;
+        UINT cFrames;
+        UINT cBand;
+        UINT cDims;
+        UINT cJoints;
+        UINT joints[NUI_SKELETON_POSITION_COUNT];
+        float fThreshold;
+
+        // cFrames * cDims, and the envelope of the band
+        Features frames;
+        Features upper;
+        Features lower;
+
+        PlayerState players[NUI_SKELETON_COUNT];
+
+        // of the task matching the template
+        Features query;
+        std::vector<float> rows[2];
+        float fDistance[NUI_SKELETON_COUNT];
+    };
+
+    struct Player
+    {
+        DWORD dwTrackingID;
+        LONGLONG liLastTimeStamp;
+        UINT head;                  // next frame written
+        UINT count;
+
+        // ring of GESTURE_MAX_FRAMES normalized frames, NUI_SKELETON_POSITION_COUNT * 3 floats each
+        std::vector<float> frames;
+    };
+
+    // body relative joints, false for a skeleton without a torso
+    static bool Normalize( _In_count_(NUI_SKELETON_POSITION_COUNT) const Vector4* pPositions, _Out_cap_(NUI_SKELETON_POSITION_COUNT * 3) float* pNormalized );
+
+    // the joints of the template of the last cFrames frames of the player
+    void BuildQuery( _In_ const Player& player, _Inout_ Template& gesture ) const;
+
+    // squared distance of the query to the envelope, stops once over the limit
+    static float LowerBound( _In_ const Template& gesture, float limit );
+
+    // squared banded DTW distance, stops once over the limit
+    static float Warp( _Inout_ Template& gesture, float limit );
+
+    void AddEvent( DWORD dwGestureID, DWORD dwTrackingID, LONGLONG liTimeStamp, float fDistance, float fThreshold );
+
+private:
+    std::vector<std::unique_ptr<Template>> m_templates;
+    DWORD m_dwNextGestureID;
+
+    Player m_players[NUI_SKELETON_COUNT];
+
+    std::vector<KINECT_GESTURE_EVENT> m_events;
+};
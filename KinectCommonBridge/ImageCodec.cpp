@@ -0,0 +1,603 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "ImageCodec.h"
+
+#include <ppl.h>
+
+// 'KCBI'
+static const UINT32 IMAGE_CODEC_MAGIC = 0x4942434b;
+
+// rows in a band, bands are the unit of parallel work
+static const UINT32 IMAGE_CODEC_BAND_ROWS = 32;
+
+// largest image of a NUI stream, 1280x960 at 4 bytes per pixel, the sizes of a header are checked against it
+static const ULONGLONG IMAGE_CODEC_MAX_IMAGE_BYTES = 1280 * 960 * 4;
+
+// op tags, the two bit prefix matches QOI
+#define CODEC_OP_INDEX      0x00    // 00xxxxxx  value from the recently seen table
+#define CODEC_OP_DIFF       0x40    // 01xxxxxx  small difference to the previous value
+#define CODEC_OP_LUMA       0x80    // 10xxxxxx  larger difference, one more byte
+#define CODEC_OP_RUN        0xc0    // 11xxxxxx  previous value repeated 1-62 times
+#define CODEC_OP_FULL       0xfe    // value follows
+#define CODEC_OP_FULL_ALPHA 0xff    // 4 byte pixel with its alpha follows
+#define CODEC_OP_MASK       0xc0
+#define CODEC_MAX_RUN       62
+
+struct ImageCodecHeader
+{
+    UINT32 magic;
+    UINT32 width;
+    UINT32 height;
+    UINT32 bytesPerPixel;
+    UINT32 bandRows;
+    UINT32 cBands;
+};
+
+// largest possible op for a single pixel
+static size_t GetWorstCaseBytes( UINT32 bytesPerPixel )
+{
+    return (4 == bytesPerPixel) ? 5 : bytesPerPixel + 1;
+}
+
+//
+// 4 byte pixels, channels are named after BGRX so green is the luma reference
+//
+static inline UINT HashPixel( UINT32 px )
+{
+    return ( (px & 0xff) * 7 + (px >> 8 & 0xff) * 5 + (px >> 16 & 0xff) * 3 + (px >> 24) * 11 ) & 63;
+}
+
+static BYTE* EncodeBand32( _In_ const UINT32* pSrc, size_t cPixels, _Out_ BYTE* pOut )
+{
+    UINT32 index[64] = { 0 };
+    UINT32 prev = 0xff000000;
+    UINT run = 0;
+
+    for( size_t i = 0; i < cPixels; ++i )
+    {
+        UINT32 px = pSrc[i];
+
+        if( px == prev )
+        {
+            if( ++run == CODEC_MAX_RUN )
+            {
+                *pOut++ = static_cast<BYTE>( CODEC_OP_RUN | (run - 1) );
+                run = 0;
+            }
+            continue;
+        }
+
+        if( run > 0 )
+        {
+            *pOut++ = static_cast<BYTE>( CODEC_OP_RUN | (run - 1) );
+            run = 0;
+        }
+
+        UINT hash = HashPixel( px );
+        if( index[hash] == px )
+        {
+            *pOut++ = static_cast<BYTE>( CODEC_OP_INDEX | hash );
+        }
+        else
+        {
+            index[hash] = px;
+
+            if( (px >> 24) == (prev >> 24) )
+            {
+                // differences wrap around like the byte arithmetic of the decoder
+                int db = static_cast<signed char>( (px & 0xff) - (prev & 0xff) );
+                int dg = static_cast<signed char>( (px >> 8 & 0xff) - (prev >> 8 & 0xff) );
+                int dr = static_cast<signed char>( (px >> 16 & 0xff) - (prev >> 16 & 0xff) );
+                int dr_dg = dr - dg;
+                int db_dg = db - dg;
+
+                if( dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1 )
+                {
+                    *pOut++ = static_cast<BYTE>( CODEC_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2) );
+                }
+                else if( dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7 )
+                {
+                    *pOut++ = static_cast<BYTE>( CODEC_OP_LUMA | (dg + 32) );
+                    *pOut++ = static_cast<BYTE>( (dr_dg + 8) << 4 | (db_dg + 8) );
+                }
+                else
+                {
+                    *pOut++ = CODEC_OP_FULL;
+                    *pOut++ = static_cast<BYTE>( px );
+                    *pOut++ = static_cast<BYTE>( px >> 8 );
+                    *pOut++ = static_cast<BYTE>( px >> 16 );
+                }
+            }
+            else
+            {
+                *pOut++ = CODEC_OP_FULL_ALPHA;
+                *pOut++ = static_cast<BYTE>( px );
+                *pOut++ = static_cast<BYTE>( px >> 8 );
+                *pOut++ = static_cast<BYTE>( px >> 16 );
+                *pOut++ = static_cast<BYTE>( px >> 24 );
+            }
+        }
+
+        prev = px;
+    }
+
+    if( run > 0 )
+    {
+        *pOut++ = static_cast<BYTE>( CODEC_OP_RUN | (run - 1) );
+    }
+
+    return pOut;
+}
+
+static bool DecodeBand32( _In_ const BYTE* pIn, _In_ const BYTE* pEnd, size_t cPixels, _Out_ UINT32* pDst )
+{
+    UINT32 index[64] = { 0 };
+    UINT32 px = 0xff000000;
+    size_t i = 0;
+
+    while( i < cPixels )
+    {
+        if( pIn >= pEnd )
+        {
+            return false;
+        }
+
+        BYTE op = *pIn++;
+
+        if( CODEC_OP_FULL == op )
+        {
+            if( pEnd - pIn < 3 )
+            {
+                return false;
+            }
+            px = (px & 0xff000000) | pIn[0] | pIn[1] << 8 | pIn[2] << 16;
+            pIn += 3;
+        }
+        else if( CODEC_OP_FULL_ALPHA == op )
+        {
+            if( pEnd - pIn < 4 )
+            {
+                return false;
+            }
+            px = pIn[0] | pIn[1] << 8 | pIn[2] << 16 | static_cast<UINT32>(pIn[3]) << 24;
+            pIn += 4;
+        }
+        else
+        {
+            int db = 0, dg = 0, dr = 0;
+
+            switch( op & CODEC_OP_MASK )
+            {
+            case CODEC_OP_INDEX:
+                px = index[op];
+                break;
+
+            case CODEC_OP_DIFF:
+                dr = (op >> 4 & 3) - 2;
+                dg = (op >> 2 & 3) - 2;
+                db = (op & 3) - 2;
+                break;
+
+            case CODEC_OP_LUMA:
+                if( pIn >= pEnd )
+                {
+                    return false;
+                }
+                dg = (op & 0x3f) - 32;
+                dr = dg + (*pIn >> 4) - 8;
+                db = dg + (*pIn & 0x0f) - 8;
+                ++pIn;
+                break;
+
+            default: // CODEC_OP_RUN
+                {
+                    size_t run = (op & 0x3f) + 1;
+                    if( run > cPixels - i )
+                    {
+                        return false;
+                    }
+                    for( ; run > 0; --run )
+                    {
+                        pDst[i++] = px;
+                    }
+                }
+                continue;
+            }
+
+            if( CODEC_OP_INDEX != (op & CODEC_OP_MASK) )
+            {
+                px = (px & 0xff000000)
+                    | ((px + db) & 0xff)
+                    | (((px >> 8) + dg) & 0xff) << 8
+                    | (((px >> 16) + dr) & 0xff) << 16;
+            }
+        }
+
+        index[HashPixel( px )] = px;
+        pDst[i++] = px;
+    }
+
+    return true;
+}
+
+//
+// 1 and 2 byte pixels (bayer, infrared), the same tags carry a single delta
+//
+static inline UINT HashValue( UINT32 value )
+{
+    return (value * 2654435761u) >> 26;
+}
+
+template <typename T>
+static BYTE* EncodeBandScalar( _In_ const T* pSrc, size_t cPixels, _Out_ BYTE* pOut )
+{
+    T index[64] = { 0 };
+    T prev = 0;
+    UINT run = 0;
+
+    for( size_t i = 0; i < cPixels; ++i )
+    {
+        T value = pSrc[i];
+
+        if( value == prev )
+        {
+            if( ++run == CODEC_MAX_RUN )
+            {
+                *pOut++ = static_cast<BYTE>( CODEC_OP_RUN | (run - 1) );
+                run = 0;
+            }
+            continue;
+        }
+
+        if( run > 0 )
+        {
+            *pOut++ = static_cast<BYTE>( CODEC_OP_RUN | (run - 1) );
+            run = 0;
+        }
+
+        UINT hash = HashValue( value );
+        if( index[hash] == value )
+        {
+            *pOut++ = static_cast<BYTE>( CODEC_OP_INDEX | hash );
+        }
+        else
+        {
+            index[hash] = value;
+
+            // 6 bit delta in the tag byte, or 14 bits over two bytes
+            int delta = static_cast<int>(value) - static_cast<int>(prev);
+            if( delta >= -32 && delta <= 31 )
+            {
+                *pOut++ = static_cast<BYTE>( CODEC_OP_DIFF | (delta + 32) );
+            }
+            else if( delta >= -8192 && delta <= 8191 )
+            {
+                UINT biased = delta + 8192;
+                *pOut++ = static_cast<BYTE>( CODEC_OP_LUMA | (biased >> 8) );
+                *pOut++ = static_cast<BYTE>( biased );
+            }
+            else
+            {
+                *pOut++ = CODEC_OP_FULL;
+                for( size_t b = 0; b < sizeof(T); ++b )
+                {
+                    *pOut++ = static_cast<BYTE>( value >> (b * 8) );
+                }
+            }
+        }
+
+        prev = value;
+    }
+
+    if( run > 0 )
+    {
+        *pOut++ = static_cast<BYTE>( CODEC_OP_RUN | (run - 1) );
+    }
+
+    return pOut;
+}
+
+template <typename T>
+static bool DecodeBandScalar( _In_ const BYTE* pIn, _In_ const BYTE* pEnd, size_t cPixels, _Out_ T* pDst )
+{
+    T index[64] = { 0 };
+    T value = 0;
+    size_t i = 0;
+
+    while( i < cPixels )
+    {
+        if( pIn >= pEnd )
+        {
+            return false;
+        }
+
+        BYTE op = *pIn++;
+
+        if( CODEC_OP_FULL == op )
+        {
+            if( static_cast<size_t>(pEnd - pIn) < sizeof(T) )
+            {
+                return false;
+            }
+            UINT32 full = 0;
+            for( size_t b = 0; b < sizeof(T); ++b )
+            {
+                full |= static_cast<UINT32>(*pIn++) << (b * 8);
+            }
+            value = static_cast<T>(full);
+        }
+        else
+        {
+            switch( op & CODEC_OP_MASK )
+            {
+            case CODEC_OP_INDEX:
+                value = index[op];
+                break;
+
+            case CODEC_OP_DIFF:
+                value = static_cast<T>( value + (op & 0x3f) - 32 );
+                break;
+
+            case CODEC_OP_LUMA:
+                if( pIn >= pEnd )
+                {
+                    return false;
+                }
+                value = static_cast<T>( value + ((op & 0x3f) << 8 | *pIn) - 8192 );
+                ++pIn;
+                break;
+
+            default: // CODEC_OP_RUN, CODEC_OP_FULL_ALPHA is never written for scalars
+                {
+                    if( CODEC_OP_FULL_ALPHA == op )
+                    {
+                        return false;
+                    }
+                    size_t run = (op & 0x3f) + 1;
+                    if( run > cPixels - i )
+                    {
+                        return false;
+                    }
+                    for( ; run > 0; --run )
+                    {
+                        pDst[i++] = value;
+                    }
+                }
+                continue;
+            }
+        }
+
+        index[HashValue( value )] = value;
+        pDst[i++] = value;
+    }
+
+    return true;
+}
+
+bool ImageCodec::IsFormatSupported( const KINECT_IMAGE_FRAME_FORMAT& format )
+{
+    // in 64 bits, the fields can come from an encoded header
+    return 0 != format.dwWidth && 0 != format.dwHeight
+        && (1 == format.cbBytesPerPixel || 2 == format.cbBytesPerPixel || 4 == format.cbBytesPerPixel)
+        && static_cast<ULONGLONG>(format.dwWidth) * format.dwHeight * format.cbBytesPerPixel <= IMAGE_CODEC_MAX_IMAGE_BYTES;
+}
+
+ULONG ImageCodec::GetEncodedBound( const KINECT_IMAGE_FRAME_FORMAT& format )
+{
+    if( !IsFormatSupported( format ) )
+    {
+        return 0;
+    }
+
+    const UINT32 cBands = (format.dwHeight + IMAGE_CODEC_BAND_ROWS - 1) / IMAGE_CODEC_BAND_ROWS;
+    const size_t bandBound = format.dwWidth * IMAGE_CODEC_BAND_ROWS * GetWorstCaseBytes( format.cbBytesPerPixel );
+
+    return static_cast<ULONG>( sizeof(ImageCodecHeader) + cBands * (sizeof(UINT32) + bandBound) );
+}
+
+HRESULT ImageCodec::Encode( const KINECT_IMAGE_FRAME_FORMAT& format, _In_ const BYTE* pImage,
+    ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG& cbWritten )
+{
+    cbWritten = 0;
+
+    if( nullptr == pImage || nullptr == pEncoded || !IsFormatSupported( format ) )
+    {
+        return E_INVALIDARG;
+    }
+
+    if( cbEncoded < GetEncodedBound( format ) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER );
+    }
+
+    ImageCodecHeader header;
+    header.magic = IMAGE_CODEC_MAGIC;
+    header.width = format.dwWidth;
+    header.height = format.dwHeight;
+    header.bytesPerPixel = format.cbBytesPerPixel;
+    header.bandRows = IMAGE_CODEC_BAND_ROWS;
+    header.cBands = (format.dwHeight + IMAGE_CODEC_BAND_ROWS - 1) / IMAGE_CODEC_BAND_ROWS;
+
+    BYTE* pData = pEncoded + sizeof(ImageCodecHeader) + header.cBands * sizeof(UINT32);
+    const size_t bandBound = header.width * IMAGE_CODEC_BAND_ROWS * GetWorstCaseBytes( header.bytesPerPixel );
+
+    // every band gets its worst case slot, they are packed together afterwards
+    std::vector<UINT32> bandSizes( header.cBands );
+
+    Concurrency::parallel_for( 0u, header.cBands, [&]( UINT32 band )
+    {
+        UINT32 rows = min( IMAGE_CODEC_BAND_ROWS, header.height - band * IMAGE_CODEC_BAND_ROWS );
+        size_t cPixels = static_cast<size_t>(rows) * header.width;
+
+        const BYTE* pSrc = pImage + static_cast<size_t>(band) * IMAGE_CODEC_BAND_ROWS * header.width * header.bytesPerPixel;
+        BYTE* pOut = pData + band * bandBound;
+        BYTE* pEnd = pOut;
+
+        switch( header.bytesPerPixel )
+        {
+        case 4:
+            pEnd = EncodeBand32( reinterpret_cast<const UINT32*>(pSrc), cPixels, pOut );
+            break;
+        case 2:
+            pEnd = EncodeBandScalar( reinterpret_cast<const USHORT*>(pSrc), cPixels, pOut );
+            break;
+        default:
+            pEnd = EncodeBandScalar( pSrc, cPixels, pOut );
+            break;
+        }
+
+        bandSizes[band] = static_cast<UINT32>( pEnd - pOut );
+    });
+
+    // the packed position of a band is never behind its slot, so a forward memmove is safe
+    std::vector<UINT32> bandEnds( header.cBands );
+    size_t offset = 0;
+    for( UINT32 band = 0; band < header.cBands; ++band )
+    {
+        memmove( pData + offset, pData + band * bandBound, bandSizes[band] );
+        offset += bandSizes[band];
+        bandEnds[band] = static_cast<UINT32>( offset );
+    }
+
+    memcpy( pEncoded, &header, sizeof(ImageCodecHeader) );
+    memcpy( pEncoded + sizeof(ImageCodecHeader), bandEnds.data(), header.cBands * sizeof(UINT32) );
+
+    cbWritten = static_cast<ULONG>( (pData - pEncoded) + offset );
+
+    return S_OK;
+}
+
+HRESULT ImageCodec::GetFormat( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Out_ KINECT_IMAGE_FRAME_FORMAT& format )
+{
+    ZeroMemory( &format, sizeof(KINECT_IMAGE_FRAME_FORMAT) );
+    format.dwStructSize = sizeof(KINECT_IMAGE_FRAME_FORMAT);
+
+    if( nullptr == pEncoded || cbEncoded < sizeof(ImageCodecHeader) )
+    {
+        return E_INVALIDARG;
+    }
+
+    ImageCodecHeader header;
+    memcpy( &header, pEncoded, sizeof(ImageCodecHeader) );
+
+    if( IMAGE_CODEC_MAGIC != header.magic || 0 == header.bandRows
+        || header.cBands != (header.height + header.bandRows - 1) / header.bandRows
+        || cbEncoded < sizeof(ImageCodecHeader) + static_cast<ULONGLONG>(header.cBands) * sizeof(UINT32) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
+    format.dwWidth = header.width;
+    format.dwHeight = header.height;
+    format.cbBytesPerPixel = header.bytesPerPixel;
+    if( !IsFormatSupported( format ) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
+    // can't overflow once the format is supported
+    format.cbBufferSize = header.width * header.height * header.bytesPerPixel;
+
+    return S_OK;
+}
+
+HRESULT ImageCodec::Decode( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+    ULONG cbImage, _Out_cap_(cbImage) BYTE* pImage )
+{
+    KINECT_IMAGE_FRAME_FORMAT format;
+    HRESULT hr = GetFormat( cbEncoded, pEncoded, format );
+    if( FAILED(hr) )
+    {
+        return hr;
+    }
+
+    if( nullptr == pImage )
+    {
+        return E_INVALIDARG;
+    }
+
+    if( cbImage < format.cbBufferSize )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER );
+    }
+
+    ImageCodecHeader header;
+    memcpy( &header, pEncoded, sizeof(ImageCodecHeader) );
+
+    std::vector<UINT32> bandEnds( header.cBands );
+    memcpy( bandEnds.data(), pEncoded + sizeof(ImageCodecHeader), header.cBands * sizeof(UINT32) );
+
+    const BYTE* pData = pEncoded + sizeof(ImageCodecHeader) + header.cBands * sizeof(UINT32);
+    const size_t cbData = cbEncoded - (pData - pEncoded);
+
+    // the band table has to be in order and inside the data
+    UINT32 previousEnd = 0;
+    for( UINT32 band = 0; band < header.cBands; ++band )
+    {
+        if( bandEnds[band] < previousEnd || bandEnds[band] > cbData )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+        previousEnd = bandEnds[band];
+    }
+
+    std::vector<BYTE> bandValid( header.cBands, FALSE );
+
+    Concurrency::parallel_for( 0u, header.cBands, [&]( UINT32 band )
+    {
+        UINT32 rows = min( header.bandRows, header.height - band * header.bandRows );
+        size_t cPixels = static_cast<size_t>(rows) * header.width;
+
+        const BYTE* pIn = pData + ((0 == band) ? 0 : bandEnds[band - 1]);
+        const BYTE* pEnd = pData + bandEnds[band];
+
+        // the band has to end inside the image, the band decoders check their runs against cPixels
+        ULONGLONG dstOffset = static_cast<ULONGLONG>(band) * header.bandRows * header.width * header.bytesPerPixel;
+        if( dstOffset + static_cast<ULONGLONG>(cPixels) * header.bytesPerPixel > format.cbBufferSize )
+        {
+            bandValid[band] = FALSE;
+            return;
+        }
+        BYTE* pDst = pImage + static_cast<size_t>(dstOffset);
+
+        bool bValid = false;
+        switch( header.bytesPerPixel )
+        {
+        case 4:
+            bValid = DecodeBand32( pIn, pEnd, cPixels, reinterpret_cast<UINT32*>(pDst) );
+            break;
+        case 2:
+            bValid = DecodeBandScalar( pIn, pEnd, cPixels, reinterpret_cast<USHORT*>(pDst) );
+            break;
+        default:
+            bValid = DecodeBandScalar( pIn, pEnd, cPixels, pDst );
+            break;
+        }
+
+        bandValid[band] = bValid ? TRUE : FALSE;
+    });
+
+    for( UINT32 band = 0; band < header.cBands; ++band )
+    {
+        if( !bandValid[band] )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,41 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// lossless codec for color/IR snapshots
+// the image is cut into bands of rows that are coded independently with QOI style
+// run/index/diff ops, so bands are encoded and decoded in parallel
+// 4 byte pixels use the QOI channel ops, 1 and 2 byte pixels use the same op tags on scalar values
+//
+// layout: ImageCodecHeader, UINT32 end offset of every band, band data
+class ImageCodec
+{
+public:
+    static bool IsFormatSupported( const KINECT_IMAGE_FRAME_FORMAT& format );
+
+    // worst case size of the encoded image, Encode needs a buffer at least this big
+    static ULONG GetEncodedBound( const KINECT_IMAGE_FRAME_FORMAT& format );
+
+    static HRESULT Encode( const KINECT_IMAGE_FRAME_FORMAT& format, _In_ const BYTE* pImage,
+        ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG& cbWritten );
+
+    // reads the image size from the header
+    static HRESULT GetFormat( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Out_ KINECT_IMAGE_FRAME_FORMAT& format );
+
+    static HRESULT Decode( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+        ULONG cbImage, _Out_cap_(cbImage) BYTE* pImage );
+};
@@ -0,0 +1,248 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "ImageTransform.h"
+
+#include <ppl.h>
+
+// rotations are copied in square tiles of the destination, the matching source tile
+// is only TRANSFORM_TILE_SIZE rows high so both stay in cache while they are transposed
+static const UINT TRANSFORM_TILE_SIZE = 32;
+
+// fixed size element for the pixel formats that don't have a native type
+template <size_t N>
+struct TransformPixel
+{
+    BYTE bytes[N];
+};
+
+template <typename PIXEL>
+static void CopyTransformed( _In_ const PIXEL* pSrc, ptrdiff_t base, ptrdiff_t du, ptrdiff_t dv,
+    UINT outWidth, UINT outHeight, _Out_ PIXEL* pDst )
+{
+    const UINT cTileRows = (outHeight + TRANSFORM_TILE_SIZE - 1) / TRANSFORM_TILE_SIZE;
+
+    Concurrency::parallel_for( 0u, cTileRows, [&]( UINT tileRow )
+    {
+        UINT v0 = tileRow * TRANSFORM_TILE_SIZE;
+        UINT v1 = min( outHeight, v0 + TRANSFORM_TILE_SIZE );
+
+        if( 1 == du )
+        {
+            // rows stay rows, only their order changes
+            for( UINT v = v0; v < v1; ++v )
+            {
+                memcpy( pDst + v * outWidth, pSrc + base + static_cast<ptrdiff_t>(v) * dv, outWidth * sizeof(PIXEL) );
+            }
+            return;
+        }
+
+        if( -1 == du )
+        {
+            // mirrored rows are still read and written in sequence
+            for( UINT v = v0; v < v1; ++v )
+            {
+                const PIXEL* pRead = pSrc + base + static_cast<ptrdiff_t>(v) * dv;
+                PIXEL* pOut = pDst + v * outWidth;
+
+                for( UINT u = 0; u < outWidth; ++u )
+                {
+                    pOut[u] = *(pRead - u);
+                }
+            }
+            return;
+        }
+
+        // rotations walk down the source columns, so copy tile by tile
+        for( UINT u0 = 0; u0 < outWidth; u0 += TRANSFORM_TILE_SIZE )
+        {
+            UINT u1 = min( outWidth, u0 + TRANSFORM_TILE_SIZE );
+
+            for( UINT v = v0; v < v1; ++v )
+            {
+                const PIXEL* pRead = pSrc + base + static_cast<ptrdiff_t>(v) * dv + static_cast<ptrdiff_t>(u0) * du;
+                PIXEL* pOut = pDst + v * outWidth;
+
+                for( UINT u = u0; u < u1; ++u, pRead += du )
+                {
+                    pOut[u] = *pRead;
+                }
+            }
+        }
+    });
+}
+
+ImageTransform::ImageTransform()
+{
+    ZeroMemory( &m_params, sizeof(KINECT_IMAGE_TRANSFORM) );
+
+    m_params.dwStructSize = sizeof(KINECT_IMAGE_TRANSFORM);
+    m_params.bMirror = false;
+    m_params.eRotation = ImageRotationNone;
+}
+
+void ImageTransform::SetParameters( const KINECT_IMAGE_TRANSFORM& params )
+{
+    m_params = params;
+
+    switch( m_params.eRotation )
+    {
+    case ImageRotationNone:
+    case ImageRotation90:
+    case ImageRotation180:
+    case ImageRotation270:
+        break;
+
+    default:
+        m_params.eRotation = ImageRotationNone;
+        break;
+    }
+}
+
+void ImageTransform::GetOutputSize( UINT width, UINT height, _Out_ UINT& outWidth, _Out_ UINT& outHeight ) const
+{
+    outWidth = SwapsAxes() ? height : width;
+    outHeight = SwapsAxes() ? width : height;
+}
+
+void ImageTransform::TransformPoint( UINT width, UINT height, LONG x, LONG y, _Out_ LONG& outX, _Out_ LONG& outY ) const
+{
+    const LONG w = static_cast<LONG>(width);
+    const LONG h = static_cast<LONG>(height);
+
+    if( m_params.bMirror )
+    {
+        x = w - 1 - x;
+    }
+
+    switch( m_params.eRotation )
+    {
+    case ImageRotation90:
+        outX = h - 1 - y;
+        outY = x;
+        break;
+    case ImageRotation180:
+        outX = w - 1 - x;
+        outY = h - 1 - y;
+        break;
+    case ImageRotation270:
+        outX = y;
+        outY = w - 1 - x;
+        break;
+    default:
+        outX = x;
+        outY = y;
+        break;
+    }
+}
+
+void ImageTransform::InverseTransformPoint( UINT width, UINT height, LONG x, LONG y, _Out_ LONG& outX, _Out_ LONG& outY ) const
+{
+    const LONG w = static_cast<LONG>(width);
+    const LONG h = static_cast<LONG>(height);
+
+    switch( m_params.eRotation )
+    {
+    case ImageRotation90:
+        outX = y;
+        outY = h - 1 - x;
+        break;
+    case ImageRotation180:
+        outX = w - 1 - x;
+        outY = h - 1 - y;
+        break;
+    case ImageRotation270:
+        outX = w - 1 - y;
+        outY = x;
+        break;
+    default:
+        outX = x;
+        outY = y;
+        break;
+    }
+
+    if( m_params.bMirror )
+    {
+        outX = w - 1 - outX;
+    }
+}
+
+// srcPitch has to be a multiple of bpp, which holds for every Nui frame
+void ImageTransform::Copy( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, UINT bpp,
+    bool bInverse, ULONG cbDst, _Out_cap_(cbDst) BYTE* pDst ) const
+{
+    if( nullptr == pSrc || nullptr == pDst || 0 == width || 0 == height || 0 == bpp )
+    {
+        return;
+    }
+
+    // swapping the axes is its own inverse, so this is the size of pDst either way
+    UINT outWidth, outHeight;
+    GetOutputSize( width, height, outWidth, outHeight );
+
+    // the point functions are defined on the native size
+    const UINT nativeWidth = bInverse ? outWidth : width;
+    const UINT nativeHeight = bInverse ? outHeight : height;
+
+    // source coordinates of the destination origin and its two neighbours give the walk
+    LONG x[3], y[3];
+    const LONG u[3] = { 0, 1, 0 };
+    const LONG v[3] = { 0, 0, 1 };
+    for( int i = 0; i < 3; ++i )
+    {
+        if( bInverse )
+        {
+            TransformPoint( nativeWidth, nativeHeight, u[i], v[i], x[i], y[i] );
+        }
+        else
+        {
+            InverseTransformPoint( nativeWidth, nativeHeight, u[i], v[i], x[i], y[i] );
+        }
+    }
+
+    const ptrdiff_t stride = srcPitch / bpp;
+    const ptrdiff_t base = y[0] * stride + x[0];
+    const ptrdiff_t du = (y[1] - y[0]) * stride + (x[1] - x[0]);
+    const ptrdiff_t dv = (y[2] - y[0]) * stride + (x[2] - x[0]);
+
+    // only write the rows that fit into the caller buffer
+    outHeight = min( outHeight, static_cast<UINT>( cbDst / (outWidth * bpp) ) );
+
+    switch( bpp )
+    {
+    case 1:
+        CopyTransformed( pSrc, base, du, dv, outWidth, outHeight, pDst );
+        break;
+    case 2:
+        CopyTransformed( reinterpret_cast<const USHORT*>(pSrc), base, du, dv, outWidth, outHeight, reinterpret_cast<USHORT*>(pDst) );
+        break;
+    case 4:
+        CopyTransformed( reinterpret_cast<const UINT32*>(pSrc), base, du, dv, outWidth, outHeight, reinterpret_cast<UINT32*>(pDst) );
+        break;
+    case 8:
+        CopyTransformed( reinterpret_cast<const UINT64*>(pSrc), base, du, dv, outWidth, outHeight, reinterpret_cast<UINT64*>(pDst) );
+        break;
+    case 12:
+        CopyTransformed( reinterpret_cast<const TransformPixel<12>*>(pSrc), base, du, dv, outWidth, outHeight, reinterpret_cast<TransformPixel<12>*>(pDst) );
+        break;
+    case 16:
+        CopyTransformed( reinterpret_cast<const TransformPixel<16>*>(pSrc), base, du, dv, outWidth, outHeight, reinterpret_cast<TransformPixel<16>*>(pDst) );
+        break;
+    default:
+        assert( false );
+        break;
+    }
+}
@@ -0,0 +1,58 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// mirror and rotation of a stream, applied while the frame is copied out of the locked rect
+// the image is mirrored first and then rotated clockwise, so every transformed pixel (u, v)
+// reads the native pixel base + u * du + v * dv and the copy is a single strided walk
+class ImageTransform
+{
+public:
+    ImageTransform();
+
+    void SetParameters( const KINECT_IMAGE_TRANSFORM& params );
+    const KINECT_IMAGE_TRANSFORM& GetParameters() const { return m_params; }
+
+    bool IsIdentity() const { return !m_params.bMirror && ImageRotationNone == m_params.eRotation; }
+    bool SwapsAxes() const { return ImageRotation90 == m_params.eRotation || ImageRotation270 == m_params.eRotation; }
+
+    // size of the transformed image for a native width x height image
+    void GetOutputSize( UINT width, UINT height, _Out_ UINT& outWidth, _Out_ UINT& outHeight ) const;
+
+    // width x height is always the native size of the image
+    // TransformPoint: native -> transformed, InverseTransformPoint: transformed -> native
+    void TransformPoint( UINT width, UINT height, LONG x, LONG y, _Out_ LONG& outX, _Out_ LONG& outY ) const;
+    void InverseTransformPoint( UINT width, UINT height, LONG x, LONG y, _Out_ LONG& outX, _Out_ LONG& outY ) const;
+
+    // copies a width x height image of bpp sized pixels, pSrc rows are srcPitch bytes apart
+    // bInverse = false: pSrc is native and pDst receives the transformed image
+    // bInverse = true: pSrc is transformed (width x height is its size) and pDst receives the native image
+    // pDst rows are tightly packed, rows that do not fit into cbDst are skipped
+    void Copy( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, UINT bpp,
+        bool bInverse, ULONG cbDst, _Out_cap_(cbDst) BYTE* pDst ) const;
+
+    // reorders a frame sized array of per pixel elements, width x height is the size of pSrc
+    template <typename T>
+    void Reorder( _In_ const T* pSrc, UINT width, UINT height, bool bInverse, _Out_ T* pDst ) const
+    {
+        Copy( reinterpret_cast<const BYTE*>(pSrc), width * sizeof(T), width, height, sizeof(T),
+            bInverse, width * height * sizeof(T), reinterpret_cast<BYTE*>(pDst) );
+    }
+
+private:
+    KINECT_IMAGE_TRANSFORM m_params;
+};
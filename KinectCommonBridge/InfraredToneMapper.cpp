@@ -0,0 +1,521 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "InfraredToneMapper.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+#include <math.h>
+
+// rows handled by a single task for the global tone curves
+static const UINT IR_BAND_ROWS = 32;
+
+// upper limit of the CLAHE grid in each direction
+static const UINT IR_MAX_TILES = 16;
+
+// output conversion for the table and tile kernels
+static inline void StoreToneValue( _Out_ BYTE& out, float value )
+{
+    out = static_cast<BYTE>( value * 255.0f + 0.5f );
+}
+static inline void StoreToneValue( _Out_ float& out, float value )
+{
+    out = value;
+}
+
+InfraredToneMapper::InfraredToneMapper()
+    : m_width(0)
+    , m_height(0)
+    , m_bHistogramValid(false)
+    , m_bTableValid(false)
+    , m_cTilesX(0)
+    , m_cTilesY(0)
+    , m_tileWidth(0)
+    , m_tileHeight(0)
+{
+    ZeroMemory( &m_params, sizeof(KINECT_IR_TONE_MAPPING) );
+
+    m_params.dwStructSize = sizeof(KINECT_IR_TONE_MAPPING);
+    m_params.eMode = IRToneMappingModeNone;
+    m_params.eOutputFormat = IROutputFormat8Bit;
+    m_params.usBlackLevel = 0;
+    m_params.usWhiteLevel = 0xffff;
+    m_params.fGamma = 1.0f;
+    m_params.fLowPercentile = 0.01f;
+    m_params.fHighPercentile = 0.99f;
+    m_params.cTilesX = 8;
+    m_params.cTilesY = 8;
+    m_params.fClipLimit = 3.0f;
+}
+
+InfraredToneMapper::~InfraredToneMapper()
+{
+}
+
+HRESULT InfraredToneMapper::SetParameters( const KINECT_IR_TONE_MAPPING& params )
+{
+    // callers of the C API can pass any value, so the enums are read as the integers they are stored as
+    UINT32 mode, outputFormat;
+    memcpy( &mode, &params.eMode, sizeof(mode) );
+    memcpy( &outputFormat, &params.eOutputFormat, sizeof(outputFormat) );
+    if( mode > IRToneMappingModeCLAHE || outputFormat > IROutputFormatFloat )
+    {
+        return E_INVALIDARG;
+    }
+
+    m_params = params;
+
+    // keep the parameters in a range the kernels can handle
+    if( m_params.usBlackLevel == 0xffff )
+    {
+        m_params.usBlackLevel = 0xfffe;
+    }
+    if( m_params.usWhiteLevel <= m_params.usBlackLevel )
+    {
+        m_params.usWhiteLevel = m_params.usBlackLevel + 1;
+    }
+    if( !(m_params.fGamma > 0.0f) )
+    {
+        m_params.fGamma = 1.0f;
+    }
+
+    m_params.fLowPercentile = max( 0.0f, min( 1.0f, m_params.fLowPercentile ) );
+    m_params.fHighPercentile = max( m_params.fLowPercentile, min( 1.0f, m_params.fHighPercentile ) );
+
+    m_params.cTilesX = max( 1u, min( IR_MAX_TILES, m_params.cTilesX ) );
+    m_params.cTilesY = max( 1u, min( IR_MAX_TILES, m_params.cTilesY ) );
+    m_params.fClipLimit = max( 1.0f, m_params.fClipLimit );
+
+    // force the tables and histograms to be rebuilt for the new curve
+    m_width = 0;
+    m_height = 0;
+
+    return S_OK;
+}
+
+ULONG InfraredToneMapper::GetBytesPerPixel() const
+{
+    return (IROutputFormatFloat == m_params.eOutputFormat) ? sizeof(float) : sizeof(BYTE);
+}
+
+void InfraredToneMapper::ResetLayout( UINT width, UINT height )
+{
+    m_width = width;
+    m_height = height;
+    m_bHistogramValid = false;
+    m_bTableValid = false;
+
+    if( IRToneMappingModeCLAHE != m_params.eMode )
+    {
+        m_histogram.assign( IR_HISTOGRAM_BINS, 0 );
+        m_table.assign( IR_HISTOGRAM_BINS, 0.0f );
+        m_table8.assign( IR_HISTOGRAM_BINS, 0 );
+        return;
+    }
+
+    // the last tile may be smaller, so the tile count follows from the rounded up tile size
+    m_tileWidth = (width + m_params.cTilesX - 1) / m_params.cTilesX;
+    m_tileHeight = (height + m_params.cTilesY - 1) / m_params.cTilesY;
+    m_cTilesX = (width + m_tileWidth - 1) / m_tileWidth;
+    m_cTilesY = (height + m_tileHeight - 1) / m_tileHeight;
+
+    m_histogram.assign( m_cTilesX * m_cTilesY * IR_CLAHE_BINS, 0 );
+    m_table.assign( m_cTilesX * m_cTilesY * IR_CLAHE_BINS, 0.0f );
+
+    // every pixel blends the tables of the four closest tile centers
+    auto computeWeights = []( UINT count, UINT tileSize, UINT cTiles, std::vector<UINT>& t0, std::vector<UINT>& t1, std::vector<float>& weight )
+    {
+        t0.resize( count );
+        t1.resize( count );
+        weight.resize( count );
+
+        for( UINT i = 0; i < count; ++i )
+        {
+            float f = (i + 0.5f) / tileSize - 0.5f;
+            if( f <= 0.0f )
+            {
+                t0[i] = t1[i] = 0;
+                weight[i] = 0.0f;
+            }
+            else if( f >= cTiles - 1 )
+            {
+                t0[i] = t1[i] = cTiles - 1;
+                weight[i] = 0.0f;
+            }
+            else
+            {
+                t0[i] = static_cast<UINT>(f);
+                t1[i] = t0[i] + 1;
+                weight[i] = f - t0[i];
+            }
+        }
+    };
+
+    computeWeights( width, m_tileWidth, m_cTilesX, m_tileX0, m_tileX1, m_weightX );
+    computeWeights( height, m_tileHeight, m_cTilesY, m_tileY0, m_tileY1, m_weightY );
+}
+
+float InfraredToneMapper::ApplyGamma( float value ) const
+{
+    if( IRToneMappingModeLinear == m_params.eMode || 1.0f == m_params.fGamma )
+    {
+        return value;
+    }
+
+    return powf( value, 1.0f / m_params.fGamma );
+}
+
+void InfraredToneMapper::BuildTable8( size_t cEntries )
+{
+    m_table8.resize( cEntries );
+
+    for( size_t i = 0; i < cEntries; ++i )
+    {
+        StoreToneValue( m_table8[i], m_table[i] );
+    }
+}
+
+void InfraredToneMapper::BuildLinearTable( UINT blackLevel, UINT whiteLevel )
+{
+    float scale = 1.0f / static_cast<float>(whiteLevel - blackLevel);
+
+    for( UINT bin = 0; bin < IR_HISTOGRAM_BINS; ++bin )
+    {
+        float value = (static_cast<float>(bin << IR_HISTOGRAM_SHIFT) - static_cast<float>(blackLevel)) * scale;
+        m_table[bin] = ApplyGamma( max( 0.0f, min( 1.0f, value ) ) );
+    }
+
+    BuildTable8( IR_HISTOGRAM_BINS );
+}
+
+void InfraredToneMapper::BuildAutoExposureTable()
+{
+    if( !m_bHistogramValid )
+    {
+        // no statistics yet, start from the configured levels
+        BuildLinearTable( m_params.usBlackLevel, m_params.usWhiteLevel );
+        return;
+    }
+
+    UINT total = 0;
+    for( UINT bin = 0; bin < IR_HISTOGRAM_BINS; ++bin )
+    {
+        total += m_histogram[bin];
+    }
+
+    // find the bins at the low and high percentiles of the previous frame
+    double lowTarget = total * static_cast<double>(m_params.fLowPercentile);
+    double highTarget = total * static_cast<double>(m_params.fHighPercentile);
+
+    UINT lowBin = 0;
+    UINT highBin = IR_HISTOGRAM_BINS - 1;
+    UINT cumulative = 0;
+    bool bLowFound = false;
+
+    for( UINT bin = 0; bin < IR_HISTOGRAM_BINS; ++bin )
+    {
+        cumulative += m_histogram[bin];
+
+        if( !bLowFound && cumulative > lowTarget )
+        {
+            lowBin = bin;
+            bLowFound = true;
+        }
+        if( cumulative >= highTarget )
+        {
+            highBin = bin;
+            break;
+        }
+    }
+
+    highBin = max( highBin, lowBin );
+
+    BuildLinearTable( lowBin << IR_HISTOGRAM_SHIFT, (highBin + 1) << IR_HISTOGRAM_SHIFT );
+}
+
+void InfraredToneMapper::BuildTileTables()
+{
+    const UINT cTiles = m_cTilesX * m_cTilesY;
+
+    for( UINT tile = 0; tile < cTiles; ++tile )
+    {
+        const UINT* pHistogram = &m_histogram[tile * IR_CLAHE_BINS];
+        float* pTable = &m_table[tile * IR_CLAHE_BINS];
+
+        UINT total = 0;
+        for( UINT bin = 0; bin < IR_CLAHE_BINS && m_bHistogramValid; ++bin )
+        {
+            total += pHistogram[bin];
+        }
+
+        if( 0 == total )
+        {
+            // nothing to equalize, keep a straight ramp
+            for( UINT bin = 0; bin < IR_CLAHE_BINS; ++bin )
+            {
+                pTable[bin] = ApplyGamma( (bin + 0.5f) / IR_CLAHE_BINS );
+            }
+            continue;
+        }
+
+        // clip the histogram and spread the excess evenly so the contrast gain is limited
+        float clipLimit = max( 1.0f, m_params.fClipLimit * total / IR_CLAHE_BINS );
+        float excess = 0.0f;
+        for( UINT bin = 0; bin < IR_CLAHE_BINS; ++bin )
+        {
+            excess += max( 0.0f, pHistogram[bin] - clipLimit );
+        }
+        float redistribute = excess / IR_CLAHE_BINS;
+
+        float scale = 1.0f / total;
+        float cumulative = 0.0f;
+        for( UINT bin = 0; bin < IR_CLAHE_BINS; ++bin )
+        {
+            cumulative += min( static_cast<float>(pHistogram[bin]), clipLimit ) + redistribute;
+            pTable[bin] = ApplyGamma( min( 1.0f, cumulative * scale ) );
+        }
+    }
+}
+
+void InfraredToneMapper::ProcessLinear8( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, _Out_ BYTE* pDst )
+{
+    const UINT black = m_params.usBlackLevel;
+    const UINT range = m_params.usWhiteLevel - black;
+
+    // out = (in - black) * 255 / range as a 16bit fixed point multiply, range is at least 256
+    // the scale and the product are rounded to nearest, so white is 255 like in the table path
+    const USHORT scale = static_cast<USHORT>( ((255u << 16) + range / 2) / range );
+
+    const __m128i vBlack = _mm_set1_epi16( static_cast<short>(black) );
+    const __m128i vRange = _mm_set1_epi16( static_cast<short>(range) );
+    const __m128i vScale = _mm_set1_epi16( static_cast<short>(scale) );
+
+    const UINT cBands = (height + IR_BAND_ROWS - 1) / IR_BAND_ROWS;
+
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        UINT yEnd = min( height, (band + 1) * IR_BAND_ROWS );
+
+        for( UINT y = band * IR_BAND_ROWS; y < yEnd; ++y )
+        {
+            const USHORT* pRow = reinterpret_cast<const USHORT*>( pSrc + y * srcPitch );
+            BYTE* pOut = pDst + y * width;
+
+            UINT x = 0;
+            for( ; x + 8 <= width; x += 8 )
+            {
+                __m128i v = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pRow + x) );
+
+                // clamp to [black, white] with saturating math, there is no unsigned min in SSE2
+                v = _mm_subs_epu16( v, vBlack );
+                v = _mm_sub_epi16( v, _mm_subs_epu16( v, vRange ) );
+
+                // high word of v * scale + 0x8000, the carry of the rounding bias is the top bit of the low word
+                __m128i lo = _mm_mullo_epi16( v, vScale );
+                v = _mm_add_epi16( _mm_mulhi_epu16( v, vScale ), _mm_srli_epi16( lo, 15 ) );
+
+                _mm_storel_epi64( reinterpret_cast<__m128i*>(pOut + x), _mm_packus_epi16( v, v ) );
+            }
+
+            for( ; x < width; ++x )
+            {
+                UINT value = min( range, static_cast<UINT>( max( 0, static_cast<int>(pRow[x]) - static_cast<int>(black) ) ) );
+                pOut[x] = static_cast<BYTE>( (value * scale + 0x8000) >> 16 );
+            }
+        }
+    });
+}
+
+template <typename PIXEL>
+void InfraredToneMapper::ProcessTable( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bGatherHistogram, _In_ const PIXEL* pTable, _Out_ PIXEL* pDst )
+{
+    const UINT cBands = (height + IR_BAND_ROWS - 1) / IR_BAND_ROWS;
+
+    // SSE2 has no gather, so the table lookups and histogram counts stay scalar; only the
+    // linear 8 bit output runs in SIMD registers, see ProcessLinear8
+    // every band counts into its own histogram, they are merged once the frame is done
+    if( bGatherHistogram )
+    {
+        m_bandHistograms.assign( cBands * IR_HISTOGRAM_BINS, 0 );
+    }
+
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        UINT yEnd = min( height, (band + 1) * IR_BAND_ROWS );
+        UINT* pHistogram = bGatherHistogram ? &m_bandHistograms[band * IR_HISTOGRAM_BINS] : nullptr;
+
+        for( UINT y = band * IR_BAND_ROWS; y < yEnd; ++y )
+        {
+            const USHORT* pRow = reinterpret_cast<const USHORT*>( pSrc + y * srcPitch );
+            PIXEL* pOut = pDst + y * width;
+
+            if( nullptr != pHistogram )
+            {
+                for( UINT x = 0; x < width; ++x )
+                {
+                    UINT bin = pRow[x] >> IR_HISTOGRAM_SHIFT;
+                    pOut[x] = pTable[bin];
+                    ++pHistogram[bin];
+                }
+            }
+            else
+            {
+                for( UINT x = 0; x < width; ++x )
+                {
+                    pOut[x] = pTable[pRow[x] >> IR_HISTOGRAM_SHIFT];
+                }
+            }
+        }
+    });
+
+    if( bGatherHistogram )
+    {
+        std::fill( m_histogram.begin(), m_histogram.end(), 0 );
+
+        for( UINT band = 0; band < cBands; ++band )
+        {
+            const UINT* pBandHistogram = &m_bandHistograms[band * IR_HISTOGRAM_BINS];
+            for( UINT bin = 0; bin < IR_HISTOGRAM_BINS; ++bin )
+            {
+                m_histogram[bin] += pBandHistogram[bin];
+            }
+        }
+
+        m_bHistogramValid = true;
+    }
+}
+
+template <typename PIXEL>
+void InfraredToneMapper::ProcessTiles( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, _Out_ PIXEL* pDst )
+{
+    const UINT cTilesX = m_cTilesX;
+    const UINT tileStride = cTilesX * IR_CLAHE_BINS;
+
+    // a task per row of tiles, so each task owns the histograms it counts into
+    Concurrency::parallel_for( 0u, m_cTilesY, [&]( UINT tileY )
+    {
+        UINT yEnd = min( height, (tileY + 1) * m_tileHeight );
+        UINT* pTileHistograms = &m_histogram[tileY * tileStride];
+
+        for( UINT y = tileY * m_tileHeight; y < yEnd; ++y )
+        {
+            const USHORT* pRow = reinterpret_cast<const USHORT*>( pSrc + y * srcPitch );
+            PIXEL* pOut = pDst + y * width;
+
+            const float* pTop = &m_table[m_tileY0[y] * tileStride];
+            const float* pBottom = &m_table[m_tileY1[y] * tileStride];
+            const float wy = m_weightY[y];
+
+            // a run of pixels per tile, so the histogram of the run is known up front
+            for( UINT tileX = 0; tileX < cTilesX; ++tileX )
+            {
+                UINT* pHistogram = pTileHistograms + tileX * IR_CLAHE_BINS;
+                UINT xEnd = min( width, (tileX + 1) * m_tileWidth );
+
+                for( UINT x = tileX * m_tileWidth; x < xEnd; ++x )
+                {
+                    UINT bin = pRow[x] >> IR_CLAHE_SHIFT;
+                    UINT t0 = m_tileX0[x] * IR_CLAHE_BINS + bin;
+                    UINT t1 = m_tileX1[x] * IR_CLAHE_BINS + bin;
+                    float wx = m_weightX[x];
+
+                    float top = pTop[t0] + (pTop[t1] - pTop[t0]) * wx;
+                    float bottom = pBottom[t0] + (pBottom[t1] - pBottom[t0]) * wx;
+
+                    StoreToneValue( pOut[x], top + (bottom - top) * wy );
+
+                    ++pHistogram[bin];
+                }
+            }
+        }
+    });
+
+    m_bHistogramValid = true;
+}
+
+void InfraredToneMapper::Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, ULONG cbDst, _Out_cap_(cbDst) BYTE* pDst )
+{
+    if( nullptr == pSrc || nullptr == pDst || 0 == width || 0 == height || !IsEnabled() )
+    {
+        return;
+    }
+
+    if( width != m_width || height != m_height )
+    {
+        ResetLayout( width, height );
+    }
+
+    // only write the rows that fit into the caller buffer
+    UINT cRows = min( height, static_cast<UINT>( cbDst / (width * GetBytesPerPixel()) ) );
+    bool bFloat = (IROutputFormatFloat == m_params.eOutputFormat);
+
+    switch( m_params.eMode )
+    {
+    case IRToneMappingModeLinear:
+    case IRToneMappingModeGamma:
+        if( !bFloat && (IRToneMappingModeLinear == m_params.eMode || 1.0f == m_params.fGamma)
+            && m_params.usWhiteLevel - m_params.usBlackLevel >= 256 )
+        {
+            // straight line, the whole conversion runs in SSE2 registers
+            ProcessLinear8( pSrc, srcPitch, width, cRows, pDst );
+            break;
+        }
+
+        // the curve does not depend on the frame, build it once
+        if( !m_bTableValid )
+        {
+            BuildLinearTable( m_params.usBlackLevel, m_params.usWhiteLevel );
+            m_bTableValid = true;
+        }
+        if( bFloat )
+        {
+            ProcessTable( pSrc, srcPitch, width, cRows, false, m_table.data(), reinterpret_cast<float*>(pDst) );
+        }
+        else
+        {
+            ProcessTable( pSrc, srcPitch, width, cRows, false, m_table8.data(), pDst );
+        }
+        break;
+
+    case IRToneMappingModeAutoExposure:
+        BuildAutoExposureTable();
+        if( bFloat )
+        {
+            ProcessTable( pSrc, srcPitch, width, cRows, true, m_table.data(), reinterpret_cast<float*>(pDst) );
+        }
+        else
+        {
+            ProcessTable( pSrc, srcPitch, width, cRows, true, m_table8.data(), pDst );
+        }
+        break;
+
+    case IRToneMappingModeCLAHE:
+        BuildTileTables();
+        std::fill( m_histogram.begin(), m_histogram.end(), 0 );
+        if( bFloat )
+        {
+            ProcessTiles( pSrc, srcPitch, width, cRows, reinterpret_cast<float*>(pDst) );
+        }
+        else
+        {
+            ProcessTiles( pSrc, srcPitch, width, cRows, pDst );
+        }
+        break;
+
+    default:
+        break;
+    }
+}
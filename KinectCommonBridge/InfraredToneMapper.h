@@ -0,0 +1,87 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// infrared samples carry 10 significant bits in the high bits of a USHORT
+#define IR_HISTOGRAM_BINS       1024
+#define IR_HISTOGRAM_SHIFT      6
+
+// CLAHE keeps one table per tile, so it uses coarser bins to stay in cache
+#define IR_CLAHE_BINS           256
+#define IR_CLAHE_SHIFT          8
+
+// converts the 16bit infrared frame to 8bit or float while it is copied out of the locked rect
+// auto exposure and CLAHE use the histogram of the previous frame, the histogram of the
+// current frame is gathered in the same pass so the frame is only read once
+class InfraredToneMapper
+{
+public:
+    InfraredToneMapper();
+    ~InfraredToneMapper();
+
+    // an unknown mode or output format fails with E_INVALIDARG and changes nothing
+    HRESULT SetParameters( const KINECT_IR_TONE_MAPPING& params );
+    const KINECT_IR_TONE_MAPPING& GetParameters() const { return m_params; }
+
+    bool IsEnabled() const { return IRToneMappingModeNone != m_params.eMode; }
+    ULONG GetBytesPerPixel() const;
+
+    // pSrc - 16bit infrared rows, srcPitch bytes apart
+    // pDst - tightly packed output rows, GetBytesPerPixel() bytes per pixel
+    void Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, ULONG cbDst, _Out_cap_(cbDst) BYTE* pDst );
+
+private:
+    void ResetLayout( UINT width, UINT height );
+
+    void BuildLinearTable( UINT blackLevel, UINT whiteLevel );
+    void BuildAutoExposureTable();
+    void BuildTileTables();
+    void BuildTable8( size_t cEntries );
+    float ApplyGamma( float value ) const;
+
+    void ProcessLinear8( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, _Out_ BYTE* pDst );
+
+    template <typename PIXEL>
+    void ProcessTable( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bGatherHistogram, _In_ const PIXEL* pTable, _Out_ PIXEL* pDst );
+
+    template <typename PIXEL>
+    void ProcessTiles( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, _Out_ PIXEL* pDst );
+
+private:
+    KINECT_IR_TONE_MAPPING m_params;
+
+    UINT m_width;
+    UINT m_height;
+
+    // histograms of the last frame, global or one per tile for CLAHE
+    bool m_bHistogramValid;
+    bool m_bTableValid;
+    std::vector<UINT> m_histogram;
+    std::vector<UINT> m_bandHistograms;
+
+    // normalized output per histogram bin, one table per tile for CLAHE
+    std::vector<float> m_table;
+    std::vector<BYTE> m_table8;
+
+    // CLAHE bilinear interpolation between the neighbouring tile tables
+    UINT m_cTilesX;
+    UINT m_cTilesY;
+    UINT m_tileWidth;
+    UINT m_tileHeight;
+    std::vector<UINT> m_tileX0, m_tileX1, m_tileY0, m_tileY1;
+    std::vector<float> m_weightX, m_weightY;
+};
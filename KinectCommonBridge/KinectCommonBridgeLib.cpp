@@ -17,6 +17,9 @@ See the Apache 2 License for the specific language governing permissions and lim
 #include "KinectCommonBridgeLib.h"
 #include "SensorManager.h"
 #include "CoordinateMapper.h"
+#include "ImageCodec.h"
+#include "DepthCodec.h"
+#include "SkeletonCodec.h"
 
 // determine if the handle is valid
 KINECT_CB bool APIENTRY KinectIsHandleValid( KCBHANDLE kcbHandle )
@@ -414,6 +417,298 @@ void APIENTRY KinectGetDepthFrameFormat( KCBHANDLE kcbHandle, _Inout_ KINECT_IMA
     pSensor->GetDepthFrameFormat( pFrame );
 }
 
+// infrared post processing
+KINECT_CB HRESULT APIENTRY KinectSetIRToneMapping(KCBHANDLE kcbHandle, _In_opt_ const KINECT_IR_TONE_MAPPING* pToneMapping)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetIRToneMapping( pToneMapping );
+}
+
+// frame orientation
+KINECT_CB HRESULT APIENTRY KinectSetIRFrameTransform(KCBHANDLE kcbHandle, _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetColorFrameTransform( pTransform );
+}
+KINECT_CB HRESULT APIENTRY KinectSetColorFrameTransform(KCBHANDLE kcbHandle, _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetColorFrameTransform( pTransform );
+}
+KINECT_CB HRESULT APIENTRY KinectSetDepthFrameTransform(KCBHANDLE kcbHandle, _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetDepthFrameTransform( pTransform );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetDepthFilter(KCBHANDLE kcbHandle, _In_opt_ const KINECT_DEPTH_FILTER* pDepthFilter)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetDepthFilter( pDepthFilter );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetDepthPlayerSegmentation(KCBHANDLE kcbHandle, bool bEnable)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetDepthPlayerSegmentation( bEnable );
+}
+KINECT_CB HRESULT APIENTRY KinectGetDepthPlayerSegmentation(KCBHANDLE kcbHandle, _Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetDepthPlayerSegmentation( pSegmentation, cbMasks, pMasks );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetDepthIntegralImages(KCBHANDLE kcbHandle, bool bEnable)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetDepthIntegralImages( bEnable );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetDepthRegionStats(KCBHANDLE kcbHandle, ULONG cRegions, _In_count_(cRegions) const RECT* pRegions,
+    _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetDepthRegionStats( cRegions, pRegions, pStats );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetDepthBackgroundModel(KCBHANDLE kcbHandle, _In_opt_ const KINECT_BACKGROUND_MODEL* pBackgroundModel)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetDepthBackgroundModel( pBackgroundModel );
+}
+KINECT_CB HRESULT APIENTRY KinectFreezeDepthBackground(KCBHANDLE kcbHandle, bool bFreeze)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->FreezeDepthBackground( bFreeze );
+}
+KINECT_CB HRESULT APIENTRY KinectResetDepthBackground(KCBHANDLE kcbHandle)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->ResetDepthBackground();
+}
+KINECT_CB HRESULT APIENTRY KinectGetDepthForeground(KCBHANDLE kcbHandle, _Inout_ KINECT_FOREGROUND_INFO* pForegroundInfo,
+    ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetDepthForeground( pForegroundInfo, cbMask, pMask, cIndices, pIndices );
+}
+
+// motion detection
+KINECT_CB HRESULT APIENTRY KinectSetColorMotionDetection(KCBHANDLE kcbHandle, _In_opt_ const KINECT_MOTION_DETECTION* pMotionDetection)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetColorMotionDetection( pMotionDetection );
+}
+KINECT_CB HRESULT APIENTRY KinectGetColorMotion(KCBHANDLE kcbHandle, _Inout_ KINECT_MOTION_INFO* pMotionInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetColorMotion( pMotionInfo, cbBitmap, pBitmap );
+}
+
+// lossless image snapshots
+KINECT_CB ULONG APIENTRY KinectGetEncodedImageBound(_In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame)
+{
+    if( nullptr == pFrame || pFrame->dwStructSize != sizeof(KINECT_IMAGE_FRAME_FORMAT) )
+    {
+        return 0;
+    }
+
+    return ImageCodec::GetEncodedBound( *pFrame );
+}
+KINECT_CB HRESULT APIENTRY KinectEncodeImage(_In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame, _In_ const BYTE* pImageBuffer,
+    ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG* pcbWritten)
+{
+    if( nullptr == pFrame || pFrame->dwStructSize != sizeof(KINECT_IMAGE_FRAME_FORMAT) || nullptr == pcbWritten )
+    {
+        return E_INVALIDARG;
+    }
+
+    return ImageCodec::Encode( *pFrame, pImageBuffer, cbEncoded, pEncoded, *pcbWritten );
+}
+KINECT_CB HRESULT APIENTRY KinectDecodeImage(ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+    _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame, ULONG cbImageBuffer, _Out_opt_cap_(cbImageBuffer) BYTE* pImageBuffer)
+{
+    if( nullptr == pFrame || pFrame->dwStructSize != sizeof(KINECT_IMAGE_FRAME_FORMAT) )
+    {
+        return E_INVALIDARG;
+    }
+
+    HRESULT hr = ImageCodec::GetFormat( cbEncoded, pEncoded, *pFrame );
+    if( FAILED(hr) || nullptr == pImageBuffer )
+    {
+        return hr;
+    }
+
+    return ImageCodec::Decode( cbEncoded, pEncoded, cbImageBuffer, pImageBuffer );
+}
+KINECT_CB HRESULT APIENTRY KinectGetEncodedColorFrame(KCBHANDLE kcbHandle, _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetEncodedColorFrame( ppEncoded, pcbEncoded, liTimeStamp );
+}
+
+// lossless depth compression
+KINECT_CB ULONG APIENTRY KinectGetEncodedDepthBound(_In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame)
+{
+    if( nullptr == pFrame || pFrame->dwStructSize != sizeof(KINECT_IMAGE_FRAME_FORMAT) )
+    {
+        return 0;
+    }
+
+    return DepthCodec::GetEncodedBound( *pFrame );
+}
+KINECT_CB HRESULT APIENTRY KinectEncodeDepth(_In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame, _In_ const BYTE* pDepthBuffer,
+    ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG* pcbWritten)
+{
+    if( nullptr == pFrame || pFrame->dwStructSize != sizeof(KINECT_IMAGE_FRAME_FORMAT) || nullptr == pcbWritten )
+    {
+        return E_INVALIDARG;
+    }
+
+    return DepthCodec::Encode( *pFrame, pDepthBuffer, cbEncoded, pEncoded, *pcbWritten );
+}
+KINECT_CB HRESULT APIENTRY KinectDecodeDepth(ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+    _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame, ULONG cbDepthBuffer, _Out_opt_cap_(cbDepthBuffer) BYTE* pDepthBuffer)
+{
+    if( nullptr == pFrame || pFrame->dwStructSize != sizeof(KINECT_IMAGE_FRAME_FORMAT) )
+    {
+        return E_INVALIDARG;
+    }
+
+    HRESULT hr = DepthCodec::GetFormat( cbEncoded, pEncoded, *pFrame );
+    if( FAILED(hr) || nullptr == pDepthBuffer )
+    {
+        return hr;
+    }
+
+    return DepthCodec::Decode( cbEncoded, pEncoded, cbDepthBuffer, pDepthBuffer );
+}
+KINECT_CB HRESULT APIENTRY KinectGetEncodedDepthFrame(KCBHANDLE kcbHandle, _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetEncodedDepthFrame( ppEncoded, pcbEncoded, liTimeStamp );
+}
+
+// compact skeleton frames
+KINECT_CB ULONG APIENTRY KinectGetEncodedSkeletonBound()
+{
+    return SkeletonCodec::GetEncodedBound();
+}
+KINECT_CB HRESULT APIENTRY KinectEncodeSkeletonFrame(_In_ const NUI_SKELETON_FRAME* pSkeletonFrame, _In_opt_ const NUI_SKELETON_FRAME* pReference,
+    ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG* pcbWritten)
+{
+    if( nullptr == pSkeletonFrame || nullptr == pcbWritten )
+    {
+        return E_INVALIDARG;
+    }
+
+    return SkeletonCodec::Encode( *pSkeletonFrame, pReference, cbEncoded, pEncoded, *pcbWritten );
+}
+KINECT_CB HRESULT APIENTRY KinectDecodeSkeletonFrame(ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Inout_ NUI_SKELETON_FRAME* pSkeletonFrame)
+{
+    if( nullptr == pSkeletonFrame )
+    {
+        return E_INVALIDARG;
+    }
+
+    return SkeletonCodec::Decode( cbEncoded, pEncoded, *pSkeletonFrame );
+}
+KINECT_CB HRESULT APIENTRY KinectGetEncodedSkeletonFrame(KCBHANDLE kcbHandle, _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetEncodedSkeletonFrame( ppEncoded, pcbEncoded, liTimeStamp );
+}
+
 // get the actual frame data
 KINECT_CB HRESULT APIENTRY KinectGetIRFrame(KCBHANDLE kcbHandle, ULONG cbBufferSize, _Inout_cap_(cbBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp)
 {
@@ -458,7 +753,154 @@ KINECT_CB HRESULT APIENTRY KinectGetSkeletonFrame(KCBHANDLE kcbHandle, _Inout_ N
         return E_NUI_BADINDEX;
     }
     
-    return pSensor->GetSkeletonFrame( *pSkeletonFrame );
+    HRESULT hr = pSensor->GetSkeletonFrame( *pSkeletonFrame );
+    if( SUCCEEDED(hr) )
+    {
+        SensorManager::GetInstance()->FuseSkeletonFrame( kcbHandle, *pSkeletonFrame );
+    }
+
+    return hr;
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetPlayerSelection(KCBHANDLE kcbHandle, _In_opt_ const KINECT_PLAYER_SELECTION* pSelection)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetPlayerSelection( pSelection );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetSkeletonFilter(KCBHANDLE kcbHandle, _In_opt_ const KINECT_SKELETON_FILTER* pFilter)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetSkeletonFilter( pFilter );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetSkeletonHistory(KCBHANDLE kcbHandle, _In_opt_ const KINECT_SKELETON_HISTORY* pHistory)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetSkeletonHistory( pHistory );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetSkeletonTrajectory(KCBHANDLE kcbHandle, _Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetSkeletonTrajectory( pTrajectory );
+}
+
+KINECT_CB HRESULT APIENTRY KinectAddGestureTemplate(KCBHANDLE kcbHandle, _In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->AddGestureTemplate( pTemplate, pdwGestureID );
+}
+
+KINECT_CB HRESULT APIENTRY KinectRemoveGestureTemplate(KCBHANDLE kcbHandle, DWORD dwGestureID)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->RemoveGestureTemplate( dwGestureID );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetGestureEvents(KCBHANDLE kcbHandle, ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetGestureEvents( cMaxEvents, pEvents, pcEvents );
+}
+
+KINECT_CB HRESULT APIENTRY KinectPredictSkeletonFrame(KCBHANDLE kcbHandle, LONGLONG liTimeStamp, _In_opt_ const KINECT_SKELETON_PREDICTION* pPrediction,
+    _Out_ NUI_SKELETON_FRAME* pSkeletonFrame)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->PredictSkeletonFrame( liTimeStamp, pPrediction, pSkeletonFrame );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetSkeletonBoneOrientations(KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+    ULONG cOrientations, _Out_cap_(cOrientations) NUI_SKELETON_BONE_ORIENTATION* pOrientations)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetSkeletonBoneOrientations( pSkeletonFrame, cOrientations, pOrientations );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetJointAngles(KCBHANDLE kcbHandle, ULONG cAngles, _In_opt_count_(cAngles) const KINECT_JOINT_ANGLE* pAngles)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetJointAngles( cAngles, pAngles );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetSkeletonJointAngles(KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+    ULONG cAngles, _Out_cap_(cAngles) float* pAngles)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetSkeletonJointAngles( pSkeletonFrame, cAngles, pAngles );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetSensorPose(KCBHANDLE kcbHandle, _In_opt_ const KINECT_SENSOR_POSE* pPose)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return SensorManager::GetInstance()->SetSensorPose( kcbHandle, pPose );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetFusedSkeletons(ULONG cMaxSkeletons, _Out_cap_(cMaxSkeletons) KINECT_FUSED_SKELETON* pSkeletons,
+    _Out_ ULONG* pcSkeletons, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    return SensorManager::GetInstance()->GetFusedSkeletons( cMaxSkeletons, pSkeletons, pcSkeletons, liTimeStamp );
 }
 
 KINECT_CB HRESULT APIENTRY KinectGetDepthImagePixels(KCBHANDLE kcbHandle, ULONG cbDepthPixels, _Inout_cap_(cbDepthPixels) NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, _Out_opt_ LONGLONG* liTimeStamp)
@@ -471,6 +913,39 @@ KINECT_CB HRESULT APIENTRY KinectGetDepthImagePixels(KCBHANDLE kcbHandle, ULONG
 
     return pSensor->GetDepthPixels( cbDepthPixels, pDepthPixels, liTimeStamp );
 }
+KINECT_CB HRESULT APIENTRY KinectGetDepthFrameMeters(KCBHANDLE kcbHandle, ULONG cDepthPixels, _Out_cap_(cDepthPixels) float* pDepthMeters,
+    ULONG cbClasses, _Out_opt_cap_(cbClasses) BYTE* pClasses, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetDepthMeters( cDepthPixels, pDepthMeters, cbClasses, pClasses, liTimeStamp );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetDepthFrameColorized( KCBHANDLE kcbHandle, ULONG cbBufferSize, _Out_cap_(cbBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp )
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetDepthColorized( cbBufferSize, pColorBuffer, liTimeStamp );
+}
+
+KINECT_CB HRESULT APIENTRY KinectSetDepthColorization( KCBHANDLE kcbHandle, _In_opt_ const KINECT_DEPTH_COLORIZATION* pColorization )
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->SetDepthColorization( pColorization );
+}
 
 // Coordinate mapping functions
 KINECT_CB HRESULT APIENTRY KinectMapColorFrameToDepthFrame( KCBHANDLE kcbHandle, 
@@ -621,6 +1096,21 @@ KINECT_CB HRESULT APIENTRY KinectMapSkeletonPointToDepthPoint(KCBHANDLE kcbHandl
     return pMapper.MapSkeletonPointToDepthPoint( pSkeletonPoint, eDepthResolution, pDepthPoint );
 }
 
+KINECT_CB HRESULT APIENTRY KinectMapSkeletonFrameToImages(KCBHANDLE kcbHandle,
+    _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+    _Inout_ KINECT_SKELETON_PROJECTION* pProjection )
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    CoordinateMapper& pMapper = pSensor->GetCoordinateMapper();
+
+    return pMapper.MapSkeletonFrameToImages( pSkeletonFrame, pProjection );
+}
+
 KINECT_CB HRESULT APIENTRY KinectGetColorFrameFromDepthPoints(KCBHANDLE kcbHandle,
     DWORD cDepthPoints, _In_count_(cDepthPoints) NUI_DEPTH_IMAGE_POINT *pDepthPoints,
     ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp)
@@ -634,6 +1124,51 @@ KINECT_CB HRESULT APIENTRY KinectGetColorFrameFromDepthPoints(KCBHANDLE kcbHandl
     return pSensor->GetColorFrameFromDepthPoints( cDepthPoints, pDepthPoints, cBufferSize, pColorBuffer, liTimeStamp );
 }
 
+KINECT_CB HRESULT APIENTRY KinectGetPointCloud( KCBHANDLE kcbHandle,
+    NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    _Inout_ KINECT_POINT_CLOUD* pPointCloud )
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetPointCloud( eDepthResolution, cDepthPixels, pDepthPixels, pPointCloud );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetDepthNormals( KCBHANDLE kcbHandle,
+    NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    _Inout_ KINECT_DEPTH_NORMALS* pNormals )
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetDepthNormals( eDepthResolution, cDepthPixels, pDepthPixels, pNormals );
+}
+
+KINECT_CB HRESULT APIENTRY KinectGetColoredPointCloud( KCBHANDLE kcbHandle,
+    NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    NUI_IMAGE_RESOLUTION eColorResolution,
+    ULONG cbColorBuffer, _In_count_(cbColorBuffer) const BYTE* pColorBuffer,
+    _Inout_ KINECT_POINT_CLOUD* pPointCloud )
+{
+    std::shared_ptr<KinectSensor> pSensor = nullptr;
+    if( !SensorManager::GetInstance()->GetKinectSensor(kcbHandle, pSensor) )
+    {
+        return E_NUI_BADINDEX;
+    }
+
+    return pSensor->GetColoredPointCloud( eDepthResolution, cDepthPixels, pDepthPixels,
+        eColorResolution, cbColorBuffer, pColorBuffer, pPointCloud );
+}
+
 KINECT_CB void APIENTRY KinectEnableAudioStream(KCBHANDLE kcbHandle, _In_opt_ AEC_SYSTEM_MODE* eAECSystemMode, _In_opt_ bool* bGainBounder)
 {
     std::shared_ptr<KinectSensor> pSensor = nullptr;
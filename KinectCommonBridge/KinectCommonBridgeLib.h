@@ -119,8 +119,142 @@ typedef enum _KINECT_SKELETON_SELECTION_MODE
     SkeletonSelectionModeSticky2    = 4,
     SkeletonSelectionModeActive1    = 5,
     SkeletonSelectionModeActive2    = 6,
+    SkeletonSelectionModeZone1      = 7,    // closest in the interaction zones of KinectSetPlayerSelection
+    SkeletonSelectionModeZone2      = 8,
 } KINECT_SKELETON_SELECTION_MODE;
 
+// Box in skeleton space a player interacts in
+typedef struct _KinectInteractionZone
+{
+    float fMinX, fMaxX;         // m
+    float fMinY, fMaxY;
+    float fMinZ, fMaxZ;
+} KINECT_INTERACTION_ZONE;
+
+// Player selection of the chooser modes
+typedef struct _KinectPlayerSelection
+{
+    DWORD dwStructSize;
+    float fHysteresis;          // m, a chosen player is replaced by one this much closer, and leaves a zone this far outside, 0 uses the default of 0.1
+    ULONG cZones;               // up to 8, 0 lets every player in
+    const KINECT_INTERACTION_ZONE* pZones;
+} KINECT_PLAYER_SELECTION;
+
+// Joint smoothing of the skeleton stream
+typedef enum _KINECT_SKELETON_FILTER_TYPE
+{
+    SkeletonFilterNone              = 0,
+    SkeletonFilterDoubleExponential = 1,    // smoothParams, same meaning as for NuiTransformSmooth
+    SkeletonFilterOneEuro           = 2,    // fMinCutoff, fBeta, fDerivativeCutoff
+    SkeletonFilterKalman            = 3,    // constant velocity, fProcessNoise, fMeasurementNoise
+} KINECT_SKELETON_FILTER_TYPE;
+
+typedef struct _KinectSkeletonFilter
+{
+    DWORD dwStructSize;
+    KINECT_SKELETON_FILTER_TYPE eType;
+    NUI_TRANSFORM_SMOOTH_PARAMETERS smoothParams;
+    float fMinCutoff;           // Hz, cutoff of a joint at rest, 0 uses the default
+    float fBeta;                // cutoff added per m/s of the joint, 0 uses the default
+    float fDerivativeCutoff;    // Hz, cutoff of the speed, 0 uses the default
+    float fProcessNoise;        // m/s^2, standard deviation of the acceleration, 0 uses the default
+    float fMeasurementNoise;    // m, standard deviation of the tracked joints, 0 uses the default
+} KINECT_SKELETON_FILTER;
+
+// History of the skeleton stream, per tracking id
+typedef struct _KinectSkeletonHistory
+{
+    DWORD dwStructSize;
+    float fSeconds;             // kept per tracking id, 0 uses the default of 5, at most 60
+    bool bHalfPrecision;        // joints as 16 bit floats, half the memory, within 1 mm up to 4 m
+} KINECT_SKELETON_HISTORY;
+
+typedef struct _KinectSkeletonTrajectory
+{
+    DWORD dwStructSize;
+    DWORD dwTrackingID;
+    LONGLONG liStartTime;       // time stamps of the skeleton frames, both inclusive
+    LONGLONG liEndTime;
+    DWORD dwJointMask;          // 1 << NUI_SKELETON_POSITION_INDEX of every joint to copy
+    ULONG cMaxFrames;           // frames the buffers hold per joint
+    ULONG cFrames;              // frames of the time range, oldest first
+    LONGLONG* pTimeStamps;      // (optional) cMaxFrames
+    Vector4* pPositions;        // (optional) cMaxFrames per joint of the mask, in joint order
+    BYTE* pTrackingStates;      // (optional) NUI_SKELETON_POSITION_TRACKING_STATE, laid out like pPositions
+} KINECT_SKELETON_TRAJECTORY;
+
+// Template gestures of the skeleton stream
+typedef struct _KinectGestureTemplate
+{
+    DWORD dwStructSize;
+    DWORD dwJointMask;          // 1 << NUI_SKELETON_POSITION_INDEX of every joint compared
+    ULONG cFrames;              // 2 to 120 frames of the gesture at 30 frames per second
+    const Vector4* pPositions;  // NUI_SKELETON_POSITION_COUNT joints per frame, like SkeletonPositions
+    float fThreshold;           // root mean square joint distance of a match in torso lengths, 0 uses the default of 0.3
+    float fBand;                // warping allowed as part of cFrames, 0 uses the default of 0.2
+} KINECT_GESTURE_TEMPLATE;
+
+typedef struct _KinectGestureEvent
+{
+    DWORD dwGestureID;
+    DWORD dwTrackingID;
+    LONGLONG liTimeStamp;       // skeleton frame that matched best
+    float fDistance;            // root mean square joint distance in torso lengths
+    float fConfidence;          // 1 - fDistance / fThreshold
+} KINECT_GESTURE_EVENT;
+
+// Prediction of the skeleton stream, to hide the latency of the frames
+typedef enum _KINECT_SKELETON_PREDICTION_MODEL
+{
+    SkeletonPredictionConstantVelocity      = 0,
+    SkeletonPredictionConstantAcceleration  = 1,
+} KINECT_SKELETON_PREDICTION_MODEL;
+
+typedef struct _KinectSkeletonPrediction
+{
+    DWORD dwStructSize;
+    KINECT_SKELETON_PREDICTION_MODEL eModel;
+    float fDamping;             // s, time constant the joints slow down with, 0 for none
+    float fMaxHorizon;          // s, furthest prediction after the last frame, 0 uses the default of 0.15
+    bool bKeepBoneLengths;      // predicted bones keep the lengths of the tracked ones
+} KINECT_SKELETON_PREDICTION;
+
+// Joints of a skeleton frame in the depth and color images
+typedef struct _KinectSkeletonProjection
+{
+    DWORD dwStructSize;
+    NUI_IMAGE_RESOLUTION eDepthResolution;
+    NUI_IMAGE_TYPE eColorType;
+    NUI_IMAGE_RESOLUTION eColorResolution;
+    NUI_DEPTH_IMAGE_POINT* pDepthPoints;    // (optional) NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT, skeleton by skeleton
+    NUI_COLOR_IMAGE_POINT* pColorPoints;    // (optional) laid out like pDepthPoints
+} KINECT_SKELETON_PROJECTION;
+
+// Angle at eCenterJoint between the bones to eFirstJoint and eSecondJoint, 180 degrees for a straight limb
+typedef struct _KinectJointAngle
+{
+    NUI_SKELETON_POSITION_INDEX eFirstJoint;
+    NUI_SKELETON_POSITION_INDEX eCenterJoint;
+    NUI_SKELETON_POSITION_INDEX eSecondJoint;
+} KINECT_JOINT_ANGLE;
+
+// Pose of a sensor in a world frame shared by several sensors, world = fRotation * skeleton point + vTranslation
+typedef struct _KinectSensorPose
+{
+    DWORD dwStructSize;
+    float fRotation[3][3];      // rows of the rotation
+    Vector4 vTranslation;       // m, w is ignored
+} KINECT_SENSOR_POSE;
+
+// A person seen by one or more sensors with a pose
+typedef struct _KinectFusedSkeleton
+{
+    DWORD dwPersonID;           // kept while any of the sensors sees the person, never 0
+    ULONG cSensors;             // sensors the joints are averaged over
+    Vector4 SkeletonPositions[NUI_SKELETON_POSITION_COUNT];    // in the world frame
+    NUI_SKELETON_POSITION_TRACKING_STATE eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_COUNT];  // the best of the sensors
+} KINECT_FUSED_SKELETON;
+
 // Structure for the frame data for depth/color
 // take note of cbBytesPerPixel 
 typedef struct _KinectImageFrameFormat
@@ -132,6 +266,204 @@ typedef struct _KinectImageFrameFormat
     ULONG cbBufferSize;
 } KINECT_IMAGE_FRAME_FORMAT;
 
+// Infrared tone mapping
+// converts the 16bit infrared frame to 8bit or float while it is copied
+typedef enum _KINECT_IR_TONE_MAPPING_MODE
+{
+    IRToneMappingModeNone           = 0,    // raw 16bit samples
+    IRToneMappingModeLinear         = 1,    // usBlackLevel..usWhiteLevel to 0..1
+    IRToneMappingModeGamma          = 2,    // linear followed by fGamma
+    IRToneMappingModeAutoExposure   = 3,    // fLowPercentile..fHighPercentile of the previous frame to 0..1
+    IRToneMappingModeCLAHE          = 4,    // contrast limited adaptive histogram equalization
+} KINECT_IR_TONE_MAPPING_MODE;
+
+typedef enum _KINECT_IR_OUTPUT_FORMAT
+{
+    IROutputFormat8Bit              = 0,    // 1 byte per pixel
+    IROutputFormatFloat             = 1,    // 4 bytes per pixel, 0.0f - 1.0f
+} KINECT_IR_OUTPUT_FORMAT;
+
+typedef struct _KinectIRToneMapping
+{
+    DWORD dwStructSize;
+    KINECT_IR_TONE_MAPPING_MODE eMode;
+    KINECT_IR_OUTPUT_FORMAT eOutputFormat;
+    USHORT usBlackLevel;        // Linear/Gamma
+    USHORT usWhiteLevel;        // Linear/Gamma
+    float fGamma;               // Gamma/AutoExposure/CLAHE
+    float fLowPercentile;       // AutoExposure, 0.0f - 1.0f
+    float fHighPercentile;      // AutoExposure, 0.0f - 1.0f
+    UINT cTilesX;               // CLAHE, 1 - 16
+    UINT cTilesY;               // CLAHE, 1 - 16
+    float fClipLimit;           // CLAHE, multiple of the average bin count
+} KINECT_IR_TONE_MAPPING;
+
+// Image orientation for color/IR/depth frames
+// rotation is clockwise and applied after the mirror
+typedef enum _KINECT_IMAGE_ROTATION
+{
+    ImageRotationNone   = 0,
+    ImageRotation90     = 1,
+    ImageRotation180    = 2,
+    ImageRotation270    = 3,
+} KINECT_IMAGE_ROTATION;
+
+typedef struct _KinectImageTransform
+{
+    DWORD dwStructSize;
+    bool bMirror;                       // flip left/right
+    KINECT_IMAGE_ROTATION eRotation;
+} KINECT_IMAGE_TRANSFORM;
+
+// Depth filtering, applied to depth frames and depth pixels while they are copied
+typedef struct _KinectDepthFilter
+{
+    DWORD dwStructSize;
+    bool bTemporal;             // exponential smoothing of every pixel over time
+    float fTemporalAlpha;       // weight of the new frame, 0.0f - 1.0f, 0 uses the default
+    USHORT usMotionThreshold;   // mm, a larger change restarts the smoothing of the pixel, 0 uses the default
+    bool bMedian;               // 3x3 median, removes speckles and single pixel holes, keeps edges
+    USHORT cMaxHoleWidth;       // widest run of missing pixels in a row that is filled, 0 turns it off
+} KINECT_DEPTH_FILTER;
+
+// Classification of a depth pixel by KinectGetDepthFrameMeters, the range follows near mode
+typedef enum _KINECT_DEPTH_CLASS
+{
+    DepthClassValid                 = 0,    // inside the range, meters hold the depth
+    DepthClassUnknown               = 1,    // no depth measured
+    DepthClassTooNear               = 2,    // closer than the minimum depth of the range
+    DepthClassTooFar                = 3,    // farther than the maximum depth of the range
+} KINECT_DEPTH_CLASS;
+
+// False color image of the depth stream, a color per depth and player index
+typedef enum _KINECT_DEPTH_COLOR_MAP
+{
+    DepthColorMapRainbow            = 0,    // red near to blue far
+    DepthColorMapGrayscale          = 1,    // white near to dark far
+} KINECT_DEPTH_COLOR_MAP;
+
+typedef struct _KinectDepthColorization
+{
+    DWORD dwStructSize;
+    KINECT_DEPTH_COLOR_MAP eColorMap;
+    USHORT usMinDepth;          // mm, ends of the color map, 0 uses the range of the near mode
+    USHORT usMaxDepth;
+    bool bPlayerTint;           // blends a color per player index into the pixels of the player
+    DWORD dwNoDepthColor;       // BGRA of the pixels outside the range
+} KINECT_DEPTH_COLORIZATION;
+
+// Background model of the depth stream, foreground without the skeleton engine
+typedef struct _KinectBackgroundModel
+{
+    DWORD dwStructSize;
+    USHORT usLearningStep;          // mm per frame the background follows the depth, 0 uses the default
+    USHORT usForegroundThreshold;   // mm in front of the background for foreground, 0 uses the default
+} KINECT_BACKGROUND_MODEL;
+
+typedef struct _KinectForegroundInfo
+{
+    DWORD dwStructSize;
+    DWORD dwWidth;                  // size of the depth frame and of the mask
+    DWORD dwHeight;
+    DWORD cForegroundPixels;
+    bool bFrozen;
+} KINECT_FOREGROUND_INFO;
+
+// Statistics of a depth frame region from summed area tables, depth outside the range of the stream is invalid
+typedef struct _KinectDepthRegionStats
+{
+    DWORD cPixels;              // pixels of the region inside the frame
+    DWORD cValidPixels;
+    float fValidRatio;          // cValidPixels / cPixels
+    float fMeanDepth;           // mm, mean and variance of the valid pixels
+    float fVariance;            // mm^2
+} KINECT_DEPTH_REGION_STATS;
+
+// Player segmentation of the depth stream
+typedef struct _KinectPlayerInfo
+{
+    DWORD cPixels;              // 0 when the player is not in the frame
+    RECT rcBounds;              // bounding box in pixels, right and bottom are exclusive
+    float fCentroidX;           // mean pixel position
+    float fCentroidY;
+    USHORT usMinDepth;          // mm, nearest and farthest pixel with a depth
+    USHORT usMaxDepth;
+} KINECT_PLAYER_INFO;
+
+typedef struct _KinectPlayerSegmentation
+{
+    DWORD dwStructSize;
+    DWORD dwWidth;              // size of the depth frame and of every mask
+    DWORD dwHeight;
+    DWORD cbMaskPitch;          // bytes per mask row, one bit per pixel, lowest bit first
+    DWORD cbMaskSize;           // bytes per mask, the masks follow each other in player order
+    DWORD cPlayers;             // players with at least one pixel
+    KINECT_PLAYER_INFO players[NUI_SKELETON_COUNT];   // players[i] has the player index i + 1
+} KINECT_PLAYER_SEGMENTATION;
+
+// Motion detection on the color/IR stream
+// 16x16 pixel blocks are compared with the previous frame on a 2x2 downsampled luma plane
+typedef struct _KinectMotionDetection
+{
+    DWORD dwStructSize;
+    UINT uThreshold;            // mean luma difference (1 - 255) of a moving block, 0 uses the default
+} KINECT_MOTION_DETECTION;
+
+typedef struct _KinectMotionInfo
+{
+    DWORD dwStructSize;
+    DWORD cBlocksX;             // blocks per row
+    DWORD cBlocksY;             // rows of blocks
+    DWORD cbBitmapPitch;        // bytes per bitmap row, one bit per block, lowest bit first
+    DWORD cMovingBlocks;
+    float fMotionScore;         // mean luma difference of the frame normalized by 255, 0.0f - 1.0f
+} KINECT_MOTION_INFO;
+
+// Point cloud from depth pixels, camera space in meters like the skeleton points
+typedef enum _KINECT_POINT_CLOUD_LAYOUT
+{
+    PointCloudLayoutXYZ     = 0,    // interleaved x, y, z floats per point in pXYZ
+    PointCloudLayoutPlanes  = 1,    // separate pX, pY and pZ arrays
+    PointCloudLayoutXYZRGB  = 2,    // KINECT_COLORED_POINT per point in pColoredPoints
+} KINECT_POINT_CLOUD_LAYOUT;
+
+typedef struct _KinectColoredPoint
+{
+    float x;
+    float y;
+    float z;
+    DWORD color;                // BGRX pixel of the color frame, 0 when the point has no color
+} KINECT_COLORED_POINT;
+
+typedef struct _KinectPointCloud
+{
+    DWORD dwStructSize;
+    KINECT_POINT_CLOUD_LAYOUT eLayout;
+    bool bCompact;              // false: one point per depth pixel, invalid depths are (0, 0, 0)
+                                // true: only valid depths, in pixel order
+    DWORD cPoints;              // capacity of the buffers in points
+    float* pXYZ;                // PointCloudLayoutXYZ, 3 * cPoints floats
+    float* pX;                  // PointCloudLayoutPlanes, cPoints floats each
+    float* pY;
+    float* pZ;
+    KINECT_COLORED_POINT* pColoredPoints;   // PointCloudLayoutXYZRGB
+    DWORD* pColors;             // optional, XYZ/Planes layout of a colored point cloud, BGRX per point
+    DWORD* pIndices;            // optional, bCompact only, depth pixel index of every point
+    DWORD cValidPoints;         // set by the call, the capacity needed when the buffers are too small
+} KINECT_POINT_CLOUD;
+
+// Surface normals of the depth pixels, camera space like the point cloud
+typedef struct _KinectDepthNormals
+{
+    DWORD dwStructSize;
+    float fMaxDepthStep;        // neighbors whose depth differs by more than this fraction of the depth
+                                // are on another surface, 0 uses the default
+    DWORD cNormals;             // capacity of the buffers in pixels, at least the pixels of the frame
+    float* pNormals;            // 3 floats per depth pixel, unit normal facing the sensor, NaN without a normal
+    BYTE* pValid;               // optional, 0xff for every pixel with a normal
+    DWORD cValidNormals;        // set by the call
+} KINECT_DEPTH_NORMALS;
+
 #ifndef KCB_AUDIOFMT
 #define KCB_AUDIOFMT
 // the audio format required for the DMO
@@ -239,6 +571,96 @@ extern "C"
     KINECT_CB void APIENTRY KinectGetIRFrameFormat( KCBHANDLE kcbHandle, _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame );
     KINECT_CB void APIENTRY KinectGetColorFrameFormat( KCBHANDLE kcbHandle, _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame );
     KINECT_CB void APIENTRY KinectGetDepthFrameFormat( KCBHANDLE kcbHandle, _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame );
+
+    // Infrared tone mapping, applies to KinectGetIRFrame and the frame format reports the new bytes per pixel
+    // pToneMapping - nullptr or IRToneMappingModeNone returns the raw 16bit frame
+    KINECT_CB HRESULT APIENTRY KinectSetIRToneMapping( KCBHANDLE kcbHandle, _In_opt_ const KINECT_IR_TONE_MAPPING* pToneMapping );
+
+    // Mirror/rotate the frames while they are copied, the frame format reports the rotated width and height
+    // the coordinate mapping functions take and return pixels/points of the transformed images
+    // aligned color frames (KinectGetColorFrameFromDepthPoints) expect the same transform on both streams
+    // pTransform - nullptr returns the frames as the sensor delivers them
+    KINECT_CB HRESULT APIENTRY KinectSetIRFrameTransform( KCBHANDLE kcbHandle, _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform );
+    KINECT_CB HRESULT APIENTRY KinectSetColorFrameTransform( KCBHANDLE kcbHandle, _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform );
+    KINECT_CB HRESULT APIENTRY KinectSetDepthFrameTransform( KCBHANDLE kcbHandle, _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform );
+
+    // Depth filter chain for KinectGetDepthFrame and KinectGetDepthImagePixels, player indices are kept
+    // pDepthFilter - nullptr turns it off
+    KINECT_CB HRESULT APIENTRY KinectSetDepthFilter( KCBHANDLE kcbHandle, _In_opt_ const KINECT_DEPTH_FILTER* pDepthFilter );
+
+    // Player masks and statistics, computed while KinectGetDepthFrame/KinectGetDepthImagePixels copies the frame
+    // KinectGetDepthPlayerSegmentation - result of the last copied frame in its orientation,
+    // pMasks receives NUI_SKELETON_COUNT masks of cbMaskSize bytes
+    KINECT_CB HRESULT APIENTRY KinectSetDepthPlayerSegmentation( KCBHANDLE kcbHandle, bool bEnable );
+    KINECT_CB HRESULT APIENTRY KinectGetDepthPlayerSegmentation( KCBHANDLE kcbHandle, _Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks );
+
+    // Summed area tables of the depth stream, built from every copied depth frame
+    // KinectGetDepthRegionStats - statistics of the last copied frame, pRegions are in its orientation
+    KINECT_CB HRESULT APIENTRY KinectSetDepthIntegralImages( KCBHANDLE kcbHandle, bool bEnable );
+    KINECT_CB HRESULT APIENTRY KinectGetDepthRegionStats( KCBHANDLE kcbHandle, ULONG cRegions, _In_count_(cRegions) const RECT* pRegions,
+        _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats );
+
+    // Background model of the depth stream, learned from every copied depth frame
+    // pBackgroundModel - nullptr turns it off
+    // KinectFreezeDepthBackground - keeps extracting foreground without learning, KinectResetDepthBackground - learns from scratch
+    // KinectGetDepthForeground - result of the last copied frame in its orientation, pMask gets 0xff for every foreground
+    // pixel, pIndices the index of every foreground pixel
+    KINECT_CB HRESULT APIENTRY KinectSetDepthBackgroundModel( KCBHANDLE kcbHandle, _In_opt_ const KINECT_BACKGROUND_MODEL* pBackgroundModel );
+    KINECT_CB HRESULT APIENTRY KinectFreezeDepthBackground( KCBHANDLE kcbHandle, bool bFreeze );
+    KINECT_CB HRESULT APIENTRY KinectResetDepthBackground( KCBHANDLE kcbHandle );
+    KINECT_CB HRESULT APIENTRY KinectGetDepthForeground( KCBHANDLE kcbHandle, _Inout_ KINECT_FOREGROUND_INFO* pForegroundInfo,
+        ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices );
+
+    // Motion detection on the color/IR stream, computed while KinectGetColorFrame/KinectGetIRFrame copies the frame
+    // pMotionDetection - nullptr turns it off
+    // KinectGetColorMotion - result of the last copied frame, the bitmap has the orientation of the frame
+    // pBitmap can be nullptr to only get the info, it needs cbBitmapPitch * cBlocksY bytes
+    KINECT_CB HRESULT APIENTRY KinectSetColorMotionDetection( KCBHANDLE kcbHandle, _In_opt_ const KINECT_MOTION_DETECTION* pMotionDetection );
+    KINECT_CB HRESULT APIENTRY KinectGetColorMotion( KCBHANDLE kcbHandle, _Inout_ KINECT_MOTION_INFO* pMotionInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap );
+
+    // Lossless snapshots of color/IR frames (1, 2 or 4 bytes per pixel)
+    // bands of rows are coded independently with a QOI style codec, so they are encoded in parallel
+    // KinectGetEncodedImageBound - size of the buffer KinectEncodeImage needs for the format
+    // KinectDecodeImage - fills in pFrame from the encoded data, pImageBuffer can be nullptr to only get the format
+    KINECT_CB ULONG APIENTRY KinectGetEncodedImageBound( _In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame );
+    KINECT_CB HRESULT APIENTRY KinectEncodeImage( _In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame, _In_ const BYTE* pImageBuffer,
+        ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG* pcbWritten );
+    KINECT_CB HRESULT APIENTRY KinectDecodeImage( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+        _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame, ULONG cbImageBuffer, _Out_opt_cap_(cbImageBuffer) BYTE* pImageBuffer );
+
+    // gets the next color/IR frame and encodes it into a buffer owned by the sensor
+    // ppEncoded stays valid until the next call for this sensor
+    KINECT_CB HRESULT APIENTRY KinectGetEncodedColorFrame( KCBHANDLE kcbHandle, _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp );
+
+    // Lossless compression of depth frames as returned by KinectGetDepthFrame (depth << 3 | player)
+    // RVL coding of the depth with the player index as a separate run length stream, bands of rows are coded in parallel
+    // KinectGetEncodedDepthBound - size of the buffer KinectEncodeDepth needs for the format
+    // KinectDecodeDepth - fills in pFrame from the encoded data, pDepthBuffer can be nullptr to only get the format
+    KINECT_CB ULONG APIENTRY KinectGetEncodedDepthBound( _In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame );
+    KINECT_CB HRESULT APIENTRY KinectEncodeDepth( _In_ const KINECT_IMAGE_FRAME_FORMAT* pFrame, _In_ const BYTE* pDepthBuffer,
+        ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG* pcbWritten );
+    KINECT_CB HRESULT APIENTRY KinectDecodeDepth( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded,
+        _Inout_ KINECT_IMAGE_FRAME_FORMAT* pFrame, ULONG cbDepthBuffer, _Out_opt_cap_(cbDepthBuffer) BYTE* pDepthBuffer );
+
+    // gets the next depth frame and encodes it into a buffer owned by the sensor
+    // ppEncoded stays valid until the next call for this sensor
+    KINECT_CB HRESULT APIENTRY KinectGetEncodedDepthFrame( KCBHANDLE kcbHandle, _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp );
+
+    // Compact coding of skeleton frames, only the skeletons that are seen are written
+    // positions are 16 bit fixed point, within 0.25 mm, and are written as the change from the skeleton with
+    // the same tracking id in the reference frame; keyframes have no reference
+    // KinectEncodeSkeletonFrame - pReference is the frame encoded before, nullptr for a keyframe
+    // KinectDecodeSkeletonFrame - pSkeletonFrame holds the frame decoded before and gets the new one,
+    //   a delta frame that doesn't follow it fails with ERROR_INVALID_DATA until the next keyframe
+    KINECT_CB ULONG APIENTRY KinectGetEncodedSkeletonBound();
+    KINECT_CB HRESULT APIENTRY KinectEncodeSkeletonFrame( _In_ const NUI_SKELETON_FRAME* pSkeletonFrame, _In_opt_ const NUI_SKELETON_FRAME* pReference,
+        ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG* pcbWritten );
+    KINECT_CB HRESULT APIENTRY KinectDecodeSkeletonFrame( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Inout_ NUI_SKELETON_FRAME* pSkeletonFrame );
+
+    // gets the next skeleton frame and encodes it into a buffer owned by the sensor
+    // a keyframe every SKELETON_CODEC_KEYFRAME_INTERVAL frames, the others are deltas from the frame before
+    // ppEncoded stays valid until the next call for this sensor
+    KINECT_CB HRESULT APIENTRY KinectGetEncodedSkeletonFrame( KCBHANDLE kcbHandle, _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp );
     
 
     // Get the data frame from a stream
@@ -253,9 +675,70 @@ extern "C"
     // pSkeletons - reference to the allocated NUI_SKELETON_FRAME structure allocated by the caller
     KINECT_CB HRESULT APIENTRY KinectGetSkeletonFrame( KCBHANDLE kcbHandle, _Inout_ NUI_SKELETON_FRAME* pSkeleton );
 
+    // hysteresis and interaction zones of the chooser mode of KinectEnableSkeletonStream
+    // pSelection - nullptr restores the defaults
+    KINECT_CB HRESULT APIENTRY KinectSetPlayerSelection( KCBHANDLE kcbHandle, _In_opt_ const KINECT_PLAYER_SELECTION* pSelection );
+
+    // joint smoothing of the skeleton frames, replaces the smooth parameters of KinectEnableSkeletonStream
+    // pFilter - nullptr turns it off
+    KINECT_CB HRESULT APIENTRY KinectSetSkeletonFilter( KCBHANDLE kcbHandle, _In_opt_ const KINECT_SKELETON_FILTER* pFilter );
+
+    // history of the tracked skeletons of every skeleton frame read, after the joint smoothing
+    // pHistory - nullptr turns it off
+    // KinectGetSkeletonTrajectory - joints of one tracking id in a time range, cFrames is set even when the buffers are too small
+    KINECT_CB HRESULT APIENTRY KinectSetSkeletonHistory( KCBHANDLE kcbHandle, _In_opt_ const KINECT_SKELETON_HISTORY* pHistory );
+    KINECT_CB HRESULT APIENTRY KinectGetSkeletonTrajectory( KCBHANDLE kcbHandle, _Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory );
+
+    // gestures recognized in every skeleton frame read, after the joint smoothing
+    // KinectRemoveGestureTemplate - dwGestureID 0 removes every template
+    // KinectGetGestureEvents - takes the recognized gestures out of the queue, oldest first
+    KINECT_CB HRESULT APIENTRY KinectAddGestureTemplate( KCBHANDLE kcbHandle, _In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID );
+    KINECT_CB HRESULT APIENTRY KinectRemoveGestureTemplate( KCBHANDLE kcbHandle, DWORD dwGestureID );
+    KINECT_CB HRESULT APIENTRY KinectGetGestureEvents( KCBHANDLE kcbHandle, ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents );
+
+    // the last skeleton frame read, after the joint smoothing, moved forward to liTimeStamp
+    // liTimeStamp - in the milliseconds of the skeleton frames, the time of the display including the latency of the frames
+    // pPrediction - (optional) nullptr predicts with constant velocity, no damping and the default horizon
+    KINECT_CB HRESULT APIENTRY KinectPredictSkeletonFrame( KCBHANDLE kcbHandle, LONGLONG liTimeStamp, _In_opt_ const KINECT_SKELETON_PREDICTION* pPrediction,
+        _Out_ NUI_SKELETON_FRAME* pSkeletonFrame );
+
+    // orientations of every bone of the tracked skeletons of the frame, like NuiSkeletonCalculateBoneOrientations for all of them in one call
+    // cOrientations - NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT, skeleton by skeleton, the bone ending in each joint
+    // bones with a joint that is not tracked, and the skeletons that are not tracked, keep the orientation of their parent
+    KINECT_CB HRESULT APIENTRY KinectGetSkeletonBoneOrientations( KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+        ULONG cOrientations, _Out_cap_(cOrientations) NUI_SKELETON_BONE_ORIENTATION* pOrientations );
+
+    // angles at the joints of the tracked skeletons of the frame
+    // KinectSetJointAngles - up to 64 angles, pAngles nullptr removes them
+    // KinectGetSkeletonJointAngles - cAngles is NUI_SKELETON_COUNT * the angles set, skeleton by skeleton, in degrees
+    //     angles with a joint that is not tracked, and the skeletons that are not tracked, are NaN
+    KINECT_CB HRESULT APIENTRY KinectSetJointAngles( KCBHANDLE kcbHandle, ULONG cAngles, _In_opt_count_(cAngles) const KINECT_JOINT_ANGLE* pAngles );
+    KINECT_CB HRESULT APIENTRY KinectGetSkeletonJointAngles( KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+        ULONG cAngles, _Out_cap_(cAngles) float* pAngles );
+
+    // fusion of the skeletons of several sensors covering one space
+    // KinectSetSensorPose - the skeleton frames read from the sensor are fused from then on, pPose nullptr stops it
+    // KinectGetFusedSkeletons - the people seen by the sensors with a skeleton frame read in the last 200 ms,
+    //     updated with every skeleton frame of any of them; cSkeletons is set even when the buffer is too small
+    //     liTimeStamp - (optional) GetTickCount64 when the newest skeleton frame was read
+    KINECT_CB HRESULT APIENTRY KinectSetSensorPose( KCBHANDLE kcbHandle, _In_opt_ const KINECT_SENSOR_POSE* pPose );
+    KINECT_CB HRESULT APIENTRY KinectGetFusedSkeletons( ULONG cMaxSkeletons, _Out_cap_(cMaxSkeletons) KINECT_FUSED_SKELETON* pSkeletons,
+        _Out_ ULONG* pcSkeletons, _Out_opt_ LONGLONG* liTimeStamp );
+
     // get depth as Depth pixels needed for coordinate mapping
     KINECT_CB HRESULT APIENTRY KinectGetDepthImagePixels( KCBHANDLE kcbHandle, ULONG cDepthPixels, _Inout_cap_(cDepthPixels) NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, _Out_opt_ LONGLONG* liTimeStamp );
 
+    // get depth as float meters, pixels outside the range of the current near mode are NaN
+    // cDepthPixels - width * height of the depth frame
+    // pClasses - (optional) one KINECT_DEPTH_CLASS byte per pixel
+    KINECT_CB HRESULT APIENTRY KinectGetDepthFrameMeters( KCBHANDLE kcbHandle, ULONG cDepthPixels, _Out_cap_(cDepthPixels) float* pDepthMeters,
+        ULONG cbClasses, _Out_opt_cap_(cbClasses) BYTE* pClasses, _Out_opt_ LONGLONG* liTimeStamp );
+
+    // get depth as a false color BGRA image for display, 4 bytes per pixel
+    // KinectSetDepthColorization - nullptr restores the defaults: rainbow, range of the near mode, player tint, black
+    KINECT_CB HRESULT APIENTRY KinectGetDepthFrameColorized( KCBHANDLE kcbHandle, ULONG cbBufferSize, _Out_cap_(cbBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp );
+    KINECT_CB HRESULT APIENTRY KinectSetDepthColorization( KCBHANDLE kcbHandle, _In_opt_ const KINECT_DEPTH_COLORIZATION* pColorization );
+
     // Coordinate mapping passthrough functions
     KINECT_CB HRESULT APIENTRY KinectMapColorFrameToDepthFrame( KCBHANDLE kcbHandle, 
         NUI_IMAGE_TYPE eColorType, NUI_IMAGE_RESOLUTION eColorResolution,
@@ -301,10 +784,41 @@ extern "C"
         NUI_IMAGE_RESOLUTION eDepthResolution, 
         _Inout_ NUI_DEPTH_IMAGE_POINT *pDepthPoint);
 
+    // every joint of the tracked skeletons of the frame in the depth and/or color image in one call
+    // joints that are not tracked, joints the sensor cannot map to color and the skeletons that are not tracked are 0
+    KINECT_CB HRESULT APIENTRY KinectMapSkeletonFrameToImages( KCBHANDLE kcbHandle,
+        _In_ const NUI_SKELETON_FRAME* pSkeletonFrame,
+        _Inout_ KINECT_SKELETON_PROJECTION* pProjection );
+
     KINECT_CB HRESULT APIENTRY KinectGetColorFrameFromDepthPoints(KCBHANDLE kcbHandle,
         DWORD cDepthPoints, _In_count_(cDepthPoints) NUI_DEPTH_IMAGE_POINT *pDepthPoints,
         ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp);
 
+    // Point cloud from the pixels of KinectGetDepthImagePixels, in the orientation of the depth stream
+    // uses cached per pixel rays, so it is a multiply per pixel instead of KinectMapDepthFrameToSkeletonFrame
+    KINECT_CB HRESULT APIENTRY KinectGetPointCloud( KCBHANDLE kcbHandle,
+        NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        _Inout_ KINECT_POINT_CLOUD* pPointCloud );
+
+    // Surface normals from the pixels of KinectGetDepthImagePixels, aligned with them
+    // neighbors without depth or across a depth edge are left out, see KINECT_DEPTH_NORMALS
+    KINECT_CB HRESULT APIENTRY KinectGetDepthNormals( KCBHANDLE kcbHandle,
+        NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        _Inout_ KINECT_DEPTH_NORMALS* pNormals );
+
+    // Colored point cloud for a matching depth/color pair
+    // the depth pixels are mapped to the color frame once and every point gathers its color
+    // in the same pass that computes its position, straight into the caller buffers
+    // pColorBuffer - a NUI_IMAGE_TYPE_COLOR frame from KinectGetColorFrame, in the orientation of the color stream
+    KINECT_CB HRESULT APIENTRY KinectGetColoredPointCloud( KCBHANDLE kcbHandle,
+        NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        NUI_IMAGE_RESOLUTION eColorResolution,
+        ULONG cbColorBuffer, _In_count_(cbColorBuffer) const BYTE* pColorBuffer,
+        _Inout_ KINECT_POINT_CLOUD* pPointCloud );
+
     KINECT_CB void APIENTRY KinectEnableAudioStream(KCBHANDLE kcbHandle, _In_opt_ AEC_SYSTEM_MODE* eAECSystemMode, _In_opt_ bool* bGainBounder);
     KINECT_CB HRESULT APIENTRY KinectStartAudioStream(KCBHANDLE kcbHandle);
     KINECT_CB void APIENTRY KinectPauseAudioStream(KCBHANDLE kcbHandle, bool bPause);
@@ -17,6 +17,9 @@ See the Apache 2 License for the specific language governing permissions and lim
 #include "KinectSensor.h"
 #include "FaceTracker.h"
 #include "AutoLock.h"
+#include "ImageCodec.h"
+#include "DepthCodec.h"
+#include "SkeletonCodec.h"
 
 /// <summary>
 /// Check whether the specified sensor is available.
@@ -104,10 +107,12 @@ KinectSensor::KinectSensor(_In_z_ const WCHAR* wcPortID)
 , m_pSkeletonStream(nullptr)
 , m_pAudioStream(nullptr)
 , m_pCoordinateMapper(nullptr)
+, m_cSkeletonEncoded(0)
 #ifdef KCB_ENABLE_FT
 , m_pFaceTracker(nullptr)
 #endif
 {
+    ZeroMemory(&m_skeletonReference, sizeof(m_skeletonReference));
 }
 
 // Dtor
@@ -252,6 +257,16 @@ HRESULT KinectSensor::CreateNuiDevice()
         if (nullptr == m_pCoordinateMapper)
         {
             m_pCoordinateMapper.reset(new (std::nothrow) CoordinateMapper());
+
+            // a new mapper has to pick up the orientation of the streams
+            if (nullptr != m_pColorStream)
+            {
+                m_pCoordinateMapper->SetColorTransform(m_pColorStream->GetTransform());
+            }
+            if (nullptr != m_pDepthStream)
+            {
+                m_pCoordinateMapper->SetDepthTransform(m_pDepthStream->GetTransform());
+            }
         }
         m_pCoordinateMapper->AttachDevice(m_pNuiSensor);
     }
@@ -811,6 +826,200 @@ HRESULT KinectSensor::GetSkeletonFrame(_Inout_ NUI_SKELETON_FRAME& skeletonFrame
     return m_pSkeletonStream->GetFrameData(skeletonFrame);
 }
 
+// the first player chosen by the skeleton chooser mode, 0 when the mode chooses none
+DWORD KinectSensor::GetChosenSkeletonID()
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return 0;
+    }
+
+    return m_pSkeletonStream->GetTrackedIDs()[FirstTrackID];
+}
+
+HRESULT KinectSensor::SetPlayerSelection(_In_opt_ const KINECT_PLAYER_SELECTION* pSelection)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pSkeletonStream->SetPlayerSelection(pSelection);
+}
+
+HRESULT KinectSensor::SetSkeletonFilter(_In_opt_ const KINECT_SKELETON_FILTER* pFilter)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pFilter && (pFilter->dwStructSize != sizeof(KINECT_SKELETON_FILTER) || static_cast<UINT>(pFilter->eType) > SkeletonFilterKalman))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pSkeletonStream->SetFilter(pFilter);
+}
+
+HRESULT KinectSensor::SetSkeletonHistory(_In_opt_ const KINECT_SKELETON_HISTORY* pHistory)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pHistory && pHistory->dwStructSize != sizeof(KINECT_SKELETON_HISTORY))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pSkeletonStream->SetHistory(pHistory);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::GetSkeletonTrajectory(_Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pTrajectory || pTrajectory->dwStructSize != sizeof(KINECT_SKELETON_TRAJECTORY))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pSkeletonStream->GetTrajectory(pTrajectory);
+}
+
+HRESULT KinectSensor::AddGestureTemplate(_In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pTemplate || pTemplate->dwStructSize != sizeof(KINECT_GESTURE_TEMPLATE) || nullptr == pdwGestureID)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pSkeletonStream->AddGestureTemplate(pTemplate, pdwGestureID);
+}
+
+HRESULT KinectSensor::RemoveGestureTemplate(DWORD dwGestureID)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pSkeletonStream->RemoveGestureTemplate(dwGestureID);
+}
+
+HRESULT KinectSensor::GetGestureEvents(ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pEvents || nullptr == pcEvents)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pSkeletonStream->GetGestureEvents(cMaxEvents, pEvents, pcEvents);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::PredictSkeletonFrame(LONGLONG liTimeStamp, _In_opt_ const KINECT_SKELETON_PREDICTION* pPrediction, _Out_ NUI_SKELETON_FRAME* pSkeletonFrame)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pSkeletonFrame || (nullptr != pPrediction && pPrediction->dwStructSize != sizeof(KINECT_SKELETON_PREDICTION)))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pSkeletonStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    KINECT_SKELETON_PREDICTION prediction = { sizeof(KINECT_SKELETON_PREDICTION) };
+    if (nullptr != pPrediction)
+    {
+        prediction = *pPrediction;
+    }
+
+    return m_pSkeletonStream->PredictFrame(liTimeStamp, prediction, *pSkeletonFrame);
+}
+
+HRESULT KinectSensor::GetSkeletonBoneOrientations(_In_ const NUI_SKELETON_FRAME* pSkeletonFrame, ULONG cOrientations, _Out_cap_(cOrientations) NUI_SKELETON_BONE_ORIENTATION* pOrientations)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pSkeletonFrame || nullptr == pOrientations)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (cOrientations < NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT)
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    m_boneOrientations.GetBoneOrientations(*pSkeletonFrame, pOrientations);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::SetJointAngles(ULONG cAngles, _In_opt_count_(cAngles) const KINECT_JOINT_ANGLE* pAngles)
+{
+    AutoLock lock(m_nuiLock);
+
+    return m_boneOrientations.SetJointAngles(cAngles, pAngles);
+}
+
+HRESULT KinectSensor::GetSkeletonJointAngles(_In_ const NUI_SKELETON_FRAME* pSkeletonFrame, ULONG cAngles, _Out_cap_(cAngles) float* pAngles)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pSkeletonFrame || nullptr == pAngles)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (cAngles < NUI_SKELETON_COUNT * m_boneOrientations.GetJointAngleCount())
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    m_boneOrientations.GetJointAngles(*pSkeletonFrame, pAngles);
+
+    return S_OK;
+}
+
 // check the frame status before getting the frame
 // not required, but may improve perf
 bool KinectSensor::ColorFrameReady()
@@ -989,6 +1198,66 @@ HRESULT KinectSensor::GetDepthPixels(ULONG cDepthPixels, _Inout_cap_(cDepthPixel
     return m_pDepthStream->GetDepthImagePixels(cDepthPixels, pDepthPixels, liTimeStamp);
 }
 
+HRESULT KinectSensor::GetDepthMeters(ULONG cDepthPixels, _Out_cap_(cDepthPixels) float* pDepthMeters,
+    ULONG cbClasses, _Out_opt_cap_(cbClasses) BYTE* pClasses, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    AutoLock lock(m_nuiLock);
+
+    // is the buffer valid
+    if (nullptr == pDepthMeters)
+    {
+        return E_INVALIDARG;
+    }
+
+    // be sure the depth stream is running
+    HRESULT hr = StartDepthStream();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    // grab the frame
+    return m_pDepthStream->GetDepthMeters(cDepthPixels, pDepthMeters, cbClasses, pClasses, liTimeStamp);
+}
+
+HRESULT KinectSensor::GetDepthColorized(ULONG cbBuffer, _Out_cap_(cbBuffer) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pColorBuffer)
+    {
+        return E_INVALIDARG;
+    }
+
+    // be sure the depth stream is running
+    HRESULT hr = StartDepthStream();
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return m_pDepthStream->GetDepthColorized(cbBuffer, pColorBuffer, liTimeStamp);
+}
+
+HRESULT KinectSensor::SetDepthColorization(_In_opt_ const KINECT_DEPTH_COLORIZATION* pColorization)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pColorization && pColorization->dwStructSize != sizeof(KINECT_DEPTH_COLORIZATION))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->SetColorization(pColorization);
+
+    return S_OK;
+}
+
 HRESULT KinectSensor::GetColorFrameFromDepthPoints(
     DWORD cDepthPoints, _In_count_(cDepthPoints) NUI_DEPTH_IMAGE_POINT *pDepthPoints,
     ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp)
@@ -1009,6 +1278,493 @@ HRESULT KinectSensor::GetColorFrameFromDepthPoints(
     return m_pColorStream->GetColorAlignedToDepth(cDepthPoints, pDepthPoints, cBufferSize, pColorBuffer, liTimeStamp);
 }
 
+HRESULT KinectSensor::SetIRToneMapping(_In_opt_ const KINECT_IR_TONE_MAPPING* pToneMapping)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pToneMapping && (pToneMapping->dwStructSize != sizeof(KINECT_IR_TONE_MAPPING)
+        || static_cast<UINT>(pToneMapping->eMode) > IRToneMappingModeCLAHE || static_cast<UINT>(pToneMapping->eOutputFormat) > IROutputFormatFloat))
+    {
+        return E_INVALIDARG;
+    }
+
+    // tone mapping is part of the color stream, it has to be enabled first
+    if (nullptr == m_pColorStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pColorStream->SetToneMapping(pToneMapping);
+}
+
+HRESULT KinectSensor::SetColorMotionDetection(_In_opt_ const KINECT_MOTION_DETECTION* pMotionDetection)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pMotionDetection && pMotionDetection->dwStructSize != sizeof(KINECT_MOTION_DETECTION))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pColorStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pColorStream->SetMotionDetection(pMotionDetection);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::GetColorMotion(_Inout_ KINECT_MOTION_INFO* pMotionInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pMotionInfo || pMotionInfo->dwStructSize != sizeof(KINECT_MOTION_INFO))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pColorStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pColorStream->GetMotion(pMotionInfo, cbBitmap, pBitmap);
+}
+
+HRESULT KinectSensor::GetPointCloud(NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    _Inout_ KINECT_POINT_CLOUD* pPointCloud)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pPointCloud || pPointCloud->dwStructSize != sizeof(KINECT_POINT_CLOUD))
+    {
+        return E_INVALIDARG;
+    }
+
+    // the pixels come in the orientation of the depth stream
+    m_pointCloud.SetDepthTransform(nullptr != m_pDepthStream ? m_pDepthStream->GetTransform() : ImageTransform().GetParameters());
+
+    return m_pointCloud.Generate(eDepthResolution, cDepthPixels, pDepthPixels, nullptr, pPointCloud);
+}
+
+HRESULT KinectSensor::GetDepthNormals(NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    _Inout_ KINECT_DEPTH_NORMALS* pNormals)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pNormals || pNormals->dwStructSize != sizeof(KINECT_DEPTH_NORMALS))
+    {
+        return E_INVALIDARG;
+    }
+
+    // the pixels come in the orientation of the depth stream
+    m_pointCloud.SetDepthTransform(nullptr != m_pDepthStream ? m_pDepthStream->GetTransform() : ImageTransform().GetParameters());
+
+    return m_pointCloud.GenerateNormals(eDepthResolution, cDepthPixels, pDepthPixels, pNormals);
+}
+
+HRESULT KinectSensor::GetColoredPointCloud(NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    NUI_IMAGE_RESOLUTION eColorResolution,
+    ULONG cbColorBuffer, _In_count_(cbColorBuffer) const BYTE* pColorBuffer,
+    _Inout_ KINECT_POINT_CLOUD* pPointCloud)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pPointCloud || pPointCloud->dwStructSize != sizeof(KINECT_POINT_CLOUD) ||
+        nullptr == pDepthPixels || nullptr == pColorBuffer)
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pCoordinateMapper)
+    {
+        return E_NUI_DEVICE_NOT_READY;
+    }
+
+    // the color frame is in the orientation of the color stream, so are the mapped points
+    DWORD colorWidth = 0, colorHeight = 0;
+    NuiImageResolutionToSize(eColorResolution, colorWidth, colorHeight);
+    if (nullptr != m_pColorStream)
+    {
+        ImageTransform colorTransform;
+        colorTransform.SetParameters(m_pColorStream->GetTransform());
+        if (colorTransform.SwapsAxes())
+        {
+            std::swap(colorWidth, colorHeight);
+        }
+    }
+
+    if (0 == colorWidth || cbColorBuffer < colorWidth * colorHeight * sizeof(UINT32))
+    {
+        return E_INVALIDARG;
+    }
+
+    // the color points are kept between frames to avoid a per frame allocation
+    if (m_pointCloudColorPoints.size() < cDepthPixels)
+    {
+        m_pointCloudColorPoints.resize(cDepthPixels);
+    }
+
+    // the mapper takes the pixels as non const, it doesn't modify them
+    HRESULT hr = m_pCoordinateMapper->MapDepthFrameToColorFrame(
+        eDepthResolution,
+        cDepthPixels, const_cast<NUI_DEPTH_IMAGE_PIXEL*>(pDepthPixels),
+        NUI_IMAGE_TYPE_COLOR, eColorResolution,
+        cDepthPixels, m_pointCloudColorPoints.data());
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    PointCloud::ColorSource color = { m_pointCloudColorPoints.data(), reinterpret_cast<const UINT32*>(pColorBuffer), colorWidth, colorHeight };
+
+    m_pointCloud.SetDepthTransform(nullptr != m_pDepthStream ? m_pDepthStream->GetTransform() : ImageTransform().GetParameters());
+
+    return m_pointCloud.Generate(eDepthResolution, cDepthPixels, pDepthPixels, &color, pPointCloud);
+}
+
+HRESULT KinectSensor::GetEncodedColorFrame(_Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == ppEncoded || nullptr == pcbEncoded)
+    {
+        return E_INVALIDARG;
+    }
+
+    *ppEncoded = nullptr;
+    *pcbEncoded = 0;
+
+    KINECT_IMAGE_FRAME_FORMAT format = { sizeof(KINECT_IMAGE_FRAME_FORMAT), 0 };
+    GetColorFrameFormat(&format);
+    if (0 == format.cbBufferSize)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    // the buffers only grow, so steady state capture doesn't allocate
+    if (m_snapshotFrame.size() < format.cbBufferSize)
+    {
+        m_snapshotFrame.resize(format.cbBufferSize);
+    }
+
+    HRESULT hr = GetColorFrame(format.cbBufferSize, m_snapshotFrame.data(), liTimeStamp);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ULONG cbBound = ImageCodec::GetEncodedBound(format);
+    if (m_snapshotEncoded.size() < cbBound)
+    {
+        m_snapshotEncoded.resize(cbBound);
+    }
+
+    ULONG cbWritten = 0;
+    hr = ImageCodec::Encode(format, m_snapshotFrame.data(), static_cast<ULONG>(m_snapshotEncoded.size()), m_snapshotEncoded.data(), cbWritten);
+    if (SUCCEEDED(hr))
+    {
+        *ppEncoded = m_snapshotEncoded.data();
+        *pcbEncoded = cbWritten;
+    }
+
+    return hr;
+}
+
+HRESULT KinectSensor::GetEncodedDepthFrame(_Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == ppEncoded || nullptr == pcbEncoded)
+    {
+        return E_INVALIDARG;
+    }
+
+    *ppEncoded = nullptr;
+    *pcbEncoded = 0;
+
+    KINECT_IMAGE_FRAME_FORMAT format = { sizeof(KINECT_IMAGE_FRAME_FORMAT), 0 };
+    GetDepthFrameFormat(&format);
+    if (0 == format.cbBufferSize)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    // the buffers only grow, so steady state capture doesn't allocate
+    if (m_depthSnapshotFrame.size() < format.cbBufferSize)
+    {
+        m_depthSnapshotFrame.resize(format.cbBufferSize);
+    }
+
+    HRESULT hr = GetDepthFrame(format.cbBufferSize, m_depthSnapshotFrame.data(), liTimeStamp);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ULONG cbBound = DepthCodec::GetEncodedBound(format);
+    if (m_depthSnapshotEncoded.size() < cbBound)
+    {
+        m_depthSnapshotEncoded.resize(cbBound);
+    }
+
+    ULONG cbWritten = 0;
+    hr = DepthCodec::Encode(format, m_depthSnapshotFrame.data(), static_cast<ULONG>(m_depthSnapshotEncoded.size()), m_depthSnapshotEncoded.data(), cbWritten);
+    if (SUCCEEDED(hr))
+    {
+        *ppEncoded = m_depthSnapshotEncoded.data();
+        *pcbEncoded = cbWritten;
+    }
+
+    return hr;
+}
+
+HRESULT KinectSensor::GetEncodedSkeletonFrame(_Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == ppEncoded || nullptr == pcbEncoded)
+    {
+        return E_INVALIDARG;
+    }
+
+    *ppEncoded = nullptr;
+    *pcbEncoded = 0;
+
+    NUI_SKELETON_FRAME skeletonFrame = { 0 };
+    HRESULT hr = GetSkeletonFrame(skeletonFrame);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    ULONG cbBound = SkeletonCodec::GetEncodedBound();
+    if (m_skeletonEncoded.size() < cbBound)
+    {
+        m_skeletonEncoded.resize(cbBound);
+    }
+
+    // a keyframe now and then lets a receiver that lost a frame start over
+    const NUI_SKELETON_FRAME* pReference = (0 == m_cSkeletonEncoded % SKELETON_CODEC_KEYFRAME_INTERVAL) ? nullptr : &m_skeletonReference;
+
+    ULONG cbWritten = 0;
+    hr = SkeletonCodec::Encode(skeletonFrame, pReference, static_cast<ULONG>(m_skeletonEncoded.size()), m_skeletonEncoded.data(), cbWritten);
+    if (SUCCEEDED(hr))
+    {
+        m_skeletonReference = skeletonFrame;
+        ++m_cSkeletonEncoded;
+
+        *ppEncoded = m_skeletonEncoded.data();
+        *pcbEncoded = cbWritten;
+        if (nullptr != liTimeStamp)
+        {
+            *liTimeStamp = skeletonFrame.liTimeStamp.QuadPart;
+        }
+    }
+
+    return hr;
+}
+
+HRESULT KinectSensor::SetColorFrameTransform(_In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pTransform && pTransform->dwStructSize != sizeof(KINECT_IMAGE_TRANSFORM))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pColorStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pColorStream->SetTransform(pTransform);
+
+    // mapping has to agree with the images the caller gets
+    if (nullptr != m_pCoordinateMapper)
+    {
+        m_pCoordinateMapper->SetColorTransform(m_pColorStream->GetTransform());
+    }
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::SetDepthFrameTransform(_In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pTransform && pTransform->dwStructSize != sizeof(KINECT_IMAGE_TRANSFORM))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->SetTransform(pTransform);
+
+    if (nullptr != m_pCoordinateMapper)
+    {
+        m_pCoordinateMapper->SetDepthTransform(m_pDepthStream->GetTransform());
+    }
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::SetDepthFilter(_In_opt_ const KINECT_DEPTH_FILTER* pDepthFilter)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pDepthFilter && pDepthFilter->dwStructSize != sizeof(KINECT_DEPTH_FILTER))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->SetFilter(pDepthFilter);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::SetDepthPlayerSegmentation(bool bEnable)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->SetPlayerSegmentation(bEnable);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::GetDepthPlayerSegmentation(_Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pSegmentation || pSegmentation->dwStructSize != sizeof(KINECT_PLAYER_SEGMENTATION))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pDepthStream->GetPlayerSegmentation(pSegmentation, cbMasks, pMasks);
+}
+
+HRESULT KinectSensor::SetDepthIntegralImages(bool bEnable)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->SetIntegralImages(bEnable);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::GetDepthRegionStats(ULONG cRegions, _In_count_(cRegions) const RECT* pRegions, _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (0 != cRegions && (nullptr == pRegions || nullptr == pStats))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pDepthStream->GetRegionStats(cRegions, pRegions, pStats);
+}
+
+HRESULT KinectSensor::SetDepthBackgroundModel(_In_opt_ const KINECT_BACKGROUND_MODEL* pBackgroundModel)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr != pBackgroundModel && pBackgroundModel->dwStructSize != sizeof(KINECT_BACKGROUND_MODEL))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->SetBackgroundModel(pBackgroundModel);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::FreezeDepthBackground(bool bFreeze)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->FreezeBackground(bFreeze);
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::ResetDepthBackground()
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    m_pDepthStream->ResetBackground();
+
+    return S_OK;
+}
+
+HRESULT KinectSensor::GetDepthForeground(_Inout_ KINECT_FOREGROUND_INFO* pForegroundInfo,
+    ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices)
+{
+    AutoLock lock(m_nuiLock);
+
+    if (nullptr == pForegroundInfo || pForegroundInfo->dwStructSize != sizeof(KINECT_FOREGROUND_INFO))
+    {
+        return E_INVALIDARG;
+    }
+
+    if (nullptr == m_pDepthStream)
+    {
+        return E_NUI_STREAM_NOT_ENABLED;
+    }
+
+    return m_pDepthStream->GetForeground(pForegroundInfo, cbMask, pMask, cIndices, pIndices);
+}
+
 void KinectSensor::EnableAudioStream()
 {
     EnableAudioStream(nullptr, nullptr);
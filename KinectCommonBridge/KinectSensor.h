@@ -21,6 +21,8 @@ See the Apache 2 License for the specific language governing permissions and lim
 #include "DataStreamSkeleton.h"
 #include "DataStreamAudio.h"
 #include "CoordinateMapper.h"
+#include "PointCloud.h"
+#include "BoneOrientations.h"
 
 class FaceTracker;
 
@@ -78,11 +80,74 @@ public:
     HRESULT GetColorFrame( ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp );
     HRESULT GetDepthFrame( ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pDepthBuffer, _Out_opt_ LONGLONG* liTimeStamp );
     HRESULT GetSkeletonFrame( _Inout_ NUI_SKELETON_FRAME& skeletonFrame );
+    DWORD GetChosenSkeletonID();
+    HRESULT SetPlayerSelection( _In_opt_ const KINECT_PLAYER_SELECTION* pSelection );
+    HRESULT SetSkeletonFilter( _In_opt_ const KINECT_SKELETON_FILTER* pFilter );
+    HRESULT SetSkeletonHistory( _In_opt_ const KINECT_SKELETON_HISTORY* pHistory );
+    HRESULT GetSkeletonTrajectory( _Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory );
+    HRESULT AddGestureTemplate( _In_ const KINECT_GESTURE_TEMPLATE* pTemplate, _Out_ DWORD* pdwGestureID );
+    HRESULT RemoveGestureTemplate( DWORD dwGestureID );
+    HRESULT GetGestureEvents( ULONG cMaxEvents, _Out_cap_(cMaxEvents) KINECT_GESTURE_EVENT* pEvents, _Out_ ULONG* pcEvents );
+    HRESULT PredictSkeletonFrame( LONGLONG liTimeStamp, _In_opt_ const KINECT_SKELETON_PREDICTION* pPrediction, _Out_ NUI_SKELETON_FRAME* pSkeletonFrame );
+    HRESULT GetSkeletonBoneOrientations( _In_ const NUI_SKELETON_FRAME* pSkeletonFrame, ULONG cOrientations, _Out_cap_(cOrientations) NUI_SKELETON_BONE_ORIENTATION* pOrientations );
+    HRESULT SetJointAngles( ULONG cAngles, _In_opt_count_(cAngles) const KINECT_JOINT_ANGLE* pAngles );
+    HRESULT GetSkeletonJointAngles( _In_ const NUI_SKELETON_FRAME* pSkeletonFrame, ULONG cAngles, _Out_cap_(cAngles) float* pAngles );
     HRESULT GetDepthPixels( ULONG cDepthPixels, _Inout_cap_(cDepthPixels) NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, _Out_opt_ LONGLONG* liTimeStamp );
+    HRESULT GetDepthMeters( ULONG cDepthPixels, _Out_cap_(cDepthPixels) float* pDepthMeters,
+        ULONG cbClasses, _Out_opt_cap_(cbClasses) BYTE* pClasses, _Out_opt_ LONGLONG* liTimeStamp );
+    HRESULT GetDepthColorized( ULONG cbBuffer, _Out_cap_(cbBuffer) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp );
+    HRESULT SetDepthColorization( _In_opt_ const KINECT_DEPTH_COLORIZATION* pColorization );
     HRESULT GetColorFrameFromDepthPoints(
         DWORD cDepthPoints, _In_count_(cDepthPoints) NUI_DEPTH_IMAGE_POINT *pDepthPoints,
         ULONG cBufferSize, _Inout_cap_(cBufferSize) BYTE* pColorBuffer, _Out_opt_ LONGLONG* liTimeStamp);
 
+    // infrared post processing
+    HRESULT SetIRToneMapping( _In_opt_ const KINECT_IR_TONE_MAPPING* pToneMapping );
+
+    // frame orientation, also applied to the coordinate mapper
+    HRESULT SetColorFrameTransform( _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform );
+    HRESULT SetDepthFrameTransform( _In_opt_ const KINECT_IMAGE_TRANSFORM* pTransform );
+
+    // depth filter chain
+    HRESULT SetDepthFilter( _In_opt_ const KINECT_DEPTH_FILTER* pDepthFilter );
+
+    // player segmentation
+    HRESULT SetDepthPlayerSegmentation( bool bEnable );
+    HRESULT GetDepthPlayerSegmentation( _Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks );
+
+    // summed area tables
+    HRESULT SetDepthIntegralImages( bool bEnable );
+    HRESULT GetDepthRegionStats( ULONG cRegions, _In_count_(cRegions) const RECT* pRegions, _Out_cap_(cRegions) KINECT_DEPTH_REGION_STATS* pStats );
+
+    // background model
+    HRESULT SetDepthBackgroundModel( _In_opt_ const KINECT_BACKGROUND_MODEL* pBackgroundModel );
+    HRESULT FreezeDepthBackground( bool bFreeze );
+    HRESULT ResetDepthBackground();
+    HRESULT GetDepthForeground( _Inout_ KINECT_FOREGROUND_INFO* pForegroundInfo,
+        ULONG cbMask, _Out_opt_cap_(cbMask) BYTE* pMask, ULONG cIndices, _Out_opt_cap_(cIndices) DWORD* pIndices );
+
+    // motion detection on the color/IR stream
+    HRESULT SetColorMotionDetection( _In_opt_ const KINECT_MOTION_DETECTION* pMotionDetection );
+    HRESULT GetColorMotion( _Inout_ KINECT_MOTION_INFO* pMotionInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap );
+
+    // depth pixels to camera space points
+    HRESULT GetPointCloud( NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        _Inout_ KINECT_POINT_CLOUD* pPointCloud );
+    HRESULT GetDepthNormals( NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        _Inout_ KINECT_DEPTH_NORMALS* pNormals );
+    HRESULT GetColoredPointCloud( NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        NUI_IMAGE_RESOLUTION eColorResolution,
+        ULONG cbColorBuffer, _In_count_(cbColorBuffer) const BYTE* pColorBuffer,
+        _Inout_ KINECT_POINT_CLOUD* pPointCloud );
+
+    // encoded snapshot, the buffer is owned by the sensor
+    HRESULT GetEncodedColorFrame( _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp );
+    HRESULT GetEncodedDepthFrame( _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp );
+    HRESULT GetEncodedSkeletonFrame( _Out_ const BYTE** ppEncoded, _Out_ ULONG* pcbEncoded, _Out_opt_ LONGLONG* liTimeStamp );
+
     // audio/speech stream
     void EnableAudioStream(_In_opt_ AEC_SYSTEM_MODE* eAECSystemMode, _In_opt_ bool* bGainBounder);
     HRESULT StartAudioStream();
@@ -173,6 +238,24 @@ private:
     std::unique_ptr<DataStreamAudio>    m_pAudioStream;
 
     std::unique_ptr<CoordinateMapper>   m_pCoordinateMapper;
+
+    // ray tables for the point cloud, kept for the lifetime of the sensor
+    PointCloud          m_pointCloud;
+    std::vector<NUI_COLOR_IMAGE_POINT>  m_pointCloudColorPoints;
+
+    // bone orientations and the joint angles set for them
+    BoneOrientations    m_boneOrientations;
+
+    // pooled buffers for encoded snapshots
+    std::vector<BYTE>   m_snapshotFrame;
+    std::vector<BYTE>   m_snapshotEncoded;
+    std::vector<BYTE>   m_depthSnapshotFrame;
+    std::vector<BYTE>   m_depthSnapshotEncoded;
+
+    // encoded skeleton frames are deltas from the frame encoded before
+    std::vector<BYTE>   m_skeletonEncoded;
+    NUI_SKELETON_FRAME  m_skeletonReference;
+    ULONG               m_cSkeletonEncoded;
 #ifdef KCB_ENABLE_FT
     std::unique_ptr<FaceTracker>        m_pFaceTracker;
 #endif
@@ -0,0 +1,292 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "MotionDetector.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+
+// 2x2 downsampling, each luma sample is the mean of four native pixels
+
+static void DownsampleBGRX( _In_ const BYTE* pRow0, _In_ const BYTE* pRow1, UINT cSamples, _Out_ BYTE* pLuma )
+{
+    for( UINT i = 0; i < cSamples; ++i, pRow0 += 8, pRow1 += 8 )
+    {
+        UINT blue = pRow0[0] + pRow0[4] + pRow1[0] + pRow1[4];
+        UINT green = pRow0[1] + pRow0[5] + pRow1[1] + pRow1[5];
+        UINT red = pRow0[2] + pRow0[6] + pRow1[2] + pRow1[6];
+
+        // BT.601 weights in 8 bit fixed point, the extra 2 bits divide the sum of four
+        pLuma[i] = static_cast<BYTE>( (29 * blue + 150 * green + 77 * red) >> 10 );
+    }
+}
+
+static void DownsampleInfrared( _In_ const BYTE* pRow0, _In_ const BYTE* pRow1, UINT cSamples, _Out_ BYTE* pLuma )
+{
+    const USHORT* p0 = reinterpret_cast<const USHORT*>(pRow0);
+    const USHORT* p1 = reinterpret_cast<const USHORT*>(pRow1);
+
+    for( UINT i = 0; i < cSamples; ++i, p0 += 2, p1 += 2 )
+    {
+        pLuma[i] = static_cast<BYTE>( (p0[0] + p0[1] + p1[0] + p1[1]) >> 10 );
+    }
+}
+
+static void DownsampleBayer( _In_ const BYTE* pRow0, _In_ const BYTE* pRow1, UINT cSamples, _Out_ BYTE* pLuma )
+{
+    // a 2x2 quad holds one red, two green and one blue sample
+    for( UINT i = 0; i < cSamples; ++i, pRow0 += 2, pRow1 += 2 )
+    {
+        pLuma[i] = static_cast<BYTE>( (pRow0[0] + pRow0[1] + pRow1[0] + pRow1[1]) >> 2 );
+    }
+}
+
+// sum of absolute differences of every block in a row of blocks
+// a 16 byte load covers the same luma row of two neighbouring blocks,
+// and _mm_sad_epu8 sums each 8 byte half on its own
+static void SumBlockDifferences( _In_ const BYTE* pLuma, _In_ const BYTE* pPreviousLuma, UINT lumaPitch, UINT cBlocks, _Out_ UINT* pBlockSad )
+{
+    UINT block = 0;
+
+    for( ; block + 2 <= cBlocks; block += 2 )
+    {
+        const BYTE* pCur = pLuma + block * MOTION_BLOCK_SAMPLES;
+        const BYTE* pPrev = pPreviousLuma + block * MOTION_BLOCK_SAMPLES;
+
+        __m128i sum = _mm_setzero_si128();
+        for( UINT row = 0; row < MOTION_BLOCK_SAMPLES; ++row, pCur += lumaPitch, pPrev += lumaPitch )
+        {
+            __m128i cur = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pCur) );
+            __m128i prev = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pPrev) );
+            sum = _mm_add_epi64( sum, _mm_sad_epu8( cur, prev ) );
+        }
+
+        pBlockSad[block] = static_cast<UINT>( _mm_cvtsi128_si32( sum ) );
+        pBlockSad[block + 1] = static_cast<UINT>( _mm_cvtsi128_si32( _mm_srli_si128( sum, 8 ) ) );
+    }
+
+    for( ; block < cBlocks; ++block )
+    {
+        const BYTE* pCur = pLuma + block * MOTION_BLOCK_SAMPLES;
+        const BYTE* pPrev = pPreviousLuma + block * MOTION_BLOCK_SAMPLES;
+
+        UINT sum = 0;
+        for( UINT row = 0; row < MOTION_BLOCK_SAMPLES; ++row, pCur += lumaPitch, pPrev += lumaPitch )
+        {
+            for( UINT i = 0; i < MOTION_BLOCK_SAMPLES; ++i )
+            {
+                sum += (pCur[i] > pPrev[i]) ? pCur[i] - pPrev[i] : pPrev[i] - pCur[i];
+            }
+        }
+
+        pBlockSad[block] = sum;
+    }
+}
+
+MotionDetector::MotionDetector()
+    : m_bEnabled(false)
+    , m_width(0)
+    , m_height(0)
+    , m_bpp(0)
+    , m_cBlocksX(0)
+    , m_cBlocksY(0)
+    , m_lumaPitch(0)
+    , m_current(0)
+    , m_bPreviousValid(false)
+    , m_bResultValid(false)
+    , m_cMovingBlocks(0)
+    , m_fScore(0.0f)
+{
+    ZeroMemory( &m_params, sizeof(KINECT_MOTION_DETECTION) );
+
+    m_params.dwStructSize = sizeof(KINECT_MOTION_DETECTION);
+    m_params.uThreshold = MOTION_DEFAULT_THRESHOLD;
+}
+
+void MotionDetector::SetParameters( _In_opt_ const KINECT_MOTION_DETECTION* pParams )
+{
+    m_bEnabled = (nullptr != pParams);
+    if( m_bEnabled )
+    {
+        m_params = *pParams;
+        if( 0 == m_params.uThreshold || m_params.uThreshold > 255 )
+        {
+            m_params.uThreshold = MOTION_DEFAULT_THRESHOLD;
+        }
+    }
+
+    // the next frame starts over, there is nothing to compare it with
+    m_bPreviousValid = false;
+    m_bResultValid = false;
+}
+
+void MotionDetector::ResetLayout( UINT width, UINT height, UINT bpp )
+{
+    m_width = width;
+    m_height = height;
+    m_bpp = bpp;
+
+    // partial blocks at the right and bottom edge are not checked
+    m_cBlocksX = width / MOTION_BLOCK_SIZE;
+    m_cBlocksY = height / MOTION_BLOCK_SIZE;
+    m_lumaPitch = m_cBlocksX * MOTION_BLOCK_SAMPLES;
+
+    m_luma.assign( 2 * m_lumaPitch * m_cBlocksY * MOTION_BLOCK_SAMPLES, 0 );
+    m_blockSad.assign( m_cBlocksX * m_cBlocksY, 0 );
+    m_moving.assign( m_cBlocksX * m_cBlocksY, 0 );
+
+    m_current = 0;
+    m_bPreviousValid = false;
+    m_bResultValid = false;
+}
+
+void MotionDetector::ProcessBlockRow( _In_ const BYTE* pSrc, UINT srcPitch, UINT blockRow, _Out_ BYTE* pLuma, _In_ const BYTE* pPreviousLuma )
+{
+    const size_t lumaOffset = static_cast<size_t>(blockRow) * MOTION_BLOCK_SAMPLES * m_lumaPitch;
+    BYTE* pLumaRow = pLuma + lumaOffset;
+    const BYTE* pRow = pSrc + static_cast<size_t>(blockRow) * MOTION_BLOCK_SIZE * srcPitch;
+
+    for( UINT y = 0; y < MOTION_BLOCK_SAMPLES; ++y, pRow += 2 * srcPitch, pLumaRow += m_lumaPitch )
+    {
+        switch( m_bpp )
+        {
+        case 4:
+            DownsampleBGRX( pRow, pRow + srcPitch, m_lumaPitch, pLumaRow );
+            break;
+        case 2:
+            DownsampleInfrared( pRow, pRow + srcPitch, m_lumaPitch, pLumaRow );
+            break;
+        default:
+            DownsampleBayer( pRow, pRow + srcPitch, m_lumaPitch, pLumaRow );
+            break;
+        }
+    }
+
+    if( m_bPreviousValid )
+    {
+        SumBlockDifferences( pLuma + lumaOffset, pPreviousLuma + lumaOffset, m_lumaPitch, m_cBlocksX,
+            m_blockSad.data() + blockRow * m_cBlocksX );
+    }
+}
+
+void MotionDetector::Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, UINT bpp, ULONG cbDst, _Out_opt_cap_(cbDst) BYTE* pDst )
+{
+    if( nullptr == pSrc || 0 == width || 0 == height )
+    {
+        return;
+    }
+
+    if( width != m_width || height != m_height || bpp != m_bpp )
+    {
+        ResetLayout( width, height, bpp );
+    }
+
+    const size_t planeSize = m_luma.size() / 2;
+    BYTE* pLuma = m_luma.data() + m_current * planeSize;
+    const BYTE* pPreviousLuma = m_luma.data() + (1 - m_current) * planeSize;
+
+    // rows of the caller buffer, the copy may cover the partial blocks at the bottom
+    const UINT rowSize = width * bpp;
+    const UINT cDstRows = (nullptr != pDst) ? min( height, static_cast<UINT>(cbDst / rowSize) ) : 0;
+    const UINT cBands = max( m_cBlocksY, (cDstRows + MOTION_BLOCK_SIZE - 1) / MOTION_BLOCK_SIZE );
+
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        if( band < m_cBlocksY )
+        {
+            ProcessBlockRow( pSrc, srcPitch, band, pLuma, pPreviousLuma );
+        }
+
+        // the rows were just read for the luma plane, so the copy comes from the cache
+        UINT y0 = band * MOTION_BLOCK_SIZE;
+        UINT y1 = min( cDstRows, y0 + MOTION_BLOCK_SIZE );
+        for( UINT y = y0; y < y1; ++y )
+        {
+            memcpy( pDst + static_cast<size_t>(y) * rowSize, pSrc + static_cast<size_t>(y) * srcPitch, rowSize );
+        }
+    });
+
+    if( m_bPreviousValid )
+    {
+        const UINT threshold = m_params.uThreshold * MOTION_BLOCK_SAMPLES * MOTION_BLOCK_SAMPLES;
+
+        UINT64 totalSad = 0;
+        m_cMovingBlocks = 0;
+        for( size_t block = 0; block < m_blockSad.size(); ++block )
+        {
+            totalSad += m_blockSad[block];
+            m_moving[block] = (m_blockSad[block] > threshold) ? 1 : 0;
+            m_cMovingBlocks += m_moving[block];
+        }
+
+        // mean absolute difference per sample, normalized to 0 - 1
+        m_fScore = m_blockSad.empty() ? 0.0f
+            : static_cast<float>( static_cast<double>(totalSad) / (255.0 * planeSize) );
+        m_bResultValid = true;
+    }
+
+    m_current = 1 - m_current;
+    m_bPreviousValid = true;
+}
+
+HRESULT MotionDetector::GetResult( const ImageTransform& transform, _Inout_ KINECT_MOTION_INFO* pInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap )
+{
+    if( !m_bEnabled || !m_bResultValid )
+    {
+        return E_NUI_FRAME_NO_DATA;
+    }
+
+    // frame sizes are multiples of the block size, so the block grid transforms like the frame
+    const BYTE* pMoving = m_moving.data();
+    UINT cBlocksX = m_cBlocksX;
+    UINT cBlocksY = m_cBlocksY;
+    if( !transform.IsIdentity() )
+    {
+        m_transformedMoving.resize( m_moving.size() );
+        transform.Reorder( m_moving.data(), m_cBlocksX, m_cBlocksY, false, m_transformedMoving.data() );
+        transform.GetOutputSize( m_cBlocksX, m_cBlocksY, cBlocksX, cBlocksY );
+        pMoving = m_transformedMoving.data();
+    }
+
+    pInfo->cBlocksX = cBlocksX;
+    pInfo->cBlocksY = cBlocksY;
+    pInfo->cbBitmapPitch = (cBlocksX + 7) / 8;
+    pInfo->cMovingBlocks = m_cMovingBlocks;
+    pInfo->fMotionScore = m_fScore;
+
+    if( nullptr == pBitmap )
+    {
+        return S_OK;
+    }
+
+    if( cbBitmap < pInfo->cbBitmapPitch * cBlocksY )
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    // one bit per block, lowest bit first
+    ZeroMemory( pBitmap, pInfo->cbBitmapPitch * cBlocksY );
+    for( UINT y = 0; y < cBlocksY; ++y )
+    {
+        BYTE* pRow = pBitmap + y * pInfo->cbBitmapPitch;
+        for( UINT x = 0; x < cBlocksX; ++x )
+        {
+            pRow[x >> 3] |= static_cast<BYTE>( *pMoving++ << (x & 7) );
+        }
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,78 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+#include "ImageTransform.h"
+
+// size of a motion block in pixels of the native frame
+#define MOTION_BLOCK_SIZE           16
+
+// luma samples per block side, the luma plane is downsampled 2x2
+#define MOTION_BLOCK_SAMPLES        (MOTION_BLOCK_SIZE / 2)
+
+// mean luma difference of a moving block when the caller doesn't set one
+#define MOTION_DEFAULT_THRESHOLD    8
+
+// block based motion detection on the color/IR stream
+// the frame is read once: every band of block rows is downsampled to luma, compared with
+// the luma of the previous frame and, on the plain copy path, copied to the caller buffer
+// in the same task so the source rows are only pulled into the cache once
+class MotionDetector
+{
+public:
+    MotionDetector();
+
+    // nullptr turns it off
+    void SetParameters( _In_opt_ const KINECT_MOTION_DETECTION* pParams );
+    bool IsEnabled() const { return m_bEnabled; }
+
+    // pSrc - native frame, rows srcPitch bytes apart
+    // bpp - 1 (bayer), 2 (infrared) or 4 (BGRX)
+    // pDst - optional, receives a tightly packed copy of the frame, rows that do not fit into cbDst are skipped
+    void Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, UINT bpp, ULONG cbDst, _Out_opt_cap_(cbDst) BYTE* pDst );
+
+    // result of the last frame, the bitmap has the orientation of the copied frame
+    HRESULT GetResult( const ImageTransform& transform, _Inout_ KINECT_MOTION_INFO* pInfo, ULONG cbBitmap, _Out_opt_cap_(cbBitmap) BYTE* pBitmap );
+
+private:
+    void ResetLayout( UINT width, UINT height, UINT bpp );
+    void ProcessBlockRow( _In_ const BYTE* pSrc, UINT srcPitch, UINT blockRow, _Out_ BYTE* pLuma, _In_ const BYTE* pPreviousLuma );
+
+private:
+    KINECT_MOTION_DETECTION m_params;
+    bool m_bEnabled;
+
+    UINT m_width;
+    UINT m_height;
+    UINT m_bpp;
+
+    UINT m_cBlocksX;
+    UINT m_cBlocksY;
+    UINT m_lumaPitch;
+
+    // luma of the current and the previous frame, the two halves swap every frame
+    std::vector<BYTE> m_luma;
+    UINT m_current;
+    bool m_bPreviousValid;
+
+    // per block results of the last frame in native block order
+    bool m_bResultValid;
+    std::vector<UINT> m_blockSad;
+    std::vector<BYTE> m_moving;
+    std::vector<BYTE> m_transformedMoving;
+    UINT m_cMovingBlocks;
+    float m_fScore;
+};
@@ -0,0 +1,356 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "PlayerSegmentation.h"
+
+#include <ppl.h>
+#include <emmintrin.h>
+#include <intrin.h>
+#include <limits.h>
+
+// 4 NUI_DEPTH_IMAGE_PIXELs to depth << 3 | player, sign extended from the low USHORT
+// so that _mm_packs_epi32 keeps all 16 bits
+static inline __m128i PackDepthPixels( __m128i pixels )
+{
+    __m128i depth = _mm_slli_epi32( _mm_srli_epi32( pixels, 16 ), NUI_IMAGE_PLAYER_INDEX_SHIFT );
+    __m128i packed = _mm_or_si128( depth, _mm_and_si128( pixels, _mm_set1_epi32( NUI_IMAGE_PLAYER_INDEX_MASK ) ) );
+    return _mm_srai_epi32( _mm_slli_epi32( packed, 16 ), 16 );
+}
+
+PlayerSegmentation::PlayerSegmentation()
+    : m_bEnabled(false)
+    , m_width(0)
+    , m_height(0)
+    , m_maskPitch(0)
+    , m_bResultValid(false)
+{
+    ResetStats( m_frameStats );
+}
+
+void PlayerSegmentation::SetEnabled( bool bEnabled )
+{
+    m_bEnabled = bEnabled;
+    m_bResultValid = false;
+}
+
+void PlayerSegmentation::ResetLayout( UINT width, UINT height )
+{
+    m_width = width;
+    m_height = height;
+    m_maskPitch = (width + 7) / 8;
+
+    m_masks.assign( NUI_SKELETON_COUNT * m_maskPitch * height, 0 );
+    m_bandStats.resize( (height + PLAYER_SEGMENTATION_BAND_ROWS - 1) / PLAYER_SEGMENTATION_BAND_ROWS );
+}
+
+void PlayerSegmentation::ResetStats( _Out_ BandStats& stats )
+{
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        PlayerStats& player = stats.players[i];
+        player.cPixels = 0;
+        player.left = UINT_MAX;
+        player.top = UINT_MAX;
+        player.right = 0;
+        player.bottom = 0;
+        player.sumX = 0;
+        player.sumY = 0;
+        player.minDepth = USHRT_MAX;
+        player.maxDepth = 0;
+    }
+}
+
+void PlayerSegmentation::AddPixel( _Inout_ PlayerStats& player, UINT x, UINT y, USHORT depth )
+{
+    ++player.cPixels;
+    player.left = min( player.left, x );
+    player.right = max( player.right, x );
+    player.top = min( player.top, y );
+    player.bottom = max( player.bottom, y );
+    player.sumX += x;
+    player.sumY += y;
+
+    // a player pixel can still be missing its depth
+    if( 0 != depth )
+    {
+        player.minDepth = min( player.minDepth, depth );
+        player.maxDepth = max( player.maxDepth, depth );
+    }
+}
+
+void PlayerSegmentation::ProcessRow( _In_ const BYTE* pSrc, bool bPixels, UINT y, _Out_opt_ NUI_DEPTH_IMAGE_PIXEL* pDstPixels,
+    _Out_opt_ BYTE* pDstPacked, _Inout_ BandStats& stats )
+{
+    const NUI_DEPTH_IMAGE_PIXEL* pSrcPixels = reinterpret_cast<const NUI_DEPTH_IMAGE_PIXEL*>(pSrc);
+    const USHORT* pSrcPacked = reinterpret_cast<const USHORT*>(pSrc);
+    USHORT* pDstPackedRow = reinterpret_cast<USHORT*>(pDstPacked);
+
+    BYTE* pMaskRows[NUI_SKELETON_COUNT];
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        pMaskRows[i] = m_masks.data() + (i * m_height + y) * m_maskPitch;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i playerMask32 = _mm_set1_epi32( NUI_IMAGE_PLAYER_INDEX_MASK );
+    const __m128i playerMask16 = _mm_set1_epi16( NUI_IMAGE_PLAYER_INDEX_MASK );
+
+    // 16 pixels at a time, their player indices end up in the 16 bytes of a register
+    UINT x = 0;
+    for( ; x + 16 <= m_width; x += 16 )
+    {
+        __m128i players;
+        if( bPixels )
+        {
+            const __m128i* pIn = reinterpret_cast<const __m128i*>(pSrcPixels + x);
+            __m128i p0 = _mm_loadu_si128( pIn );
+            __m128i p1 = _mm_loadu_si128( pIn + 1 );
+            __m128i p2 = _mm_loadu_si128( pIn + 2 );
+            __m128i p3 = _mm_loadu_si128( pIn + 3 );
+
+            if( nullptr != pDstPixels )
+            {
+                __m128i* pOut = reinterpret_cast<__m128i*>(pDstPixels + x);
+                _mm_storeu_si128( pOut, p0 );
+                _mm_storeu_si128( pOut + 1, p1 );
+                _mm_storeu_si128( pOut + 2, p2 );
+                _mm_storeu_si128( pOut + 3, p3 );
+            }
+
+            if( nullptr != pDstPackedRow )
+            {
+                __m128i* pOut = reinterpret_cast<__m128i*>(pDstPackedRow + x);
+                _mm_storeu_si128( pOut, _mm_packs_epi32( PackDepthPixels( p0 ), PackDepthPixels( p1 ) ) );
+                _mm_storeu_si128( pOut + 1, _mm_packs_epi32( PackDepthPixels( p2 ), PackDepthPixels( p3 ) ) );
+            }
+
+            players = _mm_packs_epi16(
+                _mm_packs_epi32( _mm_and_si128( p0, playerMask32 ), _mm_and_si128( p1, playerMask32 ) ),
+                _mm_packs_epi32( _mm_and_si128( p2, playerMask32 ), _mm_and_si128( p3, playerMask32 ) ) );
+        }
+        else
+        {
+            const __m128i* pIn = reinterpret_cast<const __m128i*>(pSrcPacked + x);
+            __m128i p0 = _mm_loadu_si128( pIn );
+            __m128i p1 = _mm_loadu_si128( pIn + 1 );
+
+            if( nullptr != pDstPackedRow )
+            {
+                __m128i* pOut = reinterpret_cast<__m128i*>(pDstPackedRow + x);
+                _mm_storeu_si128( pOut, p0 );
+                _mm_storeu_si128( pOut + 1, p1 );
+            }
+
+            __m128i player0 = _mm_and_si128( p0, playerMask16 );
+            __m128i player1 = _mm_and_si128( p1, playerMask16 );
+
+            if( nullptr != pDstPixels )
+            {
+                // playerIndex is the low USHORT of a pixel, depth the high one
+                __m128i depth0 = _mm_srli_epi16( p0, NUI_IMAGE_PLAYER_INDEX_SHIFT );
+                __m128i depth1 = _mm_srli_epi16( p1, NUI_IMAGE_PLAYER_INDEX_SHIFT );
+
+                __m128i* pOut = reinterpret_cast<__m128i*>(pDstPixels + x);
+                _mm_storeu_si128( pOut, _mm_unpacklo_epi16( player0, depth0 ) );
+                _mm_storeu_si128( pOut + 1, _mm_unpackhi_epi16( player0, depth0 ) );
+                _mm_storeu_si128( pOut + 2, _mm_unpacklo_epi16( player1, depth1 ) );
+                _mm_storeu_si128( pOut + 3, _mm_unpackhi_epi16( player1, depth1 ) );
+            }
+
+            players = _mm_packus_epi16( player0, player1 );
+        }
+
+        // one mask bit per pixel, lowest bit first
+        UINT occupied = ~_mm_movemask_epi8( _mm_cmpeq_epi8( players, zero ) ) & 0xffff;
+        for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+        {
+            UINT bits = (0 == occupied) ? 0 : _mm_movemask_epi8( _mm_cmpeq_epi8( players, _mm_set1_epi8( static_cast<char>(i + 1) ) ) );
+            pMaskRows[i][x / 8] = static_cast<BYTE>( bits );
+            pMaskRows[i][x / 8 + 1] = static_cast<BYTE>( bits >> 8 );
+        }
+
+        // the statistics only visit the player pixels
+        while( 0 != occupied )
+        {
+            DWORD bit = 0;
+            _BitScanForward( &bit, occupied );
+            occupied &= occupied - 1;
+
+            UINT player = bPixels ? pSrcPixels[x + bit].playerIndex : (pSrcPacked[x + bit] & NUI_IMAGE_PLAYER_INDEX_MASK);
+            USHORT depth = bPixels ? pSrcPixels[x + bit].depth : (pSrcPacked[x + bit] >> NUI_IMAGE_PLAYER_INDEX_SHIFT);
+            if( player <= NUI_SKELETON_COUNT )
+            {
+                AddPixel( stats.players[player - 1], x + bit, y, depth );
+            }
+        }
+    }
+
+    // rest of the row
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        ZeroMemory( pMaskRows[i] + x / 8, m_maskPitch - x / 8 );
+    }
+
+    for( ; x < m_width; ++x )
+    {
+        USHORT player = bPixels ? pSrcPixels[x].playerIndex : (pSrcPacked[x] & NUI_IMAGE_PLAYER_INDEX_MASK);
+        USHORT depth = bPixels ? pSrcPixels[x].depth : (pSrcPacked[x] >> NUI_IMAGE_PLAYER_INDEX_SHIFT);
+
+        if( nullptr != pDstPixels )
+        {
+            pDstPixels[x].playerIndex = player;
+            pDstPixels[x].depth = depth;
+        }
+
+        if( nullptr != pDstPackedRow )
+        {
+            pDstPackedRow[x] = static_cast<USHORT>( depth << NUI_IMAGE_PLAYER_INDEX_SHIFT | (player & NUI_IMAGE_PLAYER_INDEX_MASK) );
+        }
+
+        if( 0 != player && player <= NUI_SKELETON_COUNT )
+        {
+            pMaskRows[player - 1][x / 8] |= static_cast<BYTE>( 1 << (x & 7) );
+            AddPixel( stats.players[player - 1], x, y, depth );
+        }
+    }
+}
+
+void PlayerSegmentation::Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels,
+    ULONG cDstPixels, _Out_opt_cap_(cDstPixels) NUI_DEPTH_IMAGE_PIXEL* pDstPixels,
+    ULONG cbDstPacked, _Out_opt_cap_(cbDstPacked) BYTE* pDstPacked )
+{
+    if( width != m_width || height != m_height )
+    {
+        ResetLayout( width, height );
+    }
+
+    Concurrency::parallel_for( size_t(0), m_bandStats.size(), [&]( size_t band )
+    {
+        BandStats& stats = m_bandStats[band];
+        ResetStats( stats );
+
+        UINT yEnd = min( height, static_cast<UINT>(band + 1) * PLAYER_SEGMENTATION_BAND_ROWS );
+        for( UINT y = static_cast<UINT>(band) * PLAYER_SEGMENTATION_BAND_ROWS; y < yEnd; ++y )
+        {
+            const BYTE* pSrcRow = pSrc + y * srcPitch;
+
+            // a destination row that is the source row is already in place
+            NUI_DEPTH_IMAGE_PIXEL* pDstPixelRow = nullptr;
+            if( nullptr != pDstPixels && (y + 1) * width <= cDstPixels )
+            {
+                pDstPixelRow = pDstPixels + y * width;
+                if( reinterpret_cast<const BYTE*>(pDstPixelRow) == pSrcRow )
+                {
+                    pDstPixelRow = nullptr;
+                }
+            }
+
+            BYTE* pDstPackedRow = nullptr;
+            if( nullptr != pDstPacked && (y + 1) * width * sizeof(USHORT) <= cbDstPacked )
+            {
+                pDstPackedRow = pDstPacked + y * width * sizeof(USHORT);
+                if( pDstPackedRow == pSrcRow )
+                {
+                    pDstPackedRow = nullptr;
+                }
+            }
+
+            ProcessRow( pSrcRow, bPixels, y, pDstPixelRow, pDstPackedRow, stats );
+        }
+    } );
+
+    // merge the bands
+    ResetStats( m_frameStats );
+    for( size_t band = 0; band < m_bandStats.size(); ++band )
+    {
+        for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+        {
+            const PlayerStats& from = m_bandStats[band].players[i];
+            PlayerStats& to = m_frameStats.players[i];
+            if( 0 == from.cPixels )
+            {
+                continue;
+            }
+
+            to.cPixels += from.cPixels;
+            to.left = min( to.left, from.left );
+            to.right = max( to.right, from.right );
+            to.top = min( to.top, from.top );
+            to.bottom = max( to.bottom, from.bottom );
+            to.sumX += from.sumX;
+            to.sumY += from.sumY;
+            to.minDepth = min( to.minDepth, from.minDepth );
+            to.maxDepth = max( to.maxDepth, from.maxDepth );
+        }
+    }
+
+    m_bResultValid = true;
+}
+
+HRESULT PlayerSegmentation::GetResult( _Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks ) const
+{
+    if( !m_bEnabled || !m_bResultValid )
+    {
+        return E_NUI_FRAME_NO_DATA;
+    }
+
+    pSegmentation->dwWidth = m_width;
+    pSegmentation->dwHeight = m_height;
+    pSegmentation->cbMaskPitch = m_maskPitch;
+    pSegmentation->cbMaskSize = m_maskPitch * m_height;
+    pSegmentation->cPlayers = 0;
+
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        const PlayerStats& stats = m_frameStats.players[i];
+        KINECT_PLAYER_INFO& player = pSegmentation->players[i];
+
+        ZeroMemory( &player, sizeof(KINECT_PLAYER_INFO) );
+        if( 0 == stats.cPixels )
+        {
+            continue;
+        }
+
+        ++pSegmentation->cPlayers;
+        player.cPixels = stats.cPixels;
+        player.rcBounds.left = stats.left;
+        player.rcBounds.top = stats.top;
+        player.rcBounds.right = stats.right + 1;
+        player.rcBounds.bottom = stats.bottom + 1;
+        player.fCentroidX = static_cast<float>( static_cast<double>(stats.sumX) / stats.cPixels );
+        player.fCentroidY = static_cast<float>( static_cast<double>(stats.sumY) / stats.cPixels );
+
+        if( 0 != stats.maxDepth )
+        {
+            player.usMinDepth = stats.minDepth;
+            player.usMaxDepth = stats.maxDepth;
+        }
+    }
+
+    if( nullptr == pMasks )
+    {
+        return S_OK;
+    }
+
+    if( cbMasks < m_masks.size() )
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    memcpy_s( pMasks, cbMasks, m_masks.data(), m_masks.size() );
+
+    return S_OK;
+}
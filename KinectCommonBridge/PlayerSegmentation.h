@@ -0,0 +1,78 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// rows handled by a single task
+#define PLAYER_SEGMENTATION_BAND_ROWS   16
+
+// per player masks and statistics from the player index of the depth frame
+// the frame is copied to the caller buffers and segmented in the same pass, every band
+// of rows writes its own mask rows and statistics, which are merged once the bands are done
+class PlayerSegmentation
+{
+public:
+    PlayerSegmentation();
+
+    void SetEnabled( bool bEnabled );
+    bool IsEnabled() const { return m_bEnabled; }
+
+    // pSrc - frame in the orientation of the caller buffers, rows srcPitch bytes apart
+    // bPixels = false: packed USHORT (depth << 3 | player), true: NUI_DEPTH_IMAGE_PIXEL
+    // pDstPixels, pDstPacked - optional copies of the frame, rows that do not fit are skipped
+    // pSrc may be one of the destination buffers, rows are then only read
+    void Process( _In_ const BYTE* pSrc, UINT srcPitch, UINT width, UINT height, bool bPixels,
+        ULONG cDstPixels, _Out_opt_cap_(cDstPixels) NUI_DEPTH_IMAGE_PIXEL* pDstPixels,
+        ULONG cbDstPacked, _Out_opt_cap_(cbDstPacked) BYTE* pDstPacked );
+
+    // result of the last frame
+    HRESULT GetResult( _Inout_ KINECT_PLAYER_SEGMENTATION* pSegmentation, ULONG cbMasks, _Out_opt_cap_(cbMasks) BYTE* pMasks ) const;
+
+private:
+    struct PlayerStats
+    {
+        UINT cPixels;
+        UINT left, top, right, bottom;
+        ULONGLONG sumX, sumY;
+        USHORT minDepth, maxDepth;
+    };
+
+    struct BandStats
+    {
+        PlayerStats players[NUI_SKELETON_COUNT];
+    };
+
+    void ResetLayout( UINT width, UINT height );
+    void ProcessRow( _In_ const BYTE* pSrc, bool bPixels, UINT y, _Out_opt_ NUI_DEPTH_IMAGE_PIXEL* pDstPixels,
+        _Out_opt_ BYTE* pDstPacked, _Inout_ BandStats& stats );
+
+    static void ResetStats( _Out_ BandStats& stats );
+    static void AddPixel( _Inout_ PlayerStats& player, UINT x, UINT y, USHORT depth );
+
+private:
+    bool m_bEnabled;
+
+    UINT m_width;
+    UINT m_height;
+    UINT m_maskPitch;
+
+    // NUI_SKELETON_COUNT masks of m_maskPitch * m_height bytes
+    std::vector<BYTE> m_masks;
+    std::vector<BandStats> m_bandStats;
+
+    bool m_bResultValid;
+    BandStats m_frameStats;
+};
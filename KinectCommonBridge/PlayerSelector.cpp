@@ -0,0 +1,211 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "PlayerSelector.h"
+
+#include <float.h>
+
+// ranks a chosen sticky player ahead of every other
+#define PLAYER_STICKY_BONUS     1000.0f
+
+static inline bool IsInside( _In_ const KINECT_INTERACTION_ZONE& zone, _In_ const Vector4& position, float margin )
+{
+    return position.x >= zone.fMinX - margin && position.x <= zone.fMaxX + margin
+        && position.y >= zone.fMinY - margin && position.y <= zone.fMaxY + margin
+        && position.z >= zone.fMinZ - margin && position.z <= zone.fMaxZ + margin;
+}
+
+PlayerSelector::PlayerSelector()
+{
+    SetParameters( nullptr );
+    Reset();
+}
+
+void PlayerSelector::Reset()
+{
+    ZeroMemory( m_chosenIDs, sizeof(m_chosenIDs) );
+    ZeroMemory( m_inZoneIDs, sizeof(m_inZoneIDs) );
+    m_activity.Reset();
+}
+
+HRESULT PlayerSelector::SetParameters( _In_opt_ const KINECT_PLAYER_SELECTION* pSelection )
+{
+    if( nullptr == pSelection )
+    {
+        m_fHysteresis = PLAYER_DEFAULT_HYSTERESIS;
+        m_cZones = 0;
+        ZeroMemory( m_zones, sizeof(m_zones) );
+        return S_OK;
+    }
+
+    if( pSelection->dwStructSize != sizeof(KINECT_PLAYER_SELECTION) || pSelection->fHysteresis < 0.0f
+        || pSelection->cZones > PLAYER_MAX_ZONES || (0 != pSelection->cZones && nullptr == pSelection->pZones) )
+    {
+        return E_INVALIDARG;
+    }
+
+    m_fHysteresis = (0.0f == pSelection->fHysteresis) ? PLAYER_DEFAULT_HYSTERESIS : pSelection->fHysteresis;
+    m_cZones = pSelection->cZones;
+    ZeroMemory( m_zones, sizeof(m_zones) );
+    if( 0 != m_cZones )
+    {
+        CopyMemory( m_zones, pSelection->pZones, m_cZones * sizeof(KINECT_INTERACTION_ZONE) );
+    }
+
+    // players are in the new zones once they enter them
+    ZeroMemory( m_inZoneIDs, sizeof(m_inZoneIDs) );
+
+    return S_OK;
+}
+
+bool PlayerSelector::IsChosen( DWORD dwTrackingID ) const
+{
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        if( 0 != dwTrackingID && m_chosenIDs[i] == dwTrackingID )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool PlayerSelector::UpdateZone( DWORD dwTrackingID, _In_ const Vector4& position, _Inout_ DWORD* pInZoneIDs, _Inout_ UINT& cInZone ) const
+{
+    if( 0 == m_cZones )
+    {
+        return true;
+    }
+
+    bool bWasInside = false;
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        if( m_inZoneIDs[i] == dwTrackingID )
+        {
+            bWasInside = true;
+            break;
+        }
+    }
+
+    // inside to enter, within the hysteresis to stay
+    float margin = bWasInside ? m_fHysteresis : 0.0f;
+    for( ULONG z = 0; z < m_cZones; ++z )
+    {
+        if( IsInside(m_zones[z], position, margin) )
+        {
+            if( cInZone < NUI_SKELETON_COUNT )
+            {
+                pInZoneIDs[cInZone++] = dwTrackingID;
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PlayerSelector::Choose( KINECT_SKELETON_SELECTION_MODE mode, _In_ const NUI_SKELETON_FRAME& skeletonFrame,
+    _Out_writes_(cTrackIDs) DWORD* pTrackIDs, UINT cTrackIDs )
+{
+    if( SkeletonSelectionModeActive1 == mode || SkeletonSelectionModeActive2 == mode )
+    {
+        // add the frame to the activity of every skeleton, then take the highest activity levels
+        m_activity.Update( skeletonFrame );
+        m_activity.ChooseMostActive( pTrackIDs, cTrackIDs );
+
+        ZeroMemory( m_chosenIDs, sizeof(m_chosenIDs) );
+        CopyMemory( m_chosenIDs, pTrackIDs, min(cTrackIDs, static_cast<UINT>(NUI_SKELETON_COUNT)) * sizeof(DWORD) );
+        return;
+    }
+
+    DWORD trackingIDs[NUI_SKELETON_COUNT];
+    Vector4 positions[NUI_SKELETON_COUNT];
+    UINT cPlayers = 0;
+
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[i];
+        if( NUI_SKELETON_NOT_TRACKED != skeleton.eTrackingState )
+        {
+            trackingIDs[cPlayers] = skeleton.dwTrackingID;
+            positions[cPlayers] = skeleton.Position;
+            ++cPlayers;
+        }
+    }
+
+    Choose( mode, cPlayers, trackingIDs, positions, pTrackIDs, cTrackIDs );
+}
+
+void PlayerSelector::Choose( KINECT_SKELETON_SELECTION_MODE mode, UINT cPlayers, _In_count_(cPlayers) const DWORD* pTrackingIDs,
+    _In_count_(cPlayers) const Vector4* pPositions, _Out_writes_(cTrackIDs) DWORD* pTrackIDs, UINT cTrackIDs )
+{
+    cTrackIDs = min( cTrackIDs, static_cast<UINT>(NUI_SKELETON_COUNT) );
+    ZeroMemory( pTrackIDs, cTrackIDs * sizeof(DWORD) );
+
+    bool bSticky = (SkeletonSelectionModeSticky1 == mode || SkeletonSelectionModeSticky2 == mode);
+    bool bZone = (SkeletonSelectionModeZone1 == mode || SkeletonSelectionModeZone2 == mode);
+
+    DWORD inZoneIDs[NUI_SKELETON_COUNT] = { 0 };
+    UINT cInZone = 0;
+
+    float scores[NUI_SKELETON_COUNT];
+    for( UINT i = 0; i < cTrackIDs; ++i )
+    {
+        scores[i] = FLT_MAX;
+    }
+
+    for( UINT i = 0; i < cPlayers; ++i )
+    {
+        DWORD dwTrackingID = pTrackingIDs[i];
+
+        if( bZone && !UpdateZone(dwTrackingID, pPositions[i], inZoneIDs, cInZone) )
+        {
+            continue;
+        }
+
+        // the players chosen last time keep their place up to the hysteresis, or while seen when sticky
+        float score = pPositions[i].z;
+        if( IsChosen(dwTrackingID) )
+        {
+            score -= bSticky ? PLAYER_STICKY_BONUS : m_fHysteresis;
+        }
+
+        // insertion into the sorted choice
+        for( UINT c = 0; c < cTrackIDs; ++c )
+        {
+            if( score < scores[c] )
+            {
+                for( UINT k = cTrackIDs - 1; k > c; --k )
+                {
+                    scores[k] = scores[k - 1];
+                    pTrackIDs[k] = pTrackIDs[k - 1];
+                }
+                scores[c] = score;
+                pTrackIDs[c] = dwTrackingID;
+                break;
+            }
+        }
+    }
+
+    if( bZone )
+    {
+        CopyMemory( m_inZoneIDs, inZoneIDs, sizeof(m_inZoneIDs) );
+    }
+
+    ZeroMemory( m_chosenIDs, sizeof(m_chosenIDs) );
+    CopyMemory( m_chosenIDs, pTrackIDs, cTrackIDs * sizeof(DWORD) );
+}
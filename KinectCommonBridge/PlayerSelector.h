@@ -0,0 +1,69 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+#include "ActivityTracker.h"
+
+// interaction zones that can be set
+#define PLAYER_MAX_ZONES            8
+
+// used when the caller leaves the value at 0
+#define PLAYER_DEFAULT_HYSTERESIS   0.1f    // m
+
+// chooses the players of the skeleton chooser modes, for the skeleton stream, the face
+// tracker follows its choice
+// every policy ranks the players it can choose by their distance along the camera axis, the
+// skeleton Z, and takes the first ones, so a frame costs one pass over the players:
+//   closest - a chosen player is only replaced by one closer by more than the hysteresis
+//   sticky  - a chosen player is kept while it is seen, free places go to the closest
+//   active  - the most active players, see ActivityTracker
+//   zone    - closest of the players in an interaction zone; a player enters inside a zone and
+//             leaves once it is the hysteresis outside of every zone; without zones all players count
+class PlayerSelector
+{
+public:
+    PlayerSelector();
+
+    // forgets the chosen players
+    void Reset();
+
+    // pSelection - nullptr restores the defaults, no zones
+    HRESULT SetParameters( _In_opt_ const KINECT_PLAYER_SELECTION* pSelection );
+
+    // the players of the frame for the chooser mode, first choice first, 0 for none
+    void Choose( KINECT_SKELETON_SELECTION_MODE mode, _In_ const NUI_SKELETON_FRAME& skeletonFrame,
+        _Out_writes_(cTrackIDs) DWORD* pTrackIDs, UINT cTrackIDs );
+
+    // the same for players given as one point each, the active policy chooses the closest
+    void Choose( KINECT_SKELETON_SELECTION_MODE mode, UINT cPlayers, _In_count_(cPlayers) const DWORD* pTrackingIDs,
+        _In_count_(cPlayers) const Vector4* pPositions, _Out_writes_(cTrackIDs) DWORD* pTrackIDs, UINT cTrackIDs );
+
+private:
+    bool IsChosen( DWORD dwTrackingID ) const;
+
+    // updates the players inside the zones, true when the player is
+    bool UpdateZone( DWORD dwTrackingID, _In_ const Vector4& position, _Inout_ DWORD* pInZoneIDs, _Inout_ UINT& cInZone ) const;
+
+private:
+    float m_fHysteresis;
+    ULONG m_cZones;
+    KINECT_INTERACTION_ZONE m_zones[PLAYER_MAX_ZONES];
+
+    DWORD m_chosenIDs[NUI_SKELETON_COUNT];
+    DWORD m_inZoneIDs[NUI_SKELETON_COUNT];
+
+    ActivityTracker m_activity;
+};
@@ -0,0 +1,564 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "PointCloud.h"
+
+#include <ppl.h>
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <math.h>
+#include <limits>
+
+// millimeters to meters
+static const float DEPTH_TO_METERS = 0.001f;
+
+static inline UINT32 LookupColor( _In_opt_ const PointCloud::ColorSource* pColor, _In_ const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, size_t index )
+{
+    if( nullptr == pColor || 0 == pDepthPixels[index].depth )
+    {
+        return 0;
+    }
+
+    // negative coordinates wrap around, so one unsigned compare per axis is enough
+    const NUI_COLOR_IMAGE_POINT& point = pColor->pColorPoints[index];
+    if( static_cast<ULONG>(point.x) < pColor->width && static_cast<ULONG>(point.y) < pColor->height )
+    {
+        return pColor->pColorFrame[point.y * pColor->width + point.x];
+    }
+
+    return 0;
+}
+
+static inline void StorePoint( const KINECT_POINT_CLOUD& cloud, _In_opt_ const PointCloud::ColorSource* pColor,
+    _In_ const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, size_t pixel, size_t out, float x, float y, float z )
+{
+    switch( cloud.eLayout )
+    {
+    case PointCloudLayoutXYZRGB:
+        cloud.pColoredPoints[out].x = x;
+        cloud.pColoredPoints[out].y = y;
+        cloud.pColoredPoints[out].z = z;
+        cloud.pColoredPoints[out].color = LookupColor( pColor, pDepthPixels, pixel );
+        break;
+
+    case PointCloudLayoutPlanes:
+        cloud.pX[out] = x;
+        cloud.pY[out] = y;
+        cloud.pZ[out] = z;
+        break;
+
+    default:
+        cloud.pXYZ[out * 3] = x;
+        cloud.pXYZ[out * 3 + 1] = y;
+        cloud.pXYZ[out * 3 + 2] = z;
+        break;
+    }
+
+    if( nullptr != pColor && nullptr != cloud.pColors && PointCloudLayoutXYZRGB != cloud.eLayout )
+    {
+        cloud.pColors[out] = LookupColor( pColor, pDepthPixels, pixel );
+    }
+
+    if( cloud.bCompact && nullptr != cloud.pIndices )
+    {
+        cloud.pIndices[out] = static_cast<DWORD>(pixel);
+    }
+}
+
+// 4 points as 12 interleaved floats, nothing is written past them
+static inline void StoreInterleaved( _Out_writes_(12) float* pOut, __m128 x, __m128 y, __m128 z )
+{
+    __m128 w = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS( x, y, z, w );
+
+    // the 4th lane of every store is overwritten by the next point
+    _mm_storeu_ps( pOut, x );
+    _mm_storeu_ps( pOut + 3, y );
+    _mm_storeu_ps( pOut + 6, z );
+
+    // the last point must not write past the 12 floats
+    _mm_storel_pi( reinterpret_cast<__m64*>(pOut + 9), w );
+    _mm_store_ss( pOut + 11, _mm_movehl_ps( w, w ) );
+}
+
+static inline __m128 Select( __m128 mask, __m128 a, __m128 b )
+{
+    return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+// writes four points with valid depth to out .. out + 3
+static inline void StorePoints( const KINECT_POINT_CLOUD& cloud, _In_opt_ const PointCloud::ColorSource* pColor,
+    _In_ const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, size_t pixel, size_t out, __m128 x, __m128 y, __m128 z )
+{
+    switch( cloud.eLayout )
+    {
+    case PointCloudLayoutXYZRGB:
+        {
+            // the color takes the 4th lane, so every point is a single 16 byte store
+            __m128 c = _mm_castsi128_ps( _mm_setr_epi32(
+                LookupColor( pColor, pDepthPixels, pixel ), LookupColor( pColor, pDepthPixels, pixel + 1 ),
+                LookupColor( pColor, pDepthPixels, pixel + 2 ), LookupColor( pColor, pDepthPixels, pixel + 3 ) ) );
+            _MM_TRANSPOSE4_PS( x, y, z, c );
+
+            float* pOut = &cloud.pColoredPoints[out].x;
+            _mm_storeu_ps( pOut, x );
+            _mm_storeu_ps( pOut + 4, y );
+            _mm_storeu_ps( pOut + 8, z );
+            _mm_storeu_ps( pOut + 12, c );
+        }
+        break;
+
+    case PointCloudLayoutPlanes:
+        _mm_storeu_ps( cloud.pX + out, x );
+        _mm_storeu_ps( cloud.pY + out, y );
+        _mm_storeu_ps( cloud.pZ + out, z );
+        break;
+
+    default:
+        StoreInterleaved( cloud.pXYZ + out * 3, x, y, z );
+        break;
+    }
+
+    for( size_t lane = 0; lane < 4; ++lane )
+    {
+        if( nullptr != pColor && nullptr != cloud.pColors && PointCloudLayoutXYZRGB != cloud.eLayout )
+        {
+            cloud.pColors[out + lane] = LookupColor( pColor, pDepthPixels, pixel + lane );
+        }
+
+        if( cloud.bCompact && nullptr != cloud.pIndices )
+        {
+            cloud.pIndices[out + lane] = static_cast<DWORD>(pixel + lane);
+        }
+    }
+}
+
+PointCloud::PointCloud()
+{
+}
+
+void PointCloud::SetDepthTransform( const KINECT_IMAGE_TRANSFORM& transform )
+{
+    const KINECT_IMAGE_TRANSFORM& current = m_transform.GetParameters();
+    if( current.bMirror == transform.bMirror && current.eRotation == transform.eRotation )
+    {
+        return;
+    }
+
+    m_transform.SetParameters( transform );
+
+    // the rays are stored in the order of the transformed pixels
+    for( size_t i = 0; i < _countof(m_rayTables); ++i )
+    {
+        m_rayTables[i].x.clear();
+        m_rayTables[i].y.clear();
+    }
+}
+
+const PointCloud::RayTable* PointCloud::GetRayTable( NUI_IMAGE_RESOLUTION eResolution )
+{
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eResolution, width, height );
+    if( 0 == width || 0 == height )
+    {
+        return nullptr;
+    }
+
+    RayTable& rays = m_rayTables[eResolution];
+    if( rays.x.empty() )
+    {
+        rays.x.resize( width * height );
+        rays.y.resize( width * height );
+
+        // pixels are square, so one scale covers both axes
+        const float scale = (320.0f / width) * NUI_CAMERA_DEPTH_IMAGE_TO_SKELETON_MULTIPLIER_320x240;
+        const float centerX = width / 2.0f;
+        const float centerY = height / 2.0f;
+
+        UINT outWidth, outHeight;
+        m_transform.GetOutputSize( width, height, outWidth, outHeight );
+
+        for( UINT v = 0; v < outHeight; ++v )
+        {
+            for( UINT u = 0; u < outWidth; ++u )
+            {
+                LONG x, y;
+                m_transform.InverseTransformPoint( width, height, u, v, x, y );
+
+                rays.x[v * outWidth + u] = (x - centerX) * scale;
+                rays.y[v * outWidth + u] = -(y - centerY) * scale;
+            }
+        }
+    }
+
+    return &rays;
+}
+
+void PointCloud::ProjectBand( _In_ const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, _In_ const RayTable& rays, _In_opt_ const ColorSource* pColor,
+    size_t begin, size_t end, size_t outIndex, const KINECT_POINT_CLOUD& cloud ) const
+{
+    const float* pRayX = rays.x.data();
+    const float* pRayY = rays.y.data();
+
+    // invalid depths are 0 and project to the origin, so the dense cloud never branches on them
+    size_t i = begin;
+    for( ; i + 4 <= end; i += 4 )
+    {
+        __m128i packed = _mm_loadu_si128( reinterpret_cast<const __m128i*>(pDepthPixels + i) );
+
+        // the depth is the high USHORT of every pixel
+        __m128 z = _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( packed, 16 ) ), _mm_set1_ps( DEPTH_TO_METERS ) );
+        __m128 x = _mm_mul_ps( z, _mm_loadu_ps( pRayX + i ) );
+        __m128 y = _mm_mul_ps( z, _mm_loadu_ps( pRayY + i ) );
+
+        int mask = cloud.bCompact ? _mm_movemask_ps( _mm_cmpneq_ps( z, _mm_setzero_ps() ) ) : 0xf;
+        if( 0xf == mask )
+        {
+            StorePoints( cloud, pColor, pDepthPixels, i, outIndex, x, y, z );
+            outIndex += 4;
+        }
+        else if( 0 != mask )
+        {
+            float xs[4], ys[4], zs[4];
+            _mm_storeu_ps( xs, x );
+            _mm_storeu_ps( ys, y );
+            _mm_storeu_ps( zs, z );
+
+            for( size_t lane = 0; lane < 4; ++lane )
+            {
+                if( mask & (1 << lane) )
+                {
+                    StorePoint( cloud, pColor, pDepthPixels, i + lane, outIndex++, xs[lane], ys[lane], zs[lane] );
+                }
+            }
+        }
+    }
+
+    for( ; i < end; ++i )
+    {
+        if( !cloud.bCompact || 0 != pDepthPixels[i].depth )
+        {
+            float z = pDepthPixels[i].depth * DEPTH_TO_METERS;
+            StorePoint( cloud, pColor, pDepthPixels, i, outIndex++, pRayX[i] * z, pRayY[i] * z, z );
+        }
+    }
+}
+
+HRESULT PointCloud::Generate( NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    _In_opt_ const ColorSource* pColor, _Inout_ KINECT_POINT_CLOUD* pPointCloud )
+{
+    if( nullptr == pDepthPixels || nullptr == pPointCloud )
+    {
+        return E_INVALIDARG;
+    }
+
+    KINECT_POINT_CLOUD& cloud = *pPointCloud;
+    cloud.cValidPoints = 0;
+
+    bool bBuffers = false;
+    switch( cloud.eLayout )
+    {
+    case PointCloudLayoutXYZ:
+        bBuffers = (nullptr != cloud.pXYZ);
+        break;
+    case PointCloudLayoutPlanes:
+        bBuffers = (nullptr != cloud.pX && nullptr != cloud.pY && nullptr != cloud.pZ);
+        break;
+    case PointCloudLayoutXYZRGB:
+        bBuffers = (nullptr != cloud.pColoredPoints);
+        break;
+    }
+
+    const RayTable* pRays = GetRayTable( eDepthResolution );
+    if( !bBuffers || nullptr == pRays || cDepthPixels != pRays->x.size() )
+    {
+        return E_INVALIDARG;
+    }
+
+    const size_t cBands = (cDepthPixels + POINT_CLOUD_BAND_PIXELS - 1) / POINT_CLOUD_BAND_PIXELS;
+
+    // every band starts at its first pixel, unless the cloud is compacted
+    m_bandCounts.resize( cBands + 1 );
+    for( size_t band = 0; band <= cBands; ++band )
+    {
+        m_bandCounts[band] = min( band * POINT_CLOUD_BAND_PIXELS, static_cast<size_t>(cDepthPixels) );
+    }
+
+    if( cloud.bCompact )
+    {
+        // the first pass counts the valid depths of every band, so each band knows where its points go
+        Concurrency::parallel_for( size_t(0), cBands, [&]( size_t band )
+        {
+            size_t begin = band * POINT_CLOUD_BAND_PIXELS;
+            size_t end = min( begin + POINT_CLOUD_BAND_PIXELS, static_cast<size_t>(cDepthPixels) );
+
+            size_t count = 0;
+            for( size_t i = begin; i < end; ++i )
+            {
+                count += (0 != pDepthPixels[i].depth);
+            }
+            m_bandCounts[band + 1] = count;
+        });
+
+        m_bandCounts[0] = 0;
+        for( size_t band = 0; band < cBands; ++band )
+        {
+            m_bandCounts[band + 1] += m_bandCounts[band];
+        }
+    }
+
+    cloud.cValidPoints = static_cast<DWORD>(m_bandCounts[cBands]);
+    if( cloud.cPoints < cloud.cValidPoints )
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    Concurrency::parallel_for( size_t(0), cBands, [&]( size_t band )
+    {
+        size_t begin = band * POINT_CLOUD_BAND_PIXELS;
+        ProjectBand( pDepthPixels, *pRays, pColor, begin, min( begin + POINT_CLOUD_BAND_PIXELS, static_cast<size_t>(cDepthPixels) ),
+            m_bandCounts[band], cloud );
+    });
+
+    return S_OK;
+}
+
+void PointCloud::NormalAt( UINT width, UINT height, UINT x, UINT y, float maxStep, _Out_writes_(3) float* pNormal, _Out_ bool& bValid ) const
+{
+    const float* planes[3] = { m_pointsX.data(), m_pointsY.data(), m_pointsZ.data() };
+    const UINT center = y * width + x;
+    const float z = m_pointsZ[center];
+
+    // the neighbor itself, or the center when it has no depth or is on another surface
+    auto neighbor = [&]( bool bInside, UINT index ) -> UINT
+    {
+        if( !bInside || 0.0f == m_pointsZ[index] || fabs( m_pointsZ[index] - z ) > maxStep * z )
+        {
+            return center;
+        }
+        return index;
+    };
+
+    UINT left = neighbor( x > 0, center - 1 );
+    UINT right = neighbor( x + 1 < width, center + 1 );
+    UINT up = neighbor( y > 0, center - width );
+    UINT down = neighbor( y + 1 < height, center + width );
+
+    float dx[3], dy[3];
+    for( UINT i = 0; i < 3; ++i )
+    {
+        dx[i] = planes[i][right] - planes[i][left];
+        dy[i] = planes[i][down] - planes[i][up];
+    }
+
+    float n[3] = { dx[1] * dy[2] - dx[2] * dy[1], dx[2] * dy[0] - dx[0] * dy[2], dx[0] * dy[1] - dx[1] * dy[0] };
+    float length2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+
+    bValid = (0.0f != z && length2 > 0.0f);
+    if( !bValid )
+    {
+        pNormal[0] = pNormal[1] = pNormal[2] = std::numeric_limits<float>::quiet_NaN();
+        return;
+    }
+
+    // facing the sensor, whatever the handedness of the transformed pixels
+    float dot = n[0] * m_pointsX[center] + n[1] * m_pointsY[center] + n[2] * z;
+    float scale = ((dot > 0.0f) ? -1.0f : 1.0f) / sqrt( length2 );
+    for( UINT i = 0; i < 3; ++i )
+    {
+        pNormal[i] = n[i] * scale;
+    }
+}
+
+UINT PointCloud::NormalsRow( UINT width, UINT height, UINT y, float maxStep, const KINECT_DEPTH_NORMALS& normals ) const
+{
+    UINT cValid = 0;
+    const UINT row = y * width;
+
+    auto scalar = [&]( UINT x )
+    {
+        bool bValid = false;
+        NormalAt( width, height, x, y, maxStep, normals.pNormals + (row + x) * 3, bValid );
+        cValid += bValid;
+        if( nullptr != normals.pValid )
+        {
+            normals.pValid[row + x] = bValid ? 0xff : 0;
+        }
+    };
+
+    // the first and last row and column have missing neighbors
+    if( 0 == y || y + 1 >= height )
+    {
+        for( UINT x = 0; x < width; ++x )
+        {
+            scalar( x );
+        }
+        return cValid;
+    }
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) );
+    const __m128 signMask = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+    const __m128 nan = _mm_castsi128_ps( _mm_set1_epi32( 0x7fc00000 ) );
+    const __m128 vMaxStep = _mm_set1_ps( maxStep );
+
+    const float* pX = m_pointsX.data();
+    const float* pY = m_pointsY.data();
+    const float* pZ = m_pointsZ.data();
+
+    scalar( 0 );
+
+    UINT x = 1;
+    for( ; x + 4 < width; x += 4 )
+    {
+        const UINT i = row + x;
+
+        __m128 cx = _mm_loadu_ps( pX + i );
+        __m128 cy = _mm_loadu_ps( pY + i );
+        __m128 cz = _mm_loadu_ps( pZ + i );
+        __m128 limit = _mm_mul_ps( cz, vMaxStep );
+
+        // the neighbor at offset, or the center when it has no depth or is on another surface
+        auto neighbor = [&]( int offset, __m128& nx, __m128& ny, __m128& nz )
+        {
+            nz = _mm_loadu_ps( pZ + i + offset );
+            __m128 valid = _mm_and_ps( _mm_cmpneq_ps( nz, zero ),
+                _mm_cmple_ps( _mm_and_ps( _mm_sub_ps( nz, cz ), absMask ), limit ) );
+
+            nx = Select( valid, _mm_loadu_ps( pX + i + offset ), cx );
+            ny = Select( valid, _mm_loadu_ps( pY + i + offset ), cy );
+            nz = Select( valid, nz, cz );
+        };
+
+        __m128 lx, ly, lz, rx, ry, rz, ux, uy, uz, dx, dy, dz;
+        neighbor( -1, lx, ly, lz );
+        neighbor( 1, rx, ry, rz );
+        neighbor( -static_cast<int>(width), ux, uy, uz );
+        neighbor( width, dx, dy, dz );
+
+        // tangents along the row and the column
+        __m128 hx = _mm_sub_ps( rx, lx ), hy = _mm_sub_ps( ry, ly ), hz = _mm_sub_ps( rz, lz );
+        __m128 vx = _mm_sub_ps( dx, ux ), vy = _mm_sub_ps( dy, uy ), vz = _mm_sub_ps( dz, uz );
+
+        __m128 nx = _mm_sub_ps( _mm_mul_ps( hy, vz ), _mm_mul_ps( hz, vy ) );
+        __m128 ny = _mm_sub_ps( _mm_mul_ps( hz, vx ), _mm_mul_ps( hx, vz ) );
+        __m128 nz = _mm_sub_ps( _mm_mul_ps( hx, vy ), _mm_mul_ps( hy, vx ) );
+        __m128 length2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, nx ), _mm_mul_ps( ny, ny ) ), _mm_mul_ps( nz, nz ) );
+
+        __m128 valid = _mm_and_ps( _mm_cmpneq_ps( cz, zero ), _mm_cmpgt_ps( length2, zero ) );
+
+        // flip the normals facing away from the sensor, invalid lanes divide by 0 and are replaced
+        __m128 dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, cx ), _mm_mul_ps( ny, cy ) ), _mm_mul_ps( nz, cz ) );
+        __m128 scale = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( length2 ) );
+        scale = _mm_xor_ps( scale, _mm_and_ps( _mm_cmpgt_ps( dot, zero ), signMask ) );
+
+        nx = Select( valid, _mm_mul_ps( nx, scale ), nan );
+        ny = Select( valid, _mm_mul_ps( ny, scale ), nan );
+        nz = Select( valid, _mm_mul_ps( nz, scale ), nan );
+        StoreInterleaved( normals.pNormals + i * 3, nx, ny, nz );
+
+        int mask = _mm_movemask_ps( valid );
+        cValid += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        if( nullptr != normals.pValid )
+        {
+            for( UINT lane = 0; lane < 4; ++lane )
+            {
+                normals.pValid[i + lane] = (mask & (1 << lane)) ? 0xff : 0;
+            }
+        }
+    }
+
+    for( ; x < width; ++x )
+    {
+        scalar( x );
+    }
+
+    return cValid;
+}
+
+HRESULT PointCloud::GenerateNormals( NUI_IMAGE_RESOLUTION eDepthResolution,
+    DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+    _Inout_ KINECT_DEPTH_NORMALS* pNormals )
+{
+    if( nullptr == pDepthPixels || nullptr == pNormals || nullptr == pNormals->pNormals )
+    {
+        return E_INVALIDARG;
+    }
+
+    KINECT_DEPTH_NORMALS& normals = *pNormals;
+    normals.cValidNormals = 0;
+
+    const RayTable* pRays = GetRayTable( eDepthResolution );
+    if( nullptr == pRays || cDepthPixels != pRays->x.size() )
+    {
+        return E_INVALIDARG;
+    }
+
+    if( normals.cNormals < cDepthPixels )
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    // rows of the pixels as they were passed in
+    DWORD nativeWidth = 0, nativeHeight = 0;
+    NuiImageResolutionToSize( eDepthResolution, nativeWidth, nativeHeight );
+
+    UINT width = 0, height = 0;
+    m_transform.GetOutputSize( nativeWidth, nativeHeight, width, height );
+
+    const float maxStep = (normals.fMaxDepthStep > 0.0f) ? normals.fMaxDepthStep : DEPTH_NORMALS_DEFAULT_MAX_STEP;
+
+    m_pointsX.resize( cDepthPixels );
+    m_pointsY.resize( cDepthPixels );
+    m_pointsZ.resize( cDepthPixels );
+
+    const UINT cBands = (height + DEPTH_NORMALS_BAND_ROWS - 1) / DEPTH_NORMALS_BAND_ROWS;
+    m_bandNormals.resize( cBands );
+
+    // the points of every row are needed by the rows next to it, so they are all computed first
+    KINECT_POINT_CLOUD planes;
+    ZeroMemory( &planes, sizeof(KINECT_POINT_CLOUD) );
+    planes.eLayout = PointCloudLayoutPlanes;
+    planes.pX = m_pointsX.data();
+    planes.pY = m_pointsY.data();
+    planes.pZ = m_pointsZ.data();
+
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        size_t begin = band * DEPTH_NORMALS_BAND_ROWS * width;
+        size_t end = min( static_cast<size_t>(band + 1) * DEPTH_NORMALS_BAND_ROWS * width, static_cast<size_t>(cDepthPixels) );
+        ProjectBand( pDepthPixels, *pRays, nullptr, begin, end, begin, planes );
+    } );
+
+    Concurrency::parallel_for( 0u, cBands, [&]( UINT band )
+    {
+        UINT cValid = 0;
+        UINT yEnd = min( height, (band + 1) * DEPTH_NORMALS_BAND_ROWS );
+        for( UINT y = band * DEPTH_NORMALS_BAND_ROWS; y < yEnd; ++y )
+        {
+            cValid += NormalsRow( width, height, y, maxStep, normals );
+        }
+        m_bandNormals[band] = cValid;
+    } );
+
+    for( UINT band = 0; band < cBands; ++band )
+    {
+        normals.cValidNormals += m_bandNormals[band];
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,95 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+#include "ImageTransform.h"
+
+// depth pixels handled by a single task
+#define POINT_CLOUD_BAND_PIXELS     (16 * 1024)
+
+// rows of normals handled by a single task
+#define DEPTH_NORMALS_BAND_ROWS     16
+
+// used when the caller leaves fMaxDepthStep at 0
+#define DEPTH_NORMALS_DEFAULT_MAX_STEP  0.05f
+
+// depth frame to camera space points
+// every depth pixel has a ray with z = 1 that only depends on the pixel position, so the rays
+// are computed once per resolution and a point is the ray scaled by the depth in meters
+// the rays use the nominal depth intrinsics, the same model as NuiTransformDepthImageToSkeleton
+class PointCloud
+{
+public:
+    // colors gathered for the points, pColorPoints are the depth pixels mapped to the color frame
+    struct ColorSource
+    {
+        const NUI_COLOR_IMAGE_POINT* pColorPoints;
+        const UINT32* pColorFrame;
+        UINT width;
+        UINT height;
+    };
+
+public:
+    PointCloud();
+
+    // orientation of the depth pixels passed in, the rays are rebuilt when it changes
+    void SetDepthTransform( const KINECT_IMAGE_TRANSFORM& transform );
+
+    // pDepthPixels - a full frame at eDepthResolution, as returned by GetDepthImagePixels
+    // pColor - optional, one color point per depth pixel
+    HRESULT Generate( NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        _In_opt_ const ColorSource* pColor, _Inout_ KINECT_POINT_CLOUD* pPointCloud );
+
+    // surface normal of every depth pixel from the cross product of the tangents to its neighbors
+    // a neighbor without depth or on another surface is replaced by the pixel itself, so edges
+    // use one sided differences and a pixel without a neighbor on either axis has no normal
+    HRESULT GenerateNormals( NUI_IMAGE_RESOLUTION eDepthResolution,
+        DWORD cDepthPixels, _In_count_(cDepthPixels) const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels,
+        _Inout_ KINECT_DEPTH_NORMALS* pNormals );
+
+private:
+    struct RayTable
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+    };
+
+    const RayTable* GetRayTable( NUI_IMAGE_RESOLUTION eResolution );
+
+    // outIndex - first output point of the band, the pixel index unless the cloud is compacted
+    void ProjectBand( _In_ const NUI_DEPTH_IMAGE_PIXEL* pDepthPixels, _In_ const RayTable& rays, _In_opt_ const ColorSource* pColor,
+        size_t begin, size_t end, size_t outIndex, const KINECT_POINT_CLOUD& cloud ) const;
+
+    // one row of normals from the point planes, returns the valid normals
+    UINT NormalsRow( UINT width, UINT height, UINT y, float maxStep, const KINECT_DEPTH_NORMALS& normals ) const;
+    void NormalAt( UINT width, UINT height, UINT x, UINT y, float maxStep, _Out_writes_(3) float* pNormal, _Out_ bool& bValid ) const;
+
+private:
+    ImageTransform m_transform;
+
+    // one table per NUI_IMAGE_RESOLUTION, built on first use
+    RayTable m_rayTables[NUI_IMAGE_RESOLUTION_1280x960 + 1];
+
+    // valid points per band for the compacted output
+    std::vector<size_t> m_bandCounts;
+
+    // camera space points of the frame the normals are computed from
+    std::vector<float> m_pointsX;
+    std::vector<float> m_pointsY;
+    std::vector<float> m_pointsZ;
+    std::vector<UINT> m_bandNormals;
+};
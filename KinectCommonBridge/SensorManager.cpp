@@ -371,6 +371,12 @@ void SensorManager::CloseSensorHandle( KCBHANDLE& kcbHandle )
     // remove the handle from the list
     m_handleMap.erase(iter);
 
+    // and its skeletons from the fusion
+    {
+        AutoLock fusionLock( m_csFusionLock );
+        m_skeletonFusion.RemoveSensor( kcbHandle );
+    }
+
     kcbHandle = KCB_INVALID_HANDLE;
 }
 
@@ -409,3 +415,31 @@ bool SensorManager::GetPortIDByIndex( UINT index, ULONG cchPortID, _Out_cap_(cch
 
     return true;
 }
+
+HRESULT SensorManager::SetSensorPose( KCBHANDLE kcbHandle, _In_opt_ const KINECT_SENSOR_POSE* pPose )
+{
+    AutoLock fusionLock( m_csFusionLock );
+
+    return m_skeletonFusion.SetSensorPose( kcbHandle, pPose );
+}
+
+// called with every skeleton frame read, the arrival time is the clock all sensors share
+void SensorManager::FuseSkeletonFrame( KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME& skeletonFrame )
+{
+    AutoLock fusionLock( m_csFusionLock );
+
+    m_skeletonFusion.AddFrame( kcbHandle, skeletonFrame, GetTickCount64() );
+}
+
+HRESULT SensorManager::GetFusedSkeletons( ULONG cMaxSkeletons, _Out_cap_(cMaxSkeletons) KINECT_FUSED_SKELETON* pSkeletons,
+    _Out_ ULONG* pcSkeletons, _Out_opt_ LONGLONG* liTimeStamp )
+{
+    if( nullptr == pcSkeletons || (nullptr == pSkeletons && 0 != cMaxSkeletons) )
+    {
+        return E_INVALIDARG;
+    }
+
+    AutoLock fusionLock( m_csFusionLock );
+
+    return m_skeletonFusion.GetSkeletons( GetTickCount64(), cMaxSkeletons, pSkeletons, pcSkeletons, liTimeStamp );
+}
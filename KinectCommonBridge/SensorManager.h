@@ -15,6 +15,7 @@ See the Apache 2 License for the specific language governing permissions and lim
 #pragma once
 
 #include "KinectSensor.h"
+#include "SkeletonFusion.h"
 
 class SensorManager
 {
@@ -37,6 +38,12 @@ public:
     UINT GetSensorCount();
     bool GetPortIDByIndex( UINT index, ULONG cchPortID, _Out_cap_(cchPortID) WCHAR* pwcPortID );
 
+    // skeleton fusion across the sensors with a pose
+    HRESULT SetSensorPose( KCBHANDLE kcbHandle, _In_opt_ const KINECT_SENSOR_POSE* pPose );
+    void FuseSkeletonFrame( KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME& skeletonFrame );
+    HRESULT GetFusedSkeletons( ULONG cMaxSkeletons, _Out_cap_(cMaxSkeletons) KINECT_FUSED_SKELETON* pSkeletons,
+        _Out_ ULONG* pcSkeletons, _Out_opt_ LONGLONG* liTimeStamp );
+
 private:
     SensorManager();
     void Initialize();
@@ -72,4 +79,8 @@ private:
     std::map<int, std::wstring> m_handleMap;
 
     std::map<std::wstring, std::shared_ptr<KinectSensor> > m_kinectSensors;
+
+    // never held while taking the other locks
+    CriticalSection    m_csFusionLock;
+    SkeletonFusion     m_skeletonFusion;
 };
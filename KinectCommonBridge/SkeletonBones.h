@@ -0,0 +1,46 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// bones of the NUI skeleton, one ends in every joint but the hip center
+#define SKELETON_BONE_COUNT     (NUI_SKELETON_POSITION_COUNT - 1)
+
+// parent of every joint, the hip center is the root and its own parent
+// parents come before their children, a pass in joint order sees the parents first
+static const NUI_SKELETON_POSITION_INDEX SKELETON_PARENT_JOINTS[NUI_SKELETON_POSITION_COUNT] =
+{
+    NUI_SKELETON_POSITION_HIP_CENTER,       // hip center
+    NUI_SKELETON_POSITION_HIP_CENTER,       // spine
+    NUI_SKELETON_POSITION_SPINE,            // shoulder center
+    NUI_SKELETON_POSITION_SHOULDER_CENTER,  // head
+    NUI_SKELETON_POSITION_SHOULDER_CENTER,  // shoulder left
+    NUI_SKELETON_POSITION_SHOULDER_LEFT,    // elbow left
+    NUI_SKELETON_POSITION_ELBOW_LEFT,       // wrist left
+    NUI_SKELETON_POSITION_WRIST_LEFT,       // hand left
+    NUI_SKELETON_POSITION_SHOULDER_CENTER,  // shoulder right
+    NUI_SKELETON_POSITION_SHOULDER_RIGHT,   // elbow right
+    NUI_SKELETON_POSITION_ELBOW_RIGHT,      // wrist right
+    NUI_SKELETON_POSITION_WRIST_RIGHT,      // hand right
+    NUI_SKELETON_POSITION_HIP_CENTER,       // hip left
+    NUI_SKELETON_POSITION_HIP_LEFT,         // knee left
+    NUI_SKELETON_POSITION_KNEE_LEFT,        // ankle left
+    NUI_SKELETON_POSITION_ANKLE_LEFT,       // foot left
+    NUI_SKELETON_POSITION_HIP_CENTER,       // hip right
+    NUI_SKELETON_POSITION_HIP_RIGHT,        // knee right
+    NUI_SKELETON_POSITION_KNEE_RIGHT,       // ankle right
+    NUI_SKELETON_POSITION_ANKLE_RIGHT,      // foot right
+};
@@ -0,0 +1,508 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "SkeletonCodec.h"
+
+#include <math.h>
+
+// 'KCBS'
+static const UINT32 SKELETON_CODEC_MAGIC = 0x5342434b;
+
+static const BYTE SKELETON_CODEC_KEYFRAME = 0x01;
+static const BYTE SKELETON_CODEC_FLOOR = 0x02;
+
+// skeleton byte: slot in the low 3 bits, then the tracking state, then the delta bit
+static const BYTE SKELETON_CODEC_SLOT_MASK = 0x07;
+static const UINT SKELETON_CODEC_STATE_SHIFT = 3;
+static const BYTE SKELETON_CODEC_DELTA = 0x20;
+
+// bytes of the 2 bit joint states
+static const UINT SKELETON_CODEC_STATE_BYTES = (NUI_SKELETON_POSITION_COUNT * 2 + 7) / 8;
+
+// worst case: varints of 10 bytes for 64 bits, 5 for 32 bits and 3 for a 16 bit delta
+static const size_t SKELETON_CODEC_FRAME_BOUND = 5 + 5 + 10 + 5;
+static const size_t SKELETON_CODEC_FLOOR_BOUND = 2 * sizeof(Vector4);
+static const size_t SKELETON_CODEC_SKELETON_BOUND = 1 + 4 * 5 + 3 * 3 + SKELETON_CODEC_STATE_BYTES + NUI_SKELETON_POSITION_COUNT * 3 * 3;
+
+struct SkeletonCodecHeader
+{
+    UINT32 magic;
+    BYTE flags;
+    BYTE cSkeletons;
+    UINT16 reserved;
+};
+
+// positions of a skeleton as the decoder sees them
+struct QuantizedSkeleton
+{
+    INT16 position[3];
+    INT16 joints[NUI_SKELETON_POSITION_COUNT][3];
+};
+
+static inline INT16 Quantize( float value )
+{
+    float scaled = floorf( value * SKELETON_CODEC_SCALE + 0.5f );
+    if( !(scaled > -32768.0f) )     // NaN as well
+    {
+        return (scaled == scaled) ? -32768 : 0;
+    }
+    return static_cast<INT16>( min(scaled, 32767.0f) );
+}
+
+static inline float Dequantize( INT32 value )
+{
+    // exact, the scale is a power of 2
+    return static_cast<float>(value) * (1.0f / SKELETON_CODEC_SCALE);
+}
+
+static void QuantizeSkeleton( _In_ const NUI_SKELETON_DATA& skeleton, _Out_ QuantizedSkeleton& quantized )
+{
+    ZeroMemory( &quantized, sizeof(quantized) );
+
+    quantized.position[0] = Quantize( skeleton.Position.x );
+    quantized.position[1] = Quantize( skeleton.Position.y );
+    quantized.position[2] = Quantize( skeleton.Position.z );
+
+    if( NUI_SKELETON_TRACKED != skeleton.eTrackingState )
+    {
+        return;
+    }
+
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        if( NUI_SKELETON_POSITION_NOT_TRACKED != skeleton.eSkeletonPositionTrackingState[j] )
+        {
+            quantized.joints[j][0] = Quantize( skeleton.SkeletonPositions[j].x );
+            quantized.joints[j][1] = Quantize( skeleton.SkeletonPositions[j].y );
+            quantized.joints[j][2] = Quantize( skeleton.SkeletonPositions[j].z );
+        }
+    }
+}
+
+// the skeleton of the frame with the tracking id, nullptr when there is none
+static const NUI_SKELETON_DATA* FindSkeleton( _In_ const NUI_SKELETON_FRAME& skeletonFrame, DWORD dwTrackingID )
+{
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        if( NUI_SKELETON_NOT_TRACKED != skeleton.eTrackingState && skeleton.dwTrackingID == dwTrackingID )
+        {
+            return &skeleton;
+        }
+    }
+
+    return nullptr;
+}
+
+static inline UINT32 ZigZag( INT32 value )
+{
+    return (static_cast<UINT32>(value) << 1) ^ static_cast<UINT32>(value >> 31);
+}
+
+static inline INT32 UnZigZag( UINT32 value )
+{
+    return static_cast<INT32>(value >> 1) ^ -static_cast<INT32>(value & 1);
+}
+
+static inline ULONGLONG ZigZag64( LONGLONG value )
+{
+    return (static_cast<ULONGLONG>(value) << 1) ^ static_cast<ULONGLONG>(value >> 63);
+}
+
+static inline LONGLONG UnZigZag64( ULONGLONG value )
+{
+    return static_cast<LONGLONG>(value >> 1) ^ -static_cast<LONGLONG>(value & 1);
+}
+
+//
+// byte streams of the codec, the writer has room for the bound
+//
+class VarintWriter
+{
+public:
+    VarintWriter( _Out_ BYTE* pOut ) : m_pOut(pOut) {}
+
+    void Write( ULONGLONG value )
+    {
+        while( value >= 0x80 )
+        {
+            *m_pOut++ = static_cast<BYTE>(value) | 0x80;
+            value >>= 7;
+        }
+        *m_pOut++ = static_cast<BYTE>(value);
+    }
+
+    void WriteByte( BYTE value )
+    {
+        *m_pOut++ = value;
+    }
+
+    void WriteBytes( _In_ const void* pData, size_t cbData )
+    {
+        memcpy( m_pOut, pData, cbData );
+        m_pOut += cbData;
+    }
+
+    BYTE* Position() const { return m_pOut; }
+
+private:
+    BYTE* m_pOut;
+};
+
+class VarintReader
+{
+public:
+    VarintReader( _In_ const BYTE* pIn, _In_ const BYTE* pEnd ) : m_pIn(pIn), m_pEnd(pEnd) {}
+
+    bool Read( _Out_ ULONGLONG& value )
+    {
+        value = 0;
+        for( UINT shift = 0; shift < 64; shift += 7 )
+        {
+            if( m_pIn == m_pEnd )
+            {
+                return false;
+            }
+
+            BYTE b = *m_pIn++;
+            value |= static_cast<ULONGLONG>(b & 0x7f) << shift;
+            if( 0 == (b & 0x80) )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool Read( _Out_ DWORD& value )
+    {
+        ULONGLONG wide;
+        if( !Read(wide) || wide > 0xffffffff )
+        {
+            return false;
+        }
+        value = static_cast<DWORD>(wide);
+        return true;
+    }
+
+    bool ReadByte( _Out_ BYTE& value )
+    {
+        return ReadBytes( &value, 1 );
+    }
+
+    bool ReadBytes( _Out_ void* pData, size_t cbData )
+    {
+        if( static_cast<size_t>(m_pEnd - m_pIn) < cbData )
+        {
+            return false;
+        }
+        memcpy( pData, m_pIn, cbData );
+        m_pIn += cbData;
+        return true;
+    }
+
+private:
+    const BYTE* m_pIn;
+    const BYTE* m_pEnd;
+};
+
+ULONG SkeletonCodec::GetEncodedBound()
+{
+    return static_cast<ULONG>( sizeof(SkeletonCodecHeader) + SKELETON_CODEC_FRAME_BOUND + SKELETON_CODEC_FLOOR_BOUND
+        + NUI_SKELETON_COUNT * SKELETON_CODEC_SKELETON_BOUND );
+}
+
+HRESULT SkeletonCodec::Encode( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _In_opt_ const NUI_SKELETON_FRAME* pReference,
+    ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG& cbWritten )
+{
+    cbWritten = 0;
+
+    if( nullptr == pEncoded )
+    {
+        return E_INVALIDARG;
+    }
+
+    if( cbEncoded < GetEncodedBound() )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER );
+    }
+
+    SkeletonCodecHeader header = { SKELETON_CODEC_MAGIC, 0, 0, 0 };
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        if( NUI_SKELETON_NOT_TRACKED != skeletonFrame.SkeletonData[s].eTrackingState )
+        {
+            ++header.cSkeletons;
+        }
+    }
+
+    if( nullptr == pReference )
+    {
+        header.flags |= SKELETON_CODEC_KEYFRAME;
+    }
+
+    if( nullptr == pReference
+        || 0 != memcmp(&skeletonFrame.vFloorClipPlane, &pReference->vFloorClipPlane, sizeof(Vector4))
+        || 0 != memcmp(&skeletonFrame.vNormalToGravity, &pReference->vNormalToGravity, sizeof(Vector4)) )
+    {
+        header.flags |= SKELETON_CODEC_FLOOR;
+    }
+
+    VarintWriter writer( pEncoded );
+    writer.WriteBytes( &header, sizeof(header) );
+
+    // a delta frame names its reference, the time and frame number are changes from it
+    if( nullptr == pReference )
+    {
+        writer.Write( ZigZag64(skeletonFrame.liTimeStamp.QuadPart) );
+        writer.Write( skeletonFrame.dwFrameNumber );
+    }
+    else
+    {
+        writer.Write( pReference->dwFrameNumber );
+        writer.Write( ZigZag64(skeletonFrame.liTimeStamp.QuadPart - pReference->liTimeStamp.QuadPart) );
+        writer.Write( static_cast<DWORD>(skeletonFrame.dwFrameNumber - pReference->dwFrameNumber) );
+    }
+    writer.Write( skeletonFrame.dwFlags );
+
+    if( 0 != (header.flags & SKELETON_CODEC_FLOOR) )
+    {
+        writer.WriteBytes( &skeletonFrame.vFloorClipPlane, sizeof(Vector4) );
+        writer.WriteBytes( &skeletonFrame.vNormalToGravity, sizeof(Vector4) );
+    }
+
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        if( NUI_SKELETON_NOT_TRACKED == skeleton.eTrackingState )
+        {
+            continue;
+        }
+
+        QuantizedSkeleton quantized, reference;
+        QuantizeSkeleton( skeleton, quantized );
+
+        const NUI_SKELETON_DATA* pReferenceSkeleton = (nullptr != pReference) ? FindSkeleton( *pReference, skeleton.dwTrackingID ) : nullptr;
+        if( nullptr != pReferenceSkeleton )
+        {
+            QuantizeSkeleton( *pReferenceSkeleton, reference );
+        }
+        else
+        {
+            ZeroMemory( &reference, sizeof(reference) );
+        }
+
+        writer.WriteByte( static_cast<BYTE>(s | (skeleton.eTrackingState << SKELETON_CODEC_STATE_SHIFT) | (nullptr != pReferenceSkeleton ? SKELETON_CODEC_DELTA : 0)) );
+        writer.Write( skeleton.dwTrackingID );
+        writer.Write( skeleton.dwEnrollmentIndex );
+        writer.Write( skeleton.dwUserIndex );
+        writer.Write( skeleton.dwQualityFlags );
+
+        for( UINT i = 0; i < 3; ++i )
+        {
+            writer.Write( ZigZag(quantized.position[i] - reference.position[i]) );
+        }
+
+        if( NUI_SKELETON_TRACKED != skeleton.eTrackingState )
+        {
+            continue;
+        }
+
+        BYTE states[SKELETON_CODEC_STATE_BYTES] = { 0 };
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            states[j >> 2] |= static_cast<BYTE>( (skeleton.eSkeletonPositionTrackingState[j] & 3) << ((j & 3) * 2) );
+        }
+        writer.WriteBytes( states, sizeof(states) );
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            if( NUI_SKELETON_POSITION_NOT_TRACKED == skeleton.eSkeletonPositionTrackingState[j] )
+            {
+                continue;
+            }
+
+            for( UINT i = 0; i < 3; ++i )
+            {
+                writer.Write( ZigZag(quantized.joints[j][i] - reference.joints[j][i]) );
+            }
+        }
+    }
+
+    cbWritten = static_cast<ULONG>( writer.Position() - pEncoded );
+
+    return S_OK;
+}
+
+HRESULT SkeletonCodec::Decode( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Inout_ NUI_SKELETON_FRAME& skeletonFrame )
+{
+    if( nullptr == pEncoded )
+    {
+        return E_INVALIDARG;
+    }
+
+    VarintReader reader( pEncoded, pEncoded + cbEncoded );
+
+    SkeletonCodecHeader header;
+    if( !reader.ReadBytes(&header, sizeof(header)) || SKELETON_CODEC_MAGIC != header.magic || header.cSkeletons > NUI_SKELETON_COUNT )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
+    bool bKeyframe = 0 != (header.flags & SKELETON_CODEC_KEYFRAME);
+    const NUI_SKELETON_FRAME& reference = skeletonFrame;
+
+    // the reference stays as it is until the frame decoded
+    NUI_SKELETON_FRAME decoded;
+    ZeroMemory( &decoded, sizeof(decoded) );
+
+    ULONGLONG value;
+    if( bKeyframe )
+    {
+        if( !reader.Read(value) || !reader.Read(decoded.dwFrameNumber) )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+        decoded.liTimeStamp.QuadPart = UnZigZag64( value );
+    }
+    else
+    {
+        DWORD dwReferenceFrame, dwFrameDelta;
+        if( !reader.Read(dwReferenceFrame) || !reader.Read(value) || !reader.Read(dwFrameDelta) )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+
+        // a frame was lost or is out of order
+        if( dwReferenceFrame != reference.dwFrameNumber )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+
+        decoded.liTimeStamp.QuadPart = reference.liTimeStamp.QuadPart + UnZigZag64( value );
+        decoded.dwFrameNumber = reference.dwFrameNumber + dwFrameDelta;
+    }
+
+    if( !reader.Read(decoded.dwFlags) )
+    {
+        return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+    }
+
+    if( 0 != (header.flags & SKELETON_CODEC_FLOOR) )
+    {
+        if( !reader.ReadBytes(&decoded.vFloorClipPlane, sizeof(Vector4)) || !reader.ReadBytes(&decoded.vNormalToGravity, sizeof(Vector4)) )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+    }
+    else
+    {
+        decoded.vFloorClipPlane = reference.vFloorClipPlane;
+        decoded.vNormalToGravity = reference.vNormalToGravity;
+    }
+
+    for( UINT k = 0; k < header.cSkeletons; ++k )
+    {
+        BYTE slot;
+        if( !reader.ReadByte(slot) )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+
+        UINT s = slot & SKELETON_CODEC_SLOT_MASK;
+        UINT state = (slot >> SKELETON_CODEC_STATE_SHIFT) & 3;
+        if( s >= NUI_SKELETON_COUNT || NUI_SKELETON_NOT_TRACKED == state || NUI_SKELETON_TRACKED < state )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+
+        NUI_SKELETON_DATA& skeleton = decoded.SkeletonData[s];
+        skeleton.eTrackingState = static_cast<NUI_SKELETON_TRACKING_STATE>(state);
+        if( !reader.Read(skeleton.dwTrackingID) || !reader.Read(skeleton.dwEnrollmentIndex)
+            || !reader.Read(skeleton.dwUserIndex) || !reader.Read(skeleton.dwQualityFlags) )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+
+        QuantizedSkeleton quantized;
+        ZeroMemory( &quantized, sizeof(quantized) );
+        if( 0 != (slot & SKELETON_CODEC_DELTA) )
+        {
+            const NUI_SKELETON_DATA* pReferenceSkeleton = bKeyframe ? nullptr : FindSkeleton( reference, skeleton.dwTrackingID );
+            if( nullptr == pReferenceSkeleton )
+            {
+                return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+            }
+            QuantizeSkeleton( *pReferenceSkeleton, quantized );
+        }
+
+        INT32 position[3];
+        for( UINT i = 0; i < 3; ++i )
+        {
+            DWORD delta;
+            if( !reader.Read(delta) )
+            {
+                return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+            }
+            position[i] = quantized.position[i] + UnZigZag(delta);
+        }
+        skeleton.Position.x = Dequantize( position[0] );
+        skeleton.Position.y = Dequantize( position[1] );
+        skeleton.Position.z = Dequantize( position[2] );
+        skeleton.Position.w = 1.0f;
+
+        if( NUI_SKELETON_TRACKED != state )
+        {
+            continue;
+        }
+
+        BYTE states[SKELETON_CODEC_STATE_BYTES];
+        if( !reader.ReadBytes(states, sizeof(states)) )
+        {
+            return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+        }
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            skeleton.eSkeletonPositionTrackingState[j] = static_cast<NUI_SKELETON_POSITION_TRACKING_STATE>( (states[j >> 2] >> ((j & 3) * 2)) & 3 );
+            if( NUI_SKELETON_POSITION_NOT_TRACKED == skeleton.eSkeletonPositionTrackingState[j] )
+            {
+                continue;
+            }
+
+            INT32 joint[3];
+            for( UINT i = 0; i < 3; ++i )
+            {
+                DWORD delta;
+                if( !reader.Read(delta) )
+                {
+                    return HRESULT_FROM_WIN32( ERROR_INVALID_DATA );
+                }
+                joint[i] = quantized.joints[j][i] + UnZigZag(delta);
+            }
+
+            skeleton.SkeletonPositions[j].x = Dequantize( joint[0] );
+            skeleton.SkeletonPositions[j].y = Dequantize( joint[1] );
+            skeleton.SkeletonPositions[j].z = Dequantize( joint[2] );
+            skeleton.SkeletonPositions[j].w = 1.0f;
+        }
+    }
+
+    skeletonFrame = decoded;
+
+    return S_OK;
+}
@@ -0,0 +1,50 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// joint coordinates are 16 bit fixed point with 11 fraction bits, +-16 m in steps of 0.49 mm
+#define SKELETON_CODEC_SCALE                2048.0f
+
+// frames between two keyframes of the encoded skeleton stream of a sensor
+#define SKELETON_CODEC_KEYFRAME_INTERVAL    30
+
+// compact codec for skeleton frames
+// only the skeletons that are tracked or position only are written; positions are quantized to
+// 16 bit fixed point and written as zigzag varints, of the value in a keyframe and of the
+// change from the skeleton with the same tracking id in the reference frame otherwise
+// joints that are not tracked are not written and come back as 0, the floor planes are written
+// when they change
+//
+// the reference of a delta frame is the frame before it, the decoder gets it back from the
+// frame it decoded last, so both sides quantize the same values and errors do not add up
+//
+// layout: SkeletonCodecHeader, varints of the frame, floor planes, skeletons
+// skeleton: slot and state byte, varints of the ids, position, 2 bit joint states, joints
+class SkeletonCodec
+{
+public:
+    // worst case size of an encoded frame, Encode needs a buffer at least this big
+    static ULONG GetEncodedBound();
+
+    // pReference - the frame encoded before, nullptr writes a keyframe
+    static HRESULT Encode( _In_ const NUI_SKELETON_FRAME& skeletonFrame, _In_opt_ const NUI_SKELETON_FRAME* pReference,
+        ULONG cbEncoded, _Out_cap_(cbEncoded) BYTE* pEncoded, _Out_ ULONG& cbWritten );
+
+    // skeletonFrame - the frame decoded before, it is replaced by the decoded one
+    // a delta frame of another reference fails with ERROR_INVALID_DATA, the next keyframe starts over
+    static HRESULT Decode( ULONG cbEncoded, _In_count_(cbEncoded) const BYTE* pEncoded, _Inout_ NUI_SKELETON_FRAME& skeletonFrame );
+};
@@ -0,0 +1,393 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "SkeletonFilter.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+
+// frame time when the time stamps do not tell
+#define SKELETON_FILTER_FRAME_SECONDS   (1.0f / 30.0f)
+
+// velocity variance of a joint that just started, Kalman
+#define SKELETON_FILTER_INITIAL_VELOCITY_VARIANCE   1.0f
+
+static const float PI = 3.14159265f;
+
+static inline __m128 Select( __m128 mask, __m128 a, __m128 b )
+{
+    return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+}
+
+static inline __m128 Length( __m128 x, __m128 y, __m128 z )
+{
+    return _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ), _mm_mul_ps( z, z ) ) );
+}
+
+static inline __m128 Abs( __m128 v )
+{
+    return _mm_and_ps( v, _mm_castsi128_ps( _mm_set1_epi32( 0x7fffffff ) ) );
+}
+
+static inline __m128 LoadMask( _In_ const UINT32* p )
+{
+    return _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>(p) ) );
+}
+
+SkeletonFilter::SkeletonFilter()
+{
+    ZeroMemory( m_outX, sizeof(m_outX) );
+    ZeroMemory( m_outY, sizeof(m_outY) );
+    ZeroMemory( m_outZ, sizeof(m_outZ) );
+
+    SetParameters( nullptr );
+}
+
+HRESULT SkeletonFilter::SetParameters( _In_opt_ const KINECT_SKELETON_FILTER* pParams )
+{
+    if( nullptr != pParams )
+    {
+        // callers of the C API can pass any value, so the type is read as the integer it is stored as
+        UINT32 type;
+        memcpy( &type, &pParams->eType, sizeof(type) );
+        if( pParams->dwStructSize != sizeof(KINECT_SKELETON_FILTER) || type > SkeletonFilterKalman )
+        {
+            return E_INVALIDARG;
+        }
+        m_params = *pParams;
+    }
+    else
+    {
+        ZeroMemory( &m_params, sizeof(KINECT_SKELETON_FILTER) );
+        m_params.dwStructSize = sizeof(KINECT_SKELETON_FILTER);
+    }
+
+    if( 0.0f >= m_params.fMinCutoff )
+    {
+        m_params.fMinCutoff = SKELETON_FILTER_DEFAULT_MIN_CUTOFF;
+    }
+    if( 0.0f >= m_params.fBeta )
+    {
+        m_params.fBeta = SKELETON_FILTER_DEFAULT_BETA;
+    }
+    if( 0.0f >= m_params.fDerivativeCutoff )
+    {
+        m_params.fDerivativeCutoff = SKELETON_FILTER_DEFAULT_DERIVATIVE_CUTOFF;
+    }
+    if( 0.0f >= m_params.fProcessNoise )
+    {
+        m_params.fProcessNoise = SKELETON_FILTER_DEFAULT_PROCESS_NOISE;
+    }
+    if( 0.0f >= m_params.fMeasurementNoise )
+    {
+        m_params.fMeasurementNoise = SKELETON_FILTER_DEFAULT_MEASUREMENT_NOISE;
+    }
+
+    // the state of one filter means nothing to another
+    Reset();
+
+    return S_OK;
+}
+
+void SkeletonFilter::Reset()
+{
+    ZeroMemory( m_trackingIDs, sizeof(m_trackingIDs) );
+    ZeroMemory( m_count, sizeof(m_count) );
+    m_liLastTimeStamp = 0;
+}
+
+void SkeletonFilter::Gather( _In_ const NUI_SKELETON_FRAME& skeletonFrame )
+{
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        bool bTracked = (NUI_SKELETON_TRACKED == skeleton.eTrackingState);
+
+        // another player in the slot starts over
+        if( !bTracked || m_trackingIDs[s] != skeleton.dwTrackingID )
+        {
+            ZeroMemory( m_count + s * NUI_SKELETON_POSITION_COUNT, NUI_SKELETON_POSITION_COUNT * sizeof(float) );
+        }
+        m_trackingIDs[s] = bTracked ? skeleton.dwTrackingID : 0;
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            UINT i = s * NUI_SKELETON_POSITION_COUNT + j;
+            NUI_SKELETON_POSITION_TRACKING_STATE state = skeleton.eSkeletonPositionTrackingState[j];
+
+            m_rawX[i] = skeleton.SkeletonPositions[j].x;
+            m_rawY[i] = skeleton.SkeletonPositions[j].y;
+            m_rawZ[i] = skeleton.SkeletonPositions[j].z;
+            m_valid[i] = (bTracked && NUI_SKELETON_POSITION_NOT_TRACKED != state) ? 0xffffffff : 0;
+            m_inferred[i] = (NUI_SKELETON_POSITION_INFERRED == state) ? 0xffffffff : 0;
+        }
+    }
+}
+
+void SkeletonFilter::Scatter( _Inout_ NUI_SKELETON_FRAME& skeletonFrame ) const
+{
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            UINT i = s * NUI_SKELETON_POSITION_COUNT + j;
+            if( 0 != m_valid[i] )
+            {
+                skeleton.SkeletonPositions[j].x = m_outX[i];
+                skeleton.SkeletonPositions[j].y = m_outY[i];
+                skeleton.SkeletonPositions[j].z = m_outZ[i];
+            }
+        }
+    }
+}
+
+// Holt double exponential smoothing with the jitter radius, prediction and maximum deviation
+// of NUI_TRANSFORM_SMOOTH_PARAMETERS; inferred joints use twice the radii like the SDK samples
+void SkeletonFilter::DoubleExponential()
+{
+    const NUI_TRANSFORM_SMOOTH_PARAMETERS& smooth = m_params.smoothParams;
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 two = _mm_set1_ps( 2.0f );
+    const __m128 half = _mm_set1_ps( 0.5f );
+    const __m128 tiny = _mm_set1_ps( 1e-6f );
+    const __m128 smoothing = _mm_set1_ps( smooth.fSmoothing );
+    const __m128 correction = _mm_set1_ps( smooth.fCorrection );
+    const __m128 prediction = _mm_set1_ps( smooth.fPrediction );
+    const __m128 jitterRadius = _mm_set1_ps( smooth.fJitterRadius );
+    const __m128 maxDeviation = _mm_set1_ps( smooth.fMaxDeviationRadius );
+
+    for( UINT i = 0; i < SKELETON_FILTER_JOINTS; i += 4 )
+    {
+        __m128 valid = LoadMask( m_valid + i );
+        __m128 inferred = LoadMask( m_inferred + i );
+        __m128 count = _mm_loadu_ps( m_count + i );
+        __m128 first = _mm_cmpeq_ps( count, zero );
+        __m128 second = _mm_cmpeq_ps( count, one );
+
+        __m128 jitter = _mm_max_ps( Select( inferred, _mm_mul_ps( jitterRadius, two ), jitterRadius ), tiny );
+        __m128 deviation = Select( inferred, _mm_mul_ps( maxDeviation, two ), maxDeviation );
+
+        __m128 rx = _mm_loadu_ps( m_rawX + i ), ry = _mm_loadu_ps( m_rawY + i ), rz = _mm_loadu_ps( m_rawZ + i );
+        __m128 fx = _mm_loadu_ps( m_posX + i ), fy = _mm_loadu_ps( m_posY + i ), fz = _mm_loadu_ps( m_posZ + i );
+        __m128 tx = _mm_loadu_ps( m_velX + i ), ty = _mm_loadu_ps( m_velY + i ), tz = _mm_loadu_ps( m_velZ + i );
+
+        // jitter filter: within the radius the raw position is pulled towards the last filtered one
+        __m128 jitterWeight = _mm_min_ps( _mm_div_ps( Length( _mm_sub_ps( rx, fx ), _mm_sub_ps( ry, fy ), _mm_sub_ps( rz, fz ) ), jitter ), one );
+
+        __m128 out[3], filtered[3], trend[3];
+        const __m128 raw[3] = { rx, ry, rz };
+        const __m128 prevFiltered[3] = { fx, fy, fz };
+        const __m128 prevTrend[3] = { tx, ty, tz };
+        const __m128 prevRaw[3] = { _mm_loadu_ps( m_prevX + i ), _mm_loadu_ps( m_prevY + i ), _mm_loadu_ps( m_prevZ + i ) };
+
+        for( UINT axis = 0; axis < 3; ++axis )
+        {
+            __m128 dejittered = _mm_add_ps( prevFiltered[axis], _mm_mul_ps( _mm_sub_ps( raw[axis], prevFiltered[axis] ), jitterWeight ) );
+            __m128 smoothed = _mm_add_ps( _mm_mul_ps( dejittered, _mm_sub_ps( one, smoothing ) ),
+                _mm_mul_ps( _mm_add_ps( prevFiltered[axis], prevTrend[axis] ), smoothing ) );
+
+            // the first frame takes the raw position, the second the mean of the first two
+            filtered[axis] = Select( first, raw[axis], Select( second, _mm_mul_ps( _mm_add_ps( raw[axis], prevRaw[axis] ), half ), smoothed ) );
+
+            trend[axis] = _mm_andnot_ps( first, _mm_add_ps( _mm_mul_ps( _mm_sub_ps( filtered[axis], prevFiltered[axis] ), correction ),
+                _mm_mul_ps( prevTrend[axis], _mm_sub_ps( one, correction ) ) ) );
+
+            // predict into the future to reduce the latency
+            out[axis] = _mm_add_ps( filtered[axis], _mm_mul_ps( trend[axis], prediction ) );
+        }
+
+        // not too far away from the raw position, 0 / 0 picks 1 since min returns the second operand for NaN
+        __m128 dx = _mm_sub_ps( out[0], rx ), dy = _mm_sub_ps( out[1], ry ), dz = _mm_sub_ps( out[2], rz );
+        __m128 deviationWeight = _mm_min_ps( _mm_div_ps( deviation, Length( dx, dy, dz ) ), one );
+
+        _mm_storeu_ps( m_outX + i, _mm_add_ps( rx, _mm_mul_ps( dx, deviationWeight ) ) );
+        _mm_storeu_ps( m_outY + i, _mm_add_ps( ry, _mm_mul_ps( dy, deviationWeight ) ) );
+        _mm_storeu_ps( m_outZ + i, _mm_add_ps( rz, _mm_mul_ps( dz, deviationWeight ) ) );
+
+        _mm_storeu_ps( m_posX + i, filtered[0] );
+        _mm_storeu_ps( m_posY + i, filtered[1] );
+        _mm_storeu_ps( m_posZ + i, filtered[2] );
+        _mm_storeu_ps( m_velX + i, trend[0] );
+        _mm_storeu_ps( m_velY + i, trend[1] );
+        _mm_storeu_ps( m_velZ + i, trend[2] );
+        _mm_storeu_ps( m_prevX + i, rx );
+        _mm_storeu_ps( m_prevY + i, ry );
+        _mm_storeu_ps( m_prevZ + i, rz );
+
+        // joints without a position start over
+        _mm_storeu_ps( m_count + i, _mm_and_ps( valid, _mm_min_ps( _mm_add_ps( count, one ), two ) ) );
+    }
+}
+
+// One Euro filter: a low pass whose cutoff rises with the filtered speed of the joint
+void SkeletonFilter::OneEuro( float seconds )
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 rate = _mm_set1_ps( 1.0f / seconds );
+    const __m128 minCutoff = _mm_set1_ps( m_params.fMinCutoff );
+    const __m128 beta = _mm_set1_ps( m_params.fBeta );
+
+    // alpha = 1 / (1 + tau / Te), tau = 1 / (2 pi cutoff), so alpha = x / (1 + x) with x = 2 pi cutoff Te
+    const __m128 scale = _mm_set1_ps( 2.0f * PI * seconds );
+    float x = 2.0f * PI * m_params.fDerivativeCutoff * seconds;
+    const __m128 derivativeAlpha = _mm_set1_ps( x / (1.0f + x) );
+
+    for( UINT i = 0; i < SKELETON_FILTER_JOINTS; i += 4 )
+    {
+        __m128 valid = LoadMask( m_valid + i );
+        __m128 count = _mm_loadu_ps( m_count + i );
+        __m128 first = _mm_cmpeq_ps( count, zero );
+
+        float* const pRaw[3] = { m_rawX + i, m_rawY + i, m_rawZ + i };
+        float* const pPos[3] = { m_posX + i, m_posY + i, m_posZ + i };
+        float* const pVel[3] = { m_velX + i, m_velY + i, m_velZ + i };
+        float* const pOut[3] = { m_outX + i, m_outY + i, m_outZ + i };
+
+        for( UINT axis = 0; axis < 3; ++axis )
+        {
+            __m128 raw = _mm_loadu_ps( pRaw[axis] );
+            __m128 prev = _mm_loadu_ps( pPos[axis] );
+            __m128 prevDerivative = _mm_loadu_ps( pVel[axis] );
+
+            __m128 derivative = _mm_mul_ps( _mm_sub_ps( raw, prev ), rate );
+            derivative = _mm_add_ps( prevDerivative, _mm_mul_ps( derivativeAlpha, _mm_sub_ps( derivative, prevDerivative ) ) );
+
+            __m128 cutoff = _mm_mul_ps( _mm_add_ps( minCutoff, _mm_mul_ps( beta, Abs( derivative ) ) ), scale );
+            __m128 alpha = _mm_div_ps( cutoff, _mm_add_ps( one, cutoff ) );
+            __m128 filtered = _mm_add_ps( prev, _mm_mul_ps( alpha, _mm_sub_ps( raw, prev ) ) );
+
+            filtered = Select( first, raw, filtered );
+            _mm_storeu_ps( pOut[axis], filtered );
+            _mm_storeu_ps( pPos[axis], filtered );
+            _mm_storeu_ps( pVel[axis], _mm_andnot_ps( first, derivative ) );
+        }
+
+        _mm_storeu_ps( m_count + i, _mm_and_ps( valid, one ) );
+    }
+}
+
+// constant velocity Kalman filter with white noise acceleration, every axis on its own;
+// the axes see the same measurements at the same times, so they share one covariance
+void SkeletonFilter::Kalman( float seconds )
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 four = _mm_set1_ps( 4.0f );
+    const __m128 dt = _mm_set1_ps( seconds );
+    const __m128 dt2 = _mm_set1_ps( seconds * seconds );
+
+    float q = m_params.fProcessNoise * m_params.fProcessNoise;
+    const __m128 q00 = _mm_set1_ps( q * seconds * seconds * seconds * seconds / 4.0f );
+    const __m128 q01 = _mm_set1_ps( q * seconds * seconds * seconds / 2.0f );
+    const __m128 q11 = _mm_set1_ps( q * seconds * seconds );
+    const __m128 measurement = _mm_set1_ps( m_params.fMeasurementNoise * m_params.fMeasurementNoise );
+    const __m128 initialVelocity = _mm_set1_ps( SKELETON_FILTER_INITIAL_VELOCITY_VARIANCE );
+
+    for( UINT i = 0; i < SKELETON_FILTER_JOINTS; i += 4 )
+    {
+        __m128 valid = LoadMask( m_valid + i );
+        __m128 count = _mm_loadu_ps( m_count + i );
+        __m128 first = _mm_cmpeq_ps( count, zero );
+
+        // inferred joints are twice as uncertain
+        __m128 r = Select( LoadMask( m_inferred + i ), _mm_mul_ps( measurement, four ), measurement );
+
+        // predict
+        __m128 p00 = _mm_loadu_ps( m_p00 + i ), p01 = _mm_loadu_ps( m_p01 + i ), p11 = _mm_loadu_ps( m_p11 + i );
+        p00 = _mm_add_ps( _mm_add_ps( p00, _mm_mul_ps( _mm_add_ps( p01, p01 ), dt ) ), _mm_add_ps( _mm_mul_ps( p11, dt2 ), q00 ) );
+        p01 = _mm_add_ps( _mm_add_ps( p01, _mm_mul_ps( p11, dt ) ), q01 );
+        p11 = _mm_add_ps( p11, q11 );
+
+        // update
+        __m128 s = _mm_add_ps( p00, r );
+        __m128 k0 = _mm_div_ps( p00, s );
+        __m128 k1 = _mm_div_ps( p01, s );
+
+        float* const pRaw[3] = { m_rawX + i, m_rawY + i, m_rawZ + i };
+        float* const pPos[3] = { m_posX + i, m_posY + i, m_posZ + i };
+        float* const pVel[3] = { m_velX + i, m_velY + i, m_velZ + i };
+        float* const pOut[3] = { m_outX + i, m_outY + i, m_outZ + i };
+
+        for( UINT axis = 0; axis < 3; ++axis )
+        {
+            __m128 raw = _mm_loadu_ps( pRaw[axis] );
+            __m128 velocity = _mm_loadu_ps( pVel[axis] );
+            __m128 position = _mm_add_ps( _mm_loadu_ps( pPos[axis] ), _mm_mul_ps( velocity, dt ) );
+
+            __m128 innovation = _mm_sub_ps( raw, position );
+            position = Select( first, raw, _mm_add_ps( position, _mm_mul_ps( k0, innovation ) ) );
+            velocity = _mm_andnot_ps( first, _mm_add_ps( velocity, _mm_mul_ps( k1, innovation ) ) );
+
+            _mm_storeu_ps( pOut[axis], position );
+            _mm_storeu_ps( pPos[axis], position );
+            _mm_storeu_ps( pVel[axis], velocity );
+        }
+
+        __m128 p11Updated = _mm_sub_ps( p11, _mm_mul_ps( k1, p01 ) );
+        __m128 p00Updated = _mm_mul_ps( _mm_sub_ps( one, k0 ), p00 );
+        __m128 p01Updated = _mm_mul_ps( _mm_sub_ps( one, k0 ), p01 );
+
+        // a joint that starts knows its position as well as the measurement, its velocity not at all
+        _mm_storeu_ps( m_p00 + i, Select( first, r, p00Updated ) );
+        _mm_storeu_ps( m_p01 + i, _mm_andnot_ps( first, p01Updated ) );
+        _mm_storeu_ps( m_p11 + i, Select( first, initialVelocity, p11Updated ) );
+
+        _mm_storeu_ps( m_count + i, _mm_and_ps( valid, one ) );
+    }
+}
+
+void SkeletonFilter::Process( _Inout_ NUI_SKELETON_FRAME& skeletonFrame )
+{
+    if( !IsEnabled() )
+    {
+        return;
+    }
+
+    Gather( skeletonFrame );
+
+    // seconds since the last frame
+    LONGLONG liTimeStamp = skeletonFrame.liTimeStamp.QuadPart;
+    float seconds = SKELETON_FILTER_FRAME_SECONDS;
+    if( 0 != m_liLastTimeStamp && liTimeStamp > m_liLastTimeStamp )
+    {
+        seconds = (liTimeStamp - m_liLastTimeStamp) / 1000.0f;
+    }
+    m_liLastTimeStamp = liTimeStamp;
+
+    switch( m_params.eType )
+    {
+    case SkeletonFilterDoubleExponential:
+        DoubleExponential();
+        break;
+
+    case SkeletonFilterOneEuro:
+        OneEuro( seconds );
+        break;
+
+    case SkeletonFilterKalman:
+        Kalman( seconds );
+        break;
+
+    default:
+        break;
+    }
+
+    Scatter( skeletonFrame );
+}
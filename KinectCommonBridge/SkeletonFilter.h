@@ -0,0 +1,95 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// joints of all skeletons of a frame, a multiple of 4
+#define SKELETON_FILTER_JOINTS      (NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT)
+
+// used when the caller leaves the value at 0
+#define SKELETON_FILTER_DEFAULT_MIN_CUTOFF          1.0f    // Hz
+#define SKELETON_FILTER_DEFAULT_BETA                0.5f
+#define SKELETON_FILTER_DEFAULT_DERIVATIVE_CUTOFF   1.0f    // Hz
+#define SKELETON_FILTER_DEFAULT_PROCESS_NOISE       5.0f    // m/s^2
+#define SKELETON_FILTER_DEFAULT_MEASUREMENT_NOISE   0.01f   // m
+
+// joint smoothing of the skeleton frames without the sensor
+// the state of every joint of every skeleton is kept as structure of arrays, indexed by
+// skeleton * NUI_SKELETON_POSITION_COUNT + joint, so the filters run on 4 joints at a time;
+// a joint restarts when it is not tracked or its skeleton slot gets another tracking id
+class SkeletonFilter
+{
+public:
+    SkeletonFilter();
+
+    // nullptr turns it off, an unknown filter type fails with E_INVALIDARG and changes nothing
+    HRESULT SetParameters( _In_opt_ const KINECT_SKELETON_FILTER* pParams );
+    bool IsEnabled() const { return SkeletonFilterNone != m_params.eType; }
+
+    void Reset();
+
+    // filters the joints of the tracked skeletons in place
+    void Process( _Inout_ NUI_SKELETON_FRAME& skeletonFrame );
+
+private:
+    void Gather( _In_ const NUI_SKELETON_FRAME& skeletonFrame );
+    void Scatter( _Inout_ NUI_SKELETON_FRAME& skeletonFrame ) const;
+
+    void DoubleExponential();
+    void OneEuro( float seconds );
+    void Kalman( float seconds );
+
+private:
+    KINECT_SKELETON_FILTER m_params;
+
+    DWORD m_trackingIDs[NUI_SKELETON_COUNT];
+    LONGLONG m_liLastTimeStamp;
+
+    // joints of the current frame, masks are all bits set or 0
+    float m_rawX[SKELETON_FILTER_JOINTS];
+    float m_rawY[SKELETON_FILTER_JOINTS];
+    float m_rawZ[SKELETON_FILTER_JOINTS];
+    UINT32 m_valid[SKELETON_FILTER_JOINTS];
+    UINT32 m_inferred[SKELETON_FILTER_JOINTS];
+
+    // output of the current frame
+    float m_outX[SKELETON_FILTER_JOINTS];
+    float m_outY[SKELETON_FILTER_JOINTS];
+    float m_outZ[SKELETON_FILTER_JOINTS];
+
+    // frames of history of every joint, 0 restarts it
+    float m_count[SKELETON_FILTER_JOINTS];
+
+    // filtered position of every filter
+    float m_posX[SKELETON_FILTER_JOINTS];
+    float m_posY[SKELETON_FILTER_JOINTS];
+    float m_posZ[SKELETON_FILTER_JOINTS];
+
+    // trend of the double exponential filter, filtered derivative of One Euro, velocity of Kalman
+    float m_velX[SKELETON_FILTER_JOINTS];
+    float m_velY[SKELETON_FILTER_JOINTS];
+    float m_velZ[SKELETON_FILTER_JOINTS];
+
+    // raw position of the previous frame, double exponential
+    float m_prevX[SKELETON_FILTER_JOINTS];
+    float m_prevY[SKELETON_FILTER_JOINTS];
+    float m_prevZ[SKELETON_FILTER_JOINTS];
+
+    // covariance of position and velocity, Kalman, the same for every axis
+    float m_p00[SKELETON_FILTER_JOINTS];
+    float m_p01[SKELETON_FILTER_JOINTS];
+    float m_p11[SKELETON_FILTER_JOINTS];
+};
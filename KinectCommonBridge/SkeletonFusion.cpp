@@ -0,0 +1,400 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "SkeletonFusion.h"
+
+#include <math.h>
+
+// cost of a pair that can not be the same person, the unmatched cost is always lower
+#define SKELETON_FUSION_NO_MATCH        1000.0f
+
+// the same tracking id as the person had in the last frame of the sensor
+#define SKELETON_FUSION_STICKY_SCALE    0.5f
+
+// minimum cost assignment of the rows to distinct columns, rows <= cols
+// Hungarian algorithm with potentials, O(rows^2 * cols)
+static void AssignRows( _In_ const std::vector<float>& cost, UINT rows, UINT cols, _Out_ std::vector<int>& rowColumns )
+{
+    const float infinity = 1e30f;
+
+    // 1 based, column 0 is the virtual start
+    std::vector<float> u(rows + 1, 0.0f), v(cols + 1, 0.0f);
+    std::vector<UINT> columnRows(cols + 1, 0), way(cols + 1, 0);
+    std::vector<float> minCost(cols + 1);
+    std::vector<bool> used(cols + 1);
+
+    for( UINT row = 1; row <= rows; ++row )
+    {
+        columnRows[0] = row;
+        UINT column = 0;
+        std::fill( minCost.begin(), minCost.end(), infinity );
+        std::fill( used.begin(), used.end(), false );
+
+        // grow an alternating path until it reaches a free column
+        do
+        {
+            used[column] = true;
+            UINT r = columnRows[column];
+            UINT next = 0;
+            float delta = infinity;
+
+            for( UINT c = 1; c <= cols; ++c )
+            {
+                if( used[c] )
+                {
+                    continue;
+                }
+
+                float reduced = cost[(r - 1) * cols + (c - 1)] - u[r] - v[c];
+                if( reduced < minCost[c] )
+                {
+                    minCost[c] = reduced;
+                    way[c] = column;
+                }
+                if( minCost[c] < delta )
+                {
+                    delta = minCost[c];
+                    next = c;
+                }
+            }
+
+            for( UINT c = 0; c <= cols; ++c )
+            {
+                if( used[c] )
+                {
+                    u[columnRows[c]] += delta;
+                    v[c] -= delta;
+                }
+                else
+                {
+                    minCost[c] -= delta;
+                }
+            }
+
+            column = next;
+        } while( 0 != columnRows[column] );
+
+        // flip the path
+        do
+        {
+            UINT previous = way[column];
+            columnRows[column] = columnRows[previous];
+            column = previous;
+        } while( 0 != column );
+    }
+
+    rowColumns.assign( rows, -1 );
+    for( UINT c = 1; c <= cols; ++c )
+    {
+        if( 0 != columnRows[c] )
+        {
+            rowColumns[columnRows[c] - 1] = c - 1;
+        }
+    }
+}
+
+static inline float TrackingWeight( NUI_SKELETON_POSITION_TRACKING_STATE eState )
+{
+    switch( eState )
+    {
+    case NUI_SKELETON_POSITION_TRACKED:
+        return 1.0f;
+    case NUI_SKELETON_POSITION_INFERRED:
+        return SKELETON_FUSION_INFERRED_WEIGHT;
+    default:
+        return 0.0f;
+    }
+}
+
+SkeletonFusion::SkeletonFusion()
+    : m_dwNextPersonID(1)
+    , m_ulTime(0)
+{
+}
+
+SkeletonFusion::Sensor* SkeletonFusion::FindSensor( KCBHANDLE kcbHandle )
+{
+    for( auto iter = m_sensors.begin(); iter != m_sensors.end(); ++iter )
+    {
+        if( iter->kcbHandle == kcbHandle )
+        {
+            return &(*iter);
+        }
+    }
+
+    return nullptr;
+}
+
+HRESULT SkeletonFusion::SetSensorPose( KCBHANDLE kcbHandle, _In_opt_ const KINECT_SENSOR_POSE* pPose )
+{
+    if( nullptr == pPose )
+    {
+        RemoveSensor( kcbHandle );
+        return S_OK;
+    }
+
+    if( pPose->dwStructSize != sizeof(KINECT_SENSOR_POSE) )
+    {
+        return E_INVALIDARG;
+    }
+
+    Sensor* pSensor = FindSensor( kcbHandle );
+    if( nullptr == pSensor )
+    {
+        Sensor sensor = Sensor();
+        sensor.kcbHandle = kcbHandle;
+        sensor.bFrame = false;
+        sensor.liTimeStamp = 0;
+        sensor.ulTime = 0;
+        m_sensors.push_back( sensor );
+        pSensor = &m_sensors.back();
+    }
+
+    // the skeletons seen so far were in the old world frame
+    memcpy( pSensor->rotation, pPose->fRotation, sizeof(pSensor->rotation) );
+    pSensor->translation = pPose->vTranslation;
+    pSensor->translation.w = 0.0f;
+    pSensor->observations.clear();
+
+    return S_OK;
+}
+
+void SkeletonFusion::RemoveSensor( KCBHANDLE kcbHandle )
+{
+    for( auto iter = m_sensors.begin(); iter != m_sensors.end(); ++iter )
+    {
+        if( iter->kcbHandle == kcbHandle )
+        {
+            m_sensors.erase( iter );
+            return;
+        }
+    }
+}
+
+void SkeletonFusion::AddFrame( KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME& skeletonFrame, ULONGLONG ulTime )
+{
+    Sensor* pSensor = FindSensor( kcbHandle );
+    if( nullptr == pSensor || (pSensor->bFrame && pSensor->liTimeStamp == skeletonFrame.liTimeStamp.QuadPart) )
+    {
+        return;
+    }
+
+    pSensor->bFrame = true;
+    pSensor->liTimeStamp = skeletonFrame.liTimeStamp.QuadPart;
+    pSensor->ulTime = ulTime;
+
+    // the tracked skeletons in the world frame
+    std::vector<Observation> observations;
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        if( NUI_SKELETON_TRACKED != skeleton.eTrackingState )
+        {
+            continue;
+        }
+
+        Observation observation;
+        observation.dwTrackingID = skeleton.dwTrackingID;
+        observation.dwPersonID = 0;
+
+        const float (*r)[3] = pSensor->rotation;
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            const Vector4& p = skeleton.SkeletonPositions[j];
+            Vector4& world = observation.positions[j];
+            world.x = r[0][0] * p.x + r[0][1] * p.y + r[0][2] * p.z + pSensor->translation.x;
+            world.y = r[1][0] * p.x + r[1][1] * p.y + r[1][2] * p.z + pSensor->translation.y;
+            world.z = r[2][0] * p.x + r[2][1] * p.y + r[2][2] * p.z + pSensor->translation.z;
+            world.w = 1.0f;
+            observation.states[j] = skeleton.eSkeletonPositionTrackingState[j];
+        }
+
+        observations.push_back( observation );
+    }
+
+    // match them to the people as of now, this sensor's last frame included
+    Fuse( ulTime );
+    Associate( *pSensor, observations );
+
+    pSensor->observations.swap( observations );
+    m_ulTime = max( m_ulTime, ulTime );
+}
+
+float SkeletonFusion::Distance( _In_ const Observation& observation, _In_ const KINECT_FUSED_SKELETON& skeleton )
+{
+    float sum = 0.0f;
+    UINT count = 0;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        if( NUI_SKELETON_POSITION_NOT_TRACKED == observation.states[j] || NUI_SKELETON_POSITION_NOT_TRACKED == skeleton.eSkeletonPositionTrackingState[j] )
+        {
+            continue;
+        }
+
+        const Vector4& a = observation.positions[j];
+        const Vector4& b = skeleton.SkeletonPositions[j];
+        sum += sqrtf( (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z) );
+        ++count;
+    }
+
+    return (0 == count) ? SKELETON_FUSION_NO_MATCH : sum / count;
+}
+
+void SkeletonFusion::Associate( _In_ const Sensor& sensor, _Inout_ std::vector<Observation>& observations )
+{
+    UINT rows = static_cast<UINT>(observations.size());
+    UINT people = static_cast<UINT>(m_skeletons.size());
+    if( 0 == rows )
+    {
+        return;
+    }
+
+    // a column per person, then one per observation for leaving it unmatched
+    UINT cols = people + rows;
+    std::vector<float> cost( rows * cols, SKELETON_FUSION_GATE );
+
+    for( UINT i = 0; i < rows; ++i )
+    {
+        const Observation& observation = observations[i];
+
+        // the person this tracking id had in the last frame of the sensor
+        DWORD dwStickyID = 0;
+        for( auto iter = sensor.observations.begin(); iter != sensor.observations.end(); ++iter )
+        {
+            if( iter->dwTrackingID == observation.dwTrackingID )
+            {
+                dwStickyID = iter->dwPersonID;
+                break;
+            }
+        }
+
+        for( UINT p = 0; p < people; ++p )
+        {
+            float distance = Distance( observation, m_skeletons[p] );
+            if( m_skeletons[p].dwPersonID == dwStickyID )
+            {
+                distance *= SKELETON_FUSION_STICKY_SCALE;
+            }
+
+            cost[i * cols + p] = (distance < SKELETON_FUSION_GATE) ? distance : SKELETON_FUSION_NO_MATCH;
+        }
+    }
+
+    std::vector<int> rowColumns;
+    AssignRows( cost, rows, cols, rowColumns );
+
+    for( UINT i = 0; i < rows; ++i )
+    {
+        UINT column = static_cast<UINT>(rowColumns[i]);
+        observations[i].dwPersonID = (column < people) ? m_skeletons[column].dwPersonID : m_dwNextPersonID++;
+    }
+}
+
+void SkeletonFusion::Fuse( ULONGLONG ulTime )
+{
+    m_skeletons.clear();
+
+    // weighted sums of the joints of every person
+    std::vector<float> weights;
+
+    for( auto sensor = m_sensors.begin(); sensor != m_sensors.end(); ++sensor )
+    {
+        if( !sensor->bFrame || ulTime > sensor->ulTime + SKELETON_FUSION_TIMEOUT )
+        {
+            continue;
+        }
+
+        for( auto observation = sensor->observations.begin(); observation != sensor->observations.end(); ++observation )
+        {
+            UINT p = 0;
+            while( p < m_skeletons.size() && m_skeletons[p].dwPersonID != observation->dwPersonID )
+            {
+                ++p;
+            }
+
+            if( p == m_skeletons.size() )
+            {
+                KINECT_FUSED_SKELETON skeleton;
+                ZeroMemory( &skeleton, sizeof(skeleton) );
+                skeleton.dwPersonID = observation->dwPersonID;
+                m_skeletons.push_back( skeleton );
+                weights.resize( weights.size() + NUI_SKELETON_POSITION_COUNT, 0.0f );
+            }
+
+            KINECT_FUSED_SKELETON& skeleton = m_skeletons[p];
+            float* pWeights = &weights[p * NUI_SKELETON_POSITION_COUNT];
+            ++skeleton.cSensors;
+
+            for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+            {
+                float weight = TrackingWeight( observation->states[j] );
+                const Vector4& position = observation->positions[j];
+
+                skeleton.SkeletonPositions[j].x += weight * position.x;
+                skeleton.SkeletonPositions[j].y += weight * position.y;
+                skeleton.SkeletonPositions[j].z += weight * position.z;
+                pWeights[j] += weight;
+
+                // the best state of the sensors, tracked is greater than inferred
+                if( observation->states[j] > skeleton.eSkeletonPositionTrackingState[j] )
+                {
+                    skeleton.eSkeletonPositionTrackingState[j] = observation->states[j];
+                }
+            }
+        }
+    }
+
+    for( UINT p = 0; p < m_skeletons.size(); ++p )
+    {
+        KINECT_FUSED_SKELETON& skeleton = m_skeletons[p];
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            float weight = weights[p * NUI_SKELETON_POSITION_COUNT + j];
+            if( weight > 0.0f )
+            {
+                skeleton.SkeletonPositions[j].x /= weight;
+                skeleton.SkeletonPositions[j].y /= weight;
+                skeleton.SkeletonPositions[j].z /= weight;
+                skeleton.SkeletonPositions[j].w = 1.0f;
+            }
+        }
+    }
+}
+
+HRESULT SkeletonFusion::GetSkeletons( ULONGLONG ulTime, ULONG cMaxSkeletons, _Out_cap_(cMaxSkeletons) KINECT_FUSED_SKELETON* pSkeletons,
+    _Out_ ULONG* pcSkeletons, _Out_opt_ LONGLONG* liTimeStamp )
+{
+    // sensors that stopped sending frames drop out here
+    Fuse( ulTime );
+
+    *pcSkeletons = static_cast<ULONG>(m_skeletons.size());
+    if( nullptr != liTimeStamp )
+    {
+        *liTimeStamp = static_cast<LONGLONG>(m_ulTime);
+    }
+
+    if( cMaxSkeletons < m_skeletons.size() )
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    if( !m_skeletons.empty() )
+    {
+        memcpy( pSkeletons, m_skeletons.data(), m_skeletons.size() * sizeof(KINECT_FUSED_SKELETON) );
+    }
+
+    return S_OK;
+}
@@ -0,0 +1,91 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+#include <vector>
+
+// mean joint distance of one person seen by two sensors, above it they are two people
+#define SKELETON_FUSION_GATE            0.5f    // m
+
+// the skeletons of a sensor are left out when it has no new frame for this long
+#define SKELETON_FUSION_TIMEOUT         200     // ms
+
+// weight of an inferred joint against a tracked one
+#define SKELETON_FUSION_INFERRED_WEIGHT 0.2f
+
+// the skeletons of every sensor with a pose, moved into the shared world frame of the poses
+// and merged into one list of people
+//
+// each sensor keeps the skeletons of its last frame; a new frame is matched to the people
+// with the Hungarian assignment on the mean distance of the joints both see, keeping the
+// person of the same tracking id cheaper so the ids stay put; skeletons that match no one
+// start a new person. the joints of a person are the average over its sensors, weighted by
+// the tracking state, so the list changes with the frames of any sensor
+class SkeletonFusion
+{
+public:
+    SkeletonFusion();
+
+    // pPose - nullptr removes the sensor
+    HRESULT SetSensorPose( KCBHANDLE kcbHandle, _In_opt_ const KINECT_SENSOR_POSE* pPose );
+    void RemoveSensor( KCBHANDLE kcbHandle );
+
+    // ulTime - arrival of the frame in milliseconds, the same clock for every sensor
+    // frames of a sensor without a pose, and frames seen before, are skipped
+    void AddFrame( KCBHANDLE kcbHandle, _In_ const NUI_SKELETON_FRAME& skeletonFrame, ULONGLONG ulTime );
+
+    // the people seen by the sensors with a frame within the timeout of ulTime
+    HRESULT GetSkeletons( ULONGLONG ulTime, ULONG cMaxSkeletons, _Out_cap_(cMaxSkeletons) KINECT_FUSED_SKELETON* pSkeletons,
+        _Out_ ULONG* pcSkeletons, _Out_opt_ LONGLONG* liTimeStamp );
+
+private:
+    // a skeleton of a sensor in the world frame
+    struct Observation
+    {
+        DWORD dwTrackingID;
+        DWORD dwPersonID;
+        Vector4 positions[NUI_SKELETON_POSITION_COUNT];
+        NUI_SKELETON_POSITION_TRACKING_STATE states[NUI_SKELETON_POSITION_COUNT];
+    };
+
+    struct Sensor
+    {
+        KCBHANDLE kcbHandle;
+        float rotation[3][3];
+        Vector4 translation;
+        bool bFrame;
+        LONGLONG liTimeStamp;       // of the last frame, in the clock of the sensor
+        ULONGLONG ulTime;           // arrival of the last frame
+        std::vector<Observation> observations;
+    };
+
+    Sensor* FindSensor( KCBHANDLE kcbHandle );
+
+    // the people from the observations of the sensors that are not timed out
+    void Fuse( ULONGLONG ulTime );
+
+    // the people of the observations of the new frame of a sensor
+    void Associate( _In_ const Sensor& sensor, _Inout_ std::vector<Observation>& observations );
+
+    static float Distance( _In_ const Observation& observation, _In_ const KINECT_FUSED_SKELETON& skeleton );
+
+private:
+    std::vector<Sensor> m_sensors;
+    std::vector<KINECT_FUSED_SKELETON> m_skeletons;
+    DWORD m_dwNextPersonID;
+    ULONGLONG m_ulTime;             // arrival of the newest frame fused
+};
@@ -0,0 +1,329 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "SkeletonHistory.h"
+
+#include <math.h>
+
+SkeletonHistory::SkeletonHistory()
+    : m_bEnabled(false)
+    , m_bHalfPrecision(false)
+    , m_capacity(0)
+{
+    Reset();
+}
+
+void SkeletonHistory::SetParameters( _In_opt_ const KINECT_SKELETON_HISTORY* pParams )
+{
+    m_bEnabled = (nullptr != pParams);
+
+    ULONG capacity = 0;
+    bool bHalfPrecision = false;
+    if( nullptr != pParams )
+    {
+        float seconds = (0.0f < pParams->fSeconds) ? min( pParams->fSeconds, SKELETON_HISTORY_MAX_SECONDS ) : SKELETON_HISTORY_DEFAULT_SECONDS;
+        capacity = static_cast<ULONG>( seconds * SKELETON_HISTORY_FRAME_RATE + 0.5f ) + 1;
+        bHalfPrecision = pParams->bHalfPrecision;
+    }
+
+    if( capacity != m_capacity || bHalfPrecision != m_bHalfPrecision )
+    {
+        m_capacity = capacity;
+        m_bHalfPrecision = bHalfPrecision;
+
+        for( UINT i = 0; i < SKELETON_HISTORY_SLOTS; ++i )
+        {
+            Slot& slot = m_slots[i];
+            slot.timeStamps.assign( capacity, 0 );
+            slot.positions.assign( bHalfPrecision ? 0 : capacity * NUI_SKELETON_POSITION_COUNT * 3, 0.0f );
+            slot.halfPositions.assign( bHalfPrecision ? capacity * NUI_SKELETON_POSITION_COUNT * 3 : 0, 0 );
+            slot.trackingStates.assign( capacity * NUI_SKELETON_POSITION_COUNT, 0 );
+
+            // swap the memory of a disabled history out
+            if( 0 == capacity )
+            {
+                std::vector<LONGLONG>().swap( slot.timeStamps );
+                std::vector<float>().swap( slot.positions );
+                std::vector<USHORT>().swap( slot.halfPositions );
+                std::vector<BYTE>().swap( slot.trackingStates );
+            }
+        }
+    }
+
+    Reset();
+}
+
+void SkeletonHistory::Reset()
+{
+    for( UINT i = 0; i < SKELETON_HISTORY_SLOTS; ++i )
+    {
+        m_slots[i].dwTrackingID = 0;
+        m_slots[i].head = 0;
+        m_slots[i].count = 0;
+        m_slots[i].liLastTimeStamp = 0;
+    }
+}
+
+const SkeletonHistory::Slot* SkeletonHistory::FindSlot( DWORD dwTrackingID ) const
+{
+    for( UINT i = 0; i < SKELETON_HISTORY_SLOTS; ++i )
+    {
+        if( 0 != dwTrackingID && m_slots[i].dwTrackingID == dwTrackingID )
+        {
+            return &m_slots[i];
+        }
+    }
+
+    return nullptr;
+}
+
+SkeletonHistory::Slot* SkeletonHistory::AllocateSlot( DWORD dwTrackingID )
+{
+    Slot* pSlot = const_cast<Slot*>( FindSlot( dwTrackingID ) );
+    if( nullptr != pSlot )
+    {
+        return pSlot;
+    }
+
+    // a free slot, or the player seen longest ago
+    pSlot = &m_slots[0];
+    for( UINT i = 0; i < SKELETON_HISTORY_SLOTS; ++i )
+    {
+        if( 0 == m_slots[i].dwTrackingID )
+        {
+            pSlot = &m_slots[i];
+            break;
+        }
+
+        if( m_slots[i].liLastTimeStamp < pSlot->liLastTimeStamp )
+        {
+            pSlot = &m_slots[i];
+        }
+    }
+
+    pSlot->dwTrackingID = dwTrackingID;
+    pSlot->head = 0;
+    pSlot->count = 0;
+    pSlot->liLastTimeStamp = 0;
+
+    return pSlot;
+}
+
+void SkeletonHistory::Append( _In_ const NUI_SKELETON_FRAME& skeletonFrame )
+{
+    if( !m_bEnabled )
+    {
+        return;
+    }
+
+    LONGLONG liTimeStamp = skeletonFrame.liTimeStamp.QuadPart;
+
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        if( NUI_SKELETON_TRACKED != skeleton.eTrackingState || 0 == skeleton.dwTrackingID )
+        {
+            continue;
+        }
+
+        Slot& slot = *AllocateSlot( skeleton.dwTrackingID );
+        if( 0 != slot.count && liTimeStamp <= slot.liLastTimeStamp )
+        {
+            continue;
+        }
+
+        ULONG frame = slot.head;
+        slot.timeStamps[frame] = liTimeStamp;
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            const Vector4& position = skeleton.SkeletonPositions[j];
+            ULONG index = j * 3 * m_capacity + frame;
+
+            if( m_bHalfPrecision )
+            {
+                slot.halfPositions[index] = FloatToHalf( position.x );
+                slot.halfPositions[index + m_capacity] = FloatToHalf( position.y );
+                slot.halfPositions[index + 2 * m_capacity] = FloatToHalf( position.z );
+            }
+            else
+            {
+                slot.positions[index] = position.x;
+                slot.positions[index + m_capacity] = position.y;
+                slot.positions[index + 2 * m_capacity] = position.z;
+            }
+
+            slot.trackingStates[j * m_capacity + frame] = static_cast<BYTE>( skeleton.eSkeletonPositionTrackingState[j] );
+        }
+
+        slot.head = (slot.head + 1) % m_capacity;
+        slot.count = min( slot.count + 1, m_capacity );
+        slot.liLastTimeStamp = liTimeStamp;
+    }
+}
+
+ULONG SkeletonHistory::FindFrame( _In_ const Slot& slot, LONGLONG liTimeStamp, bool bAfter ) const
+{
+    ULONG first = 0, last = slot.count;
+    while( first < last )
+    {
+        ULONG middle = first + (last - first) / 2;
+        LONGLONG liFrame = slot.timeStamps[RingIndex( slot, middle )];
+
+        if( bAfter ? (liFrame <= liTimeStamp) : (liFrame < liTimeStamp) )
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    return first;
+}
+
+HRESULT SkeletonHistory::GetTrajectory( _Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory ) const
+{
+    if( !m_bEnabled )
+    {
+        return E_NUI_FRAME_NO_DATA;
+    }
+
+    const Slot* pSlot = FindSlot( pTrajectory->dwTrackingID );
+    if( nullptr == pSlot )
+    {
+        return E_NUI_FRAME_NO_DATA;
+    }
+
+    ULONG firstFrame = FindFrame( *pSlot, pTrajectory->liStartTime, false );
+    ULONG endFrame = FindFrame( *pSlot, pTrajectory->liEndTime, true );
+    ULONG cFrames = (endFrame > firstFrame) ? endFrame - firstFrame : 0;
+
+    pTrajectory->cFrames = cFrames;
+
+    bool bBuffers = nullptr != pTrajectory->pTimeStamps || nullptr != pTrajectory->pPositions || nullptr != pTrajectory->pTrackingStates;
+    if( bBuffers && pTrajectory->cMaxFrames < cFrames )
+    {
+        return HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER);
+    }
+
+    if( nullptr != pTrajectory->pTimeStamps )
+    {
+        for( ULONG f = 0; f < cFrames; ++f )
+        {
+            pTrajectory->pTimeStamps[f] = pSlot->timeStamps[RingIndex( *pSlot, firstFrame + f )];
+        }
+    }
+
+    // the joints of the mask one after another, cMaxFrames apart
+    ULONG output = 0;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        if( 0 == (pTrajectory->dwJointMask & (1 << j)) )
+        {
+            continue;
+        }
+
+        ULONG outputStart = output * pTrajectory->cMaxFrames;
+        ++output;
+
+        for( ULONG f = 0; f < cFrames; ++f )
+        {
+            ULONG frame = RingIndex( *pSlot, firstFrame + f );
+            ULONG index = j * 3 * m_capacity + frame;
+
+            if( nullptr != pTrajectory->pPositions )
+            {
+                Vector4& position = pTrajectory->pPositions[outputStart + f];
+                if( m_bHalfPrecision )
+                {
+                    position.x = HalfToFloat( pSlot->halfPositions[index] );
+                    position.y = HalfToFloat( pSlot->halfPositions[index + m_capacity] );
+                    position.z = HalfToFloat( pSlot->halfPositions[index + 2 * m_capacity] );
+                }
+                else
+                {
+                    position.x = pSlot->positions[index];
+                    position.y = pSlot->positions[index + m_capacity];
+                    position.z = pSlot->positions[index + 2 * m_capacity];
+                }
+                position.w = 1.0f;
+            }
+
+            if( nullptr != pTrajectory->pTrackingStates )
+            {
+                pTrajectory->pTrackingStates[outputStart + f] = pSlot->trackingStates[j * m_capacity + frame];
+            }
+        }
+    }
+
+    return S_OK;
+}
+
+// IEEE 754 binary16, rounded to nearest even
+USHORT SkeletonHistory::FloatToHalf( float value )
+{
+    UINT32 bits = 0;
+    memcpy( &bits, &value, sizeof(bits) );
+
+    USHORT sign = static_cast<USHORT>( (bits >> 16) & 0x8000 );
+    UINT32 magnitude = bits & 0x7fffffff;
+
+    // infinity and NaN, and everything too big
+    if( magnitude >= 0x47800000 )
+    {
+        return sign | ((magnitude > 0x7f800000) ? 0x7e00 : 0x7c00);
+    }
+
+    // subnormal, in units of 2^-24
+    if( magnitude < 0x38800000 )
+    {
+        float scaled = fabs( value ) * 16777216.0f;
+        return sign | static_cast<USHORT>( scaled + 0.5f );
+    }
+
+    UINT32 mantissa = magnitude & 0x007fffff;
+    UINT32 half = ((magnitude >> 23) - 112) << 10 | (mantissa >> 13);
+
+    // a carry out of the mantissa rounds into the exponent
+    UINT32 rest = mantissa & 0x1fff;
+    if( rest > 0x1000 || (rest == 0x1000 && 0 != (half & 1)) )
+    {
+        ++half;
+    }
+
+    return sign | static_cast<USHORT>( half );
+}
+
+float SkeletonHistory::HalfToFloat( USHORT value )
+{
+    UINT32 sign = static_cast<UINT32>( value & 0x8000 ) << 16;
+    UINT32 exponent = (value >> 10) & 0x1f;
+    UINT32 mantissa = value & 0x3ff;
+
+    if( 0 == exponent )
+    {
+        float magnitude = mantissa / 16777216.0f;
+        return (0 != sign) ? -magnitude : magnitude;
+    }
+
+    UINT32 bits = sign | ((31 == exponent) ? (0xff << 23) : ((exponent + 112) << 23)) | (mantissa << 13);
+
+    float result = 0.0f;
+    memcpy( &result, &bits, sizeof(result) );
+    return result;
+}
@@ -0,0 +1,85 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// tracking ids with a history, the players in view and a few that left
+#define SKELETON_HISTORY_SLOTS              (NUI_SKELETON_COUNT * 2)
+
+// frame rate of the skeleton stream, sizes the rings
+#define SKELETON_HISTORY_FRAME_RATE         30
+
+// used when the caller leaves the value at 0, and the most allowed
+#define SKELETON_HISTORY_DEFAULT_SECONDS    5.0f
+#define SKELETON_HISTORY_MAX_SECONDS        60.0f
+
+// the last seconds of the skeletons of the skeleton stream, per tracking id
+// every slot is a ring of frames stored as structure of arrays, one array per joint and axis,
+// so a trajectory is read without touching the other joints; the time stamps of a ring
+// increase, a time range is found by binary search; joints may be stored as 16 bit floats
+class SkeletonHistory
+{
+public:
+    SkeletonHistory();
+
+    // nullptr turns it off and frees the rings
+    void SetParameters( _In_opt_ const KINECT_SKELETON_HISTORY* pParams );
+    bool IsEnabled() const { return m_bEnabled; }
+
+    void Reset();
+
+    // appends the tracked skeletons of the frame, a frame that is not newer than the last one is skipped
+    void Append( _In_ const NUI_SKELETON_FRAME& skeletonFrame );
+
+    HRESULT GetTrajectory( _Inout_ KINECT_SKELETON_TRAJECTORY* pTrajectory ) const;
+
+private:
+    struct Slot
+    {
+        DWORD dwTrackingID;         // 0 for a free slot
+        ULONG head;                 // next frame written
+        ULONG count;
+        LONGLONG liLastTimeStamp;
+
+        std::vector<LONGLONG> timeStamps;
+
+        // (joint * 3 + axis) * capacity + frame, one of them is used
+        std::vector<float> positions;
+        std::vector<USHORT> halfPositions;
+
+        // joint * capacity + frame
+        std::vector<BYTE> trackingStates;
+    };
+
+    Slot* AllocateSlot( DWORD dwTrackingID );
+    const Slot* FindSlot( DWORD dwTrackingID ) const;
+
+    // ring index of the frame, 0 is the oldest
+    ULONG RingIndex( _In_ const Slot& slot, ULONG frame ) const { return (slot.head + m_capacity - slot.count + frame) % m_capacity; }
+
+    // first frame with a time stamp greater than (bAfter) or not less than liTimeStamp
+    ULONG FindFrame( _In_ const Slot& slot, LONGLONG liTimeStamp, bool bAfter ) const;
+
+    static USHORT FloatToHalf( float value );
+    static float HalfToFloat( USHORT value );
+
+private:
+    bool m_bEnabled;
+    bool m_bHalfPrecision;
+    ULONG m_capacity;
+
+    Slot m_slots[SKELETON_HISTORY_SLOTS];
+};
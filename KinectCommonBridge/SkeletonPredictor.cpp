@@ -0,0 +1,242 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "SkeletonPredictor.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <math.h>
+
+// frame time when the time stamps do not tell
+#define SKELETON_PREDICTOR_FRAME_SECONDS    (1.0f / 30.0f)
+
+static inline float Distance( _In_ const Vector4& a, _In_ const Vector4& b )
+{
+    return sqrtf( (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z) );
+}
+
+SkeletonPredictor::SkeletonPredictor()
+{
+    Reset();
+}
+
+void SkeletonPredictor::Reset()
+{
+    m_bFrame = false;
+    ZeroMemory( &m_lastFrame, sizeof(m_lastFrame) );
+    ZeroMemory( m_trackingIDs, sizeof(m_trackingIDs) );
+    ZeroMemory( m_count, sizeof(m_count) );
+    ZeroMemory( m_boneLengths, sizeof(m_boneLengths) );
+}
+
+void SkeletonPredictor::Update( _In_ const NUI_SKELETON_FRAME& skeletonFrame )
+{
+    LONGLONG liTimeStamp = skeletonFrame.liTimeStamp.QuadPart;
+    if( m_bFrame && liTimeStamp <= m_lastFrame.liTimeStamp.QuadPart )
+    {
+        return;
+    }
+
+    float seconds = m_bFrame ? (liTimeStamp - m_lastFrame.liTimeStamp.QuadPart) / 1000.0f : SKELETON_PREDICTOR_FRAME_SECONDS;
+
+    // joints of the frame, and the joints that start over
+    float rawX[SKELETON_PREDICTOR_JOINTS], rawY[SKELETON_PREDICTOR_JOINTS], rawZ[SKELETON_PREDICTOR_JOINTS];
+    UINT32 valid[SKELETON_PREDICTOR_JOINTS];
+
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        bool bTracked = (NUI_SKELETON_TRACKED == skeleton.eTrackingState);
+
+        if( !bTracked || m_trackingIDs[s] != skeleton.dwTrackingID )
+        {
+            ZeroMemory( m_count + s * NUI_SKELETON_POSITION_COUNT, NUI_SKELETON_POSITION_COUNT * sizeof(float) );
+            ZeroMemory( m_boneLengths[s], sizeof(m_boneLengths[s]) );
+        }
+        m_trackingIDs[s] = bTracked ? skeleton.dwTrackingID : 0;
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            UINT i = s * NUI_SKELETON_POSITION_COUNT + j;
+            rawX[i] = skeleton.SkeletonPositions[j].x;
+            rawY[i] = skeleton.SkeletonPositions[j].y;
+            rawZ[i] = skeleton.SkeletonPositions[j].z;
+            valid[i] = (bTracked && NUI_SKELETON_POSITION_NOT_TRACKED != skeleton.eSkeletonPositionTrackingState[j]) ? 0xffffffff : 0;
+        }
+
+        if( !bTracked )
+        {
+            continue;
+        }
+
+        // lengths of the bones whose joints were both tracked
+        for( UINT j = 1; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            NUI_SKELETON_POSITION_INDEX parent = SKELETON_PARENT_JOINTS[j];
+            if( NUI_SKELETON_POSITION_TRACKED != skeleton.eSkeletonPositionTrackingState[j] ||
+                NUI_SKELETON_POSITION_TRACKED != skeleton.eSkeletonPositionTrackingState[parent] )
+            {
+                continue;
+            }
+
+            float length = Distance( skeleton.SkeletonPositions[j], skeleton.SkeletonPositions[parent] );
+            float& boneLength = m_boneLengths[s][j];
+            boneLength = (0.0f == boneLength) ? length : boneLength + (length - boneLength) * SKELETON_PREDICTOR_BONE_WEIGHT;
+        }
+    }
+
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 two = _mm_set1_ps( 2.0f );
+    const __m128 rate = _mm_set1_ps( 1.0f / seconds );
+
+    for( UINT i = 0; i < SKELETON_PREDICTOR_JOINTS; i += 4 )
+    {
+        __m128 count = _mm_loadu_ps( m_count + i );
+        __m128 hasPosition = _mm_cmpge_ps( count, one );
+        __m128 hasVelocity = _mm_cmpge_ps( count, two );
+
+        float* const pRaw[3] = { rawX + i, rawY + i, rawZ + i };
+        float* const pPos[3] = { m_posX + i, m_posY + i, m_posZ + i };
+        float* const pVel[3] = { m_velX + i, m_velY + i, m_velZ + i };
+        float* const pAcc[3] = { m_accX + i, m_accY + i, m_accZ + i };
+
+        for( UINT axis = 0; axis < 3; ++axis )
+        {
+            __m128 raw = _mm_loadu_ps( pRaw[axis] );
+            __m128 velocity = _mm_and_ps( hasPosition, _mm_mul_ps( _mm_sub_ps( raw, _mm_loadu_ps( pPos[axis] ) ), rate ) );
+            __m128 acceleration = _mm_and_ps( hasVelocity, _mm_mul_ps( _mm_sub_ps( velocity, _mm_loadu_ps( pVel[axis] ) ), rate ) );
+
+            _mm_storeu_ps( pPos[axis], raw );
+            _mm_storeu_ps( pVel[axis], velocity );
+            _mm_storeu_ps( pAcc[axis], acceleration );
+        }
+
+        __m128 validMask = _mm_castsi128_ps( _mm_loadu_si128( reinterpret_cast<const __m128i*>(valid + i) ) );
+        _mm_storeu_ps( m_count + i, _mm_and_ps( validMask, _mm_min_ps( _mm_add_ps( count, one ), _mm_set1_ps( 3.0f ) ) ) );
+    }
+
+    m_lastFrame = skeletonFrame;
+    m_bFrame = true;
+}
+
+void SkeletonPredictor::KeepBoneLengths( UINT skeleton, _Inout_ NUI_SKELETON_DATA& skeletonData ) const
+{
+    for( UINT j = 1; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        float boneLength = m_boneLengths[skeleton][j];
+        NUI_SKELETON_POSITION_INDEX parent = SKELETON_PARENT_JOINTS[j];
+        if( 0.0f == boneLength || NUI_SKELETON_POSITION_NOT_TRACKED == skeletonData.eSkeletonPositionTrackingState[j] ||
+            NUI_SKELETON_POSITION_NOT_TRACKED == skeletonData.eSkeletonPositionTrackingState[parent] )
+        {
+            continue;
+        }
+
+        // the parent is final already, the joint keeps its direction from it
+        Vector4& joint = skeletonData.SkeletonPositions[j];
+        const Vector4& parentJoint = skeletonData.SkeletonPositions[parent];
+        float length = Distance( joint, parentJoint );
+        if( length < 1e-6f )
+        {
+            continue;
+        }
+
+        float scale = boneLength / length;
+        joint.x = parentJoint.x + (joint.x - parentJoint.x) * scale;
+        joint.y = parentJoint.y + (joint.y - parentJoint.y) * scale;
+        joint.z = parentJoint.z + (joint.z - parentJoint.z) * scale;
+    }
+}
+
+HRESULT SkeletonPredictor::Predict( LONGLONG liTimeStamp, _In_ const KINECT_SKELETON_PREDICTION& prediction, _Out_ NUI_SKELETON_FRAME& skeletonFrame ) const
+{
+    if( !m_bFrame )
+    {
+        return E_NUI_FRAME_NO_DATA;
+    }
+
+    skeletonFrame = m_lastFrame;
+
+    // never into the past, and not further than the horizon
+    float horizon = (0.0f < prediction.fMaxHorizon) ? prediction.fMaxHorizon : SKELETON_PREDICTOR_DEFAULT_HORIZON;
+    float seconds = min( max( 0.0f, (liTimeStamp - m_lastFrame.liTimeStamp.QuadPart) / 1000.0f ), horizon );
+    if( 0.0f == seconds )
+    {
+        return S_OK;
+    }
+
+    // the distance a damped joint travels at unit speed, its velocity decays with the time constant
+    float travel = seconds;
+    if( 0.0f < prediction.fDamping )
+    {
+        travel = prediction.fDamping * (1.0f - expf( -seconds / prediction.fDamping ));
+    }
+    float accelerationTravel = (SkeletonPredictionConstantAcceleration == prediction.eModel) ? 0.5f * travel * travel : 0.0f;
+
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 velocityWeight = _mm_set1_ps( travel );
+    const __m128 accelerationWeight = _mm_set1_ps( accelerationTravel );
+
+    float predicted[3][SKELETON_PREDICTOR_JOINTS];
+    const float* const pPos[3] = { m_posX, m_posY, m_posZ };
+    const float* const pVel[3] = { m_velX, m_velY, m_velZ };
+    const float* const pAcc[3] = { m_accX, m_accY, m_accZ };
+
+    for( UINT i = 0; i < SKELETON_PREDICTOR_JOINTS; i += 4 )
+    {
+        // joints without history stay where they are
+        __m128 moving = _mm_cmpge_ps( _mm_loadu_ps( m_count + i ), one );
+
+        for( UINT axis = 0; axis < 3; ++axis )
+        {
+            __m128 step = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( pVel[axis] + i ), velocityWeight ),
+                _mm_mul_ps( _mm_loadu_ps( pAcc[axis] + i ), accelerationWeight ) );
+            _mm_storeu_ps( predicted[axis] + i, _mm_add_ps( _mm_loadu_ps( pPos[axis] + i ), _mm_and_ps( moving, step ) ) );
+        }
+    }
+
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[s];
+        if( NUI_SKELETON_TRACKED != skeleton.eTrackingState )
+        {
+            continue;
+        }
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            UINT i = s * NUI_SKELETON_POSITION_COUNT + j;
+            skeleton.SkeletonPositions[j].x = predicted[0][i];
+            skeleton.SkeletonPositions[j].y = predicted[1][i];
+            skeleton.SkeletonPositions[j].z = predicted[2][i];
+        }
+
+        if( prediction.bKeepBoneLengths )
+        {
+            KeepBoneLengths( s, skeleton );
+        }
+
+        // the skeleton moves with its hip center
+        const Vector4& hip = skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HIP_CENTER];
+        const Vector4& lastHip = m_lastFrame.SkeletonData[s].SkeletonPositions[NUI_SKELETON_POSITION_HIP_CENTER];
+        skeleton.Position.x += hip.x - lastHip.x;
+        skeleton.Position.y += hip.y - lastHip.y;
+        skeleton.Position.z += hip.z - lastHip.z;
+    }
+
+    skeletonFrame.liTimeStamp.QuadPart = m_lastFrame.liTimeStamp.QuadPart + static_cast<LONGLONG>( seconds * 1000.0f + 0.5f );
+
+    return S_OK;
+}
@@ -0,0 +1,70 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+#include "SkeletonBones.h"
+
+// joints of all skeletons of a frame, a multiple of 4
+#define SKELETON_PREDICTOR_JOINTS           (NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT)
+
+// used when the caller leaves the value at 0
+#define SKELETON_PREDICTOR_DEFAULT_HORIZON  0.15f   // s
+
+// weight of the newest frame in the bone lengths
+#define SKELETON_PREDICTOR_BONE_WEIGHT      0.1f
+
+// poses of the skeletons at a time after the last skeleton frame, to hide its latency
+// the motion of every joint, position, velocity and acceleration by finite differences of
+// the last frames, is kept as structure of arrays and extrapolated 4 joints at a time;
+// a damped joint slows down exponentially; the predicted bones can be set back to the
+// lengths the skeleton had, keeping their predicted direction
+class SkeletonPredictor
+{
+public:
+    SkeletonPredictor();
+
+    void Reset();
+
+    // adds the frame, a frame that is not newer than the last one is skipped
+    void Update( _In_ const NUI_SKELETON_FRAME& skeletonFrame );
+
+    // the last frame moved to liTimeStamp, in the milliseconds of the skeleton frames
+    HRESULT Predict( LONGLONG liTimeStamp, _In_ const KINECT_SKELETON_PREDICTION& prediction, _Out_ NUI_SKELETON_FRAME& skeletonFrame ) const;
+
+private:
+    void KeepBoneLengths( UINT skeleton, _Inout_ NUI_SKELETON_DATA& skeletonData ) const;
+
+private:
+    bool m_bFrame;
+    NUI_SKELETON_FRAME m_lastFrame;
+    DWORD m_trackingIDs[NUI_SKELETON_COUNT];
+
+    // frames of history of every joint, 0 restarts it
+    float m_count[SKELETON_PREDICTOR_JOINTS];
+
+    float m_posX[SKELETON_PREDICTOR_JOINTS];
+    float m_posY[SKELETON_PREDICTOR_JOINTS];
+    float m_posZ[SKELETON_PREDICTOR_JOINTS];
+    float m_velX[SKELETON_PREDICTOR_JOINTS];
+    float m_velY[SKELETON_PREDICTOR_JOINTS];
+    float m_velZ[SKELETON_PREDICTOR_JOINTS];
+    float m_accX[SKELETON_PREDICTOR_JOINTS];
+    float m_accY[SKELETON_PREDICTOR_JOINTS];
+    float m_accZ[SKELETON_PREDICTOR_JOINTS];
+
+    // 0 for a bone that was not seen yet, the hip center has none
+    float m_boneLengths[NUI_SKELETON_COUNT][NUI_SKELETON_POSITION_COUNT];
+};
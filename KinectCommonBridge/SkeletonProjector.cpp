@@ -0,0 +1,296 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "stdafx.h"
+
+#include "SkeletonProjector.h"
+
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#include <math.h>
+#include <algorithm>
+
+// pixels a fitted color projection may be off from the sensor
+#define COLOR_PROJECTION_TOLERANCE  1.5f
+
+// closer points are behind the camera or on it
+static const float MIN_POINT_DEPTH = 1e-4f;
+
+// unknowns of the projection, the z element of the last row is 1, the depth of a point dominates it
+static const UINT PROJECTION_UNKNOWNS = 11;
+
+// x, y, z of 4 points into a vector each
+static inline void LoadPoints( _In_count_(4) const Vector4* pPoints, _Out_ __m128& x, _Out_ __m128& y, _Out_ __m128& z )
+{
+    __m128 p0 = _mm_loadu_ps( &pPoints[0].x );
+    __m128 p1 = _mm_loadu_ps( &pPoints[1].x );
+    __m128 p2 = _mm_loadu_ps( &pPoints[2].x );
+    __m128 p3 = _mm_loadu_ps( &pPoints[3].x );
+    _MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+
+    x = p0;
+    y = p1;
+    z = p2;
+}
+
+void SkeletonProjector::ProjectToDepth( NUI_IMAGE_RESOLUTION eDepthResolution, UINT cPoints, _In_count_(cPoints) const Vector4* pPoints,
+    _Out_cap_(cPoints) NUI_DEPTH_IMAGE_POINT* pDepthPoints )
+{
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eDepthResolution, width, height );
+
+    const float scale = (width / 320.0f) * NUI_CAMERA_SKELETON_TO_DEPTH_IMAGE_MULTIPLIER_320x240;
+    const __m128 vScale = _mm_set1_ps( scale );
+    const __m128 centerX = _mm_set1_ps( width / 2.0f + 0.5f );
+    const __m128 centerY = _mm_set1_ps( height / 2.0f + 0.5f );
+    const __m128 minDepth = _mm_set1_ps( MIN_POINT_DEPTH );
+    const __m128 millimeters = _mm_set1_ps( 1000.0f );
+
+    UINT i = 0;
+    for( ; i + 4 <= cPoints; i += 4 )
+    {
+        __m128 x, y, z;
+        LoadPoints( pPoints + i, x, y, z );
+
+        __m128 inFront = _mm_cmpgt_ps( z, minDepth );
+        __m128 factor = _mm_div_ps( vScale, _mm_max_ps( z, minDepth ) );
+
+        // truncated after adding 0.5, like NuiTransformSkeletonToDepthImage
+        __m128i u = _mm_cvttps_epi32( _mm_and_ps( inFront, _mm_add_ps( centerX, _mm_mul_ps( x, factor ) ) ) );
+        __m128i v = _mm_cvttps_epi32( _mm_and_ps( inFront, _mm_sub_ps( centerY, _mm_mul_ps( y, factor ) ) ) );
+        __m128i depth = _mm_cvttps_epi32( _mm_and_ps( inFront, _mm_mul_ps( z, millimeters ) ) );
+
+        LONG us[4], vs[4], depths[4];
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(us), u );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(vs), v );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(depths), depth );
+
+        for( UINT k = 0; k < 4; ++k )
+        {
+            pDepthPoints[i + k].x = us[k];
+            pDepthPoints[i + k].y = vs[k];
+            pDepthPoints[i + k].depth = depths[k];
+            pDepthPoints[i + k].reserved = 0;
+        }
+    }
+
+    for( ; i < cPoints; ++i )
+    {
+        const Vector4& point = pPoints[i];
+        NUI_DEPTH_IMAGE_POINT& depthPoint = pDepthPoints[i];
+        ZeroMemory( &depthPoint, sizeof(NUI_DEPTH_IMAGE_POINT) );
+
+        // the factor of the vectors, the last points land on the same pixels as they would in a group of 4
+        if( point.z > MIN_POINT_DEPTH )
+        {
+            float factor = scale / point.z;
+            depthPoint.x = static_cast<LONG>( (width / 2.0f + 0.5f) + point.x * factor );
+            depthPoint.y = static_cast<LONG>( (height / 2.0f + 0.5f) - point.y * factor );
+            depthPoint.depth = static_cast<LONG>( point.z * 1000.0f );
+        }
+    }
+}
+
+void SkeletonProjector::ProjectToColor( const ColorProjection& projection, UINT cPoints, _In_count_(cPoints) const Vector4* pPoints,
+    _Out_cap_(cPoints) NUI_COLOR_IMAGE_POINT* pColorPoints )
+{
+    const float (&m)[3][4] = projection.m;
+    const __m128 minDepth = _mm_set1_ps( MIN_POINT_DEPTH );
+
+    UINT i = 0;
+    for( ; i + 4 <= cPoints; i += 4 )
+    {
+        __m128 x, y, z;
+        LoadPoints( pPoints + i, x, y, z );
+
+        __m128 row[3];
+        for( UINT r = 0; r < 3; ++r )
+        {
+            row[r] = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( m[r][0] ), x ), _mm_mul_ps( _mm_set1_ps( m[r][1] ), y ) ),
+                _mm_add_ps( _mm_mul_ps( _mm_set1_ps( m[r][2] ), z ), _mm_set1_ps( m[r][3] ) ) );
+        }
+
+        __m128 inFront = _mm_and_ps( _mm_cmpgt_ps( z, minDepth ), _mm_cmpgt_ps( row[2], minDepth ) );
+        __m128 inverse = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_max_ps( row[2], minDepth ) );
+
+        // rounded to nearest, ties to even
+        __m128i u = _mm_cvtps_epi32( _mm_and_ps( inFront, _mm_mul_ps( row[0], inverse ) ) );
+        __m128i v = _mm_cvtps_epi32( _mm_and_ps( inFront, _mm_mul_ps( row[1], inverse ) ) );
+
+        LONG us[4], vs[4];
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(us), u );
+        _mm_storeu_si128( reinterpret_cast<__m128i*>(vs), v );
+
+        for( UINT k = 0; k < 4; ++k )
+        {
+            pColorPoints[i + k].x = us[k];
+            pColorPoints[i + k].y = vs[k];
+        }
+    }
+
+    for( ; i < cPoints; ++i )
+    {
+        const Vector4& point = pPoints[i];
+        // summed in the order of the vectors
+        float row[3];
+        for( UINT r = 0; r < 3; ++r )
+        {
+            row[r] = (m[r][0] * point.x + m[r][1] * point.y) + (m[r][2] * point.z + m[r][3]);
+        }
+
+        pColorPoints[i].x = 0;
+        pColorPoints[i].y = 0;
+        if( point.z > MIN_POINT_DEPTH && row[2] > MIN_POINT_DEPTH )
+        {
+            // the conversion of the vectors, a half pixel rounds the same way in both loops
+            float inverse = 1.0f / row[2];
+            pColorPoints[i].x = _mm_cvtss_si32( _mm_set_ss( row[0] * inverse ) );
+            pColorPoints[i].y = _mm_cvtss_si32( _mm_set_ss( row[1] * inverse ) );
+        }
+    }
+}
+
+void SkeletonProjector::GetCalibrationPoints( _Out_ std::vector<Vector4>& points )
+{
+    // a grid over the field of view at the depths skeletons are tracked at
+    static const float depths[] = { 0.8f, 1.5f, 2.5f, 4.0f };
+    static const float steps[] = { -1.0f, -0.5f, 0.0f, 0.5f, 1.0f };
+
+    points.clear();
+    for( UINT d = 0; d < _countof(depths); ++d )
+    {
+        for( UINT row = 0; row < _countof(steps); ++row )
+        {
+            for( UINT column = 0; column < _countof(steps); ++column )
+            {
+                Vector4 point = { steps[column] * 0.35f * depths[d], steps[row] * 0.3f * depths[d], depths[d], 1.0f };
+                points.push_back( point );
+            }
+        }
+    }
+}
+
+bool SkeletonProjector::FitColorProjection( NUI_IMAGE_RESOLUTION eColorResolution, UINT cPoints, _In_count_(cPoints) const Vector4* pPoints,
+    _In_count_(cPoints) const NUI_COLOR_IMAGE_POINT* pColorPoints, _Out_ ColorProjection& projection )
+{
+    ZeroMemory( &projection, sizeof(ColorProjection) );
+
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eColorResolution, width, height );
+    if( 0 == width || 0 == height || cPoints < PROJECTION_UNKNOWNS )
+    {
+        return false;
+    }
+
+    // normal equations of the direct linear transform, image coordinates scaled to 0..1 for the condition
+    double normal[PROJECTION_UNKNOWNS][PROJECTION_UNKNOWNS + 1] = { 0 };
+    for( UINT i = 0; i < cPoints; ++i )
+    {
+        double x = pPoints[i].x, y = pPoints[i].y, z = pPoints[i].z;
+        double image[2] = { pColorPoints[i].x / static_cast<double>(width), pColorPoints[i].y / static_cast<double>(height) };
+
+        for( UINT r = 0; r < 2; ++r )
+        {
+            double row[PROJECTION_UNKNOWNS + 1] = { 0 };
+            row[r * 4] = x;
+            row[r * 4 + 1] = y;
+            row[r * 4 + 2] = z;
+            row[r * 4 + 3] = 1.0;
+            row[8] = -image[r] * x;
+            row[9] = -image[r] * y;
+            row[10] = -image[r];
+            row[PROJECTION_UNKNOWNS] = image[r] * z;
+
+            for( UINT a = 0; a < PROJECTION_UNKNOWNS; ++a )
+            {
+                for( UINT b = 0; b <= PROJECTION_UNKNOWNS; ++b )
+                {
+                    normal[a][b] += row[a] * row[b];
+                }
+            }
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+    for( UINT c = 0; c < PROJECTION_UNKNOWNS; ++c )
+    {
+        UINT pivot = c;
+        for( UINT r = c + 1; r < PROJECTION_UNKNOWNS; ++r )
+        {
+            if( fabs( normal[r][c] ) > fabs( normal[pivot][c] ) )
+            {
+                pivot = r;
+            }
+        }
+
+        if( fabs( normal[pivot][c] ) < 1e-12 )
+        {
+            return false;
+        }
+
+        for( UINT b = 0; b <= PROJECTION_UNKNOWNS; ++b )
+        {
+            std::swap( normal[c][b], normal[pivot][b] );
+        }
+
+        for( UINT r = 0; r < PROJECTION_UNKNOWNS; ++r )
+        {
+            if( r == c )
+            {
+                continue;
+            }
+
+            double factor = normal[r][c] / normal[c][c];
+            for( UINT b = c; b <= PROJECTION_UNKNOWNS; ++b )
+            {
+                normal[r][b] -= factor * normal[c][b];
+            }
+        }
+    }
+
+    double solution[PROJECTION_UNKNOWNS + 1];
+    for( UINT a = 0; a < PROJECTION_UNKNOWNS; ++a )
+    {
+        solution[a] = normal[a][PROJECTION_UNKNOWNS] / normal[a][a];
+    }
+    solution[11] = solution[10];
+    solution[10] = 1.0;
+
+    // back to pixels
+    const double scales[3] = { static_cast<double>(width), static_cast<double>(height), 1.0 };
+    for( UINT r = 0; r < 3; ++r )
+    {
+        for( UINT c = 0; c < 4; ++c )
+        {
+            projection.m[r][c] = static_cast<float>( solution[r * 4 + c] * scales[r] );
+        }
+    }
+
+    // the sensor mapping may not be a projection at all
+    for( UINT i = 0; i < cPoints; ++i )
+    {
+        const Vector4& point = pPoints[i];
+        const float (&m)[3][4] = projection.m;
+        float w = m[2][0] * point.x + m[2][1] * point.y + m[2][2] * point.z + m[2][3];
+        float u = (m[0][0] * point.x + m[0][1] * point.y + m[0][2] * point.z + m[0][3]) / w;
+        float v = (m[1][0] * point.x + m[1][1] * point.y + m[1][2] * point.z + m[1][3]) / w;
+
+        if( fabs( u - pColorPoints[i].x ) > COLOR_PROJECTION_TOLERANCE || fabs( v - pColorPoints[i].y ) > COLOR_PROJECTION_TOLERANCE )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,43 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+#include "KinectCommonBridgeLib.h"
+
+// skeleton points projected natively into the depth and color images, 4 points at a time
+// depth uses the pinhole of NuiTransformSkeletonToDepthImage; color uses a 3x4 projection,
+// intrinsics and extrinsics of the color camera in one, fitted to points the sensor mapped
+class SkeletonProjector
+{
+public:
+    struct ColorProjection
+    {
+        // rows of the matrix, u = row0 . p / row2 . p, v = row1 . p / row2 . p with p = (x, y, z, 1)
+        float m[3][4];
+    };
+
+    static void ProjectToDepth( NUI_IMAGE_RESOLUTION eDepthResolution, UINT cPoints, _In_count_(cPoints) const Vector4* pPoints,
+        _Out_cap_(cPoints) NUI_DEPTH_IMAGE_POINT* pDepthPoints );
+
+    static void ProjectToColor( const ColorProjection& projection, UINT cPoints, _In_count_(cPoints) const Vector4* pPoints,
+        _Out_cap_(cPoints) NUI_COLOR_IMAGE_POINT* pColorPoints );
+
+    // points in view of both cameras to map with the sensor and fit to
+    static void GetCalibrationPoints( _Out_ std::vector<Vector4>& points );
+
+    // least squares fit of the mapped points, false when the projection does not match them within the tolerance
+    static bool FitColorProjection( NUI_IMAGE_RESOLUTION eColorResolution, UINT cPoints, _In_count_(cPoints) const Vector4* pPoints,
+        _In_count_(cPoints) const NUI_COLOR_IMAGE_POINT* pColorPoints, _Out_ ColorProjection& projection );
+};
@@ -0,0 +1,274 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "ActivityTracker.h"
+
+static const LONGLONG FRAME_MS = 33;
+
+// skeletons of a synthetic sequence, every one moves with its own speed
+struct Mover
+{
+    DWORD dwTrackingID;
+    float speed;                // m/s of the whole body along x
+    float waveSpeed;            // peak m/s of the right arm waving up and down
+    NUI_SKELETON_TRACKING_STATE eTrackingState;
+    float x;                    // where the body is, moved by every frame
+};
+
+static NUI_SKELETON_DATA MoveSkeleton( const Mover& mover, UINT frame )
+{
+    float seconds = frame * FRAME_MS / 1000.0f;
+    NUI_SKELETON_DATA skeleton = MakeSkeleton( mover.dwTrackingID, mover.x, 0.0f, 2.5f );
+
+    // a wave of 1 Hz, the elbow at half the amplitude of the wrist and hand
+    float wave = mover.waveSpeed / (2.0f * 3.14159265f) * sinf( 2.0f * 3.14159265f * seconds );
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_ELBOW_RIGHT].y += 0.5f * wave;
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_WRIST_RIGHT].y += wave;
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HAND_RIGHT].y += wave;
+
+    skeleton.eTrackingState = mover.eTrackingState;
+    return skeleton;
+}
+
+// adds a frame of the movers to the tracker, movers with id 0 keep moving but are left out
+static void AddFrame( ActivityTracker& tracker, _Inout_ Mover* pMovers, UINT cMovers, UINT frame )
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 1000 + frame * FRAME_MS, frame );
+    for( UINT i = 0; i < cMovers && i < NUI_SKELETON_COUNT; ++i )
+    {
+        if( 0 != pMovers[i].dwTrackingID )
+        {
+            skeletonFrame.SkeletonData[i] = MoveSkeleton( pMovers[i], frame );
+        }
+        pMovers[i].x += pMovers[i].speed * FRAME_MS / 1000.0f;
+    }
+    tracker.Update( skeletonFrame );
+}
+
+// the activity of a body moving at v converges to 1/2 v^2, a still one stays at 0
+static void TestKineticEnergy()
+{
+    ActivityTracker tracker;
+    Mover movers[] =
+    {
+        { 1, 1.0f, 0.0f, NUI_SKELETON_TRACKED },
+        { 2, 0.0f, 0.0f, NUI_SKELETON_TRACKED },
+        { 3, 2.0f, 0.0f, NUI_SKELETON_POSITION_ONLY },
+    };
+
+    for( UINT frame = 0; frame < 120; ++frame )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame );
+    }
+
+    KCB_CHECK_NEAR( tracker.GetActivity( 1 ), 0.5, 0.005 );
+    KCB_CHECK( 0.0f == tracker.GetActivity( 2 ) );
+    KCB_CHECK_NEAR( tracker.GetActivity( 3 ), 2.0, 0.02 );
+    KCB_CHECK( 0.0f == tracker.GetActivity( 4 ) );
+}
+
+// a joint that is not tracked does not count, however far it jumps
+static void TestUntrackedJoints()
+{
+    ActivityTracker tracker;
+    for( UINT frame = 0; frame < 30; ++frame )
+    {
+        NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( frame * FRAME_MS, frame );
+        NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[0];
+        skeleton = MakeSkeleton( 7, 0.0f, 0.0f, 2.0f );
+        skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HAND_LEFT].x += (frame & 1) ? 1.0f : -1.0f;
+        skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HAND_LEFT] = NUI_SKELETON_POSITION_NOT_TRACKED;
+        tracker.Update( skeletonFrame );
+    }
+
+    KCB_CHECK( 0.0f == tracker.GetActivity( 7 ) );
+}
+
+// the most active skeletons first, a waving arm counts
+static void TestChooseMostActive()
+{
+    ActivityTracker tracker;
+    Mover movers[] =
+    {
+        { 11, 0.0f, 0.0f, NUI_SKELETON_TRACKED },
+        { 12, 0.0f, 0.5f, NUI_SKELETON_TRACKED },
+        { 13, 0.0f, 2.0f, NUI_SKELETON_TRACKED },
+        { 14, 0.1f, 0.0f, NUI_SKELETON_POSITION_ONLY },
+    };
+
+    for( UINT frame = 0; frame < 60; ++frame )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame );
+    }
+
+    KCB_CHECK( tracker.GetActivity( 13 ) > tracker.GetActivity( 12 ) );
+    KCB_CHECK( tracker.GetActivity( 12 ) > tracker.GetActivity( 14 ) );
+    KCB_CHECK( tracker.GetActivity( 14 ) > tracker.GetActivity( 11 ) );
+
+    DWORD chosen[NUI_SKELETON_MAX_TRACKED_COUNT] = { 0 };
+    tracker.ChooseMostActive( chosen, NUI_SKELETON_MAX_TRACKED_COUNT );
+    KCB_CHECK( 13 == chosen[0] && 12 == chosen[1] );
+
+    DWORD one = 0;
+    tracker.ChooseMostActive( &one, 1 );
+    KCB_CHECK( 13 == one );
+}
+
+// a chosen skeleton is kept until another one is clearly more active
+static void TestHysteresis()
+{
+    ActivityTracker tracker;
+    Mover movers[] =
+    {
+        { 21, 1.0f, 0.0f, NUI_SKELETON_TRACKED },
+        { 22, 0.0f, 0.0f, NUI_SKELETON_TRACKED },
+    };
+
+    DWORD chosen = 0;
+    UINT frame = 0;
+    for( ; frame < 60; ++frame )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame );
+        tracker.ChooseMostActive( &chosen, 1 );
+    }
+    KCB_CHECK( 21 == chosen );
+
+    // 1.21 times the energy of the chosen one is not enough
+    movers[1].speed = 1.1f;
+    bool bKept = true;
+    for( ; frame < 160; ++frame )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame );
+        tracker.ChooseMostActive( &chosen, 1 );
+        bKept = bKept && (21 == chosen);
+    }
+    KCB_CHECK( bKept );
+    KCB_CHECK( tracker.GetActivity( 22 ) > tracker.GetActivity( 21 ) );
+
+    // 2.25 times is
+    movers[1].speed = 1.5f;
+    for( ; frame < 220; ++frame )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame );
+        tracker.ChooseMostActive( &chosen, 1 );
+    }
+    KCB_CHECK( 22 == chosen );
+}
+
+// a skeleton that leaves is not chosen, fades, keeps its slot for the grace period
+// when it comes back, and loses it after that
+static void TestDisappearing()
+{
+    ActivityTracker tracker;
+    Mover movers[] =
+    {
+        { 31, 1.0f, 0.0f, NUI_SKELETON_TRACKED },
+        { 32, 0.3f, 0.0f, NUI_SKELETON_TRACKED },
+    };
+
+    DWORD chosen = 0;
+    UINT frame = 0;
+    for( ; frame < 60; ++frame )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame );
+    }
+    tracker.ChooseMostActive( &chosen, 1 );
+    KCB_CHECK( 31 == chosen );
+
+    float before = tracker.GetActivity( 31 );
+    movers[0].dwTrackingID = 0;
+    AddFrame( tracker, movers, _countof(movers), frame++ );
+    tracker.ChooseMostActive( &chosen, 1 );
+    KCB_CHECK( 32 == chosen );
+    KCB_CHECK_NEAR( tracker.GetActivity( 31 ), before * ACTIVITY_DECAY, 1e-6 );
+
+    // back within the grace period, the activity picks up where it was
+    for( UINT i = 1; i < 10; ++i )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame++ );
+    }
+    float faded = tracker.GetActivity( 31 );
+    KCB_CHECK( faded > 0.0f && faded < before );
+
+    movers[0].dwTrackingID = 31;
+    AddFrame( tracker, movers, _countof(movers), frame++ );
+    KCB_CHECK( tracker.GetActivity( 31 ) > faded );
+
+    // gone for longer than the grace period
+    movers[0].dwTrackingID = 0;
+    for( UINT i = 0; i <= ACTIVITY_GRACE_FRAMES; ++i )
+    {
+        AddFrame( tracker, movers, _countof(movers), frame++ );
+    }
+    KCB_CHECK( 0.0f == tracker.GetActivity( 31 ) );
+    KCB_CHECK( tracker.GetActivity( 32 ) > 0.0f );
+}
+
+// new ids take the slots of the ones missed the longest, even before they free up
+static void TestSlotReuse()
+{
+    ActivityTracker tracker;
+    Mover movers[NUI_SKELETON_COUNT];
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        Mover mover = { 41 + i, 0.5f, 0.0f, NUI_SKELETON_TRACKED };
+        movers[i] = mover;
+    }
+
+    UINT frame = 0;
+    for( ; frame < 10; ++frame )
+    {
+        AddFrame( tracker, movers, NUI_SKELETON_COUNT, frame );
+    }
+
+    // a new crowd, the old one is still within the grace period
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        movers[i].dwTrackingID = 51 + i;
+    }
+    for( ; frame < 20; ++frame )
+    {
+        AddFrame( tracker, movers, NUI_SKELETON_COUNT, frame );
+    }
+
+    bool bNewTracked = true, bOldGone = true;
+    for( UINT i = 0; i < NUI_SKELETON_COUNT; ++i )
+    {
+        bNewTracked = bNewTracked && tracker.GetActivity( 51 + i ) > 0.0f;
+        bOldGone = bOldGone && 0.0f == tracker.GetActivity( 41 + i );
+    }
+    KCB_CHECK( bNewTracked );
+    KCB_CHECK( bOldGone );
+
+    // Reset forgets everything
+    tracker.Reset();
+    DWORD chosen[2] = { 1, 1 };
+    tracker.ChooseMostActive( chosen, 2 );
+    KCB_CHECK( 0 == chosen[0] && 0 == chosen[1] );
+    KCB_CHECK( 0.0f == tracker.GetActivity( 51 ) );
+}
+
+int main( int argc, char** argv )
+{
+    TestKineticEnergy();
+    TestUntrackedJoints();
+    TestChooseMostActive();
+    TestHysteresis();
+    TestDisappearing();
+    TestSlotReuse();
+
+    return ReportTestResult( "ActivityTrackerTests" );
+}
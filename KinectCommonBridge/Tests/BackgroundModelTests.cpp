@@ -0,0 +1,415 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "BackgroundModel.h"
+
+// a room with blobs moving in front of it, in millimeters
+struct Blob
+{
+    int x;
+    int y;
+    int dx;
+    int radius;
+    USHORT depth;
+};
+
+struct Scene
+{
+    UINT width;
+    UINT height;
+    std::vector<Blob> blobs;
+
+    Scene( UINT w, UINT h ) : width(w), height(h) {}
+
+    USHORT RoomDepth( UINT x, UINT y ) const
+    {
+        return static_cast<USHORT>( 3000 + x / 4 + y / 8 );
+    }
+
+    // depth of the nearest blob at x, y or 0
+    USHORT BlobDepth( UINT x, UINT y ) const
+    {
+        USHORT depth = 0;
+        for( size_t b = 0; b < blobs.size(); ++b )
+        {
+            int dx = static_cast<int>(x) - blobs[b].x, dy = static_cast<int>(y) - blobs[b].y;
+            if( dx * dx + dy * dy <= blobs[b].radius * blobs[b].radius && (0 == depth || blobs[b].depth < depth) )
+            {
+                depth = blobs[b].depth;
+            }
+        }
+        return depth;
+    }
+
+    // packed frame with sensor noise, player index 0 everywhere; the truth mask marks the blobs
+    void Render( TestRandom& random, _Out_ std::vector<USHORT>& packed, _Out_ std::vector<BYTE>& truth ) const
+    {
+        packed.resize( width * height );
+        truth.resize( width * height );
+        for( UINT y = 0; y < height; ++y )
+        {
+            for( UINT x = 0; x < width; ++x )
+            {
+                USHORT blob = BlobDepth( x, y );
+                int depth = static_cast<int>( ((0 != blob) ? blob : RoomDepth( x, y )) + random.Gaussian( 4.0f ) + 0.5f );
+                packed[y * width + x] = static_cast<USHORT>( depth << NUI_IMAGE_PLAYER_INDEX_SHIFT );
+                truth[y * width + x] = (0 != blob) ? 0xff : 0;
+            }
+        }
+    }
+
+    void Move()
+    {
+        for( size_t b = 0; b < blobs.size(); ++b )
+        {
+            blobs[b].x += blobs[b].dx;
+            if( blobs[b].x - blobs[b].radius < 0 || blobs[b].x + blobs[b].radius >= static_cast<int>(width) )
+            {
+                blobs[b].dx = -blobs[b].dx;
+            }
+        }
+    }
+};
+
+static void AddBlobs( Scene& scene )
+{
+    Blob walking = { static_cast<int>(scene.width) / 4, static_cast<int>(scene.height) / 2, 4, static_cast<int>(scene.height) / 5, 1500 };
+    Blob running = { static_cast<int>(scene.width) * 3 / 4, static_cast<int>(scene.height) / 3, -9, static_cast<int>(scene.height) / 8, 2200 };
+    scene.blobs.push_back( walking );
+    scene.blobs.push_back( running );
+}
+
+static void SetModel( BackgroundModel& model, USHORT learningStep )
+{
+    KINECT_BACKGROUND_MODEL params = { sizeof(KINECT_BACKGROUND_MODEL), learningStep, 0 };
+    model.SetParameters( &params );
+}
+
+static void Process( BackgroundModel& model, const Scene& scene, const std::vector<USHORT>& packed )
+{
+    model.Process( reinterpret_cast<const BYTE*>(packed.data()), scene.width * sizeof(USHORT), scene.width, scene.height, false );
+}
+
+// foreground pixels of the last frame, checks that the index list matches the mask
+static DWORD GetForeground( BackgroundModel& model, const Scene& scene, _Out_ std::vector<BYTE>& mask )
+{
+    ImageTransform transform;
+    KINECT_FOREGROUND_INFO info = { sizeof(KINECT_FOREGROUND_INFO) };
+    mask.assign( scene.width * scene.height, 0 );
+    std::vector<DWORD> indices( scene.width * scene.height );
+
+    KCB_CHECK_HR( model.GetResult( transform, &info, static_cast<ULONG>(mask.size()), mask.data(), static_cast<ULONG>(indices.size()), indices.data() ), S_OK );
+    KCB_CHECK( info.dwWidth == scene.width && info.dwHeight == scene.height );
+
+    DWORD cMarked = 0;
+    for( size_t i = 0; i < mask.size(); ++i )
+    {
+        cMarked += (0 != mask[i]) ? 1 : 0;
+    }
+
+    bool bIndicesMatch = (cMarked == info.cForegroundPixels);
+    for( DWORD i = 0; i < info.cForegroundPixels && bIndicesMatch; ++i )
+    {
+        bIndicesMatch = indices[i] < mask.size() && 0 != mask[indices[i]] && (0 == i || indices[i] > indices[i - 1]);
+    }
+    KCB_CHECK( bIndicesMatch );
+
+    return info.cForegroundPixels;
+}
+
+// pixels where mask and truth disagree
+static void Compare( const std::vector<BYTE>& mask, const std::vector<BYTE>& truth, _Out_ UINT& cMissed, _Out_ UINT& cFalse )
+{
+    cMissed = 0;
+    cFalse = 0;
+    for( size_t i = 0; i < mask.size(); ++i )
+    {
+        cMissed += (0 != truth[i] && 0 == mask[i]) ? 1 : 0;
+        cFalse += (0 == truth[i] && 0 != mask[i]) ? 1 : 0;
+    }
+}
+
+// an empty room never has foreground, the noise is far below the threshold
+static void TestEmptyRoom()
+{
+    Scene scene( 643, 97 );
+    TestRandom random( 1 );
+    BackgroundModel model;
+    SetModel( model, 0 );
+
+    std::vector<USHORT> packed;
+    std::vector<BYTE> truth, mask;
+    DWORD cForeground = 0;
+    for( int frame = 0; frame < 30; ++frame )
+    {
+        scene.Render( random, packed, truth );
+        Process( model, scene, packed );
+        cForeground += GetForeground( model, scene, mask );
+    }
+    KCB_CHECK( 0 == cForeground );
+}
+
+// blobs entering a learned room are foreground in every frame, without false pixels
+static void TestMovingBlobs()
+{
+    Scene scene( 643, 97 );
+    TestRandom random( 2 );
+    BackgroundModel model;
+    SetModel( model, 0 );
+
+    std::vector<USHORT> packed;
+    std::vector<BYTE> truth, mask;
+    for( int frame = 0; frame < 10; ++frame )
+    {
+        scene.Render( random, packed, truth );
+        Process( model, scene, packed );
+    }
+
+    AddBlobs( scene );
+    UINT cMissed = 0, cFalse = 0, cTruth = 0;
+    for( int frame = 0; frame < 100; ++frame )
+    {
+        scene.Render( random, packed, truth );
+        Process( model, scene, packed );
+        GetForeground( model, scene, mask );
+
+        UINT cFrameMissed = 0, cFrameFalse = 0;
+        Compare( mask, truth, cFrameMissed, cFrameFalse );
+        cMissed += cFrameMissed;
+        cFalse += cFrameFalse;
+        for( size_t i = 0; i < truth.size(); ++i )
+        {
+            cTruth += (0 != truth[i]) ? 1 : 0;
+        }
+
+        scene.Move();
+    }
+
+    printf( "moving blobs: %u foreground pixels, %u missed, %u false\n", cTruth, cMissed, cFalse );
+    KCB_CHECK( cTruth > 0 );
+    KCB_CHECK( 0 == cMissed );
+    KCB_CHECK( 0 == cFalse );
+}
+
+// a blob in the first frame is learned as background, the room behind it is taken
+// as soon as the blob moves away, so the blob is foreground when it comes back
+static void TestUncoveredBackground()
+{
+    Scene scene( 160, 120 );
+    Blob blob = { 40, 60, 60, 20, 1500 };
+    scene.blobs.push_back( blob );
+    TestRandom random( 3 );
+    BackgroundModel model;
+    SetModel( model, 0 );
+
+    std::vector<USHORT> packed;
+    std::vector<BYTE> truth, mask;
+    scene.Render( random, packed, truth );
+    Process( model, scene, packed );
+    KCB_CHECK( 0 == GetForeground( model, scene, mask ) );
+
+    // away from its old place, and back for a frame
+    scene.Move();
+    scene.Render( random, packed, truth );
+    Process( model, scene, packed );
+
+    scene.blobs[0].x = blob.x;
+    scene.Render( random, packed, truth );
+    Process( model, scene, packed );
+    GetForeground( model, scene, mask );
+
+    UINT cMissed = 0, cFalse = 0;
+    Compare( mask, truth, cMissed, cFalse );
+    KCB_CHECK( 0 == cMissed );
+    KCB_CHECK( 0 == cFalse );
+}
+
+// a blob that stands still is absorbed while learning, stays foreground while frozen,
+// and a reset starts over from the next frame
+static void TestFreezeAndReset()
+{
+    Scene scene( 160, 120 );
+    TestRandom random( 4 );
+    BackgroundModel model;
+    SetModel( model, 50 );
+
+    std::vector<USHORT> packed;
+    std::vector<BYTE> truth, mask;
+    scene.Render( random, packed, truth );
+    Process( model, scene, packed );
+
+    Blob blob = { 80, 60, 0, 25, 1500 };
+    scene.blobs.push_back( blob );
+    scene.Render( random, packed, truth );
+    DWORD cBlob = 0;
+    for( size_t i = 0; i < truth.size(); ++i )
+    {
+        cBlob += (0 != truth[i]) ? 1 : 0;
+    }
+
+    // 1.5 m in front of the room at 50 mm per frame, frozen it stays foreground
+    model.Freeze( true );
+    for( int frame = 0; frame < 40; ++frame )
+    {
+        scene.Render( random, packed, truth );
+        Process( model, scene, packed );
+    }
+    KCB_CHECK( cBlob == GetForeground( model, scene, mask ) );
+
+    KINECT_FOREGROUND_INFO info = { sizeof(KINECT_FOREGROUND_INFO) };
+    ImageTransform transform;
+    KCB_CHECK_HR( model.GetResult( transform, &info, 0, nullptr, 0, nullptr ), S_OK );
+    KCB_CHECK( info.bFrozen );
+
+    model.Freeze( false );
+    for( int frame = 0; frame < 40; ++frame )
+    {
+        scene.Render( random, packed, truth );
+        Process( model, scene, packed );
+    }
+    KCB_CHECK( 0 == GetForeground( model, scene, mask ) );
+
+    // after a reset the frame with the blob is the background, the empty room is behind it
+    model.Reset();
+    KCB_CHECK_HR( model.GetResult( transform, &info, 0, nullptr, 0, nullptr ), E_NUI_FRAME_NO_DATA );
+    Process( model, scene, packed );
+    KCB_CHECK( 0 == GetForeground( model, scene, mask ) );
+
+    scene.blobs.clear();
+    scene.Render( random, packed, truth );
+    Process( model, scene, packed );
+    KCB_CHECK( 0 == GetForeground( model, scene, mask ) );
+}
+
+// NUI_DEPTH_IMAGE_PIXEL frames give the same result as packed ones, and buffers are checked
+static void TestPixelFormat()
+{
+    Scene scene( 643, 97 );
+    TestRandom random( 5 );
+    BackgroundModel packedModel, pixelModel;
+    SetModel( packedModel, 0 );
+    SetModel( pixelModel, 0 );
+
+    std::vector<USHORT> packed;
+    std::vector<BYTE> truth;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels( scene.width * scene.height );
+
+    bool bSame = true;
+    for( int frame = 0; frame < 20; ++frame )
+    {
+        if( 5 == frame )
+        {
+            AddBlobs( scene );
+        }
+
+        scene.Render( random, packed, truth );
+        for( size_t i = 0; i < packed.size(); ++i )
+        {
+            pixels[i].playerIndex = 0;
+            pixels[i].depth = packed[i] >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+        }
+
+        Process( packedModel, scene, packed );
+        pixelModel.Process( reinterpret_cast<const BYTE*>(pixels.data()), scene.width * sizeof(NUI_DEPTH_IMAGE_PIXEL), scene.width, scene.height, true );
+
+        std::vector<BYTE> packedMask, pixelMask;
+        DWORD cPacked = GetForeground( packedModel, scene, packedMask );
+        DWORD cPixel = GetForeground( pixelModel, scene, pixelMask );
+        bSame = bSame && cPacked == cPixel && packedMask == pixelMask;
+
+        scene.Move();
+    }
+    KCB_CHECK( bSame );
+
+    KINECT_FOREGROUND_INFO info = { sizeof(KINECT_FOREGROUND_INFO) };
+    ImageTransform transform;
+    std::vector<BYTE> mask( scene.width * scene.height );
+    KCB_CHECK_HR( packedModel.GetResult( transform, &info, static_cast<ULONG>(mask.size()) - 1, mask.data(), 0, nullptr ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+    KCB_CHECK( info.cForegroundPixels > 0 );
+
+    std::vector<DWORD> indices( info.cForegroundPixels - 1 );
+    KCB_CHECK_HR( packedModel.GetResult( transform, &info, 0, nullptr, static_cast<ULONG>(indices.size()), indices.data() ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+
+    BackgroundModel disabled;
+    KCB_CHECK_HR( disabled.GetResult( transform, &info, 0, nullptr, 0, nullptr ), E_NUI_FRAME_NO_DATA );
+}
+
+static void BenchmarkMovingBlobs( UINT width, UINT height, bool bPixels )
+{
+    Scene scene( width, height );
+    AddBlobs( scene );
+    TestRandom random( 6 );
+
+    // the frames are rendered up front, the time is the model alone
+    const int cFrames = 30;
+    std::vector<std::vector<USHORT>> frames( cFrames );
+    std::vector<std::vector<NUI_DEPTH_IMAGE_PIXEL>> pixelFrames( cFrames );
+    std::vector<BYTE> truth;
+    for( int frame = 0; frame < cFrames; ++frame )
+    {
+        scene.Render( random, frames[frame], truth );
+        pixelFrames[frame].resize( width * height );
+        for( size_t i = 0; i < frames[frame].size(); ++i )
+        {
+            pixelFrames[frame][i].playerIndex = 0;
+            pixelFrames[frame][i].depth = frames[frame][i] >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+        }
+        scene.Move();
+    }
+
+    BackgroundModel model;
+    SetModel( model, 0 );
+
+    const int cRuns = 10;
+    Stopwatch time;
+    for( int run = 0; run < cRuns; ++run )
+    {
+        for( int frame = 0; frame < cFrames; ++frame )
+        {
+            if( bPixels )
+            {
+                model.Process( reinterpret_cast<const BYTE*>(pixelFrames[frame].data()), width * sizeof(NUI_DEPTH_IMAGE_PIXEL), width, height, true );
+            }
+            else
+            {
+                model.Process( reinterpret_cast<const BYTE*>(frames[frame].data()), width * sizeof(USHORT), width, height, false );
+            }
+        }
+    }
+    double frameUs = time.ElapsedMicroseconds() / (cRuns * cFrames);
+
+    printf( "background model %ux%u %s, moving blobs: %.0f us per frame\n", width, height, bPixels ? "pixels" : "packed", frameUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestEmptyRoom();
+    TestMovingBlobs();
+    TestUncoveredBackground();
+    TestFreezeAndReset();
+    TestPixelFormat();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkMovingBlobs( 640, 480, false );
+        BenchmarkMovingBlobs( 640, 480, true );
+        BenchmarkMovingBlobs( 320, 240, false );
+    }
+
+    return ReportTestResult( "BackgroundModelTests" );
+}
@@ -0,0 +1,343 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "BoneOrientations.h"
+
+#include <math.h>
+
+static const float AXIS_X[3] = { 1.0f, 0.0f, 0.0f };
+static const float AXIS_Y[3] = { 0.0f, 1.0f, 0.0f };
+static const float AXIS_Z[3] = { 0.0f, 0.0f, 1.0f };
+static const float AXIS_NEGATIVE_X[3] = { -1.0f, 0.0f, 0.0f };
+static const float AXIS_NEGATIVE_Y[3] = { 0.0f, -1.0f, 0.0f };
+
+// the rows of the matrix are the X, Y and Z axes of the bone
+static void CheckAxes( const NUI_SKELETON_BONE_ROTATION& rotation, const float x[3], const float y[3], const float z[3] )
+{
+    const Matrix4& m = rotation.rotationMatrix;
+    KCB_CHECK_NEAR( m.M11, x[0], 1e-4 ); KCB_CHECK_NEAR( m.M12, x[1], 1e-4 ); KCB_CHECK_NEAR( m.M13, x[2], 1e-4 );
+    KCB_CHECK_NEAR( m.M21, y[0], 1e-4 ); KCB_CHECK_NEAR( m.M22, y[1], 1e-4 ); KCB_CHECK_NEAR( m.M23, y[2], 1e-4 );
+    KCB_CHECK_NEAR( m.M31, z[0], 1e-4 ); KCB_CHECK_NEAR( m.M32, z[1], 1e-4 ); KCB_CHECK_NEAR( m.M33, z[2], 1e-4 );
+}
+
+static bool IsIdentity( const NUI_SKELETON_BONE_ROTATION& rotation )
+{
+    const Matrix4& m = rotation.rotationMatrix;
+    return fabsf( m.M11 - 1.0f ) < 1e-5f && fabsf( m.M22 - 1.0f ) < 1e-5f && fabsf( m.M33 - 1.0f ) < 1e-5f
+        && fabsf( rotation.rotationQuaternion.w - 1.0f ) < 1e-5f;
+}
+
+static bool IsSame( const NUI_SKELETON_BONE_ROTATION& a, const NUI_SKELETON_BONE_ROTATION& b )
+{
+    const float* pA = &a.rotationMatrix.M11;
+    const float* pB = &b.rotationMatrix.M11;
+    for( UINT i = 0; i < 16; ++i )
+    {
+        if( fabsf( pA[i] - pB[i] ) > 1e-5f )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// every bone of a tracked skeleton: the Y axis runs along the bone, the axes are orthonormal and
+// right handed, the quaternion is the matrix, and the hierarchical rotation takes the parent to it
+static void CheckSkeleton( _In_ const NUI_SKELETON_DATA& skeleton, _In_count_(NUI_SKELETON_POSITION_COUNT) const NUI_SKELETON_BONE_ORIENTATION* pOrientations )
+{
+    UINT cAlong = 0, cOrthonormal = 0, cQuaternion = 0, cHierarchy = 0;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        const NUI_SKELETON_BONE_ORIENTATION& orientation = pOrientations[j];
+        KCB_CHECK( j == static_cast<UINT>(orientation.endJoint) && SKELETON_PARENT_JOINTS[j] == orientation.startJoint );
+
+        const Matrix4& m = orientation.absoluteRotation.rotationMatrix;
+        float axes[3][3] = { { m.M11, m.M12, m.M13 }, { m.M21, m.M22, m.M23 }, { m.M31, m.M32, m.M33 } };
+
+        if( NUI_SKELETON_POSITION_HIP_CENTER != j )
+        {
+            const Vector4& start = skeleton.SkeletonPositions[SKELETON_PARENT_JOINTS[j]];
+            const Vector4& end = skeleton.SkeletonPositions[j];
+            float bone[3] = { end.x - start.x, end.y - start.y, end.z - start.z };
+            float length = sqrtf( bone[0] * bone[0] + bone[1] * bone[1] + bone[2] * bone[2] );
+            bool bAlong = true;
+            for( UINT i = 0; i < 3; ++i )
+            {
+                bAlong = bAlong && fabsf( axes[1][i] - bone[i] / length ) < 1e-4f;
+            }
+            cAlong += bAlong ? 1 : 0;
+        }
+
+        bool bOrthonormal = true;
+        for( UINT a = 0; a < 3; ++a )
+        {
+            for( UINT b = 0; b < 3; ++b )
+            {
+                float dot = axes[a][0] * axes[b][0] + axes[a][1] * axes[b][1] + axes[a][2] * axes[b][2];
+                bOrthonormal = bOrthonormal && fabsf( dot - (a == b ? 1.0f : 0.0f) ) < 1e-4f;
+            }
+        }
+        float determinant = axes[0][0] * (axes[1][1] * axes[2][2] - axes[1][2] * axes[2][1])
+                          - axes[0][1] * (axes[1][0] * axes[2][2] - axes[1][2] * axes[2][0])
+                          + axes[0][2] * (axes[1][0] * axes[2][1] - axes[1][1] * axes[2][0]);
+        cOrthonormal += (bOrthonormal && fabsf( determinant - 1.0f ) < 1e-4f) ? 1 : 0;
+
+        const Vector4& q = orientation.absoluteRotation.rotationQuaternion;
+        cQuaternion += (fabsf( m.M11 - (1.0f - 2.0f * (q.y * q.y + q.z * q.z)) ) < 1e-4f
+                     && fabsf( m.M12 - 2.0f * (q.x * q.y + q.w * q.z) ) < 1e-4f
+                     && fabsf( m.M23 - 2.0f * (q.y * q.z + q.w * q.x) ) < 1e-4f) ? 1 : 0;
+
+        // the absolute axes are the hierarchical ones in the axes of the parent
+        const Matrix4& parent = pOrientations[SKELETON_PARENT_JOINTS[j]].absoluteRotation.rotationMatrix;
+        const Matrix4& local = orientation.hierarchicalRotation.rotationMatrix;
+        bool bHierarchy = true;
+        if( NUI_SKELETON_POSITION_HIP_CENTER == j )
+        {
+            bHierarchy = IsSame( orientation.hierarchicalRotation, orientation.absoluteRotation );
+        }
+        else
+        {
+            const float* pLocal = &local.M11;
+            const float* pParent = &parent.M11;
+            for( UINT r = 0; r < 3; ++r )
+            {
+                for( UINT c = 0; c < 3; ++c )
+                {
+                    float product = pLocal[r * 4] * pParent[c] + pLocal[r * 4 + 1] * pParent[4 + c] + pLocal[r * 4 + 2] * pParent[8 + c];
+                    bHierarchy = bHierarchy && fabsf( product - axes[r][c] ) < 1e-4f;
+                }
+            }
+        }
+        cHierarchy += bHierarchy ? 1 : 0;
+    }
+
+    KCB_CHECK( NUI_SKELETON_POSITION_COUNT - 1 == cAlong );
+    KCB_CHECK( NUI_SKELETON_POSITION_COUNT == cOrthonormal );
+    KCB_CHECK( NUI_SKELETON_POSITION_COUNT == cQuaternion );
+    KCB_CHECK( NUI_SKELETON_POSITION_COUNT == cHierarchy );
+}
+
+// the T-pose facing the sensor: the body is the camera axes, the arms are turned a quarter
+// around Z and the legs half a turn
+static void TestTPose()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 0, 0 );
+    skeletonFrame.SkeletonData[0] = MakeSkeleton( 1, 0.0f, 0.0f, 2.0f );
+    skeletonFrame.SkeletonData[5] = MakeSkeleton( 2, -1.0f, 0.2f, 3.0f );
+
+    BoneOrientations orientations;
+    NUI_SKELETON_BONE_ORIENTATION bones[NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT];
+    orientations.GetBoneOrientations( skeletonFrame, bones );
+
+    const UINT slots[] = { 0, 5 };
+    for( UINT i = 0; i < _countof(slots); ++i )
+    {
+        const NUI_SKELETON_BONE_ORIENTATION* pBones = bones + slots[i] * NUI_SKELETON_POSITION_COUNT;
+        CheckSkeleton( skeletonFrame.SkeletonData[slots[i]], pBones );
+
+        CheckAxes( pBones[NUI_SKELETON_POSITION_HIP_CENTER].absoluteRotation, AXIS_X, AXIS_Y, AXIS_Z );
+        CheckAxes( pBones[NUI_SKELETON_POSITION_SPINE].absoluteRotation, AXIS_X, AXIS_Y, AXIS_Z );
+        CheckAxes( pBones[NUI_SKELETON_POSITION_HEAD].absoluteRotation, AXIS_X, AXIS_Y, AXIS_Z );
+
+        // the left arm along -x, the right one along +x
+        CheckAxes( pBones[NUI_SKELETON_POSITION_ELBOW_LEFT].absoluteRotation, AXIS_Y, AXIS_NEGATIVE_X, AXIS_Z );
+        CheckAxes( pBones[NUI_SKELETON_POSITION_HAND_LEFT].absoluteRotation, AXIS_Y, AXIS_NEGATIVE_X, AXIS_Z );
+        CheckAxes( pBones[NUI_SKELETON_POSITION_ELBOW_RIGHT].absoluteRotation, AXIS_NEGATIVE_Y, AXIS_X, AXIS_Z );
+        CheckAxes( pBones[NUI_SKELETON_POSITION_HAND_RIGHT].absoluteRotation, AXIS_NEGATIVE_Y, AXIS_X, AXIS_Z );
+
+        // straight on down the leg
+        CheckAxes( pBones[NUI_SKELETON_POSITION_KNEE_LEFT].absoluteRotation, AXIS_NEGATIVE_X, AXIS_NEGATIVE_Y, AXIS_Z );
+        CheckAxes( pBones[NUI_SKELETON_POSITION_ANKLE_RIGHT].absoluteRotation, AXIS_NEGATIVE_X, AXIS_NEGATIVE_Y, AXIS_Z );
+        KCB_CHECK( IsIdentity( pBones[NUI_SKELETON_POSITION_WRIST_LEFT].hierarchicalRotation ) );
+        KCB_CHECK( IsIdentity( pBones[NUI_SKELETON_POSITION_ANKLE_LEFT].hierarchicalRotation ) );
+    }
+
+    // skeletons that are not tracked are the camera axes
+    bool bIdentity = true;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        bIdentity = bIdentity && IsIdentity( bones[2 * NUI_SKELETON_POSITION_COUNT + j].absoluteRotation );
+        bIdentity = bIdentity && IsIdentity( bones[2 * NUI_SKELETON_POSITION_COUNT + j].hierarchicalRotation );
+    }
+    KCB_CHECK( bIdentity );
+}
+
+// a person turned a quarter, the right side toward the sensor: the hip center turns with them
+static void TestTurned()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 0, 0 );
+    NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[3];
+    skeleton = MakeSkeleton( 1, 0.0f, 0.0f, 2.0f );
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        Vector4& v = skeleton.SkeletonPositions[j];
+        v = MakeVector( TEST_T_POSE[j][2], v.y, 2.0f - TEST_T_POSE[j][0] );
+    }
+
+    BoneOrientations orientations;
+    NUI_SKELETON_BONE_ORIENTATION bones[NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT];
+    orientations.GetBoneOrientations( skeletonFrame, bones );
+
+    const NUI_SKELETON_BONE_ORIENTATION* pBones = bones + 3 * NUI_SKELETON_POSITION_COUNT;
+    CheckSkeleton( skeleton, pBones );
+
+    const float axisNegativeZ[3] = { 0.0f, 0.0f, -1.0f };
+    CheckAxes( pBones[NUI_SKELETON_POSITION_HIP_CENTER].absoluteRotation, axisNegativeZ, AXIS_Y, AXIS_X );
+    CheckAxes( pBones[NUI_SKELETON_POSITION_ELBOW_RIGHT].absoluteRotation, AXIS_NEGATIVE_Y, axisNegativeZ, AXIS_X );
+    KCB_CHECK( IsIdentity( pBones[NUI_SKELETON_POSITION_SPINE].hierarchicalRotation ) );
+}
+
+// the right forearm raised straight up: the elbow is at 90 degrees, the forearm bone is the
+// camera axes again, a quarter turn around Z from the upper arm
+static void TestBentElbow()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 0, 0 );
+    NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[4];
+    skeleton = MakeSkeleton( 1, 0.0f, 0.0f, 2.0f );
+    Vector4 elbow = skeleton.SkeletonPositions[NUI_SKELETON_POSITION_ELBOW_RIGHT];
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_WRIST_RIGHT] = MakeVector( elbow.x, elbow.y + 0.25f, elbow.z );
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HAND_RIGHT] = MakeVector( elbow.x, elbow.y + 0.35f, elbow.z );
+    skeletonFrame.SkeletonData[1] = MakeSkeleton( 2, 1.0f, 0.0f, 2.0f );
+
+    BoneOrientations orientations;
+    NUI_SKELETON_BONE_ORIENTATION bones[NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT];
+    orientations.GetBoneOrientations( skeletonFrame, bones );
+
+    const NUI_SKELETON_BONE_ORIENTATION* pBones = bones + 4 * NUI_SKELETON_POSITION_COUNT;
+    CheckSkeleton( skeleton, pBones );
+    CheckAxes( pBones[NUI_SKELETON_POSITION_WRIST_RIGHT].absoluteRotation, AXIS_X, AXIS_Y, AXIS_Z );
+    CheckAxes( pBones[NUI_SKELETON_POSITION_WRIST_RIGHT].hierarchicalRotation, AXIS_Y, AXIS_NEGATIVE_X, AXIS_Z );
+    KCB_CHECK( IsIdentity( pBones[NUI_SKELETON_POSITION_HAND_RIGHT].hierarchicalRotation ) );
+
+    const KINECT_JOINT_ANGLE angles[] =
+    {
+        { NUI_SKELETON_POSITION_SHOULDER_RIGHT, NUI_SKELETON_POSITION_ELBOW_RIGHT, NUI_SKELETON_POSITION_WRIST_RIGHT },
+        { NUI_SKELETON_POSITION_SHOULDER_LEFT, NUI_SKELETON_POSITION_ELBOW_LEFT, NUI_SKELETON_POSITION_WRIST_LEFT },
+        { NUI_SKELETON_POSITION_HIP_LEFT, NUI_SKELETON_POSITION_HIP_CENTER, NUI_SKELETON_POSITION_HIP_RIGHT },
+        { NUI_SKELETON_POSITION_ELBOW_LEFT, NUI_SKELETON_POSITION_SHOULDER_LEFT, NUI_SKELETON_POSITION_HIP_LEFT },
+    };
+    KCB_CHECK_HR( orientations.SetJointAngles( _countof(angles), angles ), S_OK );
+    KCB_CHECK( _countof(angles) == orientations.GetJointAngleCount() );
+
+    float values[NUI_SKELETON_COUNT * _countof(angles)];
+    orientations.GetJointAngles( skeletonFrame, values );
+
+    const float* pValues = values + 4 * _countof(angles);
+    KCB_CHECK_NEAR( pValues[0], 90.0, 1e-3 );
+    KCB_CHECK_NEAR( pValues[1], 180.0, 1e-3 );
+    KCB_CHECK_NEAR( pValues[2], 180.0 - 2.0 * atan( 0.05 / 0.1 ) * 180.0 / 3.14159265, 1e-3 );
+    KCB_CHECK_NEAR( values[1 * _countof(angles)], 180.0, 1e-3 );
+    KCB_CHECK_NEAR( values[1 * _countof(angles) + 3], 180.0 - atan2( 0.6, 0.1 ) * 180.0 / 3.14159265, 1e-3 );
+
+    // the skeletons that are not tracked and the joints that are not are NaN
+    skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_WRIST_RIGHT] = NUI_SKELETON_POSITION_NOT_TRACKED;
+    orientations.GetJointAngles( skeletonFrame, values );
+    KCB_CHECK( pValues[0] != pValues[0] );
+    KCB_CHECK_NEAR( pValues[1], 180.0, 1e-3 );
+    KCB_CHECK( values[0] != values[0] && values[5 * _countof(angles) + 2] != values[5 * _countof(angles) + 2] );
+}
+
+// bones with a joint that is not tracked keep the orientation of their parent
+static void TestNotTracked()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 0, 0 );
+    NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[0];
+    skeleton = MakeSkeleton( 1, 0.0f, 0.0f, 2.0f );
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_WRIST_LEFT] = MakeVector( 5.0f, 5.0f, 5.0f );
+    skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_WRIST_LEFT] = NUI_SKELETON_POSITION_NOT_TRACKED;
+    skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HIP_RIGHT] = NUI_SKELETON_POSITION_NOT_TRACKED;
+
+    BoneOrientations orientations;
+    NUI_SKELETON_BONE_ORIENTATION bones[NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT];
+    orientations.GetBoneOrientations( skeletonFrame, bones );
+
+    KCB_CHECK( IsSame( bones[NUI_SKELETON_POSITION_WRIST_LEFT].absoluteRotation, bones[NUI_SKELETON_POSITION_ELBOW_LEFT].absoluteRotation ) );
+    KCB_CHECK( IsSame( bones[NUI_SKELETON_POSITION_HAND_LEFT].absoluteRotation, bones[NUI_SKELETON_POSITION_ELBOW_LEFT].absoluteRotation ) );
+    KCB_CHECK( IsIdentity( bones[NUI_SKELETON_POSITION_HAND_LEFT].hierarchicalRotation ) );
+
+    // without the hips the root is the camera axes
+    KCB_CHECK( IsIdentity( bones[NUI_SKELETON_POSITION_HIP_CENTER].absoluteRotation ) );
+    CheckAxes( bones[NUI_SKELETON_POSITION_ELBOW_RIGHT].absoluteRotation, AXIS_NEGATIVE_Y, AXIS_X, AXIS_Z );
+}
+
+static void TestSetJointAngles()
+{
+    BoneOrientations orientations;
+    KINECT_JOINT_ANGLE angles[BONE_MAX_JOINT_ANGLES + 1];
+    for( UINT i = 0; i < _countof(angles); ++i )
+    {
+        KINECT_JOINT_ANGLE angle = { NUI_SKELETON_POSITION_SHOULDER_LEFT, NUI_SKELETON_POSITION_ELBOW_LEFT, NUI_SKELETON_POSITION_WRIST_LEFT };
+        angles[i] = angle;
+    }
+
+    KCB_CHECK_HR( orientations.SetJointAngles( BONE_MAX_JOINT_ANGLES + 1, angles ), E_INVALIDARG );
+    KCB_CHECK_HR( orientations.SetJointAngles( BONE_MAX_JOINT_ANGLES, angles ), S_OK );
+    KCB_CHECK( BONE_MAX_JOINT_ANGLES == orientations.GetJointAngleCount() );
+
+    // a bad angle leaves the ones set alone
+    angles[1].eCenterJoint = NUI_SKELETON_POSITION_SHOULDER_LEFT;
+    KCB_CHECK_HR( orientations.SetJointAngles( 2, angles ), E_INVALIDARG );
+    angles[1].eCenterJoint = NUI_SKELETON_POSITION_COUNT;
+    KCB_CHECK_HR( orientations.SetJointAngles( 2, angles ), E_INVALIDARG );
+    KCB_CHECK( BONE_MAX_JOINT_ANGLES == orientations.GetJointAngleCount() );
+
+    KCB_CHECK_HR( orientations.SetJointAngles( 5, nullptr ), S_OK );
+    KCB_CHECK( 0 == orientations.GetJointAngleCount() );
+}
+
+static void BenchmarkOrientations()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 0, 0 );
+    TestRandom random( 47 );
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        skeletonFrame.SkeletonData[s] = MakeSkeleton( s + 1, random.Symmetric( 1.0f ), 0.0f, 2.5f );
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            skeletonFrame.SkeletonData[s].SkeletonPositions[j].x += random.Gaussian( 0.02f );
+            skeletonFrame.SkeletonData[s].SkeletonPositions[j].z += random.Gaussian( 0.02f );
+        }
+    }
+
+    BoneOrientations orientations;
+    NUI_SKELETON_BONE_ORIENTATION bones[NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT];
+
+    const UINT cRuns = 20000;
+    Stopwatch time;
+    for( UINT run = 0; run < cRuns; ++run )
+    {
+        skeletonFrame.SkeletonData[run % NUI_SKELETON_COUNT].SkeletonPositions[NUI_SKELETON_POSITION_HAND_LEFT].y += 1e-6f;
+        orientations.GetBoneOrientations( skeletonFrame, bones );
+    }
+
+    printf( "bone orientations: %.2f us per frame of %u skeletons\n", time.ElapsedMicroseconds() / cRuns, NUI_SKELETON_COUNT );
+}
+
+int main( int argc, char** argv )
+{
+    TestTPose();
+    TestTurned();
+    TestBentElbow();
+    TestNotTracked();
+    TestSetJointAngles();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkOrientations();
+    }
+
+    return ReportTestResult( "BoneOrientationsTests" );
+}
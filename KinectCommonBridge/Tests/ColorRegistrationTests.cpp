@@ -0,0 +1,186 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "ColorRegistration.h"
+
+#include <vector>
+
+// rows of a band, as DataStreamColor registers them
+static const size_t BAND_ROWS = 32;
+
+// mapping of a color frame to depth like the coordinate mapper gives it: the depth image is
+// shifted and slightly scaled, points without depth are out of the image
+static std::vector<NUI_DEPTH_IMAGE_POINT> MakeDepthPoints( ULONG width, ULONG height, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<NUI_DEPTH_IMAGE_POINT> points( width * height );
+
+    for( ULONG y = 0; y < height; ++y )
+    {
+        for( ULONG x = 0; x < width; ++x )
+        {
+            NUI_DEPTH_IMAGE_POINT& point = points[y * width + x];
+            point.x = static_cast<LONG>( x * 0.95f ) + static_cast<LONG>( width / 50 );
+            point.y = static_cast<LONG>( y * 0.95f ) + static_cast<LONG>( height / 50 );
+            point.depth = 2000;
+            point.reserved = 0;
+
+            // no depth, the points the mapper could not map lie below or above the image
+            if( 0 == random.Next() % 10 )
+            {
+                point.y = (random.Next() & 1) ? -1 - static_cast<LONG>( random.Next() % 100 ) : static_cast<LONG>( height + random.Next() % 100 );
+            }
+        }
+    }
+
+    return points;
+}
+
+static std::vector<BYTE> MakeColor( ULONG width, ULONG height, ULONG bpp, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<BYTE> color( width * height * bpp );
+    for( size_t i = 0; i < color.size(); ++i )
+    {
+        color[i] = static_cast<BYTE>( random.Next() );
+    }
+    return color;
+}
+
+// the per byte copy the band kernel replaced, one color pixel per depth point and a bounds check of the
+// buffers for every byte
+static void RegisterPerByte( _In_ const BYTE* pSrc, size_t cbSrc, _In_ const NUI_DEPTH_IMAGE_POINT* pDepthPoints, size_t cPoints,
+    ULONG width, ULONG bpp, _Inout_ BYTE* pDst, size_t cbDst )
+{
+    size_t dwByteWidthTotal = width * bpp;
+
+    for( size_t index = 0; index < cPoints; ++index )
+    {
+        NUI_DEPTH_IMAGE_POINT depthPoint = pDepthPoints[index];
+
+        size_t imageBufferOffset = depthPoint.y * dwByteWidthTotal + (depthPoint.x * bpp);
+        size_t colorBufferOffset = index * bpp;
+
+        if( imageBufferOffset + bpp <= cbDst && colorBufferOffset + bpp <= cbSrc )
+        {
+            for( size_t i = 0; i < bpp; ++i )
+            {
+                pDst[imageBufferOffset + i] = pSrc[colorBufferOffset + i];
+            }
+        }
+    }
+}
+
+static void RegisterBands( _In_ const BYTE* pSrc, _In_ const NUI_DEPTH_IMAGE_POINT* pDepthPoints, ULONG width, ULONG height, ULONG bpp, _Inout_ BYTE* pDst )
+{
+    const size_t cPoints = width * height;
+    const size_t bandSize = width * BAND_ROWS;
+
+    for( size_t begin = 0; begin < cPoints; begin += bandSize )
+    {
+        ColorRegistration::RegisterBand( begin, min( begin + bandSize, cPoints ), bpp, pSrc, pDepthPoints, width, height, pDst );
+    }
+}
+
+// every pixel size gives the image of the per byte copy
+static void TestMatchesPerByte( ULONG width, ULONG height, ULONG bpp )
+{
+    std::vector<NUI_DEPTH_IMAGE_POINT> points = MakeDepthPoints( width, height, width + bpp );
+    std::vector<BYTE> color = MakeColor( width, height, bpp, bpp );
+
+    std::vector<BYTE> expected( width * height * bpp, 0xcd );
+    RegisterPerByte( color.data(), color.size(), points.data(), points.size(), width, bpp, expected.data(), expected.size() );
+
+    std::vector<BYTE> registered( width * height * bpp, 0xcd );
+    RegisterBands( color.data(), points.data(), width, height, bpp, registered.data() );
+
+    KCB_CHECK( registered == expected );
+}
+
+// a point left or right of the image is not mapped; the per byte copy wrapped it onto the next row
+static void TestOutsideRow()
+{
+    const ULONG width = 16, height = 4, bpp = 4;
+    std::vector<NUI_DEPTH_IMAGE_POINT> points( width * height );
+    for( ULONG i = 0; i < width * height; ++i )
+    {
+        points[i].x = -100;
+        points[i].y = -100;
+    }
+    points[0].x = width;            // right of row 1
+    points[0].y = 1;
+    points[1].x = -1;               // left of row 2
+    points[1].y = 2;
+    points[2].x = 3;
+    points[2].y = 3;
+
+    std::vector<BYTE> color = MakeColor( width, height, bpp, 1 );
+    std::vector<BYTE> registered( width * height * bpp, 0 );
+    RegisterBands( color.data(), points.data(), width, height, bpp, registered.data() );
+
+    size_t cWritten = 0;
+    for( size_t i = 0; i < width * height; ++i )
+    {
+        cWritten += (0 != reinterpret_cast<const UINT32*>(registered.data())[i]);
+    }
+    KCB_CHECK( 1 == cWritten );
+    KCB_CHECK( 0 == memcmp( &registered[(3 * width + 3) * bpp], &color[2 * bpp], bpp ) );
+}
+
+static void BenchmarkRegistration( ULONG width, ULONG height, ULONG bpp )
+{
+    std::vector<NUI_DEPTH_IMAGE_POINT> points = MakeDepthPoints( width, height, 5 );
+    std::vector<BYTE> color = MakeColor( width, height, bpp, 7 );
+    std::vector<BYTE> registered( width * height * bpp );
+
+    const int cRuns = 20;
+
+    Stopwatch perByteTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        RegisterPerByte( color.data(), color.size(), points.data(), points.size(), width, bpp, registered.data(), registered.size() );
+    }
+    double perByteUs = perByteTime.ElapsedMicroseconds() / cRuns;
+
+    Stopwatch bandTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        RegisterBands( color.data(), points.data(), width, height, bpp, registered.data() );
+    }
+    double bandUs = bandTime.ElapsedMicroseconds() / cRuns;
+
+    printf( "color to depth %ux%u, %u bytes per pixel: per byte %.0f us, bands %.0f us\n", width, height, bpp, perByteUs, bandUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestMatchesPerByte( 640, 480, 4 );
+    TestMatchesPerByte( 640, 480, 2 );
+    TestMatchesPerByte( 640, 480, 1 );
+    TestMatchesPerByte( 1280, 960, 4 );
+    TestMatchesPerByte( 80, 60, 2 );
+    TestOutsideRow();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkRegistration( 640, 480, 4 );
+        BenchmarkRegistration( 640, 480, 2 );
+        BenchmarkRegistration( 1280, 960, 4 );
+        BenchmarkRegistration( 1280, 960, 1 );
+    }
+
+    return ReportTestResult( "ColorRegistrationTests" );
+}
@@ -0,0 +1,190 @@
+//
+// Stand-ins for the Kinect for Windows SDK 1.x declarations the portable modules use,
+// with the layouts of NuiApi.h, NuiImageCamera.h and NuiSkeleton.h
+//
+#pragma once
+
+#include <windows.h>
+
+typedef struct _Vector4
+{
+    FLOAT x;
+    FLOAT y;
+    FLOAT z;
+    FLOAT w;
+} Vector4;
+
+typedef struct _Matrix4
+{
+    FLOAT M11, M12, M13, M14;
+    FLOAT M21, M22, M23, M24;
+    FLOAT M31, M32, M33, M34;
+    FLOAT M41, M42, M43, M44;
+} Matrix4;
+
+#define E_NUI_FRAME_NO_DATA             ((HRESULT)0x83010001L)
+#define E_NUI_STREAM_NOT_ENABLED        ((HRESULT)0x83010002L)
+#define E_NUI_BADINDEX                  ((HRESULT)0x83010585L)
+
+//
+// image camera
+//
+typedef enum _NUI_IMAGE_TYPE
+{
+    NUI_IMAGE_TYPE_DEPTH_AND_PLAYER_INDEX = 0,
+    NUI_IMAGE_TYPE_COLOR,
+    NUI_IMAGE_TYPE_COLOR_YUV,
+    NUI_IMAGE_TYPE_COLOR_RAW_YUV,
+    NUI_IMAGE_TYPE_DEPTH,
+    NUI_IMAGE_TYPE_COLOR_INFRARED,
+    NUI_IMAGE_TYPE_COLOR_RAW_BAYER
+} NUI_IMAGE_TYPE;
+
+typedef enum _NUI_IMAGE_RESOLUTION
+{
+    NUI_IMAGE_RESOLUTION_INVALID = -1,
+    NUI_IMAGE_RESOLUTION_80x60 = 0,
+    NUI_IMAGE_RESOLUTION_320x240,
+    NUI_IMAGE_RESOLUTION_640x480,
+    NUI_IMAGE_RESOLUTION_1280x960
+} NUI_IMAGE_RESOLUTION;
+
+inline void NuiImageResolutionToSize( NUI_IMAGE_RESOLUTION res, DWORD& refWidth, DWORD& refHeight )
+{
+    switch( res )
+    {
+    case NUI_IMAGE_RESOLUTION_80x60:    refWidth = 80;   refHeight = 60;  break;
+    case NUI_IMAGE_RESOLUTION_320x240:  refWidth = 320;  refHeight = 240; break;
+    case NUI_IMAGE_RESOLUTION_640x480:  refWidth = 640;  refHeight = 480; break;
+    case NUI_IMAGE_RESOLUTION_1280x960: refWidth = 1280; refHeight = 960; break;
+    default:                            refWidth = 0;    refHeight = 0;   break;
+    }
+}
+
+typedef struct _NUI_DEPTH_IMAGE_PIXEL
+{
+    USHORT playerIndex;
+    USHORT depth;
+} NUI_DEPTH_IMAGE_PIXEL;
+
+typedef struct _NUI_DEPTH_IMAGE_POINT
+{
+    LONG x;
+    LONG y;
+    LONG depth;
+    LONG reserved;
+} NUI_DEPTH_IMAGE_POINT;
+
+typedef struct _NUI_COLOR_IMAGE_POINT
+{
+    LONG x;
+    LONG y;
+} NUI_COLOR_IMAGE_POINT;
+
+#define NUI_IMAGE_PLAYER_INDEX_SHIFT                3
+#define NUI_IMAGE_PLAYER_INDEX_MASK                 ((1 << NUI_IMAGE_PLAYER_INDEX_SHIFT) - 1)
+#define NUI_IMAGE_DEPTH_MAXIMUM                     ((4000 << NUI_IMAGE_PLAYER_INDEX_SHIFT) | NUI_IMAGE_PLAYER_INDEX_MASK)
+#define NUI_IMAGE_DEPTH_MINIMUM                     (800 << NUI_IMAGE_PLAYER_INDEX_SHIFT)
+#define NUI_IMAGE_DEPTH_MAXIMUM_NEAR_MODE           ((3000 << NUI_IMAGE_PLAYER_INDEX_SHIFT) | NUI_IMAGE_PLAYER_INDEX_MASK)
+#define NUI_IMAGE_DEPTH_MINIMUM_NEAR_MODE           (400 << NUI_IMAGE_PLAYER_INDEX_SHIFT)
+#define NUI_IMAGE_DEPTH_NO_VALUE                    0
+#define NUI_IMAGE_DEPTH_TOO_FAR_VALUE               (0x0fff << NUI_IMAGE_PLAYER_INDEX_SHIFT)
+#define NUI_DEPTH_DEPTH_UNKNOWN_VALUE               (0x1fff << NUI_IMAGE_PLAYER_INDEX_SHIFT)
+
+#define NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS         (285.63f)
+#define NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS (3.501e-3f)
+#define NUI_CAMERA_DEPTH_NOMINAL_HORIZONTAL_FOV                 (58.5f)
+#define NUI_CAMERA_DEPTH_NOMINAL_VERTICAL_FOV                   (45.6f)
+#define NUI_CAMERA_COLOR_NOMINAL_FOCAL_LENGTH_IN_PIXELS         (531.15f)
+#define NUI_CAMERA_DEPTH_IMAGE_TO_SKELETON_MULTIPLIER_320x240   (NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS)
+#define NUI_CAMERA_SKELETON_TO_DEPTH_IMAGE_MULTIPLIER_320x240   (NUI_CAMERA_DEPTH_NOMINAL_FOCAL_LENGTH_IN_PIXELS)
+
+//
+// skeleton
+//
+#define NUI_SKELETON_COUNT              6
+#define NUI_SKELETON_MAX_TRACKED_COUNT  2
+
+typedef enum _NUI_SKELETON_POSITION_INDEX
+{
+    NUI_SKELETON_POSITION_HIP_CENTER = 0,
+    NUI_SKELETON_POSITION_SPINE,
+    NUI_SKELETON_POSITION_SHOULDER_CENTER,
+    NUI_SKELETON_POSITION_HEAD,
+    NUI_SKELETON_POSITION_SHOULDER_LEFT,
+    NUI_SKELETON_POSITION_ELBOW_LEFT,
+    NUI_SKELETON_POSITION_WRIST_LEFT,
+    NUI_SKELETON_POSITION_HAND_LEFT,
+    NUI_SKELETON_POSITION_SHOULDER_RIGHT,
+    NUI_SKELETON_POSITION_ELBOW_RIGHT,
+    NUI_SKELETON_POSITION_WRIST_RIGHT,
+    NUI_SKELETON_POSITION_HAND_RIGHT,
+    NUI_SKELETON_POSITION_HIP_LEFT,
+    NUI_SKELETON_POSITION_KNEE_LEFT,
+    NUI_SKELETON_POSITION_ANKLE_LEFT,
+    NUI_SKELETON_POSITION_FOOT_LEFT,
+    NUI_SKELETON_POSITION_HIP_RIGHT,
+    NUI_SKELETON_POSITION_KNEE_RIGHT,
+    NUI_SKELETON_POSITION_ANKLE_RIGHT,
+    NUI_SKELETON_POSITION_FOOT_RIGHT,
+    NUI_SKELETON_POSITION_COUNT
+} NUI_SKELETON_POSITION_INDEX;
+
+typedef enum _NUI_SKELETON_POSITION_TRACKING_STATE
+{
+    NUI_SKELETON_POSITION_NOT_TRACKED = 0,
+    NUI_SKELETON_POSITION_INFERRED,
+    NUI_SKELETON_POSITION_TRACKED
+} NUI_SKELETON_POSITION_TRACKING_STATE;
+
+typedef enum _NUI_SKELETON_TRACKING_STATE
+{
+    NUI_SKELETON_NOT_TRACKED = 0,
+    NUI_SKELETON_POSITION_ONLY,
+    NUI_SKELETON_TRACKED
+} NUI_SKELETON_TRACKING_STATE;
+
+typedef struct _NUI_SKELETON_DATA
+{
+    NUI_SKELETON_TRACKING_STATE eTrackingState;
+    DWORD dwTrackingID;
+    DWORD dwEnrollmentIndex;
+    DWORD dwUserIndex;
+    Vector4 Position;
+    Vector4 SkeletonPositions[NUI_SKELETON_POSITION_COUNT];
+    NUI_SKELETON_POSITION_TRACKING_STATE eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_COUNT];
+    DWORD dwQualityFlags;
+} NUI_SKELETON_DATA;
+
+typedef struct _NUI_SKELETON_FRAME
+{
+    LARGE_INTEGER liTimeStamp;
+    DWORD dwFrameNumber;
+    DWORD dwFlags;
+    Vector4 vFloorClipPlane;
+    Vector4 vNormalToGravity;
+    NUI_SKELETON_DATA SkeletonData[NUI_SKELETON_COUNT];
+} NUI_SKELETON_FRAME;
+
+typedef struct _NUI_TRANSFORM_SMOOTH_PARAMETERS
+{
+    FLOAT fSmoothing;
+    FLOAT fCorrection;
+    FLOAT fPrediction;
+    FLOAT fJitterRadius;
+    FLOAT fMaxDeviationRadius;
+} NUI_TRANSFORM_SMOOTH_PARAMETERS;
+
+typedef struct _NUI_SKELETON_BONE_ROTATION
+{
+    Matrix4 rotationMatrix;
+    Vector4 rotationQuaternion;
+} NUI_SKELETON_BONE_ROTATION;
+
+typedef struct _NUI_SKELETON_BONE_ORIENTATION
+{
+    NUI_SKELETON_POSITION_INDEX endJoint;
+    NUI_SKELETON_POSITION_INDEX startJoint;
+    NUI_SKELETON_BONE_ROTATION hierarchicalRotation;
+    NUI_SKELETON_BONE_ROTATION absoluteRotation;
+} NUI_SKELETON_BONE_ORIENTATION;
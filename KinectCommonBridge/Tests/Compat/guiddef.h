@@ -0,0 +1,6 @@
+#pragma once
+
+#include <windows.h>
+
+// the tests don't use the GUIDs, a declaration is enough
+#define DEFINE_GUID(name, ...) extern const GUID name
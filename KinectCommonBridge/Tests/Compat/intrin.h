@@ -0,0 +1,30 @@
+#pragma once
+
+// DWORD is unsigned long on Windows, the 32 bit DWORD of Compat/windows.h here
+
+#include <windows.h>
+
+inline unsigned char _BitScanForward( DWORD* pIndex, DWORD mask )
+{
+    if( 0 == mask )
+    {
+        return 0;
+    }
+    *pIndex = __builtin_ctz( mask );
+    return 1;
+}
+
+inline unsigned char _BitScanReverse( DWORD* pIndex, DWORD mask )
+{
+    if( 0 == mask )
+    {
+        return 0;
+    }
+    *pIndex = 31 - __builtin_clz( mask );
+    return 1;
+}
+
+inline unsigned int __popcnt( unsigned int value )
+{
+    return __builtin_popcount( value );
+}
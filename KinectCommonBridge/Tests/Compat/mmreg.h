@@ -0,0 +1,16 @@
+#pragma once
+
+#include <windows.h>
+
+#define WAVE_FORMAT_PCM 1
+
+typedef struct tWAVEFORMATEX
+{
+    WORD wFormatTag;
+    WORD nChannels;
+    DWORD nSamplesPerSec;
+    DWORD nAvgBytesPerSec;
+    WORD nBlockAlign;
+    WORD wBitsPerSample;
+    WORD cbSize;
+} WAVEFORMATEX;
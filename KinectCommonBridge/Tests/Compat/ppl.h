@@ -0,0 +1,32 @@
+#pragma once
+
+// the tests measure a single core, the loops run in order on the calling thread
+namespace Concurrency
+{
+    template <typename _Index_type, typename _Function>
+    void parallel_for( _Index_type first, _Index_type last, const _Function& func )
+    {
+        for( _Index_type i = first; i < last; ++i )
+        {
+            func( i );
+        }
+    }
+
+    template <typename _Index_type, typename _Function>
+    void parallel_for( _Index_type first, _Index_type last, _Index_type step, const _Function& func )
+    {
+        for( _Index_type i = first; i < last; i += step )
+        {
+            func( i );
+        }
+    }
+
+    template <typename _Iterator, typename _Function>
+    void parallel_for_each( _Iterator first, _Iterator last, const _Function& func )
+    {
+        for( ; first != last; ++first )
+        {
+            func( *first );
+        }
+    }
+}
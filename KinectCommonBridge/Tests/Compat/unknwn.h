@@ -0,0 +1,23 @@
+#pragma once
+
+#include <windows.h>
+
+struct IUnknown
+{
+    virtual HRESULT QueryInterface( REFIID riid, void** ppvObject ) = 0;
+    virtual ULONG AddRef() = 0;
+    virtual ULONG Release() = 0;
+};
+
+extern const IID IID_IUnknown;
+
+#define CLSCTX_INPROC_SERVER    0x1
+
+// no COM on the test hosts, creating an object always fails
+inline HRESULT CoCreateInstance( REFCLSID, IUnknown*, DWORD, REFIID, void** ppv )
+{
+    *ppv = nullptr;
+    return E_FAIL;
+}
+
+#define __uuidof(x) IID_IUnknown
@@ -0,0 +1,168 @@
+//
+// Stand-ins for the Windows declarations the portable modules use, so the unit tests build
+// with gcc or clang on hosts without the Windows SDK. Only what the tested code needs.
+//
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#include <time.h>
+
+// the standard C++ headers the tree uses come first, they don't build once min and max are macros
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <regex>
+#include <string>
+#include <vector>
+
+typedef uint8_t         BYTE;
+typedef uint16_t        WORD;
+typedef uint16_t        USHORT;
+typedef uint32_t        DWORD;
+typedef uint32_t        UINT;
+typedef uint32_t        ULONG;
+typedef int32_t         LONG;
+typedef int32_t         INT;
+typedef int16_t         SHORT;
+typedef int16_t         INT16;
+typedef uint16_t        UINT16;
+typedef int32_t         INT32;
+typedef uint32_t        UINT32;
+typedef int64_t         INT64;
+typedef uint64_t        UINT64;
+typedef int64_t         LONGLONG;
+typedef uint64_t        ULONGLONG;
+typedef float           FLOAT;
+typedef int             BOOL;
+typedef char            CHAR;
+typedef wchar_t         WCHAR;
+typedef const wchar_t*  LPCWSTR;
+typedef void*           HANDLE;
+typedef int32_t         HRESULT;
+
+typedef union _LARGE_INTEGER
+{
+    struct
+    {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef struct tagRECT { LONG left, top, right, bottom; } RECT;
+typedef struct tagPOINT { LONG x, y; } POINT;
+
+#define TRUE    1
+#define FALSE   0
+
+#define S_OK                        ((HRESULT)0)
+#define S_FALSE                     ((HRESULT)1)
+#define E_FAIL                      ((HRESULT)0x80004005L)
+#define E_POINTER                   ((HRESULT)0x80004003L)
+#define E_INVALIDARG                ((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY               ((HRESULT)0x8007000EL)
+#define E_UNEXPECTED                ((HRESULT)0x8000FFFFL)
+#define ERROR_INVALID_DATA          13L
+#define ERROR_INSUFFICIENT_BUFFER   122L
+#define HRESULT_FROM_WIN32(x)       ((HRESULT)(0x80070000 | ((x) & 0x0000FFFF)))
+#define SUCCEEDED(hr)               (((HRESULT)(hr)) >= 0)
+#define FAILED(hr)                  (((HRESULT)(hr)) < 0)
+
+#define APIENTRY
+#define WINAPI
+#define CALLBACK
+#define __declspec(x)
+
+#define ZeroMemory(p, cb)           memset((p), 0, (cb))
+#define CopyMemory(d, s, cb)        memcpy((d), (s), (cb))
+#define _countof(a)                 (sizeof(a) / sizeof((a)[0]))
+
+inline int memcpy_s( void* pDst, size_t cbDst, const void* pSrc, size_t cbSrc )
+{
+    if( cbSrc > cbDst )
+    {
+        memset( pDst, 0, cbDst );
+        return 34;      // ERANGE
+    }
+    memcpy( pDst, pSrc, cbSrc );
+    return 0;
+}
+
+#ifndef NOMINMAX
+#ifndef min
+#define min(a, b)                   (((a) < (b)) ? (a) : (b))
+#endif
+#ifndef max
+#define max(a, b)                   (((a) > (b)) ? (a) : (b))
+#endif
+#endif
+
+// SAL annotations used in the tree
+#define _In_
+#define _In_opt_
+#define _In_z_
+#define _Out_
+#define _Out_opt_
+#define _Inout_
+#define _Inout_opt_
+#define _In_count_(x)
+#define _In_opt_count_(x)
+#define _In_reads_(x)
+#define _In_reads_bytes_(x)
+#define _Out_cap_(x)
+#define _Out_opt_cap_(x)
+#define _Inout_cap_(x)
+#define _Out_writes_(x)
+#define _Out_writes_bytes_(x)
+#define _Out_writes_to_(x, y)
+#define _Inout_updates_(x)
+
+// the tests run the modules on one thread
+typedef struct _CRITICAL_SECTION { int unused; } CRITICAL_SECTION;
+inline void InitializeCriticalSection( CRITICAL_SECTION* ) {}
+inline void DeleteCriticalSection( CRITICAL_SECTION* ) {}
+inline void EnterCriticalSection( CRITICAL_SECTION* ) {}
+inline void LeaveCriticalSection( CRITICAL_SECTION* ) {}
+
+inline ULONGLONG GetTickCount64()
+{
+    timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return static_cast<ULONGLONG>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+inline DWORD GetTickCount()
+{
+    return static_cast<DWORD>( GetTickCount64() );
+}
+
+inline BOOL QueryPerformanceFrequency( LARGE_INTEGER* pFrequency )
+{
+    pFrequency->QuadPart = 1000000000;
+    return TRUE;
+}
+
+inline BOOL QueryPerformanceCounter( LARGE_INTEGER* pCounter )
+{
+    timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    pCounter->QuadPart = static_cast<LONGLONG>(now.tv_sec) * 1000000000 + now.tv_nsec;
+    return TRUE;
+}
+
+typedef struct _GUID
+{
+    DWORD Data1;
+    WORD Data2;
+    WORD Data3;
+    BYTE Data4[8];
+} GUID, IID;
+typedef const IID& REFIID;
+typedef const GUID& REFCLSID;
@@ -0,0 +1,9 @@
+#pragma once
+
+typedef enum _AEC_SYSTEM_MODE
+{
+    SINGLE_CHANNEL_AEC = 0,
+    OPTIBEAM_ARRAY_ONLY = 2,
+    OPTIBEAM_ARRAY_AND_AEC = 4,
+    SINGLE_CHANNEL_NSAGC = 5
+} AEC_SYSTEM_MODE;
@@ -0,0 +1,240 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "DepthCodec.h"
+
+// the layout of the header, see DepthCodec.cpp
+struct EncodedHeader
+{
+    UINT32 magic;
+    UINT32 width;
+    UINT32 height;
+    UINT32 bandRows;
+    UINT32 cBands;
+};
+
+static KINECT_IMAGE_FRAME_FORMAT MakeFormat( DWORD width, DWORD height )
+{
+    KINECT_IMAGE_FRAME_FORMAT format = { sizeof(KINECT_IMAGE_FRAME_FORMAT), height, width, sizeof(USHORT), width * height * 2 };
+    return format;
+}
+
+// packed depth of a room: a sloped wall with sensor noise, a player in front of it,
+// the shadow strip on the left and scattered pixels without depth
+static std::vector<USHORT> MakeDepth( DWORD width, DWORD height, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<USHORT> depth( width * height );
+
+    const int playerLeft = width * 2 / 5, playerRight = width * 3 / 5;
+    const int playerTop = height / 6;
+
+    for( DWORD y = 0; y < height; ++y )
+    {
+        for( DWORD x = 0; x < width; ++x )
+        {
+            int value = 3000 + x - y / 2 + static_cast<int>( random.Gaussian( 2.0f ) );
+            USHORT player = 0;
+
+            if( static_cast<int>(x) >= playerLeft && static_cast<int>(x) < playerRight && static_cast<int>(y) >= playerTop )
+            {
+                value = 1500 + static_cast<int>( random.Gaussian( 2.0f ) );
+                player = 1;
+            }
+
+            bool bHole = x < 8 || 0 == random.Next() % 100;
+            depth[y * width + x] = bHole ? 0 : static_cast<USHORT>( value << NUI_IMAGE_PLAYER_INDEX_SHIFT | player );
+        }
+    }
+
+    return depth;
+}
+
+static void TestRoundTrip( DWORD width, DWORD height )
+{
+    KINECT_IMAGE_FRAME_FORMAT format = MakeFormat( width, height );
+    std::vector<USHORT> depth = MakeDepth( width, height, width );
+    const BYTE* pDepth = reinterpret_cast<const BYTE*>(depth.data());
+
+    ULONG cbBound = DepthCodec::GetEncodedBound( format );
+    KCB_CHECK( cbBound > 0 );
+
+    std::vector<BYTE> encoded( cbBound );
+    ULONG cbWritten = 0;
+    KCB_CHECK_HR( DepthCodec::Encode( format, pDepth, cbBound, encoded.data(), cbWritten ), S_OK );
+    KCB_CHECK( cbWritten > 0 && cbWritten <= cbBound );
+
+    KINECT_IMAGE_FRAME_FORMAT decodedFormat;
+    KCB_CHECK_HR( DepthCodec::GetFormat( cbWritten, encoded.data(), decodedFormat ), S_OK );
+    KCB_CHECK( decodedFormat.dwWidth == width && decodedFormat.dwHeight == height );
+    KCB_CHECK( decodedFormat.cbBytesPerPixel == sizeof(USHORT) && decodedFormat.cbBufferSize == format.cbBufferSize );
+
+    std::vector<USHORT> decoded( depth.size(), 0xcdcd );
+    KCB_CHECK_HR( DepthCodec::Decode( cbWritten, encoded.data(), format.cbBufferSize, reinterpret_cast<BYTE*>(decoded.data()) ), S_OK );
+    KCB_CHECK( decoded == depth );
+
+    KCB_CHECK_HR( DepthCodec::Decode( cbWritten, encoded.data(), format.cbBufferSize - 1, reinterpret_cast<BYTE*>(decoded.data()) ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+    KCB_CHECK_HR( DepthCodec::Encode( format, pDepth, cbBound - 1, encoded.data(), cbWritten ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+}
+
+// every depth and player index survives, including the extremes of both
+static void TestExtremeValues()
+{
+    KINECT_IMAGE_FRAME_FORMAT format = MakeFormat( 67, 35 );
+    TestRandom random( 5 );
+
+    std::vector<USHORT> depth( format.dwWidth * format.dwHeight );
+    for( size_t i = 0; i < depth.size(); ++i )
+    {
+        depth[i] = static_cast<USHORT>( random.Next() );
+    }
+    depth[0] = 0xffff;
+    depth[1] = 0x0007;
+    depth[2] = 0x0008;
+
+    // steps around the one and two nibble limits in every position of a group of 8,
+    // then with steps of three nibbles in between
+    static const int steps[] = { 3, -4, 4, -32, 31, 0, -1, 1, -3, 32, -33 };
+    int value = 4000;
+    for( size_t i = format.dwWidth * 16, k = 0; i < format.dwWidth * 32; ++i, ++k )
+    {
+        size_t cSteps = (i < format.dwWidth * 24) ? 9 : 11;
+        value += steps[k % cSteps];
+        depth[i] = static_cast<USHORT>( value << NUI_IMAGE_PLAYER_INDEX_SHIFT );
+    }
+
+    std::vector<BYTE> encoded( DepthCodec::GetEncodedBound( format ) );
+    ULONG cbWritten = 0;
+    KCB_CHECK_HR( DepthCodec::Encode( format, reinterpret_cast<const BYTE*>(depth.data()), static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+
+    std::vector<USHORT> decoded( depth.size() );
+    KCB_CHECK_HR( DepthCodec::Decode( cbWritten, encoded.data(), format.cbBufferSize, reinterpret_cast<BYTE*>(decoded.data()) ), S_OK );
+    KCB_CHECK( decoded == depth );
+}
+
+// width * height * 2 of the header wraps around in 32 bits
+static void TestOverflowingHeader()
+{
+    const UINT32 width = 0x10000;
+    const UINT32 height = 0x8001;
+    const UINT32 cbWrapped = width * height * 2;     // 0x20000 after the wrap
+    const UINT32 cBands = (height + 31) / 32;
+
+    // every band is one run of 2^21 zeros and player 0, more than the wrapped size holds
+    const UINT32 band[] = { 2 * sizeof(UINT32), 0x88888881, 0, 0x7fffff00 };
+    const UINT32 cbBand = sizeof(band) - 1;
+    std::vector<BYTE> encoded( sizeof(EncodedHeader) + cBands * sizeof(UINT32) + sizeof(band) );
+    EncodedHeader header = { 0x4442434b, width, height, 32, cBands };
+    memcpy( encoded.data(), &header, sizeof(header) );
+    std::vector<UINT32> bandEnds( cBands, cbBand );
+    memcpy( encoded.data() + sizeof(header), bandEnds.data(), cBands * sizeof(UINT32) );
+    memcpy( encoded.data() + sizeof(header) + cBands * sizeof(UINT32), band, sizeof(band) );
+
+    KINECT_IMAGE_FRAME_FORMAT format;
+    KCB_CHECK_HR( DepthCodec::GetFormat( static_cast<ULONG>(encoded.size()), encoded.data(), format ),
+        HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+
+    std::vector<BYTE> depth( cbWrapped );
+    KCB_CHECK_HR( DepthCodec::Decode( static_cast<ULONG>(encoded.size()), encoded.data(), cbWrapped, depth.data() ),
+        HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+
+    // larger than any NUI stream without wrapping
+    header.width = 4096;
+    header.height = 4096;
+    header.cBands = 4096 / 32;
+    memcpy( encoded.data(), &header, sizeof(header) );
+    KCB_CHECK_HR( DepthCodec::GetFormat( static_cast<ULONG>(encoded.size()), encoded.data(), format ),
+        HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+}
+
+// damaged band data is reported, and never written outside of the image
+static void TestCorruptData()
+{
+    KINECT_IMAGE_FRAME_FORMAT format = MakeFormat( 160, 120 );
+    std::vector<USHORT> depth = MakeDepth( 160, 120, 7 );
+
+    std::vector<BYTE> encoded( DepthCodec::GetEncodedBound( format ) );
+    ULONG cbWritten = 0;
+    KCB_CHECK_HR( DepthCodec::Encode( format, reinterpret_cast<const BYTE*>(depth.data()), static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+
+    TestRandom random( 11 );
+    std::vector<BYTE> decoded( format.cbBufferSize );
+    bool bReported = true;
+    for( int i = 0; i < 2000; ++i )
+    {
+        std::vector<BYTE> damaged( encoded.begin(), encoded.begin() + cbWritten );
+        damaged[sizeof(EncodedHeader) + random.Next() % (cbWritten - sizeof(EncodedHeader))] ^= static_cast<BYTE>( 1 + random.Next() % 255 );
+
+        HRESULT hr = DepthCodec::Decode( cbWritten, damaged.data(), format.cbBufferSize, decoded.data() );
+        bReported = bReported && (S_OK == hr || HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) == hr);
+    }
+    KCB_CHECK( bReported );
+
+    // cut off data
+    for( ULONG cb = 0; cb < cbWritten; cb += 97 )
+    {
+        KCB_CHECK( FAILED( DepthCodec::Decode( cb, encoded.data(), format.cbBufferSize, decoded.data() ) ) );
+    }
+}
+
+static void BenchmarkCodec( DWORD width, DWORD height )
+{
+    KINECT_IMAGE_FRAME_FORMAT format = MakeFormat( width, height );
+    std::vector<USHORT> depth = MakeDepth( width, height, 3 );
+    std::vector<BYTE> encoded( DepthCodec::GetEncodedBound( format ) );
+    std::vector<BYTE> decoded( format.cbBufferSize );
+
+    const int cRuns = 50;
+    ULONG cbWritten = 0;
+
+    Stopwatch encodeTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        DepthCodec::Encode( format, reinterpret_cast<const BYTE*>(depth.data()), static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten );
+    }
+    double encodeUs = encodeTime.ElapsedMicroseconds() / cRuns;
+
+    Stopwatch decodeTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        DepthCodec::Decode( cbWritten, encoded.data(), format.cbBufferSize, decoded.data() );
+    }
+    double decodeUs = decodeTime.ElapsedMicroseconds() / cRuns;
+
+    printf( "depth %ux%u: ratio %.2f, encode %.0f us, decode %.0f us\n",
+        width, height, static_cast<double>(format.cbBufferSize) / cbWritten, encodeUs, decodeUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestRoundTrip( 640, 480 );
+    TestRoundTrip( 320, 240 );
+    TestRoundTrip( 80, 60 );
+    TestRoundTrip( 643, 97 );
+    TestExtremeValues();
+    TestOverflowingHeader();
+    TestCorruptData();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkCodec( 640, 480 );
+        BenchmarkCodec( 320, 240 );
+    }
+
+    return ReportTestResult( "DepthCodecTests" );
+}
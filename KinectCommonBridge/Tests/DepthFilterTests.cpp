@@ -0,0 +1,339 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "DepthFilter.h"
+
+static const UINT WIDTH = 643;      // not a multiple of the SIMD width, so the scalar tails run too
+static const UINT HEIGHT = 97;
+
+// a tilted wall with a box in front, in millimeters
+static USHORT TrueDepth( UINT x, UINT y )
+{
+    if( x > WIDTH / 3 && x < WIDTH / 2 && y > HEIGHT / 4 && y < HEIGHT / 2 )
+    {
+        return 1200;
+    }
+    return static_cast<USHORT>( 2500 + x + y );
+}
+
+static BYTE PlayerOf( UINT x, UINT y )
+{
+    return static_cast<BYTE>( (x > WIDTH / 3 && x < WIDTH / 2) ? 1 + (y % 6) : 0 );
+}
+
+static void MakeFrame( _Out_ std::vector<USHORT>& packed, TestRandom& random, float sigma )
+{
+    packed.resize( WIDTH * HEIGHT );
+    for( UINT y = 0; y < HEIGHT; ++y )
+    {
+        for( UINT x = 0; x < WIDTH; ++x )
+        {
+            int depth = static_cast<int>( TrueDepth( x, y ) + random.Gaussian( sigma ) + 0.5f );
+            packed[y * WIDTH + x] = static_cast<USHORT>( depth << NUI_IMAGE_PLAYER_INDEX_SHIFT | PlayerOf( x, y ) );
+        }
+    }
+}
+
+static double RmsError( const std::vector<USHORT>& packed )
+{
+    double sum = 0.0;
+    UINT count = 0;
+    for( UINT y = 1; y + 1 < HEIGHT; ++y )
+    {
+        for( UINT x = 1; x + 1 < WIDTH; ++x )
+        {
+            double error = static_cast<double>( packed[y * WIDTH + x] >> NUI_IMAGE_PLAYER_INDEX_SHIFT ) - TrueDepth( x, y );
+            sum += error * error;
+            ++count;
+        }
+    }
+    return sqrt( sum / count );
+}
+
+static bool PlayersKept( const std::vector<USHORT>& input, const std::vector<USHORT>& output )
+{
+    for( size_t i = 0; i < input.size(); ++i )
+    {
+        if( (input[i] & NUI_IMAGE_PLAYER_INDEX_MASK) != (output[i] & NUI_IMAGE_PLAYER_INDEX_MASK) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static KINECT_DEPTH_FILTER MakeParams( bool bTemporal, bool bMedian, USHORT cMaxHoleWidth )
+{
+    KINECT_DEPTH_FILTER params = { sizeof(KINECT_DEPTH_FILTER), bTemporal, 0.0f, 0, bMedian, cMaxHoleWidth };
+    return params;
+}
+
+// noise on a static scene goes down with the frames, a jump restarts the pixel
+static void TestTemporal()
+{
+    DepthFilter filter;
+    KINECT_DEPTH_FILTER params = MakeParams( true, false, 0 );
+    filter.SetParameters( &params );
+
+    TestRandom random( 1 );
+    std::vector<USHORT> input, output( WIDTH * HEIGHT );
+    double rawError = 0.0;
+    for( int frame = 0; frame < 30; ++frame )
+    {
+        MakeFrame( input, random, 8.0f );
+        filter.Process( reinterpret_cast<const BYTE*>(input.data()), WIDTH * sizeof(USHORT), WIDTH, HEIGHT, false,
+            reinterpret_cast<BYTE*>(output.data()) );
+        rawError = RmsError( input );
+    }
+
+    double filteredError = RmsError( output );
+    printf( "temporal: raw rms %.2f mm, filtered %.2f mm\n", rawError, filteredError );
+    KCB_CHECK( filteredError < 0.5 * rawError );
+    KCB_CHECK( PlayersKept( input, output ) );
+
+    // the whole frame moves 400 mm, above the default motion threshold
+    for( size_t i = 0; i < input.size(); ++i )
+    {
+        input[i] = static_cast<USHORT>( input[i] + (400 << NUI_IMAGE_PLAYER_INDEX_SHIFT) );
+    }
+    filter.Process( reinterpret_cast<const BYTE*>(input.data()), WIDTH * sizeof(USHORT), WIDTH, HEIGHT, false,
+        reinterpret_cast<BYTE*>(output.data()) );
+    KCB_CHECK( input == output );
+}
+
+// speckles are removed, the edge of the box stays where it is
+static void TestMedian()
+{
+    DepthFilter filter;
+    KINECT_DEPTH_FILTER params = MakeParams( false, true, 0 );
+    filter.SetParameters( &params );
+
+    TestRandom random( 2 );
+    std::vector<USHORT> input, output( WIDTH * HEIGHT );
+    MakeFrame( input, random, 0.0f );
+
+    UINT cSpeckles = 0;
+    for( size_t i = WIDTH; i + WIDTH < input.size(); i += 37 )
+    {
+        input[i] = (0 == (i & 1)) ? static_cast<USHORT>( input[i] & NUI_IMAGE_PLAYER_INDEX_MASK ) : static_cast<USHORT>( input[i] | 0xf000 );
+        ++cSpeckles;
+    }
+
+    filter.Process( reinterpret_cast<const BYTE*>(input.data()), WIDTH * sizeof(USHORT), WIDTH, HEIGHT, false,
+        reinterpret_cast<BYTE*>(output.data()) );
+
+    // the median of a plane is the center pixel, next to the box it is the second value of the wall
+    UINT cWrong = 0;
+    UINT cEdgeMoved = 0;
+    for( UINT y = 1; y + 1 < HEIGHT; ++y )
+    {
+        for( UINT x = 1; x + 1 < WIDTH; ++x )
+        {
+            USHORT depth = output[y * WIDTH + x] >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+            bool bBesideBox = (x >= WIDTH / 3 && x <= WIDTH / 2 && y >= HEIGHT / 4 && y <= HEIGHT / 2)
+                && !(x > WIDTH / 3 + 1 && x + 1 < WIDTH / 2 && y > HEIGHT / 4 + 1 && y + 1 < HEIGHT / 2);
+            if( !bBesideBox && depth != TrueDepth( x, y ) )
+            {
+                ++cWrong;
+            }
+            // across the edge only the two depths of the sides may show up
+            bool bNearEdge = (x >= WIDTH / 3 - 1 && x <= WIDTH / 3 + 2) || (x >= WIDTH / 2 - 1 && x <= WIDTH / 2 + 1);
+            if( bNearEdge && y > HEIGHT / 4 + 1 && y + 1 < HEIGHT / 2 && depth != 1200 && depth < 2500 )
+            {
+                ++cEdgeMoved;
+            }
+        }
+    }
+
+    printf( "median: %u speckles in, %u wrong pixels out\n", cSpeckles, cWrong );
+    KCB_CHECK( cWrong * 20 < cSpeckles );
+    KCB_CHECK( 0 == cEdgeMoved );
+    KCB_CHECK( PlayersKept( input, output ) );
+}
+
+// short holes take the farther side, long holes and holes at the border stay
+static void TestHoleFilling()
+{
+    DepthFilter filter;
+    KINECT_DEPTH_FILTER params = MakeParams( false, false, 4 );
+    filter.SetParameters( &params );
+
+    TestRandom random( 3 );
+    std::vector<USHORT> input, output( WIDTH * HEIGHT );
+    MakeFrame( input, random, 0.0f );
+
+    const UINT y = HEIGHT / 3;
+    USHORT* pRow = &input[y * WIDTH];
+    for( UINT x = 0; x < 3; ++x )                   // at the border
+    {
+        pRow[x] &= NUI_IMAGE_PLAYER_INDEX_MASK;
+    }
+    for( UINT x = 100; x < 104; ++x )               // 4 wide
+    {
+        pRow[x] &= NUI_IMAGE_PLAYER_INDEX_MASK;
+    }
+    for( UINT x = 200; x < 205; ++x )               // 5 wide
+    {
+        pRow[x] &= NUI_IMAGE_PLAYER_INDEX_MASK;
+    }
+    for( UINT x = WIDTH / 2 - 2; x < WIDTH / 2; ++x )   // between the box and the wall
+    {
+        pRow[x] &= NUI_IMAGE_PLAYER_INDEX_MASK;
+    }
+
+    filter.Process( reinterpret_cast<const BYTE*>(input.data()), WIDTH * sizeof(USHORT), WIDTH, HEIGHT, false,
+        reinterpret_cast<BYTE*>(output.data()) );
+
+    const USHORT* pOut = &output[y * WIDTH];
+    KCB_CHECK( 0 == (pOut[0] >> NUI_IMAGE_PLAYER_INDEX_SHIFT) );
+    KCB_CHECK( (pOut[101] >> NUI_IMAGE_PLAYER_INDEX_SHIFT) == TrueDepth( 104, y ) );
+    KCB_CHECK( 0 == (pOut[202] >> NUI_IMAGE_PLAYER_INDEX_SHIFT) );
+    KCB_CHECK( (pOut[WIDTH / 2 - 1] >> NUI_IMAGE_PLAYER_INDEX_SHIFT) == TrueDepth( WIDTH / 2, y ) );
+    KCB_CHECK( PlayersKept( input, output ) );
+}
+
+// NUI_DEPTH_IMAGE_PIXEL input gives the same depth as the packed format
+static void TestPixelFormat()
+{
+    DepthFilter packedFilter, pixelFilter;
+    KINECT_DEPTH_FILTER params = MakeParams( true, true, 8 );
+    packedFilter.SetParameters( &params );
+    pixelFilter.SetParameters( &params );
+
+    TestRandom random( 4 );
+    std::vector<USHORT> input, output( WIDTH * HEIGHT );
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels( WIDTH * HEIGHT ), pixelOutput( WIDTH * HEIGHT );
+
+    bool bSame = true;
+    for( int frame = 0; frame < 4; ++frame )
+    {
+        MakeFrame( input, random, 6.0f );
+        for( size_t i = 0; i < input.size(); ++i )
+        {
+            pixels[i].depth = input[i] >> NUI_IMAGE_PLAYER_INDEX_SHIFT;
+            pixels[i].playerIndex = input[i] & NUI_IMAGE_PLAYER_INDEX_MASK;
+        }
+
+        packedFilter.Process( reinterpret_cast<const BYTE*>(input.data()), WIDTH * sizeof(USHORT), WIDTH, HEIGHT, false,
+            reinterpret_cast<BYTE*>(output.data()) );
+        pixelFilter.Process( reinterpret_cast<const BYTE*>(pixels.data()), WIDTH * sizeof(NUI_DEPTH_IMAGE_PIXEL), WIDTH, HEIGHT, true,
+            reinterpret_cast<BYTE*>(pixelOutput.data()) );
+
+        for( size_t i = 0; i < input.size(); ++i )
+        {
+            bSame = bSame && pixelOutput[i].depth == (output[i] >> NUI_IMAGE_PLAYER_INDEX_SHIFT)
+                && pixelOutput[i].playerIndex == pixels[i].playerIndex;
+        }
+    }
+    KCB_CHECK( bSame );
+}
+
+// the last columns of every row repeat the first ones, so the scalar tails see the pixels the SIMD loops see;
+// an alpha of 0.5 on integer depths smooths to half millimeters, which both round the same way
+// the median tail is the column after the temporal one, its neighbourhood comes from the temporal tail
+static void TestSimdMatchesScalar( bool bMedian )
+{
+    const UINT tail = WIDTH - WIDTH % 8;
+    KCB_CHECK( 3 == WIDTH - tail );
+    const UINT first = bMedian ? tail + 1 : tail;
+    const UINT last = bMedian ? tail + 2 : WIDTH;
+
+    DepthFilter filter;
+    KINECT_DEPTH_FILTER params = MakeParams( true, bMedian, 0 );
+    params.fTemporalAlpha = 0.5f;
+    filter.SetParameters( &params );
+
+    TestRandom random( 6 );
+    std::vector<USHORT> input( WIDTH * HEIGHT ), output( WIDTH * HEIGHT );
+
+    UINT cDifferent = 0, cHalves = 0;
+    for( int frame = 0; frame < 8; ++frame )
+    {
+        for( UINT y = 0; y < HEIGHT; ++y )
+        {
+            USHORT* pRow = &input[y * WIDTH];
+            for( UINT x = 0; x < tail; ++x )
+            {
+                USHORT depth = (0 == random.Next() % 11) ? 0 : static_cast<USHORT>( 1000 + random.Next() % 8 );
+                pRow[x] = static_cast<USHORT>( depth << NUI_IMAGE_PLAYER_INDEX_SHIFT );
+            }
+            for( UINT x = tail; x < WIDTH; ++x )
+            {
+                pRow[x] = pRow[x - tail];
+            }
+        }
+
+        filter.Process( reinterpret_cast<const BYTE*>(input.data()), WIDTH * sizeof(USHORT), WIDTH, HEIGHT, false,
+            reinterpret_cast<BYTE*>(output.data()) );
+
+        for( UINT y = 1; y + 1 < HEIGHT; ++y )
+        {
+            for( UINT x = first; x < last; ++x )
+            {
+                cDifferent += output[y * WIDTH + x] != output[y * WIDTH + x - tail];
+                cHalves += input[y * WIDTH + x] != output[y * WIDTH + x];
+            }
+        }
+    }
+
+    KCB_CHECK( 0 == cDifferent );
+    KCB_CHECK( 0 != cHalves );
+}
+
+static void BenchmarkLatency( UINT width, UINT height, bool bPixels )
+{
+    DepthFilter filter;
+    KINECT_DEPTH_FILTER params = MakeParams( true, true, 8 );
+    filter.SetParameters( &params );
+
+    const UINT bytesPerPixel = bPixels ? sizeof(NUI_DEPTH_IMAGE_PIXEL) : sizeof(USHORT);
+    std::vector<BYTE> input( width * height * bytesPerPixel ), output( input.size() );
+    TestRandom random( 5 );
+    for( size_t i = 0; i < input.size(); i += 2 )
+    {
+        USHORT value = static_cast<USHORT>( (2000 + random.Next() % 64) << NUI_IMAGE_PLAYER_INDEX_SHIFT );
+        memcpy( &input[i], &value, sizeof(value) );
+    }
+
+    const int cFrames = 100;
+    Stopwatch time;
+    for( int frame = 0; frame < cFrames; ++frame )
+    {
+        filter.Process( input.data(), width * bytesPerPixel, width, height, bPixels, output.data() );
+    }
+
+    printf( "depth filter %ux%u %s: %.0f us per frame\n", width, height, bPixels ? "pixels" : "packed",
+        time.ElapsedMicroseconds() / cFrames );
+}
+
+int main( int argc, char** argv )
+{
+    TestTemporal();
+    TestMedian();
+    TestHoleFilling();
+    TestPixelFormat();
+    TestSimdMatchesScalar( false );
+    TestSimdMatchesScalar( true );
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkLatency( 640, 480, false );
+        BenchmarkLatency( 640, 480, true );
+        BenchmarkLatency( 320, 240, false );
+    }
+
+    return ReportTestResult( "DepthFilterTests" );
+}
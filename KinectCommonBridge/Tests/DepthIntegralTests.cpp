@@ -0,0 +1,259 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "DepthIntegral.h"
+
+#include <math.h>
+#include <vector>
+
+static const USHORT MIN_DEPTH = 800;
+static const USHORT MAX_DEPTH = 4000;
+
+// depth from 0 to the largest 13 bit value, so holes and pixels on either side of the range occur
+static std::vector<NUI_DEPTH_IMAGE_PIXEL> MakeDepthPixels( UINT width, UINT height, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels( width * height );
+    for( size_t i = 0; i < pixels.size(); ++i )
+    {
+        UINT32 r = random.Next();
+        pixels[i].playerIndex = static_cast<USHORT>( r % 7 );
+        pixels[i].depth = (0 == (r >> 8) % 9) ? 0 : static_cast<USHORT>( (r >> 12) % 8192 );
+    }
+
+    // on the edges of the range
+    pixels[0].depth = MIN_DEPTH;
+    pixels[1].depth = MIN_DEPTH - 1;
+    pixels[2].depth = MAX_DEPTH;
+    pixels[3].depth = MAX_DEPTH + 1;
+    return pixels;
+}
+
+static std::vector<USHORT> PackDepth( const std::vector<NUI_DEPTH_IMAGE_PIXEL>& pixels )
+{
+    std::vector<USHORT> packed( pixels.size() );
+    for( size_t i = 0; i < pixels.size(); ++i )
+    {
+        packed[i] = static_cast<USHORT>( pixels[i].depth << NUI_IMAGE_PLAYER_INDEX_SHIFT | pixels[i].playerIndex );
+    }
+    return packed;
+}
+
+// the statistics summed pixel by pixel over the region of a width x height image, clipped to it
+static KINECT_DEPTH_REGION_STATS BruteForceStats( const NUI_DEPTH_IMAGE_PIXEL* pPixels, UINT width, UINT height, const RECT& region )
+{
+    KINECT_DEPTH_REGION_STATS stats;
+    ZeroMemory( &stats, sizeof(stats) );
+
+    LONG left = max( region.left, 0L ), top = max( region.top, 0L );
+    LONG right = min( region.right, static_cast<LONG>(width) ), bottom = min( region.bottom, static_cast<LONG>(height) );
+    if( left >= right || top >= bottom )
+    {
+        return stats;
+    }
+
+    double sum = 0.0, sumSq = 0.0;
+    for( LONG y = top; y < bottom; ++y )
+    {
+        for( LONG x = left; x < right; ++x )
+        {
+            USHORT depth = pPixels[y * width + x].depth;
+            if( depth >= MIN_DEPTH && depth <= MAX_DEPTH )
+            {
+                ++stats.cValidPixels;
+                sum += depth;
+                sumSq += static_cast<double>(depth) * depth;
+            }
+        }
+    }
+
+    stats.cPixels = (right - left) * (bottom - top);
+    stats.fValidRatio = static_cast<float>(stats.cValidPixels) / stats.cPixels;
+    if( 0 != stats.cValidPixels )
+    {
+        double mean = sum / stats.cValidPixels;
+        stats.fMeanDepth = static_cast<float>(mean);
+        stats.fVariance = static_cast<float>( sumSq / stats.cValidPixels - mean * mean );
+    }
+    return stats;
+}
+
+// regions of every size, a few reaching out of the image or empty
+static std::vector<RECT> MakeRegions( UINT width, UINT height, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<RECT> regions;
+
+    RECT whole = { 0, 0, static_cast<LONG>(width), static_cast<LONG>(height) };
+    RECT pixel = { 1, 1, 2, 2 };
+    RECT outside = { -20, -5, static_cast<LONG>(width) + 7, 3 };
+    RECT empty = { 5, 5, 5, 9 };
+    regions.push_back( whole );
+    regions.push_back( pixel );
+    regions.push_back( outside );
+    regions.push_back( empty );
+
+    for( UINT i = 0; i < 200; ++i )
+    {
+        RECT region;
+        region.left = static_cast<LONG>( random.Next() % (width + 10) ) - 5;
+        region.top = static_cast<LONG>( random.Next() % (height + 10) ) - 5;
+        region.right = region.left + 1 + static_cast<LONG>( random.Next() % width );
+        region.bottom = region.top + 1 + static_cast<LONG>( random.Next() % height );
+        regions.push_back( region );
+    }
+    return regions;
+}
+
+static UINT CountMismatches( const std::vector<KINECT_DEPTH_REGION_STATS>& stats, const NUI_DEPTH_IMAGE_PIXEL* pPixels, UINT width, UINT height,
+    const std::vector<RECT>& regions )
+{
+    UINT cMismatches = 0;
+    for( size_t i = 0; i < regions.size(); ++i )
+    {
+        KINECT_DEPTH_REGION_STATS expected = BruteForceStats( pPixels, width, height, regions[i] );
+        const KINECT_DEPTH_REGION_STATS& actual = stats[i];
+
+        bool bMatch = expected.cPixels == actual.cPixels && expected.cValidPixels == actual.cValidPixels &&
+            expected.fValidRatio == actual.fValidRatio &&
+            fabs( expected.fMeanDepth - actual.fMeanDepth ) <= 1e-3f &&
+            fabs( expected.fVariance - actual.fVariance ) <= 1e-5f * max( expected.fVariance, 1.0f );
+        cMismatches += !bMatch;
+    }
+    return cMismatches;
+}
+
+// both depth formats, widths that leave a rest after the 8 pixels at a time, bands and strips that do not divide the frame
+static void TestMatchesBruteForce( UINT width, UINT height )
+{
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, width * height );
+    std::vector<USHORT> packed = PackDepth( pixels );
+    std::vector<RECT> regions = MakeRegions( width, height, width );
+    std::vector<KINECT_DEPTH_REGION_STATS> stats( regions.size() );
+
+    ImageTransform transform;
+    DepthIntegral integral;
+    integral.SetEnabled( true );
+
+    integral.Process( reinterpret_cast<const BYTE*>(pixels.data()), width * sizeof(NUI_DEPTH_IMAGE_PIXEL), width, height, true, MIN_DEPTH, MAX_DEPTH );
+    KCB_CHECK_HR( integral.GetRegionStats( transform, static_cast<ULONG>(regions.size()), regions.data(), stats.data() ), S_OK );
+    KCB_CHECK( 0 == CountMismatches( stats, pixels.data(), width, height, regions ) );
+
+    integral.Process( reinterpret_cast<const BYTE*>(packed.data()), width * sizeof(USHORT), width, height, false, MIN_DEPTH, MAX_DEPTH );
+    KCB_CHECK_HR( integral.GetRegionStats( transform, static_cast<ULONG>(regions.size()), regions.data(), stats.data() ), S_OK );
+    KCB_CHECK( 0 == CountMismatches( stats, pixels.data(), width, height, regions ) );
+}
+
+// regions in the orientation of the transform give the statistics of the transformed image
+static void TestTransform()
+{
+    const UINT width = 80, height = 60;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, 21 );
+
+    DepthIntegral integral;
+    integral.SetEnabled( true );
+    integral.Process( reinterpret_cast<const BYTE*>(pixels.data()), width * sizeof(NUI_DEPTH_IMAGE_PIXEL), width, height, true, MIN_DEPTH, MAX_DEPTH );
+
+    static const KINECT_IMAGE_ROTATION rotations[] = { ImageRotationNone, ImageRotation90, ImageRotation180, ImageRotation270 };
+    for( UINT r = 0; r < _countof(rotations); ++r )
+    {
+        for( UINT mirror = 0; mirror < 2; ++mirror )
+        {
+            KINECT_IMAGE_TRANSFORM params = { sizeof(KINECT_IMAGE_TRANSFORM), 0 != mirror, rotations[r] };
+            ImageTransform transform;
+            transform.SetParameters( params );
+
+            UINT outWidth = 0, outHeight = 0;
+            transform.GetOutputSize( width, height, outWidth, outHeight );
+            std::vector<NUI_DEPTH_IMAGE_PIXEL> transformed( pixels.size() );
+            transform.Reorder( pixels.data(), width, height, false, transformed.data() );
+
+            std::vector<RECT> regions = MakeRegions( outWidth, outHeight, r * 2 + mirror );
+            std::vector<KINECT_DEPTH_REGION_STATS> stats( regions.size() );
+            KCB_CHECK_HR( integral.GetRegionStats( transform, static_cast<ULONG>(regions.size()), regions.data(), stats.data() ), S_OK );
+            KCB_CHECK( 0 == CountMismatches( stats, transformed.data(), outWidth, outHeight, regions ) );
+        }
+    }
+}
+
+static void TestNoData()
+{
+    const UINT width = 16, height = 8;
+    std::vector<USHORT> packed( width * height, static_cast<USHORT>( 1000 << NUI_IMAGE_PLAYER_INDEX_SHIFT ) );
+    RECT region = { 0, 0, 4, 4 };
+    KINECT_DEPTH_REGION_STATS stats;
+    ImageTransform transform;
+
+    DepthIntegral integral;
+    KCB_CHECK_HR( integral.GetRegionStats( transform, 1, &region, &stats ), E_NUI_FRAME_NO_DATA );
+
+    integral.SetEnabled( true );
+    KCB_CHECK_HR( integral.GetRegionStats( transform, 1, &region, &stats ), E_NUI_FRAME_NO_DATA );
+
+    integral.Process( reinterpret_cast<const BYTE*>(packed.data()), width * sizeof(USHORT), width, height, false, MIN_DEPTH, MAX_DEPTH );
+    KCB_CHECK_HR( integral.GetRegionStats( transform, 1, &region, &stats ), S_OK );
+    KCB_CHECK( 16 == stats.cValidPixels && 1000.0f == stats.fMeanDepth && 0.0f == stats.fVariance );
+
+    // enabling again waits for the next frame
+    integral.SetEnabled( true );
+    KCB_CHECK_HR( integral.GetRegionStats( transform, 1, &region, &stats ), E_NUI_FRAME_NO_DATA );
+}
+
+static void BenchmarkProcess( UINT width, UINT height )
+{
+    std::vector<USHORT> packed = PackDepth( MakeDepthPixels( width, height, 9 ) );
+    std::vector<RECT> regions = MakeRegions( width, height, 4 );
+    std::vector<KINECT_DEPTH_REGION_STATS> stats( regions.size() );
+    ImageTransform transform;
+
+    DepthIntegral integral;
+    integral.SetEnabled( true );
+
+    const int cRuns = 50;
+    Stopwatch processTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        integral.Process( reinterpret_cast<const BYTE*>(packed.data()), width * sizeof(USHORT), width, height, false, MIN_DEPTH, MAX_DEPTH );
+    }
+    double processUs = processTime.ElapsedMicroseconds() / cRuns;
+
+    Stopwatch statsTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        integral.GetRegionStats( transform, static_cast<ULONG>(regions.size()), regions.data(), stats.data() );
+    }
+    double statsUs = statsTime.ElapsedMicroseconds() / cRuns;
+
+    printf( "depth integral %ux%u: tables %.0f us, %u regions %.1f us\n", width, height, processUs, static_cast<UINT>(regions.size()), statsUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestMatchesBruteForce( 640, 480 );
+    TestMatchesBruteForce( 643, 37 );
+    TestMatchesBruteForce( 80, 60 );
+    TestMatchesBruteForce( 5, 3 );
+    TestTransform();
+    TestNoData();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkProcess( 320, 240 );
+        BenchmarkProcess( 640, 480 );
+    }
+
+    return ReportTestResult( "DepthIntegralTests" );
+}
@@ -0,0 +1,546 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "GestureRecognizer.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+static const LONGLONG FRAME_MS = 33;
+static const UINT GESTURE_FRAMES = 30;
+static const UINT GESTURE_COUNT = 32;
+static const float PI = 3.14159265f;
+
+// tighter than the default, the half turns from neighboring directions share most of their path
+static const float GESTURE_THRESHOLD = 0.2f;
+
+static const DWORD ARM_JOINTS = (1 << NUI_SKELETON_POSITION_ELBOW_RIGHT) | (1 << NUI_SKELETON_POSITION_WRIST_RIGHT) | (1 << NUI_SKELETON_POSITION_HAND_RIGHT);
+
+// the right arm straight out from the shoulder along dx, dy, dz
+static void SetArm( _Inout_ NUI_SKELETON_DATA& skeleton, float dx, float dy, float dz )
+{
+    const Vector4& shoulder = skeleton.SkeletonPositions[NUI_SKELETON_POSITION_SHOULDER_RIGHT];
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_ELBOW_RIGHT] = MakeVector( shoulder.x + 0.30f * dx, shoulder.y + 0.30f * dy, shoulder.z + 0.30f * dz );
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_WRIST_RIGHT] = MakeVector( shoulder.x + 0.55f * dx, shoulder.y + 0.55f * dy, shoulder.z + 0.55f * dz );
+    skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HAND_RIGHT] = MakeVector( shoulder.x + 0.65f * dx, shoulder.y + 0.65f * dy, shoulder.z + 0.65f * dz );
+}
+
+// gesture g sweeps the arm from one of 8 directions by a quarter or half turn either way,
+// bulging out of the plane of the body halfway; t from 0 to 1
+static NUI_SKELETON_DATA MakeGestureSkeleton( DWORD dwTrackingID, UINT g, float t )
+{
+    float start = (g % 8) * PI / 4.0f;
+    float sweep = ((g / 8) % 2 ? -1.0f : 1.0f) * (g < 16 ? PI / 2.0f : PI);
+    float angle = start + sweep * t;
+
+    NUI_SKELETON_DATA skeleton = MakeSkeleton( dwTrackingID, 0.0f, 0.0f, 2.0f );
+    SetArm( skeleton, cosf( angle ), sinf( angle ), 0.3f * sinf( PI * t ) );
+    return skeleton;
+}
+
+// the arm down and forward, away from every gesture
+static NUI_SKELETON_DATA MakeRestSkeleton( DWORD dwTrackingID )
+{
+    NUI_SKELETON_DATA skeleton = MakeSkeleton( dwTrackingID, 0.0f, 0.0f, 2.0f );
+    SetArm( skeleton, 0.0f, -0.5f, -0.85f );
+    return skeleton;
+}
+
+// turns the skeleton by heading around the vertical axis through the hip center, scales it
+// and moves the hip center to x, y, z
+static void PlaceSkeleton( _Inout_ NUI_SKELETON_DATA& skeleton, float heading, float scale, float x, float y, float z )
+{
+    Vector4 hip = skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HIP_CENTER];
+    float c = cosf( heading ), s = sinf( heading );
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        Vector4& v = skeleton.SkeletonPositions[j];
+        float dx = (v.x - hip.x) * scale, dy = (v.y - hip.y) * scale, dz = (v.z - hip.z) * scale;
+        v = MakeVector( x + c * dx - s * dz, y + dy, z + s * dx + c * dz );
+    }
+    skeleton.Position = MakeVector( x, y, z );
+}
+
+static void AddTemplates( GestureRecognizer& recognizer, UINT cGestures, _Out_cap_(cGestures) DWORD* pdwGestureIDs )
+{
+    std::vector<Vector4> positions( GESTURE_FRAMES * NUI_SKELETON_POSITION_COUNT );
+    for( UINT g = 0; g < cGestures; ++g )
+    {
+        for( UINT f = 0; f < GESTURE_FRAMES; ++f )
+        {
+            NUI_SKELETON_DATA skeleton = MakeGestureSkeleton( 1, g, f / (GESTURE_FRAMES - 1.0f) );
+            memcpy( &positions[f * NUI_SKELETON_POSITION_COUNT], skeleton.SkeletonPositions, sizeof(skeleton.SkeletonPositions) );
+        }
+
+        KINECT_GESTURE_TEMPLATE gesture = { sizeof(KINECT_GESTURE_TEMPLATE), ARM_JOINTS, GESTURE_FRAMES, positions.data(), GESTURE_THRESHOLD, 0.0f };
+        KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &pdwGestureIDs[g] ), S_OK );
+    }
+}
+
+// a player resting and doing random gestures at their own pace, with jittery arm joints;
+// a gesture takes up to a tenth longer than its template and the warping stays inside the band
+struct Performance
+{
+    UINT gesture;               // GESTURE_COUNT while resting
+    UINT cFrames;
+    UINT frame;
+    float warp;                 // exponent of the time of the gesture
+    float sigma;                // m of jitter
+    UINT cDone;
+};
+
+static NUI_SKELETON_DATA Perform( DWORD dwTrackingID, _Inout_ Performance& performance, TestRandom& random, UINT cGestures )
+{
+    if( performance.frame == performance.cFrames )
+    {
+        if( GESTURE_COUNT == performance.gesture )
+        {
+            performance.gesture = random.Next() % cGestures;
+            performance.cFrames = static_cast<UINT>( GESTURE_FRAMES * (1.0f + 0.1f * random.Uniform()) );
+            performance.warp = 0.85f + 0.3f * random.Uniform();
+
+            // half of them sloppy, close to the threshold or over it
+            performance.sigma = (random.Uniform() < 0.5f) ? 0.01f : 0.05f + 0.025f * random.Uniform();
+        }
+        else
+        {
+            ++performance.cDone;
+            performance.gesture = GESTURE_COUNT;
+            performance.cFrames = 10 + random.Next() % 20;
+        }
+        performance.frame = 0;
+    }
+
+    NUI_SKELETON_DATA skeleton = (GESTURE_COUNT == performance.gesture)
+        ? MakeRestSkeleton( dwTrackingID )
+        : MakeGestureSkeleton( dwTrackingID, performance.gesture, powf( performance.frame / (performance.cFrames - 1.0f), performance.warp ) );
+    ++performance.frame;
+
+    for( UINT j = NUI_SKELETON_POSITION_ELBOW_RIGHT; j <= NUI_SKELETON_POSITION_HAND_RIGHT; ++j )
+    {
+        skeleton.SkeletonPositions[j].x += random.Gaussian( performance.sigma );
+        skeleton.SkeletonPositions[j].y += random.Gaussian( performance.sigma );
+        skeleton.SkeletonPositions[j].z += random.Gaussian( performance.sigma );
+    }
+
+    return skeleton;
+}
+
+// the recognizer without the lower bound and without abandoning paths: every template is warped
+// over the whole band for every player in every frame, the events fire by the same rule
+class FullDtwRecognizer
+{
+public:
+    FullDtwRecognizer( UINT cGestures, _In_count_(cGestures) const DWORD* pdwGestureIDs )
+        : m_cGestures(cGestures)
+        , m_cBand(static_cast<UINT>( GESTURE_DEFAULT_BAND * GESTURE_FRAMES + 0.5f ))
+    {
+        m_gestureIDs.assign( pdwGestureIDs, pdwGestureIDs + cGestures );
+        m_templates.resize( cGestures * GESTURE_FRAMES * 9 );
+        for( UINT g = 0; g < cGestures; ++g )
+        {
+            for( UINT f = 0; f < GESTURE_FRAMES; ++f )
+            {
+                NUI_SKELETON_DATA skeleton = MakeGestureSkeleton( 1, g, f / (GESTURE_FRAMES - 1.0f) );
+                Normalize( skeleton, &m_templates[(g * GESTURE_FRAMES + f) * 9] );
+            }
+        }
+
+        for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+        {
+            m_players[p].dwTrackingID = 0;
+            m_players[p].states.resize( cGestures );
+        }
+    }
+
+    void Process( _In_ const NUI_SKELETON_FRAME& skeletonFrame )
+    {
+        for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+        {
+            const NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[p];
+            Player& player = m_players[p];
+            if( NUI_SKELETON_TRACKED != skeleton.eTrackingState )
+            {
+                continue;
+            }
+
+            if( player.dwTrackingID != skeleton.dwTrackingID )
+            {
+                player.dwTrackingID = skeleton.dwTrackingID;
+                player.frames.clear();
+                player.states.assign( m_cGestures, State() );
+            }
+
+            float normalized[9];
+            Normalize( skeleton, normalized );
+            player.frames.insert( player.frames.end(), normalized, normalized + 9 );
+            if( player.frames.size() > GESTURE_FRAMES * 9 )
+            {
+                player.frames.erase( player.frames.begin(), player.frames.begin() + 9 );
+            }
+
+            for( UINT g = 0; g < m_cGestures; ++g )
+            {
+                State& state = player.states[g];
+                if( 0 < state.cRestFrames )
+                {
+                    --state.cRestFrames;
+                    continue;
+                }
+
+                float distance = (player.frames.size() == GESTURE_FRAMES * 9) ? Warp( player, g ) : FLT_MAX;
+                if( FLT_MAX != distance && (0.0f == state.fPending || distance < state.fPending) )
+                {
+                    state.fPending = distance;
+                    state.liPending = skeletonFrame.liTimeStamp.QuadPart;
+                }
+                else if( 0.0f != state.fPending )
+                {
+                    KINECT_GESTURE_EVENT gestureEvent = { m_gestureIDs[g], player.dwTrackingID, state.liPending, state.fPending, 0.0f };
+                    m_events.push_back( gestureEvent );
+                    state.fPending = 0.0f;
+                    state.cRestFrames = GESTURE_FRAMES / 2;
+                }
+            }
+        }
+    }
+
+    const std::vector<KINECT_GESTURE_EVENT>& Events() const { return m_events; }
+
+private:
+    struct State
+    {
+        State() : fPending(0.0f), liPending(0), cRestFrames(0) {}
+
+        float fPending;
+        LONGLONG liPending;
+        UINT cRestFrames;
+    };
+
+    struct Player
+    {
+        DWORD dwTrackingID;
+        std::vector<float> frames;      // the last GESTURE_FRAMES frames of the arm
+        std::vector<State> states;
+    };
+
+    // the arm joints relative to the hip center and the heading of the shoulders, in torso lengths
+    static void Normalize( _In_ const NUI_SKELETON_DATA& skeleton, _Out_cap_(9) float* pNormalized )
+    {
+        const Vector4* pPositions = skeleton.SkeletonPositions;
+        const Vector4& hip = pPositions[NUI_SKELETON_POSITION_HIP_CENTER];
+        const Vector4& shoulder = pPositions[NUI_SKELETON_POSITION_SHOULDER_CENTER];
+        float dx = pPositions[NUI_SKELETON_POSITION_SHOULDER_RIGHT].x - pPositions[NUI_SKELETON_POSITION_SHOULDER_LEFT].x;
+        float dz = pPositions[NUI_SKELETON_POSITION_SHOULDER_RIGHT].z - pPositions[NUI_SKELETON_POSITION_SHOULDER_LEFT].z;
+        float width = sqrtf( dx * dx + dz * dz );
+        float torso = sqrtf( (shoulder.x - hip.x) * (shoulder.x - hip.x) + (shoulder.y - hip.y) * (shoulder.y - hip.y) + (shoulder.z - hip.z) * (shoulder.z - hip.z) );
+
+        for( UINT i = 0; i < 3; ++i )
+        {
+            const Vector4& v = pPositions[NUI_SKELETON_POSITION_ELBOW_RIGHT + i];
+            float x = v.x - hip.x, y = v.y - hip.y, z = v.z - hip.z;
+            pNormalized[i * 3] = (dx * x + dz * z) / width / torso;
+            pNormalized[i * 3 + 1] = y / torso;
+            pNormalized[i * 3 + 2] = (dx * z - dz * x) / width / torso;
+        }
+    }
+
+    // root mean square joint distance of the best path, FLT_MAX over the threshold
+    float Warp( _In_ const Player& player, UINT g ) const
+    {
+        const UINT n = GESTURE_FRAMES;
+        std::vector<float> cost( (n + 1) * (n + 1), FLT_MAX );
+        cost[0] = 0.0f;
+        for( UINT i = 1; i <= n; ++i )
+        {
+            UINT first = (i > m_cBand) ? i - m_cBand : 1;
+            UINT last = min( n, i + m_cBand );
+            for( UINT j = first; j <= last; ++j )
+            {
+                const float* pQuery = &player.frames[(i - 1) * 9];
+                const float* pTemplate = &m_templates[(g * n + j - 1) * 9];
+                float distance = 0.0f;
+                for( UINT d = 0; d < 9; ++d )
+                {
+                    distance += (pQuery[d] - pTemplate[d]) * (pQuery[d] - pTemplate[d]);
+                }
+
+                float best = min( cost[(i - 1) * (n + 1) + j - 1], min( cost[(i - 1) * (n + 1) + j], cost[i * (n + 1) + j - 1] ) );
+                cost[i * (n + 1) + j] = best + distance;
+            }
+        }
+
+        float limit = GESTURE_THRESHOLD * GESTURE_THRESHOLD * n * 3;
+        return (cost[n * (n + 1) + n] <= limit) ? sqrtf( cost[n * (n + 1) + n] / (n * 3) ) : FLT_MAX;
+    }
+
+private:
+    UINT m_cGestures;
+    UINT m_cBand;
+    std::vector<DWORD> m_gestureIDs;
+    std::vector<float> m_templates;     // GESTURE_FRAMES normalized frames of every gesture
+    Player m_players[NUI_SKELETON_COUNT];
+    std::vector<KINECT_GESTURE_EVENT> m_events;
+};
+
+// two players, the second one turned away, taller and off to the side
+static NUI_SKELETON_FRAME PerformFrame( _Inout_ Performance* pPerformances, TestRandom& random, UINT cGestures, UINT frame )
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 1000 + frame * FRAME_MS, frame );
+    skeletonFrame.SkeletonData[0] = Perform( 101, pPerformances[0], random, cGestures );
+    skeletonFrame.SkeletonData[3] = Perform( 102, pPerformances[1], random, cGestures );
+    PlaceSkeleton( skeletonFrame.SkeletonData[3], 0.5f, 1.2f, -0.8f, 0.1f, 3.0f );
+    return skeletonFrame;
+}
+
+static void TakeEvents( GestureRecognizer& recognizer, _Inout_ std::vector<KINECT_GESTURE_EVENT>& events )
+{
+    KINECT_GESTURE_EVENT buffer[8];
+    ULONG cEvents = 0;
+    do
+    {
+        recognizer.GetEvents( _countof(buffer), buffer, &cEvents );
+        events.insert( events.end(), buffer, buffer + cEvents );
+    } while( cEvents == _countof(buffer) );
+}
+
+// pruning with the envelope and abandoning paths over the threshold fires exactly the events the
+// full warping does, and every gesture done is recognized, for every place and heading of the player
+static void TestMatchesFullDtw()
+{
+    GestureRecognizer recognizer;
+    DWORD gestureIDs[GESTURE_COUNT];
+    AddTemplates( recognizer, GESTURE_COUNT, gestureIDs );
+    KCB_CHECK( recognizer.IsEnabled() );
+
+    FullDtwRecognizer reference( GESTURE_COUNT, gestureIDs );
+
+    TestRandom random( 44 );
+    Performance performances[2] = { { GESTURE_COUNT, 0, 0, 1.0f, 0.01f, 0 }, { GESTURE_COUNT, 0, 0, 1.0f, 0.01f, 0 } };
+    std::vector<KINECT_GESTURE_EVENT> events;
+    std::vector<UINT> done[2];
+    UINT cMissed = 0;
+    for( UINT frame = 0; frame < 3000; ++frame )
+    {
+        NUI_SKELETON_FRAME skeletonFrame = PerformFrame( performances, random, GESTURE_COUNT, frame );
+        recognizer.Process( skeletonFrame );
+        reference.Process( skeletonFrame );
+        TakeEvents( recognizer, events );
+
+        // a clean gesture just done fired within a few frames of its end
+        for( UINT p = 0; p < 2; ++p )
+        {
+            const Performance& performance = performances[p];
+            if( GESTURE_COUNT != performance.gesture && performance.frame == performance.cFrames && 0.01f == performance.sigma )
+            {
+                done[p].push_back( frame );
+            }
+        }
+        for( UINT p = 0; p < 2; ++p )
+        {
+            while( !done[p].empty() && frame >= done[p].front() + GESTURE_FRAMES / 2 )
+            {
+                LONGLONG liEnd = 1000 + done[p].front() * FRAME_MS;
+                bool bFound = false;
+                for( size_t e = 0; e < events.size(); ++e )
+                {
+                    bFound = bFound || (101 + p == events[e].dwTrackingID && llabs( events[e].liTimeStamp - liEnd ) <= 3 * FRAME_MS);
+                }
+                cMissed += bFound ? 0 : 1;
+                done[p].erase( done[p].begin() );
+            }
+        }
+    }
+
+    printf( "%u and %u gestures done, %u events, %u missed\n", performances[0].cDone, performances[1].cDone, static_cast<UINT>( events.size() ), cMissed );
+    KCB_CHECK( performances[0].cDone > 40 && performances[1].cDone > 40 );
+    KCB_CHECK( 0 == cMissed );
+
+    // the sloppy gestures put matches close to the threshold, where a bound that is too high
+    // or a path abandoned too early would lose them
+    UINT cClose = 0;
+    for( size_t e = 0; e < events.size(); ++e )
+    {
+        cClose += (events[e].fDistance > 0.75f * GESTURE_THRESHOLD) ? 1 : 0;
+    }
+    printf( "%u events within a quarter of the threshold\n", cClose );
+    KCB_CHECK( cClose > 5 );
+
+    const std::vector<KINECT_GESTURE_EVENT>& expected = reference.Events();
+    KCB_CHECK( expected.size() == events.size() );
+
+    // the reference fires the players of a frame in another order
+    UINT cMatched = 0;
+    for( size_t e = 0; e < expected.size(); ++e )
+    {
+        for( size_t i = 0; i < events.size(); ++i )
+        {
+            if( events[i].dwGestureID == expected[e].dwGestureID && events[i].dwTrackingID == expected[e].dwTrackingID &&
+                events[i].liTimeStamp == expected[e].liTimeStamp && fabsf( events[i].fDistance - expected[e].fDistance ) < 1e-4f )
+            {
+                ++cMatched;
+                KCB_CHECK_NEAR( events[i].fConfidence, 1.0f - events[i].fDistance / GESTURE_THRESHOLD, 1e-5 );
+                break;
+            }
+        }
+    }
+    KCB_CHECK( expected.size() == cMatched );
+}
+
+// a gesture with a warp inside the band matches, the right one of the templates, once
+static void TestRecognize()
+{
+    GestureRecognizer recognizer;
+    DWORD gestureIDs[GESTURE_COUNT];
+    AddTemplates( recognizer, GESTURE_COUNT, gestureIDs );
+
+    UINT frame = 0;
+    for( ; frame < 20; ++frame )
+    {
+        NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( frame * FRAME_MS, frame );
+        skeletonFrame.SkeletonData[1] = MakeRestSkeleton( 7 );
+        recognizer.Process( skeletonFrame );
+    }
+
+    const UINT cFrames = GESTURE_FRAMES + 3;
+    for( UINT f = 0; f < cFrames; ++f, ++frame )
+    {
+        NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( frame * FRAME_MS, frame );
+        skeletonFrame.SkeletonData[1] = MakeGestureSkeleton( 7, 21, powf( f / (cFrames - 1.0f), 1.2f ) );
+        recognizer.Process( skeletonFrame );
+
+        // the same frame again is skipped
+        recognizer.Process( skeletonFrame );
+    }
+    LONGLONG liEnd = (frame - 1) * FRAME_MS;
+
+    for( UINT f = 0; f < 20; ++f, ++frame )
+    {
+        NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( frame * FRAME_MS, frame );
+        skeletonFrame.SkeletonData[1] = MakeRestSkeleton( 7 );
+        recognizer.Process( skeletonFrame );
+    }
+
+    KINECT_GESTURE_EVENT events[4];
+    ULONG cEvents = 0;
+    recognizer.GetEvents( _countof(events), events, &cEvents );
+    KCB_CHECK( 1 == cEvents );
+    KCB_CHECK( gestureIDs[21] == events[0].dwGestureID && 7 == events[0].dwTrackingID );
+    KCB_CHECK( llabs( events[0].liTimeStamp - liEnd ) <= 2 * FRAME_MS );
+    KCB_CHECK( events[0].fDistance < 0.1f && events[0].fConfidence > 0.6f );
+
+    recognizer.GetEvents( _countof(events), events, &cEvents );
+    KCB_CHECK( 0 == cEvents );
+}
+
+static void TestTemplates()
+{
+    GestureRecognizer recognizer;
+    KCB_CHECK( !recognizer.IsEnabled() );
+
+    std::vector<Vector4> positions( (GESTURE_MAX_FRAMES + 1) * NUI_SKELETON_POSITION_COUNT );
+    for( UINT f = 0; f <= GESTURE_MAX_FRAMES; ++f )
+    {
+        NUI_SKELETON_DATA skeleton = MakeRestSkeleton( 1 );
+        memcpy( &positions[f * NUI_SKELETON_POSITION_COUNT], skeleton.SkeletonPositions, sizeof(skeleton.SkeletonPositions) );
+    }
+
+    DWORD dwGestureID = 0;
+    KINECT_GESTURE_TEMPLATE gesture = { sizeof(KINECT_GESTURE_TEMPLATE), 0, GESTURE_FRAMES, positions.data(), 0.0f, 0.0f };
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwGestureID ), E_INVALIDARG );
+    gesture.dwJointMask = 1u << NUI_SKELETON_POSITION_COUNT;
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwGestureID ), E_INVALIDARG );
+
+    gesture.dwJointMask = ARM_JOINTS;
+    gesture.cFrames = 1;
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwGestureID ), E_INVALIDARG );
+    gesture.cFrames = GESTURE_MAX_FRAMES + 1;
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwGestureID ), E_INVALIDARG );
+    gesture.cFrames = GESTURE_FRAMES;
+    gesture.pPositions = nullptr;
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwGestureID ), E_INVALIDARG );
+
+    // a frame without a torso
+    positions[NUI_SKELETON_POSITION_SHOULDER_CENTER] = positions[NUI_SKELETON_POSITION_HIP_CENTER];
+    gesture.pPositions = positions.data();
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwGestureID ), E_INVALIDARG );
+    KCB_CHECK( !recognizer.IsEnabled() );
+
+    gesture.pPositions = positions.data() + NUI_SKELETON_POSITION_COUNT;
+    gesture.cFrames = GESTURE_MAX_FRAMES;
+    DWORD dwFirstID = 0, dwSecondID = 0;
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwFirstID ), S_OK );
+    KCB_CHECK_HR( recognizer.AddTemplate( &gesture, &dwSecondID ), S_OK );
+    KCB_CHECK( 0 != dwFirstID && dwFirstID != dwSecondID );
+
+    KCB_CHECK_HR( recognizer.RemoveTemplate( dwFirstID ), S_OK );
+    KCB_CHECK_HR( recognizer.RemoveTemplate( dwFirstID ), E_INVALIDARG );
+    KCB_CHECK( recognizer.IsEnabled() );
+    KCB_CHECK_HR( recognizer.RemoveTemplate( 0 ), S_OK );
+    KCB_CHECK( !recognizer.IsEnabled() );
+}
+
+// the recognizer against the full warping of every template, both on the same frames
+static void BenchmarkRecognizer( UINT cGestures )
+{
+    GestureRecognizer recognizer;
+    DWORD gestureIDs[GESTURE_COUNT];
+    AddTemplates( recognizer, cGestures, gestureIDs );
+    FullDtwRecognizer reference( cGestures, gestureIDs );
+
+    TestRandom random( 45 );
+    Performance performances[2] = { { GESTURE_COUNT, 0, 0, 1.0f, 0.01f, 0 }, { GESTURE_COUNT, 0, 0, 1.0f, 0.01f, 0 } };
+    const UINT cFrames = 1000;
+    std::vector<NUI_SKELETON_FRAME> frames( cFrames );
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        frames[frame] = PerformFrame( performances, random, cGestures, frame );
+    }
+
+    Stopwatch time;
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        recognizer.Process( frames[frame] );
+    }
+    double pruned = time.ElapsedMicroseconds() / cFrames;
+
+    time.Restart();
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        reference.Process( frames[frame] );
+    }
+    double full = time.ElapsedMicroseconds() / cFrames;
+
+    printf( "%u templates of %u frames, 2 players: %.1f us per frame pruned, %.1f us full DTW, %.1fx\n",
+        cGestures, GESTURE_FRAMES, pruned, full, full / pruned );
+}
+
+int main( int argc, char** argv )
+{
+    TestTemplates();
+    TestRecognize();
+    TestMatchesFullDtw();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkRecognizer( 8 );
+        BenchmarkRecognizer( GESTURE_COUNT );
+    }
+
+    return ReportTestResult( "GestureRecognizerTests" );
+}
@@ -0,0 +1,203 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "ImageCodec.h"
+
+// the layout of the header, see ImageCodec.cpp
+struct EncodedHeader
+{
+    UINT32 magic;
+    UINT32 width;
+    UINT32 height;
+    UINT32 bytesPerPixel;
+    UINT32 bandRows;
+    UINT32 cBands;
+};
+
+static KINECT_IMAGE_FRAME_FORMAT MakeFormat( DWORD width, DWORD height, ULONG bytesPerPixel )
+{
+    KINECT_IMAGE_FRAME_FORMAT format = { sizeof(KINECT_IMAGE_FRAME_FORMAT), height, width, bytesPerPixel, width * height * bytesPerPixel };
+    return format;
+}
+
+// smooth gradients with sensor noise and a flat area, like a room seen by the camera
+static std::vector<BYTE> MakeImage( const KINECT_IMAGE_FRAME_FORMAT& format, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<BYTE> image( format.cbBufferSize );
+
+    for( DWORD y = 0; y < format.dwHeight; ++y )
+    {
+        for( DWORD x = 0; x < format.dwWidth; ++x )
+        {
+            bool bFlat = x < format.dwWidth / 4;
+            BYTE* pPixel = &image[(y * format.dwWidth + x) * format.cbBytesPerPixel];
+
+            for( ULONG c = 0; c < format.cbBytesPerPixel; ++c )
+            {
+                UINT value = bFlat ? 40 : (x + 2 * y + 50 * c) + (random.Next() & 3);
+                pPixel[c] = static_cast<BYTE>( value );
+            }
+
+            if( 4 == format.cbBytesPerPixel )
+            {
+                pPixel[3] = 0xff;
+            }
+        }
+    }
+
+    return image;
+}
+
+static void TestRoundTrip( DWORD width, DWORD height, ULONG bytesPerPixel )
+{
+    KINECT_IMAGE_FRAME_FORMAT format = MakeFormat( width, height, bytesPerPixel );
+    std::vector<BYTE> image = MakeImage( format, width + bytesPerPixel );
+
+    ULONG cbBound = ImageCodec::GetEncodedBound( format );
+    KCB_CHECK( cbBound > 0 );
+
+    std::vector<BYTE> encoded( cbBound );
+    ULONG cbWritten = 0;
+    KCB_CHECK_HR( ImageCodec::Encode( format, image.data(), cbBound, encoded.data(), cbWritten ), S_OK );
+    KCB_CHECK( cbWritten > 0 && cbWritten <= cbBound );
+
+    KINECT_IMAGE_FRAME_FORMAT decodedFormat;
+    KCB_CHECK_HR( ImageCodec::GetFormat( cbWritten, encoded.data(), decodedFormat ), S_OK );
+    KCB_CHECK( decodedFormat.dwWidth == width && decodedFormat.dwHeight == height );
+    KCB_CHECK( decodedFormat.cbBytesPerPixel == bytesPerPixel && decodedFormat.cbBufferSize == format.cbBufferSize );
+
+    std::vector<BYTE> decoded( format.cbBufferSize, 0xcd );
+    KCB_CHECK_HR( ImageCodec::Decode( cbWritten, encoded.data(), format.cbBufferSize, decoded.data() ), S_OK );
+    KCB_CHECK( decoded == image );
+
+    // a buffer that is one byte short is refused before anything is written
+    KCB_CHECK_HR( ImageCodec::Decode( cbWritten, encoded.data(), format.cbBufferSize - 1, decoded.data() ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+    KCB_CHECK_HR( ImageCodec::Encode( format, image.data(), cbBound - 1, encoded.data(), cbWritten ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+}
+
+// width * height * bytesPerPixel of the header wraps around in 32 bits
+static void TestOverflowingHeader()
+{
+    const UINT32 width = 0x10000;
+    const UINT32 height = 0x10001;
+    const UINT32 cbWrapped = width * height * 4;     // 0x40000 after the wrap
+    const UINT32 cBands = (height + 31) / 32;
+    const UINT32 cbRuns = 2000;
+
+    // the first band repeats a pixel 124000 times, more than the wrapped size holds
+    std::vector<BYTE> encoded( sizeof(EncodedHeader) + cBands * sizeof(UINT32) + cbRuns, 0xfd );
+    EncodedHeader header = { 0x4942434b, width, height, 4, 32, cBands };
+    memcpy( encoded.data(), &header, sizeof(header) );
+    std::vector<UINT32> bandEnds( cBands, cbRuns );
+    memcpy( encoded.data() + sizeof(header), bandEnds.data(), cBands * sizeof(UINT32) );
+
+    KINECT_IMAGE_FRAME_FORMAT format;
+    KCB_CHECK_HR( ImageCodec::GetFormat( static_cast<ULONG>(encoded.size()), encoded.data(), format ),
+        HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+
+    std::vector<BYTE> image( cbWrapped );
+    KCB_CHECK_HR( ImageCodec::Decode( static_cast<ULONG>(encoded.size()), encoded.data(), cbWrapped, image.data() ),
+        HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+
+    // larger than any NUI stream without wrapping
+    header.width = 4096;
+    header.height = 4096;
+    header.cBands = 4096 / 32;
+    memcpy( encoded.data(), &header, sizeof(header) );
+    KCB_CHECK_HR( ImageCodec::GetFormat( static_cast<ULONG>(encoded.size()), encoded.data(), format ),
+        HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+}
+
+// damaged band data is reported, and never written outside of the image
+static void TestCorruptData()
+{
+    KINECT_IMAGE_FRAME_FORMAT format = MakeFormat( 160, 120, 4 );
+    std::vector<BYTE> image = MakeImage( format, 7 );
+
+    std::vector<BYTE> encoded( ImageCodec::GetEncodedBound( format ) );
+    ULONG cbWritten = 0;
+    KCB_CHECK_HR( ImageCodec::Encode( format, image.data(), static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+
+    TestRandom random( 11 );
+    std::vector<BYTE> decoded( format.cbBufferSize );
+    bool bReported = true;
+    for( int i = 0; i < 2000; ++i )
+    {
+        std::vector<BYTE> damaged( encoded.begin(), encoded.begin() + cbWritten );
+        damaged[sizeof(EncodedHeader) + random.Next() % (cbWritten - sizeof(EncodedHeader))] ^= static_cast<BYTE>( 1 + random.Next() % 255 );
+
+        HRESULT hr = ImageCodec::Decode( cbWritten, damaged.data(), format.cbBufferSize, decoded.data() );
+        bReported = bReported && (S_OK == hr || HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) == hr);
+    }
+    KCB_CHECK( bReported );
+
+    // cut off data
+    for( ULONG cb = 0; cb < cbWritten; cb += 97 )
+    {
+        KCB_CHECK( FAILED( ImageCodec::Decode( cb, encoded.data(), format.cbBufferSize, decoded.data() ) ) );
+    }
+}
+
+static void BenchmarkCodec( DWORD width, DWORD height, ULONG bytesPerPixel )
+{
+    KINECT_IMAGE_FRAME_FORMAT format = MakeFormat( width, height, bytesPerPixel );
+    std::vector<BYTE> image = MakeImage( format, 3 );
+    std::vector<BYTE> encoded( ImageCodec::GetEncodedBound( format ) );
+    std::vector<BYTE> decoded( format.cbBufferSize );
+
+    const int cRuns = 20;
+    ULONG cbWritten = 0;
+
+    Stopwatch encodeTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        ImageCodec::Encode( format, image.data(), static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten );
+    }
+    double encodeUs = encodeTime.ElapsedMicroseconds() / cRuns;
+
+    Stopwatch decodeTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        ImageCodec::Decode( cbWritten, encoded.data(), format.cbBufferSize, decoded.data() );
+    }
+    double decodeUs = decodeTime.ElapsedMicroseconds() / cRuns;
+
+    printf( "image %ux%u x%u: ratio %.2f, encode %.0f us (%.0f MB/s), decode %.0f us (%.0f MB/s)\n",
+        width, height, bytesPerPixel, static_cast<double>(format.cbBufferSize) / cbWritten,
+        encodeUs, format.cbBufferSize / encodeUs, decodeUs, format.cbBufferSize / decodeUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestRoundTrip( 640, 480, 4 );
+    TestRoundTrip( 1280, 960, 4 );
+    TestRoundTrip( 640, 480, 2 );
+    TestRoundTrip( 641, 33, 1 );
+    TestOverflowingHeader();
+    TestCorruptData();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkCodec( 1280, 960, 4 );
+        BenchmarkCodec( 640, 480, 4 );
+        BenchmarkCodec( 640, 480, 2 );
+    }
+
+    return ReportTestResult( "ImageCodecTests" );
+}
@@ -0,0 +1,242 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "PlayerSelector.h"
+
+// the players of a frame, one point each
+struct Players
+{
+    UINT cPlayers;
+    DWORD trackingIDs[NUI_SKELETON_COUNT];
+    Vector4 positions[NUI_SKELETON_COUNT];
+};
+
+static Players MakePlayers( UINT cPlayers, const DWORD* pTrackingIDs, const float* pZ )
+{
+    Players players;
+    ZeroMemory( &players, sizeof(players) );
+    players.cPlayers = cPlayers;
+    for( UINT i = 0; i < cPlayers; ++i )
+    {
+        players.trackingIDs[i] = pTrackingIDs[i];
+        players.positions[i] = MakeVector( 0.0f, 0.0f, pZ[i] );
+    }
+    return players;
+}
+
+// the choice of mode for players 1 and 2 at z1 and z2, one player in the modes for one like the skeleton stream
+static void ChooseTwo( PlayerSelector& selector, KINECT_SKELETON_SELECTION_MODE mode, float z1, float z2, _Out_writes_(2) DWORD* pChosen )
+{
+    static const DWORD trackingIDs[2] = { 1, 2 };
+    const float z[2] = { z1, z2 };
+    Players players = MakePlayers( 2, trackingIDs, z );
+
+    UINT cTrackIDs = (SkeletonSelectionModeClosest1 == mode || SkeletonSelectionModeSticky1 == mode
+        || SkeletonSelectionModeActive1 == mode || SkeletonSelectionModeZone1 == mode) ? 1 : 2;
+    pChosen[1] = 0;
+    selector.Choose( mode, players.cPlayers, players.trackingIDs, players.positions, pChosen, cTrackIDs );
+}
+
+// the closest player is only replaced by one closer by more than the hysteresis
+static void TestClosestHysteresis()
+{
+    PlayerSelector selector;
+    DWORD chosen[2];
+
+    ChooseTwo( selector, SkeletonSelectionModeClosest1, 2.0f, 2.3f, chosen );
+    KCB_CHECK( 1 == chosen[0] && 0 == chosen[1] );
+
+    // 5 cm closer is within the default hysteresis of 10 cm
+    ChooseTwo( selector, SkeletonSelectionModeClosest1, 2.0f, 1.95f, chosen );
+    KCB_CHECK( 1 == chosen[0] );
+
+    ChooseTwo( selector, SkeletonSelectionModeClosest1, 2.0f, 1.85f, chosen );
+    KCB_CHECK( 2 == chosen[0] );
+
+    // and now player 2 holds on the same way
+    ChooseTwo( selector, SkeletonSelectionModeClosest1, 1.8f, 1.85f, chosen );
+    KCB_CHECK( 2 == chosen[0] );
+
+    // a hysteresis of its own
+    KINECT_PLAYER_SELECTION selection = { sizeof(KINECT_PLAYER_SELECTION), 0.5f, 0, nullptr };
+    KCB_CHECK_HR( selector.SetParameters( &selection ), S_OK );
+    ChooseTwo( selector, SkeletonSelectionModeClosest1, 1.5f, 1.85f, chosen );
+    KCB_CHECK( 2 == chosen[0] );
+    ChooseTwo( selector, SkeletonSelectionModeClosest1, 1.3f, 1.85f, chosen );
+    KCB_CHECK( 1 == chosen[0] );
+
+    // both chosen, closest first
+    selector.Reset();
+    ChooseTwo( selector, SkeletonSelectionModeClosest2, 2.5f, 2.0f, chosen );
+    KCB_CHECK( 2 == chosen[0] && 1 == chosen[1] );
+}
+
+// a chosen sticky player is kept while it is seen, however close the others come
+static void TestSticky()
+{
+    PlayerSelector selector;
+    DWORD chosen[2];
+
+    ChooseTwo( selector, SkeletonSelectionModeSticky1, 2.0f, 3.0f, chosen );
+    KCB_CHECK( 1 == chosen[0] );
+    ChooseTwo( selector, SkeletonSelectionModeSticky1, 3.5f, 1.0f, chosen );
+    KCB_CHECK( 1 == chosen[0] );
+
+    // player 1 leaves, player 2 takes its place and keeps it when player 1 is back
+    static const DWORD onlyTwo[1] = { 2 };
+    static const float onlyTwoZ[1] = { 1.0f };
+    Players players = MakePlayers( 1, onlyTwo, onlyTwoZ );
+    selector.Choose( SkeletonSelectionModeSticky1, players.cPlayers, players.trackingIDs, players.positions, chosen, 1 );
+    KCB_CHECK( 2 == chosen[0] );
+    ChooseTwo( selector, SkeletonSelectionModeSticky1, 0.8f, 3.0f, chosen );
+    KCB_CHECK( 2 == chosen[0] );
+
+    // two places, a third player closer than both does not get one
+    static const DWORD three[3] = { 1, 2, 3 };
+    const float first[3] = { 2.0f, 2.5f, 3.0f };
+    const float later[3] = { 2.0f, 2.5f, 1.0f };
+    selector.Reset();
+    players = MakePlayers( 3, three, first );
+    selector.Choose( SkeletonSelectionModeSticky2, players.cPlayers, players.trackingIDs, players.positions, chosen, 2 );
+    KCB_CHECK( 1 == chosen[0] && 2 == chosen[1] );
+    players = MakePlayers( 3, three, later );
+    selector.Choose( SkeletonSelectionModeSticky2, players.cPlayers, players.trackingIDs, players.positions, chosen, 2 );
+    KCB_CHECK( 1 == chosen[0] && 2 == chosen[1] );
+}
+
+// a player enters inside a zone and leaves once it is the hysteresis outside of it
+static void TestZones()
+{
+    static const KINECT_INTERACTION_ZONE zones[2] =
+    {
+        { -0.5f, 0.5f, -1.0f, 1.0f, 1.5f, 2.5f },
+        { 1.0f, 2.0f, -1.0f, 1.0f, 3.0f, 4.0f },
+    };
+    KINECT_PLAYER_SELECTION selection = { sizeof(KINECT_PLAYER_SELECTION), 0.0f, 1, zones };
+
+    PlayerSelector selector;
+    KCB_CHECK_HR( selector.SetParameters( &selection ), S_OK );
+
+    // player 2 is always outside, and closer than player 1
+    static const float steps[] = { 2.7f, 2.4f, 2.55f, 2.59f, 2.65f, 2.55f, 2.5f };
+    static const DWORD expected[] = { 0, 1, 1, 1, 0, 0, 1 };
+    for( UINT i = 0; i < _countof(steps); ++i )
+    {
+        DWORD chosen[2];
+        ChooseTwo( selector, SkeletonSelectionModeZone1, steps[i], 1.0f, chosen );
+        KCB_CHECK( expected[i] == chosen[0] );
+        KCB_CHECK( 0 == chosen[1] );
+    }
+
+    // the closest of the players in any of the zones
+    selection.cZones = 2;
+    KCB_CHECK_HR( selector.SetParameters( &selection ), S_OK );
+    static const DWORD trackingIDs[3] = { 1, 2, 3 };
+    static const float z[3] = { 3.5f, 1.0f, 2.0f };
+    Players players = MakePlayers( 3, trackingIDs, z );
+    players.positions[0].x = 1.5f;
+
+    DWORD chosen[2];
+    selector.Choose( SkeletonSelectionModeZone2, players.cPlayers, players.trackingIDs, players.positions, chosen, 2 );
+    KCB_CHECK( 3 == chosen[0] && 1 == chosen[1] );
+
+    // without zones every player counts
+    KCB_CHECK_HR( selector.SetParameters( nullptr ), S_OK );
+    selector.Choose( SkeletonSelectionModeZone2, players.cPlayers, players.trackingIDs, players.positions, chosen, 2 );
+    KCB_CHECK( 2 == chosen[0] && 3 == chosen[1] );
+}
+
+// the players of a frame are the skeletons that are tracked or have a position
+static void TestFrame()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 1000, 1 );
+    skeletonFrame.SkeletonData[1] = MakeSkeleton( 11, 0.0f, 0.0f, 3.0f );
+    skeletonFrame.SkeletonData[4] = MakeSkeleton( 12, 0.0f, 0.0f, 2.0f );
+    skeletonFrame.SkeletonData[4].eTrackingState = NUI_SKELETON_POSITION_ONLY;
+    skeletonFrame.SkeletonData[5] = MakeSkeleton( 13, 0.0f, 0.0f, 1.0f );
+    skeletonFrame.SkeletonData[5].eTrackingState = NUI_SKELETON_NOT_TRACKED;
+
+    PlayerSelector selector;
+    DWORD chosen[3];
+    selector.Choose( SkeletonSelectionModeClosest2, skeletonFrame, chosen, 3 );
+    KCB_CHECK( 12 == chosen[0] && 11 == chosen[1] && 0 == chosen[2] );
+}
+
+static void TestInvalidParameters()
+{
+    static const KINECT_INTERACTION_ZONE zones[PLAYER_MAX_ZONES + 1] = {};
+
+    PlayerSelector selector;
+    KINECT_PLAYER_SELECTION selection = { sizeof(KINECT_PLAYER_SELECTION), 0.0f, 0, nullptr };
+    KCB_CHECK_HR( selector.SetParameters( &selection ), S_OK );
+
+    selection.dwStructSize = 0;
+    KCB_CHECK_HR( selector.SetParameters( &selection ), E_INVALIDARG );
+    selection.dwStructSize = sizeof(KINECT_PLAYER_SELECTION);
+
+    selection.fHysteresis = -0.1f;
+    KCB_CHECK_HR( selector.SetParameters( &selection ), E_INVALIDARG );
+    selection.fHysteresis = 0.0f;
+
+    selection.cZones = 1;
+    KCB_CHECK_HR( selector.SetParameters( &selection ), E_INVALIDARG );
+
+    selection.pZones = zones;
+    selection.cZones = PLAYER_MAX_ZONES + 1;
+    KCB_CHECK_HR( selector.SetParameters( &selection ), E_INVALIDARG );
+    selection.cZones = PLAYER_MAX_ZONES;
+    KCB_CHECK_HR( selector.SetParameters( &selection ), S_OK );
+}
+
+static void BenchmarkChoose()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 1000, 1 );
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        skeletonFrame.SkeletonData[s] = MakeSkeleton( 1 + s, -2.5f + s, 0.0f, 1.5f + 0.4f * s );
+    }
+
+    static const KINECT_INTERACTION_ZONE zone = { -1.0f, 1.0f, -1.0f, 1.0f, 1.0f, 3.0f };
+    KINECT_PLAYER_SELECTION selection = { sizeof(KINECT_PLAYER_SELECTION), 0.0f, 1, &zone };
+    PlayerSelector selector;
+    selector.SetParameters( &selection );
+
+    const int cRuns = 100000;
+    DWORD chosen[2];
+    Stopwatch time;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        selector.Choose( SkeletonSelectionModeZone2, skeletonFrame, chosen, 2 );
+    }
+
+    printf( "player selection, %d skeletons in a zone: %.3f us\n", NUI_SKELETON_COUNT, time.ElapsedMicroseconds() / cRuns );
+}
+
+int main( int argc, char** argv )
+{
+    TestClosestHysteresis();
+    TestSticky();
+    TestZones();
+    TestFrame();
+    TestInvalidParameters();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkChoose();
+    }
+
+    return ReportTestResult( "PlayerSelectorTests" );
+}
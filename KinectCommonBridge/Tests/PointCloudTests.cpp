@@ -0,0 +1,481 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "PointCloud.h"
+
+#include <math.h>
+#include <vector>
+
+// depth of a room in pixels of the depth stream: a sloped wall, a player in front of it,
+// the shadow strip on the left and scattered pixels without depth
+static std::vector<NUI_DEPTH_IMAGE_PIXEL> MakeDepthPixels( DWORD width, DWORD height, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels( width * height );
+
+    for( DWORD y = 0; y < height; ++y )
+    {
+        for( DWORD x = 0; x < width; ++x )
+        {
+            NUI_DEPTH_IMAGE_PIXEL& pixel = pixels[y * width + x];
+            pixel.depth = static_cast<USHORT>( 3000 + x * 640 / width - y * 240 / height );
+            pixel.playerIndex = 0;
+
+            if( x >= width * 2 / 5 && x < width * 3 / 5 && y >= height / 6 )
+            {
+                pixel.depth = static_cast<USHORT>( 1500 + random.Next() % 20 );
+                pixel.playerIndex = 1;
+            }
+            if( x < width / 80 || 0 == random.Next() % 7 )
+            {
+                pixel.depth = 0;
+                pixel.playerIndex = 0;
+            }
+        }
+    }
+
+    return pixels;
+}
+
+static KINECT_POINT_CLOUD MakeCloud( KINECT_POINT_CLOUD_LAYOUT eLayout, bool bCompact, DWORD cPoints )
+{
+    KINECT_POINT_CLOUD cloud;
+    ZeroMemory( &cloud, sizeof(cloud) );
+    cloud.dwStructSize = sizeof(KINECT_POINT_CLOUD);
+    cloud.eLayout = eLayout;
+    cloud.bCompact = bCompact;
+    cloud.cPoints = cPoints;
+    return cloud;
+}
+
+// the point of NuiTransformDepthImageToSkeleton for the depth pixel x, y in meters
+static void RayModel( DWORD width, DWORD height, double x, double y, double z, _Out_writes_(3) double* pPoint )
+{
+    const double scale = (320.0 / width) * NUI_CAMERA_DEPTH_NOMINAL_INVERSE_FOCAL_LENGTH_IN_PIXELS;
+    pPoint[0] = (x - width / 2.0) * scale * z;
+    pPoint[1] = -(y - height / 2.0) * scale * z;
+    pPoint[2] = z;
+}
+
+// largest distance of the points of a dense cloud from the ray model, pSourceX/Y give the pixel
+// of the untransformed frame every point comes from
+static double MaxRayError( DWORD width, DWORD height, _In_ const NUI_DEPTH_IMAGE_PIXEL* pPixels,
+    _In_ const float* pXYZ, _In_ const UINT* pSourceX, _In_ const UINT* pSourceY, size_t cPoints )
+{
+    double maxError = 0.0;
+    for( size_t i = 0; i < cPoints; ++i )
+    {
+        double expected[3];
+        RayModel( width, height, pSourceX[i], pSourceY[i], pPixels[i].depth * 0.001, expected );
+        for( UINT k = 0; k < 3; ++k )
+        {
+            maxError = max( maxError, fabs( pXYZ[i * 3 + k] - expected[k] ) );
+        }
+    }
+    return maxError;
+}
+
+// every point of a dense cloud is its pixel's ray scaled by the depth, holes are at the origin
+static void TestRayModel( NUI_IMAGE_RESOLUTION eResolution )
+{
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eResolution, width, height );
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, width );
+    const DWORD cPixels = width * height;
+
+    std::vector<UINT> sourceX( cPixels ), sourceY( cPixels );
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        sourceX[i] = i % width;
+        sourceY[i] = i / width;
+    }
+
+    PointCloud generator;
+    std::vector<float> xyz( cPixels * 3, -1.0f );
+    KINECT_POINT_CLOUD cloud = MakeCloud( PointCloudLayoutXYZ, false, cPixels );
+    cloud.pXYZ = xyz.data();
+    KCB_CHECK_HR( generator.Generate( eResolution, cPixels, pixels.data(), nullptr, &cloud ), S_OK );
+    KCB_CHECK( cPixels == cloud.cValidPoints );
+    KCB_CHECK( MaxRayError( width, height, pixels.data(), xyz.data(), sourceX.data(), sourceY.data(), cPixels ) < 1e-5 );
+
+    bool bHolesAtOrigin = true;
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        if( 0 == pixels[i].depth )
+        {
+            bHolesAtOrigin = bHolesAtOrigin && 0.0f == xyz[i * 3] && 0.0f == xyz[i * 3 + 1] && 0.0f == xyz[i * 3 + 2];
+        }
+    }
+    KCB_CHECK( bHolesAtOrigin );
+
+    // the planes hold the same points
+    std::vector<float> px( cPixels ), py( cPixels ), pz( cPixels );
+    KINECT_POINT_CLOUD planes = MakeCloud( PointCloudLayoutPlanes, false, cPixels );
+    planes.pX = px.data();
+    planes.pY = py.data();
+    planes.pZ = pz.data();
+    KCB_CHECK_HR( generator.Generate( eResolution, cPixels, pixels.data(), nullptr, &planes ), S_OK );
+
+    bool bSame = true;
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        bSame = bSame && px[i] == xyz[i * 3] && py[i] == xyz[i * 3 + 1] && pz[i] == xyz[i * 3 + 2];
+    }
+    KCB_CHECK( bSame );
+}
+
+// a compact cloud has the valid depths in pixel order with their indices, the colored one their colors
+static void TestCompact()
+{
+    const DWORD width = 320, height = 240, cPixels = width * height;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, 9 );
+
+    std::vector<float> dense( cPixels * 3 );
+    PointCloud generator;
+    KINECT_POINT_CLOUD cloud = MakeCloud( PointCloudLayoutXYZ, false, cPixels );
+    cloud.pXYZ = dense.data();
+    KCB_CHECK_HR( generator.Generate( NUI_IMAGE_RESOLUTION_320x240, cPixels, pixels.data(), nullptr, &cloud ), S_OK );
+
+    // colors of a 640x480 frame, a pixel's color is its index, some depth pixels map outside
+    const UINT colorWidth = 640, colorHeight = 480;
+    std::vector<UINT32> colorFrame( colorWidth * colorHeight );
+    for( UINT i = 0; i < colorWidth * colorHeight; ++i )
+    {
+        colorFrame[i] = i + 1;
+    }
+    std::vector<NUI_COLOR_IMAGE_POINT> colorPoints( cPixels );
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        colorPoints[i].x = static_cast<LONG>( (i % width) * 2 ) - 10;
+        colorPoints[i].y = static_cast<LONG>( (i / width) * 2 ) + 5;
+    }
+    PointCloud::ColorSource color = { colorPoints.data(), colorFrame.data(), colorWidth, colorHeight };
+
+    DWORD cValid = 0;
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        cValid += (0 != pixels[i].depth);
+    }
+
+    // too small, the call tells how many points it needs
+    std::vector<KINECT_COLORED_POINT> points( cValid );
+    std::vector<DWORD> indices( cValid );
+    KINECT_POINT_CLOUD compact = MakeCloud( PointCloudLayoutXYZRGB, true, cValid - 1 );
+    compact.pColoredPoints = points.data();
+    compact.pIndices = indices.data();
+    KCB_CHECK_HR( generator.Generate( NUI_IMAGE_RESOLUTION_320x240, cPixels, pixels.data(), &color, &compact ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+    KCB_CHECK( cValid == compact.cValidPoints );
+
+    compact.cPoints = cValid;
+    KCB_CHECK_HR( generator.Generate( NUI_IMAGE_RESOLUTION_320x240, cPixels, pixels.data(), &color, &compact ), S_OK );
+    KCB_CHECK( cValid == compact.cValidPoints );
+
+    bool bInOrder = true, bSame = true, bColored = true;
+    for( DWORD k = 0; k < cValid; ++k )
+    {
+        DWORD i = indices[k];
+        bInOrder = bInOrder && i < cPixels && 0 != pixels[i].depth && (0 == k || i > indices[k - 1]);
+        if( i >= cPixels )
+        {
+            break;
+        }
+        bSame = bSame && points[k].x == dense[i * 3] && points[k].y == dense[i * 3 + 1] && points[k].z == dense[i * 3 + 2];
+
+        const NUI_COLOR_IMAGE_POINT& p = colorPoints[i];
+        bool bInside = p.x >= 0 && p.x < static_cast<LONG>(colorWidth) && p.y >= 0 && p.y < static_cast<LONG>(colorHeight);
+        bColored = bColored && points[k].color == (bInside ? colorFrame[p.y * colorWidth + p.x] : 0);
+    }
+    KCB_CHECK( bInOrder );
+    KCB_CHECK( bSame );
+    KCB_CHECK( bColored );
+
+    // a frame of another resolution, or without buffers
+    KCB_CHECK_HR( generator.Generate( NUI_IMAGE_RESOLUTION_640x480, cPixels, pixels.data(), nullptr, &compact ), E_INVALIDARG );
+    KINECT_POINT_CLOUD empty = MakeCloud( PointCloudLayoutPlanes, false, cPixels );
+    KCB_CHECK_HR( generator.Generate( NUI_IMAGE_RESOLUTION_320x240, cPixels, pixels.data(), nullptr, &empty ), E_INVALIDARG );
+}
+
+// transformed depth pixels use the rays of the pixels they came from
+static void TestTransform()
+{
+    const DWORD width = 80, height = 60, cPixels = width * height;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, 13 );
+    std::vector<float> xyz( cPixels * 3 );
+    std::vector<UINT> sourceX( cPixels ), sourceY( cPixels );
+
+    PointCloud generator;
+    KINECT_IMAGE_TRANSFORM transform = { sizeof(KINECT_IMAGE_TRANSFORM), true, ImageRotationNone };
+    generator.SetDepthTransform( transform );
+
+    KINECT_POINT_CLOUD cloud = MakeCloud( PointCloudLayoutXYZ, false, cPixels );
+    cloud.pXYZ = xyz.data();
+    KCB_CHECK_HR( generator.Generate( NUI_IMAGE_RESOLUTION_80x60, cPixels, pixels.data(), nullptr, &cloud ), S_OK );
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        sourceX[i] = width - 1 - i % width;
+        sourceY[i] = i / width;
+    }
+    KCB_CHECK( MaxRayError( width, height, pixels.data(), xyz.data(), sourceX.data(), sourceY.data(), cPixels ) < 1e-5 );
+
+    // 90 degrees clockwise, the rows of the output are the columns of the frame from the bottom up
+    transform.bMirror = false;
+    transform.eRotation = ImageRotation90;
+    generator.SetDepthTransform( transform );
+    KCB_CHECK_HR( generator.Generate( NUI_IMAGE_RESOLUTION_80x60, cPixels, pixels.data(), nullptr, &cloud ), S_OK );
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        sourceX[i] = i / height;
+        sourceY[i] = height - 1 - i % height;
+    }
+    KCB_CHECK( MaxRayError( width, height, pixels.data(), xyz.data(), sourceX.data(), sourceY.data(), cPixels ) < 1e-5 );
+}
+
+static KINECT_DEPTH_NORMALS MakeNormals( DWORD cNormals, _Out_writes_(cNormals * 3) float* pNormals, _Out_opt_cap_(cNormals) BYTE* pValid )
+{
+    KINECT_DEPTH_NORMALS normals;
+    ZeroMemory( &normals, sizeof(normals) );
+    normals.dwStructSize = sizeof(KINECT_DEPTH_NORMALS);
+    normals.cNormals = cNormals;
+    normals.pNormals = pNormals;
+    normals.pValid = pValid;
+    return normals;
+}
+
+// the normal of the pixel x, y in double: the cross product of the differences of its neighbors
+// along the row and the column, a neighbor without depth or more than maxStep of the depth away
+// replaced by the pixel itself; false without a normal
+static bool NormalModel( DWORD width, DWORD height, _In_ const NUI_DEPTH_IMAGE_PIXEL* pPixels, DWORD x, DWORD y, double maxStep,
+    _Out_writes_(3) double* pNormal )
+{
+    const double z = pPixels[y * width + x].depth * 0.001;
+
+    auto point = [&]( bool bInside, DWORD nx, DWORD ny, _Out_writes_(3) double* pPoint )
+    {
+        double nz = bInside ? pPixels[ny * width + nx].depth * 0.001 : 0.0;
+        if( 0.0 == nz || fabs( nz - z ) > maxStep * z )
+        {
+            nx = x;
+            ny = y;
+            nz = z;
+        }
+        RayModel( width, height, nx, ny, nz, pPoint );
+    };
+
+    double left[3], right[3], up[3], down[3];
+    point( x > 0, x - 1, y, left );
+    point( x + 1 < width, x + 1, y, right );
+    point( y > 0, x, y - 1, up );
+    point( y + 1 < height, x, y + 1, down );
+
+    double h[3], v[3], center[3];
+    for( UINT k = 0; k < 3; ++k )
+    {
+        h[k] = right[k] - left[k];
+        v[k] = down[k] - up[k];
+    }
+    RayModel( width, height, x, y, z, center );
+
+    double n[3] = { h[1] * v[2] - h[2] * v[1], h[2] * v[0] - h[0] * v[2], h[0] * v[1] - h[1] * v[0] };
+    double length = sqrt( n[0] * n[0] + n[1] * n[1] + n[2] * n[2] );
+    if( 0.0 == z || 0.0 == length )
+    {
+        return false;
+    }
+
+    double scale = ((n[0] * center[0] + n[1] * center[1] + n[2] * center[2] > 0.0) ? -1.0 : 1.0) / length;
+    for( UINT k = 0; k < 3; ++k )
+    {
+        pNormal[k] = n[k] * scale;
+    }
+    return true;
+}
+
+// the normals of the 4 pixels at a time rows and of the edges match the model, pixels without a normal are NaN
+static void TestNormals( NUI_IMAGE_RESOLUTION eResolution )
+{
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eResolution, width, height );
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, width + 1 );
+    const DWORD cPixels = width * height;
+
+    PointCloud generator;
+    std::vector<float> normalsXYZ( cPixels * 3 );
+    std::vector<BYTE> valid( cPixels, 0x55 );
+    KINECT_DEPTH_NORMALS normals = MakeNormals( cPixels, normalsXYZ.data(), valid.data() );
+    KCB_CHECK_HR( generator.GenerateNormals( eResolution, cPixels, pixels.data(), &normals ), S_OK );
+
+    UINT cValid = 0, cMismatches = 0;
+    double maxError = 0.0;
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        double expected[3];
+        bool bExpected = NormalModel( width, height, pixels.data(), i % width, i / width, DEPTH_NORMALS_DEFAULT_MAX_STEP, expected );
+        const float* pNormal = &normalsXYZ[i * 3];
+
+        cValid += bExpected;
+        cMismatches += (bExpected ? 0xff : 0) != valid[i];
+        for( UINT k = 0; k < 3; ++k )
+        {
+            if( bExpected )
+            {
+                maxError = max( maxError, fabs( pNormal[k] - expected[k] ) );
+            }
+            else
+            {
+                cMismatches += (pNormal[k] == pNormal[k]);
+            }
+        }
+    }
+
+    KCB_CHECK( 0 == cMismatches );
+    KCB_CHECK( maxError < 1e-3 );
+    KCB_CHECK( cValid == normals.cValidNormals );
+    KCB_CHECK( cValid > cPixels / 2 );
+}
+
+// a flat wall faces the sensor mirrored or not, a hole has no normal and its neighbors use one sided
+// differences, a pixel alone has none either
+static void TestNormalsWall()
+{
+    const DWORD width = 80, height = 60, cPixels = width * height;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels( cPixels );
+    for( DWORD i = 0; i < cPixels; ++i )
+    {
+        pixels[i].depth = 2000;
+        pixels[i].playerIndex = 0;
+    }
+
+    // a hole, and a pixel in the middle of a hole
+    const DWORD hole = 20 * width + 21;
+    pixels[hole].depth = 0;
+    for( DWORD y = 40; y < 45; ++y )
+    {
+        for( DWORD x = 50; x < 55; ++x )
+        {
+            pixels[y * width + x].depth = (42 == y && 52 == x) ? 2000 : 0;
+        }
+    }
+
+    PointCloud generator;
+    std::vector<float> normalsXYZ( cPixels * 3 );
+    std::vector<BYTE> valid( cPixels );
+    KINECT_DEPTH_NORMALS normals = MakeNormals( cPixels, normalsXYZ.data(), valid.data() );
+
+    for( UINT mirror = 0; mirror < 2; ++mirror )
+    {
+        KINECT_IMAGE_TRANSFORM transform = { sizeof(KINECT_IMAGE_TRANSFORM), 0 != mirror, ImageRotationNone };
+        generator.SetDepthTransform( transform );
+        KCB_CHECK_HR( generator.GenerateNormals( NUI_IMAGE_RESOLUTION_80x60, cPixels, pixels.data(), &normals ), S_OK );
+
+        double maxError = 0.0;
+        UINT cValid = 0;
+        for( DWORD i = 0; i < cPixels; ++i )
+        {
+            if( 0xff == valid[i] )
+            {
+                ++cValid;
+                maxError = max( maxError, max( fabs( normalsXYZ[i * 3] ), max( fabs( normalsXYZ[i * 3 + 1] ), fabs( normalsXYZ[i * 3 + 2] + 1.0 ) ) ) );
+            }
+        }
+
+        KCB_CHECK( maxError < 1e-5 );
+        KCB_CHECK( cPixels - 26 == cValid && cValid == normals.cValidNormals );
+        KCB_CHECK( 0 == valid[hole] && normalsXYZ[hole * 3] != normalsXYZ[hole * 3] );
+        KCB_CHECK( 0xff == valid[hole + 1] && 0xff == valid[hole + width] );
+        KCB_CHECK( 0 == valid[42 * width + 52] );
+    }
+
+    // the buffers
+    normals.cNormals = cPixels - 1;
+    KCB_CHECK_HR( generator.GenerateNormals( NUI_IMAGE_RESOLUTION_80x60, cPixels, pixels.data(), &normals ), HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER) );
+    normals.cNormals = cPixels;
+    KCB_CHECK_HR( generator.GenerateNormals( NUI_IMAGE_RESOLUTION_320x240, cPixels, pixels.data(), &normals ), E_INVALIDARG );
+    normals.pValid = nullptr;
+    KCB_CHECK_HR( generator.GenerateNormals( NUI_IMAGE_RESOLUTION_80x60, cPixels, pixels.data(), &normals ), S_OK );
+    KCB_CHECK( cPixels - 26 == normals.cValidNormals );
+}
+
+static void BenchmarkGenerate( KINECT_POINT_CLOUD_LAYOUT eLayout, bool bCompact, const char* name )
+{
+    const DWORD width = 640, height = 480, cPixels = width * height;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, 3 );
+
+    std::vector<float> xyz( cPixels * 3 ), px( cPixels ), py( cPixels ), pz( cPixels );
+    std::vector<DWORD> indices( cPixels );
+    KINECT_POINT_CLOUD cloud = MakeCloud( eLayout, bCompact, cPixels );
+    cloud.pXYZ = xyz.data();
+    cloud.pX = px.data();
+    cloud.pY = py.data();
+    cloud.pZ = pz.data();
+    cloud.pIndices = bCompact ? indices.data() : nullptr;
+
+    PointCloud generator;
+    generator.Generate( NUI_IMAGE_RESOLUTION_640x480, cPixels, pixels.data(), nullptr, &cloud );
+
+    const int cRuns = 50;
+    Stopwatch time;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        generator.Generate( NUI_IMAGE_RESOLUTION_640x480, cPixels, pixels.data(), nullptr, &cloud );
+    }
+
+    printf( "point cloud 640x480 %s: %.0f us, %u points\n", name, time.ElapsedMicroseconds() / cRuns, cloud.cValidPoints );
+}
+
+static void BenchmarkNormals()
+{
+    const DWORD width = 640, height = 480, cPixels = width * height;
+    std::vector<NUI_DEPTH_IMAGE_PIXEL> pixels = MakeDepthPixels( width, height, 3 );
+
+    std::vector<float> normalsXYZ( cPixels * 3 );
+    std::vector<BYTE> valid( cPixels );
+    KINECT_DEPTH_NORMALS normals = MakeNormals( cPixels, normalsXYZ.data(), valid.data() );
+
+    PointCloud generator;
+    generator.GenerateNormals( NUI_IMAGE_RESOLUTION_640x480, cPixels, pixels.data(), &normals );
+
+    const int cRuns = 50;
+    Stopwatch time;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        generator.GenerateNormals( NUI_IMAGE_RESOLUTION_640x480, cPixels, pixels.data(), &normals );
+    }
+
+    printf( "depth normals 640x480: %.0f us, %u normals\n", time.ElapsedMicroseconds() / cRuns, normals.cValidNormals );
+}
+
+int main( int argc, char** argv )
+{
+    TestRayModel( NUI_IMAGE_RESOLUTION_640x480 );
+    TestRayModel( NUI_IMAGE_RESOLUTION_320x240 );
+    TestRayModel( NUI_IMAGE_RESOLUTION_80x60 );
+    TestCompact();
+    TestTransform();
+    TestNormals( NUI_IMAGE_RESOLUTION_640x480 );
+    TestNormals( NUI_IMAGE_RESOLUTION_80x60 );
+    TestNormalsWall();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkGenerate( PointCloudLayoutXYZ, false, "xyz" );
+        BenchmarkGenerate( PointCloudLayoutPlanes, false, "planes" );
+        BenchmarkGenerate( PointCloudLayoutXYZ, true, "compact xyz" );
+        BenchmarkNormals();
+    }
+
+    return ReportTestResult( "PointCloudTests" );
+}
@@ -0,0 +1,403 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "SkeletonCodec.h"
+
+#include <math.h>
+#include <limits>
+#include <vector>
+
+static const LONGLONG FRAME_MS = 33;
+
+// quantization error of a coordinate, half a step of 1/2048 m
+static const float MAX_ERROR = 0.5f / SKELETON_CODEC_SCALE;
+
+// a sequence of a sensor: one player walking and waving with the sensor noise on its joints,
+// one seen as position only, and a third one that comes in halfway with a joint it cannot see
+static NUI_SKELETON_FRAME MakeSequenceFrame( UINT frame, TestRandom& random )
+{
+    float seconds = frame * FRAME_MS / 1000.0f;
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 5000 + frame * FRAME_MS, 100 + frame );
+
+    NUI_SKELETON_DATA& walker = skeletonFrame.SkeletonData[1];
+    walker = MakeSkeleton( 7, sinf( seconds ), 0.0f, 2.5f + 0.5f * cosf( 0.5f * seconds ) );
+    walker.SkeletonPositions[NUI_SKELETON_POSITION_HAND_RIGHT].y += 0.3f * sinf( 6.0f * seconds );
+    walker.SkeletonPositions[NUI_SKELETON_POSITION_WRIST_RIGHT].y += 0.25f * sinf( 6.0f * seconds );
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        walker.SkeletonPositions[j].x += random.Gaussian( 0.002f );
+        walker.SkeletonPositions[j].y += random.Gaussian( 0.002f );
+        walker.SkeletonPositions[j].z += random.Gaussian( 0.002f );
+    }
+    walker.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_FOOT_LEFT] = NUI_SKELETON_POSITION_INFERRED;
+    walker.dwQualityFlags = (frame / 50) & 3;
+
+    NUI_SKELETON_DATA& bystander = skeletonFrame.SkeletonData[4];
+    bystander = MakeSkeleton( 12, -1.5f, 0.0f, 3.5f + 0.1f * seconds );
+    bystander.eTrackingState = NUI_SKELETON_POSITION_ONLY;
+    bystander.dwUserIndex = 3;
+
+    if( frame >= 150 )
+    {
+        NUI_SKELETON_DATA& newcomer = skeletonFrame.SkeletonData[0];
+        newcomer = MakeSkeleton( 21, 1.2f, 0.0f, 3.0f - 0.2f * seconds );
+        newcomer.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HAND_LEFT] = NUI_SKELETON_POSITION_NOT_TRACKED;
+        newcomer.dwEnrollmentIndex = 2;
+    }
+
+    // the floor estimate changes now and then
+    skeletonFrame.vFloorClipPlane.w = 1.0f + 0.01f * (frame / 100);
+
+    return skeletonFrame;
+}
+
+// largest difference of a position from the original, -1 when the frames differ in anything else
+static float CompareFrames( const NUI_SKELETON_FRAME& original, const NUI_SKELETON_FRAME& decoded )
+{
+    if( original.liTimeStamp.QuadPart != decoded.liTimeStamp.QuadPart || original.dwFrameNumber != decoded.dwFrameNumber
+        || original.dwFlags != decoded.dwFlags
+        || 0 != memcmp( &original.vFloorClipPlane, &decoded.vFloorClipPlane, sizeof(Vector4) )
+        || 0 != memcmp( &original.vNormalToGravity, &decoded.vNormalToGravity, sizeof(Vector4) ) )
+    {
+        return -1.0f;
+    }
+
+    float maxError = 0.0f;
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        const NUI_SKELETON_DATA& a = original.SkeletonData[s];
+        const NUI_SKELETON_DATA& b = decoded.SkeletonData[s];
+        if( a.eTrackingState != b.eTrackingState )
+        {
+            return -1.0f;
+        }
+        if( NUI_SKELETON_NOT_TRACKED == a.eTrackingState )
+        {
+            continue;
+        }
+        if( a.dwTrackingID != b.dwTrackingID || a.dwEnrollmentIndex != b.dwEnrollmentIndex
+            || a.dwUserIndex != b.dwUserIndex || a.dwQualityFlags != b.dwQualityFlags )
+        {
+            return -1.0f;
+        }
+
+        maxError = max( maxError, fabsf( a.Position.x - b.Position.x ) );
+        maxError = max( maxError, fabsf( a.Position.y - b.Position.y ) );
+        maxError = max( maxError, fabsf( a.Position.z - b.Position.z ) );
+        if( NUI_SKELETON_TRACKED != a.eTrackingState )
+        {
+            continue;
+        }
+
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            if( a.eSkeletonPositionTrackingState[j] != b.eSkeletonPositionTrackingState[j] )
+            {
+                return -1.0f;
+            }
+
+            // joints that are not tracked come back as 0
+            const Vector4& p = b.SkeletonPositions[j];
+            if( NUI_SKELETON_POSITION_NOT_TRACKED == a.eSkeletonPositionTrackingState[j] )
+            {
+                if( 0.0f != p.x || 0.0f != p.y || 0.0f != p.z )
+                {
+                    return -1.0f;
+                }
+                continue;
+            }
+
+            maxError = max( maxError, fabsf( a.SkeletonPositions[j].x - p.x ) );
+            maxError = max( maxError, fabsf( a.SkeletonPositions[j].y - p.y ) );
+            maxError = max( maxError, fabsf( a.SkeletonPositions[j].z - p.z ) );
+        }
+    }
+
+    return maxError;
+}
+
+// 300 frames with a keyframe every SKELETON_CODEC_KEYFRAME_INTERVAL like the sensor writes them,
+// every position within half a step and the stream much smaller than the frames
+static void TestRoundTrip()
+{
+    TestRandom random( 3 );
+    std::vector<BYTE> encoded( SkeletonCodec::GetEncodedBound() );
+
+    NUI_SKELETON_FRAME reference, decoded;
+    ZeroMemory( &decoded, sizeof(decoded) );
+
+    float maxError = 0.0f;
+    bool bSame = true;
+    size_t cbFrames = 0, cbEncoded = 0, cbKeyframes = 0;
+    UINT cKeyframes = 0;
+    for( UINT frame = 0; frame < 300; ++frame )
+    {
+        NUI_SKELETON_FRAME skeletonFrame = MakeSequenceFrame( frame, random );
+        bool bKeyframe = 0 == frame % SKELETON_CODEC_KEYFRAME_INTERVAL;
+
+        ULONG cbWritten = 0;
+        KCB_CHECK_HR( SkeletonCodec::Encode( skeletonFrame, bKeyframe ? nullptr : &reference,
+            static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+        KCB_CHECK_HR( SkeletonCodec::Decode( cbWritten, encoded.data(), decoded ), S_OK );
+
+        float error = CompareFrames( skeletonFrame, decoded );
+        bSame = bSame && error >= 0.0f;
+        maxError = max( maxError, error );
+
+        cbFrames += sizeof(NUI_SKELETON_FRAME);
+        cbEncoded += cbWritten;
+        if( bKeyframe )
+        {
+            cbKeyframes += cbWritten;
+            ++cKeyframes;
+        }
+        reference = skeletonFrame;
+    }
+
+    KCB_CHECK( bSame );
+    KCB_CHECK( maxError > 0.0f && maxError <= MAX_ERROR * 1.001f );
+
+    // more than 15 times smaller, keyframes more than 8 times
+    double ratio = static_cast<double>(cbFrames) / cbEncoded;
+    double keyframeRatio = static_cast<double>(cKeyframes * sizeof(NUI_SKELETON_FRAME)) / cbKeyframes;
+    KCB_CHECK( ratio > 15.0 );
+    KCB_CHECK( keyframeRatio > 8.0 && keyframeRatio < ratio );
+}
+
+// outside of +-16 m the coordinates saturate, NaN comes back as 0
+static void TestQuantization()
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 0, 1 );
+    NUI_SKELETON_DATA& skeleton = skeletonFrame.SkeletonData[2];
+    skeleton = MakeSkeleton( 5, 0.0f, 0.0f, 2.0f );
+    skeleton.SkeletonPositions[0].x = 100.0f;
+    skeleton.SkeletonPositions[0].y = -100.0f;
+    skeleton.SkeletonPositions[0].z = std::numeric_limits<float>::quiet_NaN();
+    skeleton.SkeletonPositions[1].x = 1.0f / 4096.0f;       // halfway rounds up
+    skeleton.SkeletonPositions[1].y = -3.0f / 4096.0f;
+
+    std::vector<BYTE> encoded( SkeletonCodec::GetEncodedBound() );
+    ULONG cbWritten = 0;
+    KCB_CHECK_HR( SkeletonCodec::Encode( skeletonFrame, nullptr, static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+
+    NUI_SKELETON_FRAME decoded;
+    ZeroMemory( &decoded, sizeof(decoded) );
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbWritten, encoded.data(), decoded ), S_OK );
+
+    const Vector4* pJoints = decoded.SkeletonData[2].SkeletonPositions;
+    KCB_CHECK( 32767.0f / SKELETON_CODEC_SCALE == pJoints[0].x );
+    KCB_CHECK( -16.0f == pJoints[0].y );
+    KCB_CHECK( 0.0f == pJoints[0].z );
+    KCB_CHECK( 1.0f / SKELETON_CODEC_SCALE == pJoints[1].x );
+    KCB_CHECK( -1.0f / SKELETON_CODEC_SCALE == pJoints[1].y );
+    KCB_CHECK_NEAR( pJoints[3].y, 0.8, MAX_ERROR );
+}
+
+// a delta frame decoded on another frame than its reference fails and leaves the frame as it was,
+// the next keyframe starts over
+static void TestWrongReference()
+{
+    TestRandom random( 5 );
+    std::vector<BYTE> encoded( SkeletonCodec::GetEncodedBound() );
+    ULONG cbWritten = 0;
+
+    NUI_SKELETON_FRAME frames[4];
+    for( UINT i = 0; i < _countof(frames); ++i )
+    {
+        frames[i] = MakeSequenceFrame( 150 + i, random );
+    }
+
+    NUI_SKELETON_FRAME decoded;
+    ZeroMemory( &decoded, sizeof(decoded) );
+    KCB_CHECK_HR( SkeletonCodec::Encode( frames[0], nullptr, static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbWritten, encoded.data(), decoded ), S_OK );
+
+    // frame 1 is lost, frame 2 is a delta from it
+    KCB_CHECK_HR( SkeletonCodec::Encode( frames[2], &frames[1], static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+    NUI_SKELETON_FRAME before = decoded;
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbWritten, encoded.data(), decoded ), HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+    KCB_CHECK( 0 == memcmp( &before, &decoded, sizeof(decoded) ) );
+
+    // a reference with the right frame number, but without the skeleton a delta refers to
+    NUI_SKELETON_FRAME emptied = decoded;
+    ZeroMemory( &emptied.SkeletonData[1], sizeof(NUI_SKELETON_DATA) );
+    KCB_CHECK_HR( SkeletonCodec::Encode( frames[1], &frames[0], static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbWritten, encoded.data(), emptied ), HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) );
+
+    KCB_CHECK_HR( SkeletonCodec::Encode( frames[3], nullptr, static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbWritten, encoded.data(), decoded ), S_OK );
+    KCB_CHECK( CompareFrames( frames[3], decoded ) >= 0.0f );
+}
+
+// cut off, damaged and random data is rejected, never read past its end; small buffers are refused
+static void TestBadInput()
+{
+    TestRandom random( 7 );
+    std::vector<BYTE> encoded( SkeletonCodec::GetEncodedBound() );
+    ULONG cbKeyframe = 0, cbDelta = 0;
+
+    NUI_SKELETON_FRAME first = MakeSequenceFrame( 200, random );
+    NUI_SKELETON_FRAME second = MakeSequenceFrame( 201, random );
+    KCB_CHECK_HR( SkeletonCodec::Encode( first, nullptr, static_cast<ULONG>(encoded.size()), encoded.data(), cbKeyframe ), S_OK );
+    std::vector<BYTE> keyframe( encoded.begin(), encoded.begin() + cbKeyframe );
+    KCB_CHECK_HR( SkeletonCodec::Encode( second, &first, static_cast<ULONG>(encoded.size()), encoded.data(), cbDelta ), S_OK );
+    std::vector<BYTE> delta( encoded.begin(), encoded.begin() + cbDelta );
+
+    NUI_SKELETON_FRAME decoded;
+    ZeroMemory( &decoded, sizeof(decoded) );
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbKeyframe, keyframe.data(), decoded ), S_OK );
+    NUI_SKELETON_FRAME reference = decoded;
+
+    // every cut, in a copy of its own size so the sanitizers see reads past the end
+    bool bCutRejected = true;
+    for( ULONG cb = 1; cb < cbKeyframe; ++cb )
+    {
+        std::vector<BYTE> cut( keyframe.begin(), keyframe.begin() + cb );
+        NUI_SKELETON_FRAME frame = reference;
+        bCutRejected = bCutRejected && HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) == SkeletonCodec::Decode( cb, cut.data(), frame );
+    }
+    for( ULONG cb = 1; cb < cbDelta; ++cb )
+    {
+        std::vector<BYTE> cut( delta.begin(), delta.begin() + cb );
+        NUI_SKELETON_FRAME frame = reference;
+        bCutRejected = bCutRejected && HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) == SkeletonCodec::Decode( cb, cut.data(), frame );
+    }
+    KCB_CHECK( bCutRejected );
+
+    // damaged bytes decode to something or are reported, and never to more skeletons than a frame has
+    bool bReported = true;
+    for( int i = 0; i < 5000; ++i )
+    {
+        std::vector<BYTE> damaged = (i & 1) ? delta : keyframe;
+        damaged[random.Next() % damaged.size()] ^= static_cast<BYTE>( 1 + random.Next() % 255 );
+
+        NUI_SKELETON_FRAME frame = reference;
+        HRESULT hr = SkeletonCodec::Decode( static_cast<ULONG>(damaged.size()), damaged.data(), frame );
+        bReported = bReported && (S_OK == hr || HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) == hr);
+    }
+    KCB_CHECK( bReported );
+
+    bool bRandomRejected = true;
+    for( int i = 0; i < 1000; ++i )
+    {
+        std::vector<BYTE> noise( 1 + random.Next() % 400 );
+        for( size_t k = 0; k < noise.size(); ++k )
+        {
+            noise[k] = static_cast<BYTE>( random.Next() );
+        }
+        NUI_SKELETON_FRAME frame = reference;
+        bRandomRejected = bRandomRejected && HRESULT_FROM_WIN32( ERROR_INVALID_DATA ) == SkeletonCodec::Decode( static_cast<ULONG>(noise.size()), noise.data(), frame );
+    }
+    KCB_CHECK( bRandomRejected );
+
+    ULONG cbWritten = 1;
+    KCB_CHECK_HR( SkeletonCodec::Encode( second, &first, SkeletonCodec::GetEncodedBound() - 1, encoded.data(), cbWritten ),
+        HRESULT_FROM_WIN32( ERROR_INSUFFICIENT_BUFFER ) );
+    KCB_CHECK( 0 == cbWritten );
+    KCB_CHECK_HR( SkeletonCodec::Encode( second, &first, static_cast<ULONG>(encoded.size()), nullptr, cbWritten ), E_INVALIDARG );
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbDelta, nullptr, decoded ), E_INVALIDARG );
+}
+
+// the largest delta frame: six tracked skeletons crossing the whole range, every id at its
+// largest, the time and frame number jumping as far as they can and a new floor
+static void TestEncodedBound()
+{
+    TestRandom random( 9 );
+    NUI_SKELETON_FRAME frames[2];
+    for( UINT i = 0; i < 2; ++i )
+    {
+        frames[i] = MakeSkeletonFrame( 0, 0xffffffff - i );
+        frames[i].dwFlags = 0xffffffff;
+        frames[i].vFloorClipPlane.w = 1.0f + i;
+        for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+        {
+            NUI_SKELETON_DATA& skeleton = frames[i].SkeletonData[s];
+            skeleton = MakeSkeleton( 0xfffffff0 + s, -15.0f + 30.0f * i, 0.0f, 15.0f - 30.0f * i );
+            skeleton.dwEnrollmentIndex = skeleton.dwUserIndex = skeleton.dwQualityFlags = 0xffffffff;
+            for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+            {
+                skeleton.SkeletonPositions[j].y += random.Symmetric( 15.0f );
+            }
+        }
+    }
+    frames[1].liTimeStamp.QuadPart = 0x7fffffffffffffffLL;
+
+    std::vector<BYTE> encoded( SkeletonCodec::GetEncodedBound() );
+    ULONG cbWritten = 0;
+    KCB_CHECK_HR( SkeletonCodec::Encode( frames[1], &frames[0], static_cast<ULONG>(encoded.size()), encoded.data(), cbWritten ), S_OK );
+    KCB_CHECK( cbWritten > encoded.size() * 9 / 10 && cbWritten <= encoded.size() );
+
+    NUI_SKELETON_FRAME decoded = frames[0];
+    KCB_CHECK_HR( SkeletonCodec::Decode( cbWritten, encoded.data(), decoded ), S_OK );
+    float error = CompareFrames( frames[1], decoded );
+    KCB_CHECK( error >= 0.0f && error <= MAX_ERROR * 1.001f );
+}
+
+static void BenchmarkCodec()
+{
+    TestRandom random( 1 );
+    const UINT cFrames = 300;
+    std::vector<NUI_SKELETON_FRAME> frames( cFrames );
+    for( UINT i = 0; i < cFrames; ++i )
+    {
+        frames[i] = MakeSequenceFrame( 150 + i, random );
+    }
+
+    std::vector<BYTE> encoded( cFrames * SkeletonCodec::GetEncodedBound() );
+    std::vector<ULONG> sizes( cFrames );
+    size_t cbEncoded = 0;
+
+    Stopwatch encodeTime;
+    BYTE* pEncoded = encoded.data();
+    for( UINT i = 0; i < cFrames; ++i )
+    {
+        const NUI_SKELETON_FRAME* pReference = (0 == i % SKELETON_CODEC_KEYFRAME_INTERVAL) ? nullptr : &frames[i - 1];
+        SkeletonCodec::Encode( frames[i], pReference, SkeletonCodec::GetEncodedBound(), pEncoded, sizes[i] );
+        pEncoded += sizes[i];
+        cbEncoded += sizes[i];
+    }
+    double encodeUs = encodeTime.ElapsedMicroseconds() / cFrames;
+
+    NUI_SKELETON_FRAME decoded;
+    ZeroMemory( &decoded, sizeof(decoded) );
+    Stopwatch decodeTime;
+    pEncoded = encoded.data();
+    for( UINT i = 0; i < cFrames; ++i )
+    {
+        SkeletonCodec::Decode( sizes[i], pEncoded, decoded );
+        pEncoded += sizes[i];
+    }
+    double decodeUs = decodeTime.ElapsedMicroseconds() / cFrames;
+
+    printf( "skeleton codec: %.0f bytes a frame, ratio %.1f, encode %.2f us, decode %.2f us\n",
+        static_cast<double>(cbEncoded) / cFrames, static_cast<double>(cFrames * sizeof(NUI_SKELETON_FRAME)) / cbEncoded, encodeUs, decodeUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestRoundTrip();
+    TestQuantization();
+    TestWrongReference();
+    TestBadInput();
+    TestEncodedBound();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkCodec();
+    }
+
+    return ReportTestResult( "SkeletonCodecTests" );
+}
@@ -0,0 +1,319 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "SkeletonFilter.h"
+
+static const LONGLONG FRAME_MS = 33;
+
+// the default smoothing of the Kinect samples
+static const NUI_TRANSFORM_SMOOTH_PARAMETERS DEFAULT_SMOOTHING = { 0.5f, 0.5f, 0.5f, 0.05f, 0.04f };
+
+static KINECT_SKELETON_FILTER MakeParams( KINECT_SKELETON_FILTER_TYPE eType )
+{
+    KINECT_SKELETON_FILTER params;
+    ZeroMemory( &params, sizeof(params) );
+    params.dwStructSize = sizeof(KINECT_SKELETON_FILTER);
+    params.eType = eType;
+    params.smoothParams = DEFAULT_SMOOTHING;
+    return params;
+}
+
+static const char* FilterName( KINECT_SKELETON_FILTER_TYPE eType )
+{
+    switch( eType )
+    {
+    case SkeletonFilterDoubleExponential:   return "double exponential";
+    case SkeletonFilterOneEuro:             return "one euro";
+    case SkeletonFilterKalman:              return "kalman";
+    default:                                return "none";
+    }
+}
+
+// every skeleton slot tracked, the joints of skeleton s at x = s, moving along z at speed m/s
+static NUI_SKELETON_FRAME MakeTruth( UINT frame, float speed )
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 1000 + frame * FRAME_MS, frame );
+    float z = 2.0f + speed * frame * FRAME_MS / 1000.0f;
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        skeletonFrame.SkeletonData[s] = MakeSkeleton( 1 + s, -2.5f + s, 0.0f, z );
+    }
+    return skeletonFrame;
+}
+
+static void AddJitter( _Inout_ NUI_SKELETON_FRAME& skeletonFrame, TestRandom& random, float sigma )
+{
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            Vector4& joint = skeletonFrame.SkeletonData[s].SkeletonPositions[j];
+            joint.x += random.Gaussian( sigma );
+            joint.y += random.Gaussian( sigma );
+            joint.z += random.Gaussian( sigma );
+        }
+    }
+}
+
+// mean squared distance of the joints to the truth, and mean signed error along z
+static void Compare( const NUI_SKELETON_FRAME& result, const NUI_SKELETON_FRAME& truth, _Inout_ double& sumSq, _Inout_ double& sumZ, _Inout_ UINT& count )
+{
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            const Vector4& a = result.SkeletonData[s].SkeletonPositions[j];
+            const Vector4& b = truth.SkeletonData[s].SkeletonPositions[j];
+            double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+            sumSq += (dx * dx + dy * dy + dz * dz) / 3.0;
+            sumZ += dz;
+            ++count;
+        }
+    }
+}
+
+// runs the filter over jittered frames of skeletons moving at speed, after a warm up
+// variance is the mean squared error per axis of the output, lag the mean error along the motion
+static void MeasureFilter( const KINECT_SKELETON_FILTER& params, float speed, float sigma, _Out_ double& rawVariance, _Out_ double& variance, _Out_ double& lag )
+{
+    SkeletonFilter filter;
+    filter.SetParameters( &params );
+
+    TestRandom random( 42 );
+    double rawSumSq = 0.0, rawSumZ = 0.0, sumSq = 0.0, sumZ = 0.0;
+    UINT rawCount = 0, count = 0;
+    for( UINT frame = 0; frame < 300; ++frame )
+    {
+        NUI_SKELETON_FRAME truth = MakeTruth( frame, speed );
+        NUI_SKELETON_FRAME skeletonFrame = truth;
+        AddJitter( skeletonFrame, random, sigma );
+
+        if( frame >= 60 )
+        {
+            Compare( skeletonFrame, truth, rawSumSq, rawSumZ, rawCount );
+        }
+
+        filter.Process( skeletonFrame );
+
+        if( frame >= 60 )
+        {
+            Compare( skeletonFrame, truth, sumSq, sumZ, count );
+        }
+    }
+
+    rawVariance = rawSumSq / rawCount;
+    variance = sumSq / count;
+    lag = -sumZ / count;
+}
+
+// variance of the output over the variance of the measurements of a steady state constant
+// velocity Kalman filter, the alpha beta filter of the tracking index (Kalata)
+static double KalmanNoiseRatio( float processNoise, float measurementNoise, float seconds )
+{
+    double lambda = processNoise * seconds * seconds / measurementNoise;
+    double root = sqrt( lambda * lambda + 8.0 * lambda );
+    double alpha = -(lambda * lambda + 8.0 * lambda - (lambda + 4.0) * root) / 8.0;
+    double beta = 2.0 * (2.0 - alpha) - 4.0 * sqrt( 1.0 - alpha );
+    return (2.0 * alpha * alpha + beta * (2.0 - 3.0 * alpha)) / (alpha * (4.0 - beta - 2.0 * alpha));
+}
+
+static void ReportJitter( const char* name, double rawVariance, double variance, double bias )
+{
+    printf( "%s, still: raw %.2f mm, filtered %.2f mm rms per axis, variance ratio %.3f, bias %.2f mm\n",
+        name, 1000.0 * sqrt( rawVariance ), 1000.0 * sqrt( variance ), variance / rawVariance, 1000.0 * bias );
+}
+
+// 1 cm of jitter on still skeletons, every filter takes out a good part of it without a bias
+static void TestJitter()
+{
+    double rawVariance = 0.0, variance = 0.0, bias = 0.0;
+
+    MeasureFilter( MakeParams( SkeletonFilterDoubleExponential ), 0.0f, 0.01f, rawVariance, variance, bias );
+    ReportJitter( "double exponential", rawVariance, variance, bias );
+    KCB_CHECK_NEAR( sqrt( rawVariance ), 0.01, 0.0005 );
+    KCB_CHECK( variance < 0.5 * rawVariance );
+    KCB_CHECK( fabs( bias ) < 0.001 );
+
+    // a joint at rest is filtered at the minimum cutoff
+    MeasureFilter( MakeParams( SkeletonFilterOneEuro ), 0.0f, 0.01f, rawVariance, variance, bias );
+    ReportJitter( "one euro", rawVariance, variance, bias );
+    KCB_CHECK( variance < 0.25 * rawVariance );
+    KCB_CHECK( fabs( bias ) < 0.001 );
+
+    // the default process noise of 5 m/s^2 follows quick moves and keeps about half of the variance,
+    // a calmer model keeps less; both match the steady state of the filter
+    KINECT_SKELETON_FILTER params = MakeParams( SkeletonFilterKalman );
+    MeasureFilter( params, 0.0f, 0.01f, rawVariance, variance, bias );
+    ReportJitter( "kalman", rawVariance, variance, bias );
+    KCB_CHECK_NEAR( variance / rawVariance, KalmanNoiseRatio( SKELETON_FILTER_DEFAULT_PROCESS_NOISE, 0.01f, FRAME_MS / 1000.0f ), 0.05 );
+    KCB_CHECK( variance < 0.6 * rawVariance );
+    KCB_CHECK( fabs( bias ) < 0.001 );
+
+    params.fProcessNoise = 0.5f;
+    MeasureFilter( params, 0.0f, 0.01f, rawVariance, variance, bias );
+    ReportJitter( "kalman 0.5 m/s^2", rawVariance, variance, bias );
+    KCB_CHECK_NEAR( variance / rawVariance, KalmanNoiseRatio( 0.5f, 0.01f, FRAME_MS / 1000.0f ), 0.05 );
+    KCB_CHECK( variance < 0.25 * rawVariance );
+}
+
+// skeletons walking at 1 m/s, the filters follow without falling far behind
+static void TestMotion()
+{
+    double rawVariance = 0.0, variance = 0.0, lag = 0.0;
+
+    // constant velocity is what the Kalman filter models, it has no lag
+    MeasureFilter( MakeParams( SkeletonFilterKalman ), 1.0f, 0.01f, rawVariance, variance, lag );
+    printf( "kalman, 1 m/s: filtered %.2f mm rms per axis, lag %.2f mm\n", 1000.0 * sqrt( variance ), 1000.0 * lag );
+    KCB_CHECK( fabs( lag ) < 0.002 );
+    KCB_CHECK( variance < rawVariance );
+
+    // the cutoff of One Euro rises with the speed, so it lags less than a low pass at the
+    // minimum cutoff would: v * T * (1 - a) / a with a = 1 / (1 + 1 / (2 pi fc T))
+    const double T = FRAME_MS / 1000.0;
+    const double a = 1.0 / (1.0 + 1.0 / (2.0 * 3.14159265 * SKELETON_FILTER_DEFAULT_MIN_CUTOFF * T));
+    MeasureFilter( MakeParams( SkeletonFilterOneEuro ), 1.0f, 0.01f, rawVariance, variance, lag );
+    printf( "one euro, 1 m/s: filtered %.2f mm rms per axis, lag %.2f mm, %.2f mm at the minimum cutoff\n",
+        1000.0 * sqrt( variance ), 1000.0 * lag, 1000.0 * T * (1.0 - a) / a );
+    KCB_CHECK( lag > 0.0 && lag < 0.5 * T * (1.0 - a) / a );
+
+    // the trend of the double exponential filter catches up with the motion
+    MeasureFilter( MakeParams( SkeletonFilterDoubleExponential ), 1.0f, 0.01f, rawVariance, variance, lag );
+    printf( "double exponential, 1 m/s: filtered %.2f mm rms per axis, lag %.2f mm\n", 1000.0 * sqrt( variance ), 1000.0 * lag );
+    KCB_CHECK( fabs( lag ) < 0.033 );
+}
+
+// a new tracking id in a slot starts over from its raw joints, joints that are not tracked are left alone
+static void TestRestart()
+{
+    const KINECT_SKELETON_FILTER_TYPE types[] = { SkeletonFilterDoubleExponential, SkeletonFilterOneEuro, SkeletonFilterKalman };
+    for( UINT t = 0; t < _countof(types); ++t )
+    {
+        KINECT_SKELETON_FILTER params = MakeParams( types[t] );
+        SkeletonFilter filter;
+        filter.SetParameters( &params );
+
+        UINT frame = 0;
+        for( ; frame < 30; ++frame )
+        {
+            NUI_SKELETON_FRAME skeletonFrame = MakeTruth( frame, 0.0f );
+            filter.Process( skeletonFrame );
+        }
+
+        // another player 3 m to the side in slot 0, a joint of slot 1 not tracked
+        NUI_SKELETON_FRAME input = MakeTruth( frame, 0.0f );
+        input.SkeletonData[0] = MakeSkeleton( 99, 3.0f, 0.0f, 3.0f );
+        input.SkeletonData[1].SkeletonPositions[NUI_SKELETON_POSITION_HAND_LEFT].x = 7.0f;
+        input.SkeletonData[1].eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HAND_LEFT] = NUI_SKELETON_POSITION_NOT_TRACKED;
+
+        NUI_SKELETON_FRAME output = input;
+        filter.Process( output );
+
+        KCB_CHECK( 0 == memcmp( &output.SkeletonData[0], &input.SkeletonData[0], sizeof(NUI_SKELETON_DATA) ) );
+        KCB_CHECK( 7.0f == output.SkeletonData[1].SkeletonPositions[NUI_SKELETON_POSITION_HAND_LEFT].x );
+    }
+
+    // turned off, frames pass through
+    SkeletonFilter filter;
+    filter.SetParameters( nullptr );
+    KCB_CHECK( !filter.IsEnabled() );
+
+    TestRandom random( 5 );
+    NUI_SKELETON_FRAME input = MakeTruth( 0, 0.0f );
+    AddJitter( input, random, 0.01f );
+    NUI_SKELETON_FRAME output = input;
+    filter.Process( output );
+    KCB_CHECK( 0 == memcmp( &output, &input, sizeof(NUI_SKELETON_FRAME) ) );
+}
+
+// an unknown filter type is refused and the filter keeps what it had, a fresh filter stays off
+static void TestInvalidType()
+{
+    KINECT_SKELETON_FILTER invalid = MakeParams( SkeletonFilterNone );
+    const UINT32 type = 7;
+    memcpy( &invalid.eType, &type, sizeof(type) );
+
+    SkeletonFilter filter;
+    KCB_CHECK_HR( filter.SetParameters( &invalid ), E_INVALIDARG );
+    KCB_CHECK( !filter.IsEnabled() );
+
+    NUI_SKELETON_FRAME input = MakeTruth( 0, 0.0f );
+    NUI_SKELETON_FRAME output = input;
+    filter.Process( output );
+    KCB_CHECK( 0 == memcmp( &output, &input, sizeof(NUI_SKELETON_FRAME) ) );
+
+    KINECT_SKELETON_FILTER params = MakeParams( SkeletonFilterKalman );
+    KCB_CHECK_HR( filter.SetParameters( &params ), S_OK );
+    KCB_CHECK_HR( filter.SetParameters( &invalid ), E_INVALIDARG );
+    KCB_CHECK( filter.IsEnabled() );
+
+    params.dwStructSize = 0;
+    KCB_CHECK_HR( filter.SetParameters( &params ), E_INVALIDARG );
+
+    // still the Kalman filter, a still joint stays where it is
+    output = input;
+    filter.Process( output );
+    const Vector4& joint = output.SkeletonData[0].SkeletonPositions[NUI_SKELETON_POSITION_HEAD];
+    const Vector4& truth = input.SkeletonData[0].SkeletonPositions[NUI_SKELETON_POSITION_HEAD];
+    KCB_CHECK_NEAR( joint.z, truth.z, 1e-6 );
+    KCB_CHECK_NEAR( joint.y, truth.y, 1e-6 );
+}
+
+static void BenchmarkFilter( KINECT_SKELETON_FILTER_TYPE eType )
+{
+    KINECT_SKELETON_FILTER params = MakeParams( eType );
+    SkeletonFilter filter;
+    filter.SetParameters( &params );
+
+    TestRandom random( 7 );
+    const UINT cFrames = 64;
+    std::vector<NUI_SKELETON_FRAME> frames( cFrames );
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        frames[frame] = MakeTruth( frame, 0.5f );
+        AddJitter( frames[frame], random, 0.01f );
+    }
+
+    const UINT cRuns = 200;
+    Stopwatch time;
+    for( UINT run = 0; run < cRuns; ++run )
+    {
+        for( UINT frame = 0; frame < cFrames; ++frame )
+        {
+            NUI_SKELETON_FRAME skeletonFrame = frames[frame];
+            skeletonFrame.liTimeStamp.QuadPart += run * cFrames * FRAME_MS;
+            filter.Process( skeletonFrame );
+        }
+    }
+
+    printf( "%s: %.2f us per frame of %u skeletons\n", FilterName( eType ), time.ElapsedMicroseconds() / (cRuns * cFrames), NUI_SKELETON_COUNT );
+}
+
+int main( int argc, char** argv )
+{
+    TestJitter();
+    TestMotion();
+    TestRestart();
+    TestInvalidType();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkFilter( SkeletonFilterDoubleExponential );
+        BenchmarkFilter( SkeletonFilterOneEuro );
+        BenchmarkFilter( SkeletonFilterKalman );
+    }
+
+    return ReportTestResult( "SkeletonFilterTests" );
+}
@@ -0,0 +1,404 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "SkeletonFusion.h"
+
+#include <math.h>
+#include <vector>
+
+static const LONGLONG FRAME_MS = 33;
+
+// sensor a is the world frame, sensor b stands 2.5 m to the right of it turned a quarter
+// towards the people in front of a
+static const KCBHANDLE SENSOR_A = 1;
+static const KCBHANDLE SENSOR_B = 2;
+
+static KINECT_SENSOR_POSE MakePose( float yaw, float x, float y, float z )
+{
+    KINECT_SENSOR_POSE pose;
+    ZeroMemory( &pose, sizeof(pose) );
+    pose.dwStructSize = sizeof(KINECT_SENSOR_POSE);
+
+    // rotation around the vertical axis
+    float c = cosf( yaw ), s = sinf( yaw );
+    pose.fRotation[0][0] = c;       pose.fRotation[0][2] = s;
+    pose.fRotation[1][1] = 1.0f;
+    pose.fRotation[2][0] = -s;      pose.fRotation[2][2] = c;
+    pose.vTranslation = MakeVector( x, y, z );
+    return pose;
+}
+
+static const KINECT_SENSOR_POSE POSE_A = MakePose( 0.0f, 0.0f, 0.0f, 0.0f );
+static const KINECT_SENSOR_POSE POSE_B = MakePose( -1.5707963f, 2.5f, 0.0f, 2.5f );
+
+// the skeleton as the sensor of the pose sees it, world = rotation * seen + translation
+static NUI_SKELETON_DATA SeenBy( const KINECT_SENSOR_POSE& pose, NUI_SKELETON_DATA skeleton )
+{
+    Vector4* pPositions[NUI_SKELETON_POSITION_COUNT + 1] = { &skeleton.Position };
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        pPositions[j + 1] = &skeleton.SkeletonPositions[j];
+    }
+
+    for( UINT i = 0; i < _countof(pPositions); ++i )
+    {
+        Vector4& v = *pPositions[i];
+        float d[3] = { v.x - pose.vTranslation.x, v.y - pose.vTranslation.y, v.z - pose.vTranslation.z };
+        v = MakeVector(
+            pose.fRotation[0][0] * d[0] + pose.fRotation[1][0] * d[1] + pose.fRotation[2][0] * d[2],
+            pose.fRotation[0][1] * d[0] + pose.fRotation[1][1] * d[1] + pose.fRotation[2][1] * d[2],
+            pose.fRotation[0][2] * d[0] + pose.fRotation[1][2] * d[1] + pose.fRotation[2][2] * d[2] );
+    }
+
+    return skeleton;
+}
+
+// a person in the world at x, z as a sensor sees them in slot of the frame
+static void AddPerson( _Inout_ NUI_SKELETON_FRAME& skeletonFrame, UINT slot, DWORD dwTrackingID, const KINECT_SENSOR_POSE& pose, float x, float z )
+{
+    skeletonFrame.SkeletonData[slot] = SeenBy( pose, MakeSkeleton( dwTrackingID, x, 0.0f, z ) );
+}
+
+static std::vector<KINECT_FUSED_SKELETON> GetSkeletons( SkeletonFusion& fusion, ULONGLONG ulTime )
+{
+    KINECT_FUSED_SKELETON skeletons[2 * NUI_SKELETON_COUNT];
+    ULONG cSkeletons = 0;
+    KCB_CHECK_HR( fusion.GetSkeletons( ulTime, _countof(skeletons), skeletons, &cSkeletons, nullptr ), S_OK );
+    return std::vector<KINECT_FUSED_SKELETON>( skeletons, skeletons + cSkeletons );
+}
+
+// the fused person closest to world x, z
+static const KINECT_FUSED_SKELETON* FindPerson( const std::vector<KINECT_FUSED_SKELETON>& skeletons, float x, float z )
+{
+    const KINECT_FUSED_SKELETON* pClosest = nullptr;
+    float closest = 1e30f;
+    for( size_t i = 0; i < skeletons.size(); ++i )
+    {
+        const Vector4& hip = skeletons[i].SkeletonPositions[NUI_SKELETON_POSITION_HIP_CENTER];
+        float distance = (hip.x - x) * (hip.x - x) + (hip.z - z) * (hip.z - z);
+        if( distance < closest )
+        {
+            closest = distance;
+            pClosest = &skeletons[i];
+        }
+    }
+    return pClosest;
+}
+
+// largest distance of the joints from the T-pose at x, z
+static float PoseError( const KINECT_FUSED_SKELETON& skeleton, float x, float z )
+{
+    float error = 0.0f;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        const Vector4& v = skeleton.SkeletonPositions[j];
+        float dx = v.x - (x + TEST_T_POSE[j][0]), dy = v.y - TEST_T_POSE[j][1], dz = v.z - (z + TEST_T_POSE[j][2]);
+        error = max( error, sqrtf( dx * dx + dy * dy + dz * dz ) );
+    }
+    return error;
+}
+
+// the joints seen by a turned sensor come out in the world frame; frames of sensors without a
+// pose and frames seen before are skipped
+static void TestPoseTransform()
+{
+    SkeletonFusion fusion;
+    KINECT_SENSOR_POSE pose = POSE_B;
+    pose.dwStructSize = 0;
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_B, &pose ), E_INVALIDARG );
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_B, &POSE_B ), S_OK );
+
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 500, 1 );
+    AddPerson( skeletonFrame, 2, 21, POSE_B, 0.3f, 2.0f );
+    KCB_CHECK( fabsf( skeletonFrame.SkeletonData[2].Position.z - 2.2f ) < 1e-5f );
+
+    fusion.AddFrame( SENSOR_A, skeletonFrame, 1000 );
+    KCB_CHECK( GetSkeletons( fusion, 1000 ).empty() );
+
+    fusion.AddFrame( SENSOR_B, skeletonFrame, 1000 );
+    std::vector<KINECT_FUSED_SKELETON> skeletons = GetSkeletons( fusion, 1000 );
+    KCB_CHECK( 1 == skeletons.size() );
+    KCB_CHECK( 0 != skeletons[0].dwPersonID && 1 == skeletons[0].cSensors );
+    KCB_CHECK_NEAR( PoseError( skeletons[0], 0.3f, 2.0f ), 0.0, 1e-5 );
+    KCB_CHECK( NUI_SKELETON_POSITION_TRACKED == skeletons[0].eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HEAD] );
+
+    // the same frame again changes nothing, not even the time of the last frame
+    LONGLONG liTimeStamp = 0;
+    ULONG cSkeletons = 0;
+    KINECT_FUSED_SKELETON skeleton;
+    fusion.AddFrame( SENSOR_B, skeletonFrame, 1100 );
+    KCB_CHECK_HR( fusion.GetSkeletons( 1100, 1, &skeleton, &cSkeletons, &liTimeStamp ), S_OK );
+    KCB_CHECK( 1 == cSkeletons && 1000 == liTimeStamp );
+    KCB_CHECK_HR( fusion.GetSkeletons( 1100, 0, &skeleton, &cSkeletons, nullptr ), HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER) );
+    KCB_CHECK( 1 == cSkeletons );
+
+    // without a pose the sensor is gone
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_B, nullptr ), S_OK );
+    KCB_CHECK( GetSkeletons( fusion, 1100 ).empty() );
+}
+
+// two people seen by both sensors in another order, each sensor off by a few centimeters the
+// other way: two people of both sensors, on the true joints, with the same ids frame after frame
+static void TestTwoSensors()
+{
+    SkeletonFusion fusion;
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_A, &POSE_A ), S_OK );
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_B, &POSE_B ), S_OK );
+
+    DWORD dwFirstID = 0, dwSecondID = 0;
+    bool bSame = true, bOnJoints = true;
+    for( UINT frame = 0; frame < 60; ++frame )
+    {
+        // walking towards each other along x, passing 1 m apart in depth
+        float x1 = -1.0f + frame * 0.02f, x2 = 1.0f - frame * 0.02f;
+        ULONGLONG ulTime = 1000 + frame * FRAME_MS;
+
+        NUI_SKELETON_FRAME frameA = MakeSkeletonFrame( 100 + frame * FRAME_MS, frame );
+        AddPerson( frameA, 0, 11, POSE_A, x1 + 0.03f, 2.0f );
+        AddPerson( frameA, 4, 12, POSE_A, x2 + 0.03f, 3.0f );
+        fusion.AddFrame( SENSOR_A, frameA, ulTime );
+
+        NUI_SKELETON_FRAME frameB = MakeSkeletonFrame( 9000 + frame * FRAME_MS, frame );
+        AddPerson( frameB, 1, 22, POSE_B, x2 - 0.03f, 3.0f );
+        AddPerson( frameB, 3, 21, POSE_B, x1 - 0.03f, 2.0f );
+        fusion.AddFrame( SENSOR_B, frameB, ulTime + 5 );
+
+        std::vector<KINECT_FUSED_SKELETON> skeletons = GetSkeletons( fusion, ulTime + 5 );
+        const KINECT_FUSED_SKELETON* pFirst = FindPerson( skeletons, x1, 2.0f );
+        const KINECT_FUSED_SKELETON* pSecond = FindPerson( skeletons, x2, 3.0f );
+        if( 0 == frame )
+        {
+            KCB_CHECK( 2 == skeletons.size() && pFirst != pSecond );
+            dwFirstID = pFirst->dwPersonID;
+            dwSecondID = pSecond->dwPersonID;
+        }
+
+        bSame = bSame && 2 == skeletons.size() && 2 == pFirst->cSensors && 2 == pSecond->cSensors
+            && dwFirstID == pFirst->dwPersonID && dwSecondID == pSecond->dwPersonID;
+        bOnJoints = bOnJoints && PoseError( *pFirst, x1, 2.0f ) < 1e-4f && PoseError( *pSecond, x2, 3.0f ) < 1e-4f;
+    }
+    KCB_CHECK( bSame );
+    KCB_CHECK( bOnJoints );
+    KCB_CHECK( dwFirstID != dwSecondID );
+}
+
+// an inferred joint counts for less, one the sensor does not track not at all
+static void TestWeights()
+{
+    SkeletonFusion fusion;
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_A, &POSE_A ), S_OK );
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_B, &POSE_B ), S_OK );
+
+    NUI_SKELETON_FRAME frameA = MakeSkeletonFrame( 100, 1 );
+    AddPerson( frameA, 0, 11, POSE_A, 0.0f, 2.0f );
+    frameA.SkeletonData[0].SkeletonPositions[NUI_SKELETON_POSITION_HAND_LEFT].y += 0.12f;
+    frameA.SkeletonData[0].eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HAND_LEFT] = NUI_SKELETON_POSITION_INFERRED;
+    frameA.SkeletonData[0].SkeletonPositions[NUI_SKELETON_POSITION_FOOT_LEFT].y += 1.0f;
+    frameA.SkeletonData[0].eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_FOOT_LEFT] = NUI_SKELETON_POSITION_NOT_TRACKED;
+    fusion.AddFrame( SENSOR_A, frameA, 1000 );
+
+    NUI_SKELETON_FRAME frameB = MakeSkeletonFrame( 200, 1 );
+    AddPerson( frameB, 5, 21, POSE_B, 0.0f, 2.0f );
+    frameB.SkeletonData[5].eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_FOOT_RIGHT] = NUI_SKELETON_POSITION_INFERRED;
+    fusion.AddFrame( SENSOR_B, frameB, 1010 );
+
+    std::vector<KINECT_FUSED_SKELETON> skeletons = GetSkeletons( fusion, 1010 );
+    KCB_CHECK( 1 == skeletons.size() );
+    const KINECT_FUSED_SKELETON& skeleton = skeletons[0];
+    KCB_CHECK( 2 == skeleton.cSensors );
+
+    // 0.12 m off at a weight of 0.2 against 1
+    KCB_CHECK_NEAR( skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HAND_LEFT].y, TEST_T_POSE[NUI_SKELETON_POSITION_HAND_LEFT][1] + 0.02, 1e-5 );
+    KCB_CHECK_NEAR( skeleton.SkeletonPositions[NUI_SKELETON_POSITION_FOOT_LEFT].y, TEST_T_POSE[NUI_SKELETON_POSITION_FOOT_LEFT][1], 1e-5 );
+
+    // the best state of the sensors
+    KCB_CHECK( NUI_SKELETON_POSITION_TRACKED == skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HAND_LEFT] );
+    KCB_CHECK( NUI_SKELETON_POSITION_TRACKED == skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_FOOT_LEFT] );
+    KCB_CHECK( NUI_SKELETON_POSITION_TRACKED == skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_FOOT_RIGHT] );
+}
+
+// sensor b sees a second person at a mean joint distance of d from the person of sensor a
+static size_t CountPeople( float d )
+{
+    SkeletonFusion fusion;
+    fusion.SetSensorPose( SENSOR_A, &POSE_A );
+    fusion.SetSensorPose( SENSOR_B, &POSE_B );
+
+    NUI_SKELETON_FRAME frameA = MakeSkeletonFrame( 100, 1 );
+    AddPerson( frameA, 0, 11, POSE_A, 0.0f, 2.0f );
+    fusion.AddFrame( SENSOR_A, frameA, 1000 );
+
+    NUI_SKELETON_FRAME frameB = MakeSkeletonFrame( 200, 1 );
+    AddPerson( frameB, 0, 21, POSE_B, d, 2.0f );
+    fusion.AddFrame( SENSOR_B, frameB, 1010 );
+
+    return GetSkeletons( fusion, 1010 ).size();
+}
+
+// one person up to the gate of 0.5 m, two beyond it
+static void TestGate()
+{
+    KCB_CHECK( 1 == CountPeople( 0.0f ) );
+    KCB_CHECK( 1 == CountPeople( 0.45f ) );
+    KCB_CHECK( 2 == CountPeople( 0.55f ) );
+    KCB_CHECK( 2 == CountPeople( 2.0f ) );
+}
+
+// two people 0.45 m apart, sensor b sees both of them shifted by 0.25 m: the first one of sensor
+// b is closer to the second person, but only the assignment of the least total distance keeps
+// both people within the gate
+static void TestAssignment()
+{
+    SkeletonFusion fusion;
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_A, &POSE_A ), S_OK );
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_B, &POSE_B ), S_OK );
+
+    NUI_SKELETON_FRAME frameA = MakeSkeletonFrame( 100, 1 );
+    AddPerson( frameA, 0, 11, POSE_A, 0.0f, 2.0f );
+    AddPerson( frameA, 1, 12, POSE_A, 0.45f, 2.0f );
+    fusion.AddFrame( SENSOR_A, frameA, 1000 );
+
+    NUI_SKELETON_FRAME frameB = MakeSkeletonFrame( 200, 1 );
+    AddPerson( frameB, 0, 21, POSE_B, 0.25f, 2.0f );
+    AddPerson( frameB, 1, 22, POSE_B, 0.7f, 2.0f );
+    fusion.AddFrame( SENSOR_B, frameB, 1010 );
+
+    std::vector<KINECT_FUSED_SKELETON> skeletons = GetSkeletons( fusion, 1010 );
+    KCB_CHECK( 2 == skeletons.size() );
+    const KINECT_FUSED_SKELETON* pFirst = FindPerson( skeletons, 0.125f, 2.0f );
+    const KINECT_FUSED_SKELETON* pSecond = FindPerson( skeletons, 0.575f, 2.0f );
+    KCB_CHECK( 2 == pFirst->cSensors && 2 == pSecond->cSensors );
+    KCB_CHECK_NEAR( PoseError( *pFirst, 0.125f, 2.0f ), 0.0, 1e-5 );
+    KCB_CHECK_NEAR( PoseError( *pSecond, 0.575f, 2.0f ), 0.0, 1e-5 );
+}
+
+// a sensor without frames for 200 ms drops out, its people stay with the other sensor under
+// their ids, and it joins them again when it comes back
+static void TestDropout()
+{
+    SkeletonFusion fusion;
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_A, &POSE_A ), S_OK );
+    KCB_CHECK_HR( fusion.SetSensorPose( SENSOR_B, &POSE_B ), S_OK );
+
+    // a person both sensors see, and one only sensor a sees
+    UINT frame = 0;
+    ULONGLONG ulLastA = 0;
+    for( ; frame < 10; ++frame )
+    {
+        NUI_SKELETON_FRAME frameA = MakeSkeletonFrame( 100 + frame * FRAME_MS, frame );
+        AddPerson( frameA, 0, 11, POSE_A, 0.0f, 2.0f );
+        AddPerson( frameA, 1, 12, POSE_A, -1.5f, 3.0f );
+        ulLastA = 1000 + frame * FRAME_MS;
+        fusion.AddFrame( SENSOR_A, frameA, ulLastA );
+
+        NUI_SKELETON_FRAME frameB = MakeSkeletonFrame( 5000 + frame * FRAME_MS, frame );
+        AddPerson( frameB, 2, 21, POSE_B, 0.0f, 2.0f );
+        fusion.AddFrame( SENSOR_B, frameB, ulLastA + 10 );
+    }
+
+    std::vector<KINECT_FUSED_SKELETON> skeletons = GetSkeletons( fusion, ulLastA + 10 );
+    KCB_CHECK( 2 == skeletons.size() );
+    DWORD dwSharedID = FindPerson( skeletons, 0.0f, 2.0f )->dwPersonID;
+    KCB_CHECK( 2 == FindPerson( skeletons, 0.0f, 2.0f )->cSensors );
+
+    // sensor a stops, sensor b goes on
+    bool bKept = true, bDropped = true;
+    ULONGLONG ulTime = ulLastA;
+    for( ; frame < 30; ++frame )
+    {
+        ulTime = 1000 + frame * FRAME_MS;
+        NUI_SKELETON_FRAME frameB = MakeSkeletonFrame( 5000 + frame * FRAME_MS, frame );
+        AddPerson( frameB, 2, 21, POSE_B, 0.0f, 2.0f );
+        fusion.AddFrame( SENSOR_B, frameB, ulTime + 10 );
+
+        skeletons = GetSkeletons( fusion, ulTime + 10 );
+        if( ulTime + 10 <= ulLastA + SKELETON_FUSION_TIMEOUT )
+        {
+            bKept = bKept && 2 == skeletons.size() && 2 == FindPerson( skeletons, 0.0f, 2.0f )->cSensors;
+        }
+        else
+        {
+            bDropped = bDropped && 1 == skeletons.size() && 1 == skeletons[0].cSensors && dwSharedID == skeletons[0].dwPersonID;
+        }
+    }
+    KCB_CHECK( bKept );
+    KCB_CHECK( bDropped );
+
+    // the time alone drops sensors too
+    KCB_CHECK( 1 == GetSkeletons( fusion, ulTime + 10 + SKELETON_FUSION_TIMEOUT ).size() );
+    KCB_CHECK( GetSkeletons( fusion, ulTime + 11 + SKELETON_FUSION_TIMEOUT ).empty() );
+
+    // sensor a is back, its person joins the one of sensor b
+    NUI_SKELETON_FRAME frameB = MakeSkeletonFrame( 5000 + frame * FRAME_MS, frame );
+    AddPerson( frameB, 2, 21, POSE_B, 0.0f, 2.0f );
+    fusion.AddFrame( SENSOR_B, frameB, 1000 + frame * FRAME_MS );
+    NUI_SKELETON_FRAME frameA = MakeSkeletonFrame( 100 + frame * FRAME_MS, frame );
+    AddPerson( frameA, 3, 11, POSE_A, 0.0f, 2.0f );
+    fusion.AddFrame( SENSOR_A, frameA, 1000 + frame * FRAME_MS + 5 );
+
+    skeletons = GetSkeletons( fusion, 1000 + frame * FRAME_MS + 5 );
+    KCB_CHECK( 1 == skeletons.size() && 2 == skeletons[0].cSensors && dwSharedID == skeletons[0].dwPersonID );
+}
+
+// four sensors around six people
+static void BenchmarkFusion()
+{
+    SkeletonFusion fusion;
+    KINECT_SENSOR_POSE poses[4];
+    for( UINT s = 0; s < _countof(poses); ++s )
+    {
+        float yaw = s * 1.5707963f;
+        poses[s] = MakePose( yaw, -3.0f * sinf( yaw ), 0.0f, 3.0f - 3.0f * cosf( yaw ) );
+        fusion.SetSensorPose( s + 1, &poses[s] );
+    }
+
+    TestRandom random( 48 );
+    const UINT cFrames = 2000;
+    Stopwatch time;
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        UINT s = frame % _countof(poses);
+        NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( frame * 10, frame );
+        for( UINT p = 0; p < NUI_SKELETON_COUNT; ++p )
+        {
+            AddPerson( skeletonFrame, (p + s) % NUI_SKELETON_COUNT, 10 * (s + 1) + p, poses[s],
+                -1.25f + 0.5f * p + random.Gaussian( 0.02f ), 3.0f + random.Gaussian( 0.02f ) );
+        }
+        fusion.AddFrame( s + 1, skeletonFrame, frame * 10 );
+    }
+    double perFrame = time.ElapsedMicroseconds() / cFrames;
+
+    std::vector<KINECT_FUSED_SKELETON> skeletons = GetSkeletons( fusion, (cFrames - 1) * 10 );
+    KCB_CHECK( NUI_SKELETON_COUNT == skeletons.size() );
+    printf( "fusion: %.2f us per frame of %u skeletons from 4 sensors, %u people\n", perFrame, NUI_SKELETON_COUNT, static_cast<UINT>( skeletons.size() ) );
+}
+
+int main( int argc, char** argv )
+{
+    TestPoseTransform();
+    TestTwoSensors();
+    TestWeights();
+    TestGate();
+    TestAssignment();
+    TestDropout();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkFusion();
+    }
+
+    return ReportTestResult( "SkeletonFusionTests" );
+}
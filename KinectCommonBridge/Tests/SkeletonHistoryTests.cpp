@@ -0,0 +1,328 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "SkeletonHistory.h"
+
+#include <limits.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+static const LONGLONG FRAME_MS = 33;
+
+static KINECT_SKELETON_HISTORY MakeParams( float fSeconds, bool bHalfPrecision )
+{
+    KINECT_SKELETON_HISTORY params;
+    ZeroMemory( &params, sizeof(params) );
+    params.dwStructSize = sizeof(KINECT_SKELETON_HISTORY);
+    params.fSeconds = fSeconds;
+    params.bHalfPrecision = bHalfPrecision;
+    return params;
+}
+
+static LONGLONG FrameTime( UINT frame )
+{
+    return 1000 + frame * FRAME_MS;
+}
+
+// skeleton 7 in slot 2, its hip center at x = frame / 100 so every frame can be told apart
+static NUI_SKELETON_FRAME MakeFrame( UINT frame )
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( FrameTime( frame ), frame );
+    skeletonFrame.SkeletonData[2] = MakeSkeleton( 7, frame / 100.0f, 0.5f, 2.0f );
+    skeletonFrame.SkeletonData[2].eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HAND_LEFT] =
+        (0 == frame % 3) ? NUI_SKELETON_POSITION_INFERRED : NUI_SKELETON_POSITION_TRACKED;
+    return skeletonFrame;
+}
+
+struct Trajectory
+{
+    KINECT_SKELETON_TRAJECTORY query;
+    std::vector<LONGLONG> timeStamps;
+    std::vector<Vector4> positions;
+    std::vector<BYTE> trackingStates;
+};
+
+static void MakeTrajectory( DWORD dwTrackingID, LONGLONG liStartTime, LONGLONG liEndTime, DWORD dwJointMask, ULONG cMaxFrames, _Out_ Trajectory& trajectory )
+{
+    ULONG cJoints = 0;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        cJoints += (0 != (dwJointMask & (1 << j)));
+    }
+
+    trajectory.timeStamps.assign( cMaxFrames, -1 );
+    trajectory.positions.assign( cMaxFrames * cJoints, MakeVector( -1.0f, -1.0f, -1.0f ) );
+    trajectory.trackingStates.assign( cMaxFrames * cJoints, 0xff );
+
+    KINECT_SKELETON_TRAJECTORY& query = trajectory.query;
+    ZeroMemory( &query, sizeof(query) );
+    query.dwStructSize = sizeof(KINECT_SKELETON_TRAJECTORY);
+    query.dwTrackingID = dwTrackingID;
+    query.liStartTime = liStartTime;
+    query.liEndTime = liEndTime;
+    query.dwJointMask = dwJointMask;
+    query.cMaxFrames = cMaxFrames;
+    query.pTimeStamps = trajectory.timeStamps.data();
+    query.pPositions = trajectory.positions.data();
+    query.pTrackingStates = trajectory.trackingStates.data();
+}
+
+// the ring keeps the last seconds of frames oldest first, the joints of the mask cMaxFrames apart
+static void TestRingWrap()
+{
+    const UINT cFrames = 100;
+    const ULONG capacity = 31;        // 1 s at 30 frames a second and the frame at either end
+
+    SkeletonHistory history;
+    KINECT_SKELETON_HISTORY params = MakeParams( 1.0f, false );
+    history.SetParameters( &params );
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        history.Append( MakeFrame( frame ) );
+    }
+
+    const DWORD mask = (1 << NUI_SKELETON_POSITION_HIP_CENTER) | (1 << NUI_SKELETON_POSITION_HAND_LEFT);
+    Trajectory trajectory;
+    MakeTrajectory( 7, 0, FrameTime( cFrames ), mask, 40, trajectory );
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), S_OK );
+    KCB_CHECK( capacity == trajectory.query.cFrames );
+
+    UINT cWrong = 0;
+    for( ULONG f = 0; f < capacity; ++f )
+    {
+        UINT frame = cFrames - capacity + f;
+        const Vector4& hip = trajectory.positions[f];
+        const Vector4& hand = trajectory.positions[40 + f];
+
+        cWrong += FrameTime( frame ) != trajectory.timeStamps[f];
+        cWrong += frame / 100.0f != hip.x || 0.5f != hip.y || 2.0f != hip.z || 1.0f != hip.w;
+        cWrong += frame / 100.0f + TEST_T_POSE[NUI_SKELETON_POSITION_HAND_LEFT][0] != hand.x;
+        cWrong += NUI_SKELETON_POSITION_TRACKED != trajectory.trackingStates[f];
+        cWrong += ((0 == frame % 3) ? NUI_SKELETON_POSITION_INFERRED : NUI_SKELETON_POSITION_TRACKED) != trajectory.trackingStates[40 + f];
+    }
+    KCB_CHECK( 0 == cWrong );
+
+    // the buffers past the frames are untouched
+    KCB_CHECK( -1 == trajectory.timeStamps[capacity] && -1.0f == trajectory.positions[capacity].x );
+
+    // a frame that is not newer is skipped
+    history.Append( MakeFrame( 10 ) );
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), S_OK );
+    KCB_CHECK( capacity == trajectory.query.cFrames && FrameTime( cFrames - 1 ) == trajectory.timeStamps[capacity - 1] );
+}
+
+// both ends of the range are inclusive; the frames found by binary search are the ones a linear scan finds
+static void TestTimeRange()
+{
+    SkeletonHistory history;
+    KINECT_SKELETON_HISTORY params = MakeParams( 2.0f, false );
+    history.SetParameters( &params );
+
+    // frames with gaps, past the capacity of 61
+    std::vector<LONGLONG> times;
+    for( UINT frame = 0; frame < 150; ++frame )
+    {
+        if( 0 != frame % 7 )
+        {
+            history.Append( MakeFrame( frame ) );
+            times.push_back( FrameTime( frame ) );
+        }
+    }
+    times.erase( times.begin(), times.end() - 61 );
+
+    TestRandom random( 5 );
+    UINT cWrong = 0;
+    for( UINT i = 0; i < 500; ++i )
+    {
+        // ends on a frame, between frames and outside of the history
+        LONGLONG liStart = times.front() - 100 + static_cast<LONGLONG>( random.Next() % (times.back() - times.front() + 200) );
+        LONGLONG liEnd = liStart + static_cast<LONGLONG>( random.Next() % 1000 ) - 100;
+        if( 0 == i % 4 )
+        {
+            liStart = times[random.Next() % times.size()];
+            liEnd = times[random.Next() % times.size()];
+        }
+
+        std::vector<LONGLONG> expected;
+        for( size_t f = 0; f < times.size(); ++f )
+        {
+            if( times[f] >= liStart && times[f] <= liEnd )
+            {
+                expected.push_back( times[f] );
+            }
+        }
+
+        Trajectory trajectory;
+        MakeTrajectory( 7, liStart, liEnd, 1, 61, trajectory );
+        cWrong += S_OK != history.GetTrajectory( &trajectory.query );
+        cWrong += expected.size() != trajectory.query.cFrames;
+        cWrong += !std::equal( expected.begin(), expected.end(), trajectory.timeStamps.begin() );
+    }
+    KCB_CHECK( 0 == cWrong );
+
+    // a count without buffers, and buffers that are too small
+    Trajectory trajectory;
+    MakeTrajectory( 7, times[10], times[20], 1, 5, trajectory );
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER) );
+    KCB_CHECK( 11 == trajectory.query.cFrames );
+
+    trajectory.query.pTimeStamps = nullptr;
+    trajectory.query.pPositions = nullptr;
+    trajectory.query.pTrackingStates = nullptr;
+    trajectory.query.cMaxFrames = 0;
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), S_OK );
+    KCB_CHECK( 11 == trajectory.query.cFrames );
+}
+
+// 16 bit floats keep the joints within 1 mm up to 4 m, and values they hold exactly unchanged
+static void TestHalfPrecision()
+{
+    SkeletonHistory history;
+    KINECT_SKELETON_HISTORY params = MakeParams( 0.0f, true );
+    history.SetParameters( &params );
+
+    const UINT cFrames = 150;
+    TestRandom random( 9 );
+    std::vector<NUI_SKELETON_FRAME> frames( cFrames );
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        frames[frame] = MakeSkeletonFrame( FrameTime( frame ), frame );
+        NUI_SKELETON_DATA& skeleton = frames[frame].SkeletonData[0];
+        skeleton = MakeSkeleton( 3, 0.0f, 0.0f, 0.0f );
+        for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+        {
+            skeleton.SkeletonPositions[j] = MakeVector( random.Symmetric( 4.0f ), random.Symmetric( 4.0f ), random.Uniform() * 4.0f );
+        }
+
+        // representable in 16 bits, the smallest subnormal and the largest value below 4
+        skeleton.SkeletonPositions[0] = MakeVector( 1.5f, -0.25f, 3.99609375f );
+        skeleton.SkeletonPositions[1] = MakeVector( 5.9604645e-8f, 0.0f, -2.0f );
+
+        history.Append( frames[frame] );
+    }
+
+    Trajectory trajectory;
+    MakeTrajectory( 3, 0, FrameTime( cFrames ), 0xfffff, cFrames, trajectory );
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), S_OK );
+    KCB_CHECK( cFrames == trajectory.query.cFrames );
+
+    float maxError = 0.0f;
+    UINT cInexact = 0;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        for( UINT f = 0; f < cFrames; ++f )
+        {
+            const Vector4& expected = frames[f].SkeletonData[0].SkeletonPositions[j];
+            const Vector4& actual = trajectory.positions[j * cFrames + f];
+            maxError = max( maxError, max( fabsf( expected.x - actual.x ), max( fabsf( expected.y - actual.y ), fabsf( expected.z - actual.z ) ) ) );
+
+            if( j < 2 )
+            {
+                cInexact += expected.x != actual.x || expected.y != actual.y || expected.z != actual.z;
+            }
+        }
+    }
+    KCB_CHECK( maxError <= 1e-3f );
+    KCB_CHECK( 0 == cInexact );
+}
+
+// a history per tracking id; a new player takes the slot of the one seen longest ago
+static void TestSlots()
+{
+    SkeletonHistory history;
+    Trajectory trajectory;
+    MakeTrajectory( 7, 0, LLONG_MAX, 1, 10, trajectory );
+
+    history.Append( MakeFrame( 0 ) );
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), E_NUI_FRAME_NO_DATA );
+
+    KINECT_SKELETON_HISTORY params = MakeParams( 0.0f, false );
+    history.SetParameters( &params );
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), E_NUI_FRAME_NO_DATA );
+
+    // player 1 leaves, then one new player a frame
+    for( UINT frame = 0; frame < 1 + SKELETON_HISTORY_SLOTS; ++frame )
+    {
+        NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( FrameTime( frame ), frame );
+        skeletonFrame.SkeletonData[0] = MakeSkeleton( 1 + frame, 0.0f, 0.0f, 2.0f );
+        history.Append( skeletonFrame );
+    }
+
+    trajectory.query.dwTrackingID = 1;
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), E_NUI_FRAME_NO_DATA );
+    trajectory.query.dwTrackingID = 2;
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), S_OK );
+    KCB_CHECK( 1 == trajectory.query.cFrames && FrameTime( 1 ) == trajectory.timeStamps[0] );
+    trajectory.query.dwTrackingID = 1 + SKELETON_HISTORY_SLOTS;
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), S_OK );
+
+    // turned off
+    history.SetParameters( nullptr );
+    KCB_CHECK_HR( history.GetTrajectory( &trajectory.query ), E_NUI_FRAME_NO_DATA );
+}
+
+static void BenchmarkHistory( bool bHalfPrecision )
+{
+    SkeletonHistory history;
+    KINECT_SKELETON_HISTORY params = MakeParams( 60.0f, bHalfPrecision );
+    history.SetParameters( &params );
+
+    const UINT cFrames = 1801;
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 0, 0 );
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        skeletonFrame.SkeletonData[s] = MakeSkeleton( 1 + s, -2.5f + s, 0.0f, 2.5f );
+    }
+
+    Stopwatch appendTime;
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        skeletonFrame.liTimeStamp.QuadPart = FrameTime( frame );
+        history.Append( skeletonFrame );
+    }
+    double appendUs = appendTime.ElapsedMicroseconds() / cFrames;
+
+    // the last 10 seconds of one hand
+    Trajectory trajectory;
+    MakeTrajectory( 1, FrameTime( cFrames - 300 ), FrameTime( cFrames ), 1 << NUI_SKELETON_POSITION_HAND_RIGHT, 300, trajectory );
+
+    const int cRuns = 10000;
+    Stopwatch queryTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        history.GetTrajectory( &trajectory.query );
+    }
+    double queryUs = queryTime.ElapsedMicroseconds() / cRuns;
+
+    printf( "skeleton history 60 s%s: append %.2f us, 300 frames of a joint %.2f us\n", bHalfPrecision ? " half precision" : "", appendUs, queryUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestRingWrap();
+    TestTimeRange();
+    TestHalfPrecision();
+    TestSlots();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkHistory( false );
+        BenchmarkHistory( true );
+    }
+
+    return ReportTestResult( "SkeletonHistoryTests" );
+}
@@ -0,0 +1,246 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestSkeletons.h"
+
+#include "SkeletonPredictor.h"
+
+#include <math.h>
+
+static const LONGLONG FRAME_MS = 33;
+
+static KINECT_SKELETON_PREDICTION MakePrediction( KINECT_SKELETON_PREDICTION_MODEL eModel, float fDamping )
+{
+    KINECT_SKELETON_PREDICTION prediction;
+    ZeroMemory( &prediction, sizeof(prediction) );
+    prediction.dwStructSize = sizeof(KINECT_SKELETON_PREDICTION);
+    prediction.eModel = eModel;
+    prediction.fDamping = fDamping;
+    return prediction;
+}
+
+// skeleton 1 of the frame walking along x at speed m/s, the other slots empty
+static NUI_SKELETON_FRAME MakeWalk( UINT frame, float speed )
+{
+    NUI_SKELETON_FRAME skeletonFrame = MakeSkeletonFrame( 1000 + frame * FRAME_MS, frame );
+    skeletonFrame.SkeletonData[1] = MakeSkeleton( 7, -1.0f + speed * frame * FRAME_MS / 1000.0f, 0.0f, 2.5f );
+    return skeletonFrame;
+}
+
+// largest distance of the joints of skeleton 1 to the last frame moved by dx along x
+static float MaxOffsetError( const NUI_SKELETON_FRAME& predicted, const NUI_SKELETON_FRAME& last, float dx )
+{
+    float maxError = 0.0f;
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        const Vector4& a = predicted.SkeletonData[1].SkeletonPositions[j];
+        const Vector4& b = last.SkeletonData[1].SkeletonPositions[j];
+        maxError = max( maxError, fabsf( a.x - b.x - dx ) );
+        maxError = max( maxError, fabsf( a.y - b.y ) );
+        maxError = max( maxError, fabsf( a.z - b.z ) );
+    }
+    return maxError;
+}
+
+// a joint moving at constant velocity is extrapolated along it by both models, up to the horizon
+static void TestConstantVelocity()
+{
+    const float speed = 1.5f;
+    const UINT cFrames = 10;
+
+    SkeletonPredictor predictor;
+    KINECT_SKELETON_PREDICTION velocity = MakePrediction( SkeletonPredictionConstantVelocity, 0.0f );
+    KINECT_SKELETON_PREDICTION acceleration = MakePrediction( SkeletonPredictionConstantAcceleration, 0.0f );
+
+    NUI_SKELETON_FRAME predicted;
+    KCB_CHECK_HR( predictor.Predict( 1000, velocity, predicted ), E_NUI_FRAME_NO_DATA );
+
+    NUI_SKELETON_FRAME last;
+    for( UINT frame = 0; frame < cFrames; ++frame )
+    {
+        last = MakeWalk( frame, speed );
+        predictor.Update( last );
+    }
+    LONGLONG liLast = last.liTimeStamp.QuadPart;
+
+    // 100 ms ahead
+    KCB_CHECK_HR( predictor.Predict( liLast + 100, velocity, predicted ), S_OK );
+    KCB_CHECK( MaxOffsetError( predicted, last, speed * 0.1f ) < 1e-4f );
+    KCB_CHECK( liLast + 100 == predicted.liTimeStamp.QuadPart );
+    KCB_CHECK_NEAR( predicted.SkeletonData[1].Position.x, last.SkeletonData[1].Position.x + speed * 0.1f, 1e-4f );
+    KCB_CHECK( NUI_SKELETON_NOT_TRACKED == predicted.SkeletonData[0].eTrackingState );
+
+    // no acceleration to add
+    KCB_CHECK_HR( predictor.Predict( liLast + 100, acceleration, predicted ), S_OK );
+    KCB_CHECK( MaxOffsetError( predicted, last, speed * 0.1f ) < 1e-4f );
+
+    // not further than the default horizon, never into the past
+    KCB_CHECK_HR( predictor.Predict( liLast + 500, velocity, predicted ), S_OK );
+    KCB_CHECK( MaxOffsetError( predicted, last, speed * SKELETON_PREDICTOR_DEFAULT_HORIZON ) < 1e-4f );
+    KCB_CHECK( liLast + 150 == predicted.liTimeStamp.QuadPart );
+
+    KCB_CHECK_HR( predictor.Predict( liLast - 50, velocity, predicted ), S_OK );
+    KCB_CHECK( MaxOffsetError( predicted, last, 0.0f ) == 0.0f );
+    KCB_CHECK( liLast == predicted.liTimeStamp.QuadPart );
+
+    // a frame that is not newer is skipped
+    predictor.Update( MakeWalk( 0, speed ) );
+    KCB_CHECK_HR( predictor.Predict( liLast + 100, velocity, predicted ), S_OK );
+    KCB_CHECK( MaxOffsetError( predicted, last, speed * 0.1f ) < 1e-4f );
+
+    // a new person in the slot starts without history and stays where it is
+    NUI_SKELETON_FRAME other = MakeWalk( cFrames, speed );
+    other.SkeletonData[1].dwTrackingID = 8;
+    predictor.Update( other );
+    KCB_CHECK_HR( predictor.Predict( other.liTimeStamp.QuadPart + 100, velocity, predicted ), S_OK );
+    KCB_CHECK( MaxOffsetError( predicted, other, 0.0f ) == 0.0f );
+}
+
+// a damped joint travels fDamping * (1 - e^(-t / fDamping)) of its velocity, less than undamped and
+// never more than the time constant; a long time constant is no damping, a short one stops the joint
+static void TestDampingLimits()
+{
+    const float speed = 2.0f;
+
+    SkeletonPredictor predictor;
+    NUI_SKELETON_FRAME last;
+    for( UINT frame = 0; frame < 5; ++frame )
+    {
+        last = MakeWalk( frame, speed );
+        predictor.Update( last );
+    }
+    LONGLONG liLast = last.liTimeStamp.QuadPart;
+
+    const float dampings[] = { 0.001f, 0.02f, 0.05f, 0.1f, 1000.0f };
+    float previousStep = 0.0f;
+    for( size_t k = 0; k < sizeof(dampings) / sizeof(dampings[0]); ++k )
+    {
+        float damping = dampings[k];
+        NUI_SKELETON_FRAME predicted;
+        KCB_CHECK_HR( predictor.Predict( liLast + 100, MakePrediction( SkeletonPredictionConstantVelocity, damping ), predicted ), S_OK );
+
+        float step = predicted.SkeletonData[1].SkeletonPositions[NUI_SKELETON_POSITION_HEAD].x - last.SkeletonData[1].SkeletonPositions[NUI_SKELETON_POSITION_HEAD].x;
+        float expected = speed * damping * (1.0f - expf( -0.1f / damping ));
+        KCB_CHECK( MaxOffsetError( predicted, last, expected ) < 1e-4f );
+
+        KCB_CHECK( step > previousStep );
+        KCB_CHECK( step <= speed * 0.1f + 1e-4f );
+        KCB_CHECK( step <= speed * damping + 1e-4f );
+        previousStep = step;
+    }
+
+    // the limits
+    KCB_CHECK( previousStep > speed * 0.1f - 1e-3f );
+
+    NUI_SKELETON_FRAME predicted;
+    KCB_CHECK_HR( predictor.Predict( liLast + 100, MakePrediction( SkeletonPredictionConstantVelocity, 0.001f ), predicted ), S_OK );
+    KCB_CHECK( MaxOffsetError( predicted, last, 0.0f ) < speed * 0.001f + 1e-4f );
+}
+
+static float BoneLength( const NUI_SKELETON_DATA& skeleton, NUI_SKELETON_POSITION_INDEX joint )
+{
+    const Vector4& a = skeleton.SkeletonPositions[joint];
+    const Vector4& b = skeleton.SkeletonPositions[SKELETON_PARENT_JOINTS[joint]];
+    return sqrtf( (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z) );
+}
+
+// the right hand is tracked at its length, then inferred and drifting away from the wrist; the prediction
+// stretches the bone, bKeepBoneLengths sets it back to the tracked length along the predicted direction
+static void TestKeepBoneLengths()
+{
+    const float handLength = TEST_T_POSE[NUI_SKELETON_POSITION_HAND_RIGHT][0] - TEST_T_POSE[NUI_SKELETON_POSITION_WRIST_RIGHT][0];
+
+    SkeletonPredictor predictor;
+    NUI_SKELETON_FRAME last;
+    for( UINT frame = 0; frame < 6; ++frame )
+    {
+        last = MakeWalk( frame, 0.0f );
+        if( frame >= 3 )
+        {
+            NUI_SKELETON_DATA& skeleton = last.SkeletonData[1];
+            skeleton.SkeletonPositions[NUI_SKELETON_POSITION_HAND_RIGHT].x += 0.05f * (frame - 2);
+            skeleton.eSkeletonPositionTrackingState[NUI_SKELETON_POSITION_HAND_RIGHT] = NUI_SKELETON_POSITION_INFERRED;
+        }
+        predictor.Update( last );
+    }
+    LONGLONG liLast = last.liTimeStamp.QuadPart;
+
+    KINECT_SKELETON_PREDICTION prediction = MakePrediction( SkeletonPredictionConstantVelocity, 0.0f );
+    NUI_SKELETON_FRAME stretched;
+    KCB_CHECK_HR( predictor.Predict( liLast + 100, prediction, stretched ), S_OK );
+    KCB_CHECK( BoneLength( stretched.SkeletonData[1], NUI_SKELETON_POSITION_HAND_RIGHT ) > handLength + 0.2f );
+
+    prediction.bKeepBoneLengths = true;
+    NUI_SKELETON_FRAME kept;
+    KCB_CHECK_HR( predictor.Predict( liLast + 100, prediction, kept ), S_OK );
+
+    // every bone at its tracked length, the hand still right of the wrist
+    for( UINT j = 1; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        NUI_SKELETON_POSITION_INDEX joint = static_cast<NUI_SKELETON_POSITION_INDEX>( j );
+        KCB_CHECK_NEAR( BoneLength( kept.SkeletonData[1], joint ), BoneLength( MakeSkeleton( 7, 0.0f, 0.0f, 0.0f ), joint ), 1e-4f );
+    }
+    const Vector4& hand = kept.SkeletonData[1].SkeletonPositions[NUI_SKELETON_POSITION_HAND_RIGHT];
+    const Vector4& wrist = kept.SkeletonData[1].SkeletonPositions[NUI_SKELETON_POSITION_WRIST_RIGHT];
+    KCB_CHECK_NEAR( hand.x - wrist.x, handLength, 1e-4f );
+    KCB_CHECK_NEAR( hand.y - wrist.y, 0.0f, 1e-4f );
+}
+
+static void BenchmarkPredict()
+{
+    SkeletonPredictor predictor;
+    KINECT_SKELETON_PREDICTION prediction = MakePrediction( SkeletonPredictionConstantAcceleration, 0.05f );
+    prediction.bKeepBoneLengths = true;
+
+    const int cRuns = 10000;
+    NUI_SKELETON_FRAME frames[2] = { MakeWalk( 0, 1.0f ), MakeWalk( 1, 1.0f ) };
+    for( UINT s = 0; s < NUI_SKELETON_COUNT; ++s )
+    {
+        frames[0].SkeletonData[s] = MakeSkeleton( 1 + s, -2.5f + s, 0.0f, 2.5f );
+        frames[1].SkeletonData[s] = MakeSkeleton( 1 + s, -2.5f + s, 0.0f, 2.52f );
+    }
+
+    Stopwatch updateTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        NUI_SKELETON_FRAME& frame = frames[i & 1];
+        frame.liTimeStamp.QuadPart = 1000 + i * FRAME_MS;
+        predictor.Update( frame );
+    }
+    double updateUs = updateTime.ElapsedMicroseconds() / cRuns;
+
+    NUI_SKELETON_FRAME predicted;
+    Stopwatch predictTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        predictor.Predict( 1000 + cRuns * FRAME_MS + i % 100, prediction, predicted );
+    }
+    double predictUs = predictTime.ElapsedMicroseconds() / cRuns;
+
+    printf( "skeleton prediction, %d skeletons: update %.2f us, predict %.2f us\n", NUI_SKELETON_COUNT, updateUs, predictUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestConstantVelocity();
+    TestDampingLimits();
+    TestKeepBoneLengths();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkPredict();
+    }
+
+    return ReportTestResult( "SkeletonPredictorTests" );
+}
@@ -0,0 +1,221 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#include "TestCommon.h"
+
+#include "SkeletonProjector.h"
+
+#include <float.h>
+#include <math.h>
+#include <vector>
+
+// points in the field of view at the depths skeletons are tracked at, and a few behind the camera
+static std::vector<Vector4> MakePoints( size_t cPoints, UINT32 seed )
+{
+    TestRandom random( seed );
+    std::vector<Vector4> points( cPoints );
+    for( size_t i = 0; i < cPoints; ++i )
+    {
+        float z = 0.8f + random.Uniform() * 3.2f;
+        Vector4 point = { random.Symmetric( 0.5f ) * z, random.Symmetric( 0.4f ) * z, z, 1.0f };
+        if( 0 == i % 17 )
+        {
+            point.z = -point.z * (i % 2);
+        }
+        points[i] = point;
+    }
+    return points;
+}
+
+// distance of a coordinate to the nearest pixel edge, the float and double formulas may truncate to either side of it
+static double EdgeDistance( double value )
+{
+    return fabs( value - floor( value + 0.5 ) );
+}
+
+// NuiTransformSkeletonToDepthImage, in double, the depth in millimeters
+static void ProjectLikeNui( DWORD width, DWORD height, const Vector4& point, _Out_ double& x, _Out_ double& y, _Out_ LONG& depth )
+{
+    x = y = 0.0;
+    depth = 0;
+    if( point.z > FLT_EPSILON )
+    {
+        x = width / 2 + point.x * (width / 320.0) * NUI_CAMERA_SKELETON_TO_DEPTH_IMAGE_MULTIPLIER_320x240 / point.z + 0.5;
+        y = height / 2 - point.y * (height / 240.0) * NUI_CAMERA_SKELETON_TO_DEPTH_IMAGE_MULTIPLIER_320x240 / point.z + 0.5;
+        depth = static_cast<LONG>( point.z * 1000.0 );
+    }
+}
+
+// the pixel of the sensor formula, but for a coordinate within float precision of a pixel edge; the last
+// 3 points of the 4 at a time loop land where they would alone
+static void TestDepthMatchesNui( NUI_IMAGE_RESOLUTION eResolution )
+{
+    DWORD width = 0, height = 0;
+    NuiImageResolutionToSize( eResolution, width, height );
+
+    std::vector<Vector4> points = MakePoints( 4003, width );
+    std::vector<NUI_DEPTH_IMAGE_POINT> depthPoints( points.size() );
+    SkeletonProjector::ProjectToDepth( eResolution, static_cast<UINT>(points.size()), points.data(), depthPoints.data() );
+
+    UINT cMismatches = 0, cAlone = 0;
+    for( size_t i = 0; i < points.size(); ++i )
+    {
+        double x, y;
+        LONG depth;
+        ProjectLikeNui( width, height, points[i], x, y, depth );
+
+        const NUI_DEPTH_IMAGE_POINT& depthPoint = depthPoints[i];
+        bool bMatch = (static_cast<LONG>(x) == depthPoint.x || EdgeDistance( x ) < 1e-3) &&
+            (static_cast<LONG>(y) == depthPoint.y || EdgeDistance( y ) < 1e-3) &&
+            abs( depth - depthPoint.depth ) <= 1;
+        cMismatches += !bMatch;
+
+        NUI_DEPTH_IMAGE_POINT alone;
+        SkeletonProjector::ProjectToDepth( eResolution, 1, &points[i], &alone );
+        cAlone += (0 == memcmp( &alone, &depthPoint, sizeof(NUI_DEPTH_IMAGE_POINT) ));
+    }
+
+    KCB_CHECK( 0 == cMismatches );
+    KCB_CHECK( points.size() == cAlone );
+
+    // behind the camera
+    KCB_CHECK( 0 == depthPoints[17].x && 0 == depthPoints[17].y && 0 == depthPoints[17].depth );
+}
+
+// u = x, v = y, w = 1
+static SkeletonProjector::ColorProjection MakeIdentityProjection()
+{
+    SkeletonProjector::ColorProjection projection;
+    ZeroMemory( &projection, sizeof(projection) );
+    projection.m[0][0] = 1.0f;
+    projection.m[1][1] = 1.0f;
+    projection.m[2][3] = 1.0f;
+    return projection;
+}
+
+// half pixels round to the even pixel, in the 4 at a time loop and in the last points alike
+static void TestColorRounding()
+{
+    static const float halves[] = { 0.5f, 1.5f, 2.5f, 3.5f, -0.5f, -1.5f, 100.5f };
+    static const LONG expected[] = { 0, 2, 2, 4, 0, -2, 100 };
+    const UINT cPoints = _countof(halves);
+
+    SkeletonProjector::ColorProjection projection = MakeIdentityProjection();
+
+    // every value once in a group of 4 and once in the last 3
+    for( UINT shift = 0; shift < 4; ++shift )
+    {
+        Vector4 points[cPoints];
+        for( UINT i = 0; i < cPoints; ++i )
+        {
+            UINT k = (i + shift) % cPoints;
+            points[i].x = halves[k];
+            points[i].y = halves[cPoints - 1 - k];
+            points[i].z = 1.0f;
+            points[i].w = 1.0f;
+        }
+
+        NUI_COLOR_IMAGE_POINT colorPoints[cPoints];
+        SkeletonProjector::ProjectToColor( projection, cPoints, points, colorPoints );
+
+        for( UINT i = 0; i < cPoints; ++i )
+        {
+            UINT k = (i + shift) % cPoints;
+            KCB_CHECK( expected[k] == colorPoints[i].x );
+            KCB_CHECK( expected[cPoints - 1 - k] == colorPoints[i].y );
+        }
+    }
+}
+
+// a projection of the color camera, fitted back from the pixels it maps the calibration points to
+static void TestColorFit()
+{
+    SkeletonProjector::ColorProjection truth;
+    const float camera[3][4] =
+    {
+        { 525.0f, 0.0f, 320.0f, -13.0f },
+        { 0.0f, -525.0f, 240.0f, 2.0f },
+        { 0.0f, 0.0f, 1.0f, 0.0f },
+    };
+    memcpy( truth.m, camera, sizeof(camera) );
+
+    std::vector<Vector4> points;
+    SkeletonProjector::GetCalibrationPoints( points );
+    std::vector<NUI_COLOR_IMAGE_POINT> colorPoints( points.size() );
+    SkeletonProjector::ProjectToColor( truth, static_cast<UINT>(points.size()), points.data(), colorPoints.data() );
+
+    SkeletonProjector::ColorProjection fitted;
+    KCB_CHECK( SkeletonProjector::FitColorProjection( NUI_IMAGE_RESOLUTION_640x480, static_cast<UINT>(points.size()), points.data(), colorPoints.data(), fitted ) );
+
+    std::vector<Vector4> test = MakePoints( 1001, 3 );
+    std::vector<NUI_COLOR_IMAGE_POINT> expected( test.size() ), projected( test.size() );
+    SkeletonProjector::ProjectToColor( truth, static_cast<UINT>(test.size()), test.data(), expected.data() );
+    SkeletonProjector::ProjectToColor( fitted, static_cast<UINT>(test.size()), test.data(), projected.data() );
+
+    LONG maxError = 0;
+    for( size_t i = 0; i < test.size(); ++i )
+    {
+        maxError = max( maxError, max( abs( expected[i].x - projected[i].x ), abs( expected[i].y - projected[i].y ) ) );
+    }
+    KCB_CHECK( maxError <= 2 );
+
+    // behind the camera
+    KCB_CHECK( 0 == projected[17].x && 0 == projected[17].y );
+
+    // a mapping that is no projection
+    colorPoints[5].x += 40;
+    KCB_CHECK( !SkeletonProjector::FitColorProjection( NUI_IMAGE_RESOLUTION_640x480, static_cast<UINT>(points.size()), points.data(), colorPoints.data(), fitted ) );
+}
+
+static void BenchmarkProjection()
+{
+    std::vector<Vector4> points = MakePoints( NUI_SKELETON_COUNT * NUI_SKELETON_POSITION_COUNT, 1 );
+    std::vector<NUI_DEPTH_IMAGE_POINT> depthPoints( points.size() );
+    std::vector<NUI_COLOR_IMAGE_POINT> colorPoints( points.size() );
+    SkeletonProjector::ColorProjection projection = MakeIdentityProjection();
+
+    const int cRuns = 100000;
+
+    Stopwatch depthTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        SkeletonProjector::ProjectToDepth( NUI_IMAGE_RESOLUTION_320x240, static_cast<UINT>(points.size()), points.data(), depthPoints.data() );
+    }
+    double depthUs = depthTime.ElapsedMicroseconds() / cRuns;
+
+    Stopwatch colorTime;
+    for( int i = 0; i < cRuns; ++i )
+    {
+        SkeletonProjector::ProjectToColor( projection, static_cast<UINT>(points.size()), points.data(), colorPoints.data() );
+    }
+    double colorUs = colorTime.ElapsedMicroseconds() / cRuns;
+
+    printf( "skeleton projection, %u joints: depth %.3f us, color %.3f us\n", static_cast<UINT>(points.size()), depthUs, colorUs );
+}
+
+int main( int argc, char** argv )
+{
+    TestDepthMatchesNui( NUI_IMAGE_RESOLUTION_80x60 );
+    TestDepthMatchesNui( NUI_IMAGE_RESOLUTION_320x240 );
+    TestDepthMatchesNui( NUI_IMAGE_RESOLUTION_640x480 );
+    TestColorRounding();
+    TestColorFit();
+
+    if( IsBenchmarkRun( argc, argv ) )
+    {
+        BenchmarkProjection();
+    }
+
+    return ReportTestResult( "SkeletonProjectorTests" );
+}
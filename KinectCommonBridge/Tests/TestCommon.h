@@ -0,0 +1,141 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+// checks and timing shared by the unit tests
+// a test is a console program per module, it returns 0 when every check passed and
+// runs its benchmarks when started with --bench
+
+#include "stdafx.h"
+
+#include <stdio.h>
+#include <math.h>
+
+static int g_cChecks = 0;
+static int g_cFailures = 0;
+
+#define KCB_CHECK( condition ) \
+    do \
+    { \
+        ++g_cChecks; \
+        if( !(condition) ) \
+        { \
+            ++g_cFailures; \
+            printf( "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition ); \
+        } \
+    } while( 0 )
+
+#define KCB_CHECK_NEAR( actual, expected, tolerance ) \
+    do \
+    { \
+        ++g_cChecks; \
+        double _actual = (actual), _expected = (expected); \
+        if( !(fabs( _actual - _expected ) <= (tolerance)) ) \
+        { \
+            ++g_cFailures; \
+            printf( "%s(%d): check failed: %s is %g, expected %g +- %g\n", __FILE__, __LINE__, #actual, _actual, _expected, static_cast<double>(tolerance) ); \
+        } \
+    } while( 0 )
+
+#define KCB_CHECK_HR( hr, expected ) \
+    do \
+    { \
+        ++g_cChecks; \
+        HRESULT _hr = (hr); \
+        if( _hr != (expected) ) \
+        { \
+            ++g_cFailures; \
+            printf( "%s(%d): check failed: %s returned 0x%08x, expected 0x%08x\n", __FILE__, __LINE__, #hr, static_cast<unsigned>(_hr), static_cast<unsigned>(expected) ); \
+        } \
+    } while( 0 )
+
+static inline bool IsBenchmarkRun( int argc, char** argv )
+{
+    return argc > 1 && 0 == strcmp( argv[1], "--bench" );
+}
+
+static inline int ReportTestResult( const char* name )
+{
+    printf( "%s: %d checks, %d failed\n", name, g_cChecks, g_cFailures );
+    return (0 == g_cFailures) ? 0 : 1;
+}
+
+// wall clock of a block of code
+class Stopwatch
+{
+public:
+    Stopwatch()
+    {
+        QueryPerformanceFrequency( &m_frequency );
+        Restart();
+    }
+
+    void Restart()
+    {
+        QueryPerformanceCounter( &m_start );
+    }
+
+    double ElapsedMicroseconds() const
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter( &now );
+        return static_cast<double>(now.QuadPart - m_start.QuadPart) * 1e6 / static_cast<double>(m_frequency.QuadPart);
+    }
+
+private:
+    LARGE_INTEGER m_frequency;
+    LARGE_INTEGER m_start;
+};
+
+// repeatable noise for the synthetic inputs, the same on every platform
+class TestRandom
+{
+public:
+    explicit TestRandom( UINT32 seed ) : m_state(seed ? seed : 1) {}
+
+    UINT32 Next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    // uniform in [0, 1)
+    float Uniform()
+    {
+        return static_cast<float>( Next() >> 8 ) * (1.0f / 16777216.0f);
+    }
+
+    // uniform in [-range, range)
+    float Symmetric( float range )
+    {
+        return (Uniform() * 2.0f - 1.0f) * range;
+    }
+
+    // roughly gaussian, sum of uniforms
+    float Gaussian( float sigma )
+    {
+        float sum = 0.0f;
+        for( int i = 0; i < 12; ++i )
+        {
+            sum += Uniform();
+        }
+        return (sum - 6.0f) * sigma;
+    }
+
+private:
+    UINT32 m_state;
+};
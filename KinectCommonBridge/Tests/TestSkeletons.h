@@ -0,0 +1,86 @@
+/***********************************************************************************************************
+Copyright  Microsoft Open Technologies, Inc.
+All Rights Reserved        
+Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+except in compliance with the License. You may obtain a copy of the License at 
+http://www.apache.org/licenses/LICENSE-2.0 
+
+THIS CODE IS PROVIDED *AS IS* BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, EITHER 
+EXPRESS OR IMPLIED, INCLUDING WITHOUT LIMITATION ANY IMPLIED WARRANTIES OR 
+CONDITIONS OF TITLE, FITNESS FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT. 
+
+See the Apache 2 License for the specific language governing permissions and limitations under the License.
+***********************************************************************************************************/
+
+#pragma once
+
+// synthetic skeletons for the tests of the skeleton modules
+
+#include "TestCommon.h"
+
+// joints of a person in a T-pose facing the sensor, relative to the hip center in meters,
+// the left side of the person at -x, arms straight out along x
+static const float TEST_T_POSE[NUI_SKELETON_POSITION_COUNT][3] =
+{
+    {  0.00f,  0.00f,  0.00f },     // hip center
+    {  0.00f,  0.30f,  0.00f },     // spine
+    {  0.00f,  0.60f,  0.00f },     // shoulder center
+    {  0.00f,  0.80f,  0.00f },     // head
+    { -0.20f,  0.55f,  0.00f },     // shoulder left
+    { -0.50f,  0.55f,  0.00f },     // elbow left
+    { -0.75f,  0.55f,  0.00f },     // wrist left
+    { -0.85f,  0.55f,  0.00f },     // hand left
+    {  0.20f,  0.55f,  0.00f },     // shoulder right
+    {  0.50f,  0.55f,  0.00f },     // elbow right
+    {  0.75f,  0.55f,  0.00f },     // wrist right
+    {  0.85f,  0.55f,  0.00f },     // hand right
+    { -0.10f, -0.05f,  0.00f },     // hip left
+    { -0.10f, -0.50f,  0.00f },     // knee left
+    { -0.10f, -0.90f,  0.00f },     // ankle left
+    { -0.10f, -0.95f, -0.10f },     // foot left
+    {  0.10f, -0.05f,  0.00f },     // hip right
+    {  0.10f, -0.50f,  0.00f },     // knee right
+    {  0.10f, -0.90f,  0.00f },     // ankle right
+    {  0.10f, -0.95f, -0.10f },     // foot right
+};
+
+static inline Vector4 MakeVector( float x, float y, float z )
+{
+    Vector4 v = { x, y, z, 1.0f };
+    return v;
+}
+
+// tracked skeleton in the T-pose with the hip center at x, y, z and every joint tracked
+static NUI_SKELETON_DATA MakeSkeleton( DWORD dwTrackingID, float x, float y, float z )
+{
+    NUI_SKELETON_DATA skeleton;
+    ZeroMemory( &skeleton, sizeof(skeleton) );
+
+    skeleton.eTrackingState = NUI_SKELETON_TRACKED;
+    skeleton.dwTrackingID = dwTrackingID;
+    skeleton.Position = MakeVector( x, y, z );
+    for( UINT j = 0; j < NUI_SKELETON_POSITION_COUNT; ++j )
+    {
+        skeleton.SkeletonPositions[j] = MakeVector( x + TEST_T_POSE[j][0], y + TEST_T_POSE[j][1], z + TEST_T_POSE[j][2] );
+        skeleton.eSkeletonPositionTrackingState[j] = NUI_SKELETON_POSITION_TRACKED;
+    }
+
+    return skeleton;
+}
+
+// empty frame, time in milliseconds like the sensor's
+static NUI_SKELETON_FRAME MakeSkeletonFrame( LONGLONG liTimeStamp, DWORD dwFrameNumber )
+{
+    NUI_SKELETON_FRAME frame;
+    ZeroMemory( &frame, sizeof(frame) );
+
+    frame.liTimeStamp.QuadPart = liTimeStamp;
+    frame.dwFrameNumber = dwFrameNumber;
+
+    // a level floor 1 m below the sensor
+    frame.vFloorClipPlane = MakeVector( 0.0f, 1.0f, 0.0f );
+    frame.vNormalToGravity = MakeVector( 0.0f, 1.0f, 0.0f );
+    frame.vNormalToGravity.w = 0.0f;
+
+    return frame;
+}